@@ -0,0 +1,233 @@
+const delta = require('.')
+const b4a = require('b4a')
+const process = require('bare-process')
+const seedrandom = require('math-random-seed')
+const { spawnSync } = require('bare-subprocess')
+const { generateTestData, mutateData } = require('./test/helpers')
+
+// Concurrency scaling and tail latency of the async API. Every point of
+// the sweep keeps a number of creates and applies in flight over a mix of
+// small and large inputs, with the worker pool at a given size. Each point
+// runs in a fresh process so the metrics() histograms and the peak RSS
+// belong to that point alone.
+//
+//   bare bench-concurrency.js [--concurrency 1,4,16] [--threads 1,2,4] [--operations n] [--json file]
+
+// Input sizes and how often each is picked. The smallest run inline, the
+// next are coalesced into batches and the rest go to the pool one by one.
+const SIZES = [
+  { size: 512, weight: 40 },
+  { size: 8 * 1024, weight: 30 },
+  { size: 128 * 1024, weight: 20 },
+  { size: 1024 * 1024, weight: 8 },
+  { size: 4 * 1024 * 1024, weight: 2 }
+]
+
+const SEED = 1
+
+function parseArgs(argv) {
+  const args = {
+    concurrency: [1, 2, 4, 8, 16, 32, 64],
+    threads: [1, 2, 4, 8],
+    operations: 2000,
+    warmup: 100,
+    json: null,
+    point: false
+  }
+
+  for (let i = 0; i < argv.length; i++) {
+    const arg = argv[i]
+    const value = argv[i + 1]
+
+    if (arg === '--point') {
+      args.point = true
+      continue
+    }
+
+    if (value === undefined) throw new Error(`Missing value for ${arg}`)
+
+    if (arg === '--concurrency') args.concurrency = value.split(',').map(Number)
+    else if (arg === '--threads') args.threads = value.split(',').map(Number)
+    else if (arg === '--operations') args.operations = Number(value)
+    else if (arg === '--warmup') args.warmup = Number(value)
+    else if (arg === '--json') args.json = value
+    else throw new Error(`Unknown option ${arg}`)
+
+    i++
+  }
+
+  return args
+}
+
+function percentile(sorted, p) {
+  if (sorted.length === 0) return 0
+  const rank = Math.min(sorted.length, Math.max(1, Math.ceil(p * sorted.length)))
+  return sorted[rank - 1]
+}
+
+// One pair of inputs per size, and the delta between them for applies
+function prepareInputs() {
+  return SIZES.map(({ size, weight }) => {
+    const source = generateTestData(size, 'structured')
+    const target = mutateData(source, 'point', 0.02)
+    return { size, weight, source, target, diff: delta.createSync(source, target) }
+  })
+}
+
+function pickInput(rng, inputs, totalWeight) {
+  let r = rng() * totalWeight
+  for (const input of inputs) {
+    r -= input.weight
+    if (r < 0) return input
+  }
+  return inputs[inputs.length - 1]
+}
+
+// Run one point of the sweep in this process: keep `concurrency` requests in
+// flight until `operations` have completed, half creates and half applies
+async function runPoint({ concurrency, threads, operations, warmup }) {
+  delta.configure({ threads })
+
+  const inputs = prepareInputs()
+  const totalWeight = inputs.reduce((sum, input) => sum + input.weight, 0)
+  const rng = seedrandom(String(SEED))
+
+  async function drive(count, latencies) {
+    let remaining = count
+    let bytes = 0
+
+    async function lane() {
+      while (remaining > 0) {
+        remaining--
+
+        const input = pickInput(rng, inputs, totalWeight)
+        const isCreate = rng() < 0.5
+
+        const start = process.hrtime.bigint()
+        const result = isCreate
+          ? await delta.create(input.source, input.target)
+          : await delta.apply(input.source, input.diff)
+        const elapsed = Number(process.hrtime.bigint() - start) / 1e6
+
+        if (!isCreate && !b4a.equals(result, input.target)) throw new Error('Apply returned the wrong target')
+
+        if (latencies) latencies.push(elapsed)
+        bytes += input.source.length + (isCreate ? input.target.length : input.diff.length)
+      }
+    }
+
+    await Promise.all(Array.from({ length: concurrency }, lane))
+    return bytes
+  }
+
+  await drive(warmup, null)
+
+  const before = delta.metrics()
+  const latencies = []
+
+  const start = process.hrtime.bigint()
+  const bytes = await drive(operations, latencies)
+  const seconds = Number(process.hrtime.bigint() - start) / 1e9
+
+  const after = delta.metrics()
+  latencies.sort((a, b) => a - b)
+
+  // The histograms are cumulative, so the mean is exact for the measured
+  // operations while the percentiles include the warmup
+  const waits = after.queueWait.count - before.queueWait.count
+  const waitMean = waits > 0
+    ? (after.queueWait.mean * after.queueWait.count - before.queueWait.mean * before.queueWait.count) / waits
+    : 0
+
+  const usage = typeof process.resourceUsage === 'function' ? process.resourceUsage() : null
+
+  return {
+    concurrency,
+    threads,
+    operations,
+    opsPerSecond: operations / seconds,
+    mbPerSecond: bytes / 1024 / 1024 / seconds,
+    latency: {
+      p50: percentile(latencies, 0.5),
+      p99: percentile(latencies, 0.99),
+      p999: percentile(latencies, 0.999),
+      max: latencies[latencies.length - 1]
+    },
+    queueWait: {
+      mean: waitMean,
+      p50: after.queueWait.p50,
+      p99: after.queueWait.p99,
+      p999: after.queueWait.p999
+    },
+    inlined: delta.stats().inlined,
+    peakRss: usage ? usage.maxRSS * 1024 : null
+  }
+}
+
+function format(n, digits = 2) {
+  return n === null ? '-' : n.toFixed(digits)
+}
+
+async function run() {
+  const args = parseArgs(process.argv.slice(2))
+
+  if (args.point) {
+    const result = await runPoint({
+      concurrency: args.concurrency[0],
+      threads: args.threads[0],
+      operations: args.operations,
+      warmup: args.warmup
+    })
+
+    process.stdout.write(JSON.stringify(result) + '\n')
+    return
+  }
+
+  console.log('Threads  Conc     ops/s    MB/s   p50 ms   p99 ms  p999 ms  wait mean  wait p99  peak RSS')
+  console.log('=========================================================================================')
+
+  const results = []
+
+  for (const threads of args.threads) {
+    for (const concurrency of args.concurrency) {
+      const child = spawnSync(process.execPath, [
+        __filename, '--point',
+        '--threads', String(threads),
+        '--concurrency', String(concurrency),
+        '--operations', String(args.operations),
+        '--warmup', String(args.warmup)
+      ])
+
+      if (child.status !== 0) {
+        throw new Error(`Point threads=${threads} concurrency=${concurrency} failed: ${b4a.toString(child.stderr || b4a.alloc(0))}`)
+      }
+
+      const result = JSON.parse(b4a.toString(child.stdout))
+      results.push(result)
+
+      const rss = result.peakRss === null ? null : result.peakRss / 1024 / 1024
+
+      console.log(
+        `${String(threads).padStart(7)} ${String(concurrency).padStart(5)} ` +
+        `${format(result.opsPerSecond, 0).padStart(9)} ${format(result.mbPerSecond, 1).padStart(7)} ` +
+        `${format(result.latency.p50).padStart(8)} ${format(result.latency.p99).padStart(8)} ${format(result.latency.p999).padStart(8)} ` +
+        `${format(result.queueWait.mean, 3).padStart(10)} ${format(result.queueWait.p99, 3).padStart(9)} ` +
+        `${(rss === null ? '-' : format(rss, 1) + 'MB').padStart(9)}`
+      )
+    }
+  }
+
+  if (args.json) {
+    const fs = require('bare-fs')
+    fs.writeFileSync(args.json, JSON.stringify({ seed: SEED, sizes: SIZES, operations: args.operations, results }, null, 2) + '\n')
+  }
+
+  console.log('\nLatency is measured around each await, queue wait is the time requests spent in the pool queue.')
+  console.log('Throughput that stops growing with concurrency at a fixed thread count, or p99 that grows faster')
+  console.log('than concurrency divided by threads, points at contention rather than a busy pool.')
+}
+
+run().catch(err => {
+  console.error('BENCHMARK FAILED:', err.message)
+  process.exit(1)
+})
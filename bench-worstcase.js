@@ -0,0 +1,72 @@
+const delta = require('.')
+const b4a = require('b4a')
+const process = require('bare-process')
+const { measureRecipe } = require('./test/helpers')
+
+// Worst-case fixtures against their time budgets. Every fixture of
+// test/fixtures/worst-case.json, written by bench/bench_worstcase, is rebuilt
+// and timed against its benign baseline. Creates are costed per target byte
+// and applies per byte of delta and output, as when they were recorded. The
+// process fails when a fixture costs more than its budget relative to the
+// baseline.
+//
+//   bare bench-worstcase.js [--fixtures file] [--runs n]
+
+function parseArgs(argv) {
+  const args = {
+    fixtures: null,
+    runs: 5
+  }
+
+  for (let i = 0; i < argv.length; i++) {
+    const arg = argv[i]
+    const value = argv[i + 1]
+
+    if (value === undefined) throw new Error(`Missing value for ${arg}`)
+
+    if (arg === '--fixtures') args.fixtures = value
+    else if (arg === '--runs') args.runs = Number(value)
+    else throw new Error(`Unknown option ${arg}`)
+
+    i++
+  }
+
+  return args
+}
+
+function run() {
+  const args = parseArgs(process.argv.slice(2))
+  const recorded = args.fixtures
+    ? JSON.parse(b4a.toString(require('bare-fs').readFileSync(args.fixtures)))
+    : require('./test/fixtures/worst-case.json')
+
+  const { size, hashWindowSize, searchLimit, fixtures } = recorded
+  const options = { hashWindowSize, searchDepth: searchLimit }
+
+  console.log('Fixture                         ns/B   base ns/B    ratio   budget')
+  console.log('==================================================================')
+
+  let failed = 0
+
+  for (const fixture of fixtures) {
+    const { ns, baseNs } = measureRecipe(fixture, size, delta, options, args.runs)
+    const ratio = ns / baseNs
+    const over = ratio > fixture.budget
+
+    if (over) failed++
+
+    console.log(
+      `${fixture.name.padEnd(26)} ${ns.toFixed(3).padStart(9)} ${baseNs.toFixed(3).padStart(11)} ` +
+      `${ratio.toFixed(1).padStart(8)} ${String(fixture.budget).padStart(8)}${over ? '  OVER BUDGET' : ''}`
+    )
+  }
+
+  if (failed > 0) throw new Error(`${failed} of ${fixtures.length} fixtures over budget`)
+}
+
+try {
+  run()
+} catch (err) {
+  console.error('BENCHMARK FAILED:', err.message)
+  process.exit(1)
+}
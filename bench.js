@@ -20,8 +20,8 @@ async function benchmark(scenario, compressed = false) {
   const original = generateTestData(scenario.size, scenario.dataType)
   const modified = mutateData(original, 'point', scenario.mutations)
   
-  const options = compressed ? { compressed: true } : {}
-  const suffix = compressed ? ' (comp)' : ''
+  const options = compressed ? { compressed } : {}
+  const suffix = compressed ? ` (${compressed})` : ''
   
   // Time delta creation
   const createStart = process.hrtime.bigint()
@@ -30,7 +30,7 @@ async function benchmark(scenario, compressed = false) {
   
   // Time delta application
   const applyStart = process.hrtime.bigint()
-  const result = await apply(original, delta, options)
+  const result = await apply(original, delta)
   const applyEnd = process.hrtime.bigint()
   
   if (!b4a.equals(result, modified)) {
@@ -46,7 +46,7 @@ async function benchmark(scenario, compressed = false) {
   const applyThroughput = (scenario.size / 1024 / 1024) / (applyTime / 1000)
   
   const mutationRate = scenario.mutations * 100
-  const nameWithSuffix = (scenario.name + suffix).padEnd(15)
+  const nameWithSuffix = (scenario.name + suffix).padEnd(22)
   
   console.log(`${nameWithSuffix} ${(scenario.size/1024).toFixed(0).padStart(5)}KB  ${mutationRate.toFixed(0).padStart(3)}%  ${createTime.toFixed(1).padStart(5)}ms  ${applyTime.toFixed(1).padStart(4)}ms  ${createThroughput.toFixed(0).padStart(4)}MB/s  ${applyThroughput.toFixed(0).padStart(4)}MB/s  ${ratio.toFixed(1).padStart(5)}%`)
   
@@ -54,8 +54,8 @@ async function benchmark(scenario, compressed = false) {
 }
 
 async function run() {
-  console.log('Scenario         Size  Mut  Create Apply CreateMB/s ApplyMB/s Delta')
-  console.log('===================================================================')
+  console.log('Scenario                Size  Mut  Create Apply CreateMB/s ApplyMB/s Delta')
+  console.log('==========================================================================')
   
   const compressionResults = []
   
@@ -63,31 +63,35 @@ async function run() {
     // Run uncompressed benchmark
     const uncompressed = await benchmark(scenario, false)
     
-    // Run compressed benchmark
-    const compressed = await benchmark(scenario, true)
-    
-    // Calculate compression effectiveness
-    const compressionRatio = (compressed.delta.length / uncompressed.delta.length) * 100
-    const createOverhead = ((compressed.createTime / uncompressed.createTime) - 1) * 100
-    const applyOverhead = ((compressed.applyTime / uncompressed.applyTime) - 1) * 100
-    
-    compressionResults.push({
-      name: scenario.name,
-      size: scenario.size,
-      dataType: scenario.dataType,
-      compressionRatio,
-      createOverhead,
-      applyOverhead,
-      originalDelta: uncompressed.ratio,
-      compressedDelta: compressed.ratio
-    })
+    // Run compressed benchmarks, zstd for size and lz4 for apply latency
+    for (const codec of ['zstd', 'lz4']) {
+      const compressed = await benchmark(scenario, codec)
+      
+      // Calculate compression effectiveness
+      const compressionRatio = (compressed.delta.length / uncompressed.delta.length) * 100
+      const createOverhead = ((compressed.createTime / uncompressed.createTime) - 1) * 100
+      const applyOverhead = ((compressed.applyTime / uncompressed.applyTime) - 1) * 100
+      
+      compressionResults.push({
+        name: scenario.name,
+        codec,
+        size: scenario.size,
+        dataType: scenario.dataType,
+        compressionRatio,
+        createOverhead,
+        applyOverhead,
+        originalDelta: uncompressed.ratio,
+        compressedDelta: compressed.ratio
+      })
+    }
   }
   
   console.log('\n=== COMPRESSION ANALYSIS ===')
-  console.log('Scenario         Size  Type        Compression  CreateOH  ApplyOH   Original  Compressed')
-  console.log('====================================================================================')
+  console.log('Scenario         Codec  Size  Type        Compression  CreateOH  ApplyOH   Original  Compressed')
+  console.log('===========================================================================================')
   
   for (const result of compressionResults) {
+    const codec = result.codec.padEnd(5)
     const sizeMB = (result.size / 1024).toFixed(0).padStart(4)
     const type = result.dataType.padEnd(10)
     const compRatio = `${result.compressionRatio.toFixed(1)}%`.padStart(8)
@@ -96,7 +100,7 @@ async function run() {
     const originalDelta = `${result.originalDelta.toFixed(1)}%`.padStart(8)
     const compressedDelta = `${result.compressedDelta.toFixed(1)}%`.padStart(10)
     
-    console.log(`${result.name.padEnd(15)} ${sizeMB}KB  ${type} ${compRatio} ${createOH} ${applyOH}  ${originalDelta}  ${compressedDelta}`)
+    console.log(`${result.name.padEnd(15)} ${codec} ${sizeMB}KB  ${type} ${compRatio} ${createOH} ${applyOH}  ${originalDelta}  ${compressedDelta}`)
   }
   
   console.log('\nPerformance Analysis:')
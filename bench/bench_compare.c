@@ -0,0 +1,802 @@
+#include <bsdiff.h>
+#include <bspatch.h>
+#include <inttypes.h>
+#include <lz4frame.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <xdelta3.h>
+#include <zstd.h>
+
+#include <delta.h>
+
+#include "corpus.h"
+#include "harness.h"
+
+// Compare bare-delta with the usual alternatives on the same pairs:
+// xdelta3, bsdiff and zstd --patch-from.  All of them are built from
+// source with the benchmarks and called in process, so no network or
+// installed tools are needed at run time.
+//
+//   bench_compare [options] [<source> <target>]...
+//
+// Peak memory counts what each tool allocates while it runs, not the
+// source, target and patch buffers every tool is handed.
+
+#define COMPARE_CREATE_OVERHEAD 1024
+
+// Search depth of the JavaScript API
+#define COMPARE_SEARCH_LIMIT 250
+
+// bsdiff writes an uncompressed stream that the original tool compressed
+// with bzip2; zstd at this level stands in for it
+#define COMPARE_BSDIFF_LEVEL 19
+
+typedef struct {
+  int warmup;
+  int iterations;
+  size_t size;
+  double churn;
+  int versions;
+  uint64_t seed;
+  int levels[8];
+  int nlevels;
+  const char **kinds;
+  int nkinds;
+  const char **tools;
+  int ntools;
+  const char *json;
+} compare_options_t;
+
+// The pair being measured and the buffers every tool shares
+typedef struct {
+  const char *source;
+  size_t source_len;
+  const char *target;
+  size_t target_len;
+  char *patch;
+  size_t patch_len;
+  size_t patch_cap;
+  char *scratch;
+  size_t scratch_len;
+  size_t scratch_cap;
+  char *output;
+  ZSTD_CCtx *cctx;
+  ZSTD_DCtx *dctx;
+  LZ4F_dctx *lz4_dctx;
+} compare_state_t;
+
+typedef struct compare_tool compare_tool_t;
+
+struct compare_tool {
+  char name[32];
+  int level;
+  int (*create)(const compare_tool_t *tool, compare_state_t *state);
+  int (*apply)(const compare_tool_t *tool, compare_state_t *state);
+};
+
+typedef struct {
+  size_t patch_len;
+  bench_summary_t create;
+  bench_summary_t apply;
+  int64_t create_peak;
+  int64_t apply_peak;
+} compare_result_t;
+
+static bool
+compare_reserve(char **data, size_t *cap, size_t len) {
+  if (len <= *cap) return true;
+
+  char *next = realloc(*data, len);
+  if (next == NULL) return false;
+
+  *data = next;
+  *cap = len;
+  return true;
+}
+
+// Codec contexts are created on first use and dropped before every memory
+// measurement, so their allocations count against the tool that uses them
+static ZSTD_CCtx *
+compare_cctx(compare_state_t *state) {
+  if (state->cctx == NULL) state->cctx = ZSTD_createCCtx();
+  return state->cctx;
+}
+
+static ZSTD_DCtx *
+compare_dctx(compare_state_t *state) {
+  if (state->dctx == NULL) state->dctx = ZSTD_createDCtx();
+  return state->dctx;
+}
+
+static void
+compare_drop_contexts(compare_state_t *state) {
+  if (state->cctx) ZSTD_freeCCtx(state->cctx);
+  if (state->dctx) ZSTD_freeDCtx(state->dctx);
+  if (state->lz4_dctx) LZ4F_freeDecompressionContext(state->lz4_dctx);
+
+  state->cctx = NULL;
+  state->dctx = NULL;
+  state->lz4_dctx = NULL;
+
+  delta_release_thread_cache();
+}
+
+// bare-delta, as create() and apply() run it: the raw delta, optionally
+// compressed with zstd at the tool's level or with LZ4
+
+static int
+compare_delta_raw(compare_state_t *state, char *out) {
+  return delta_create_with_options(
+    state->source, state->source_len,
+    state->target, state->target_len,
+    out,
+    DELTA_NHASH_DEFAULT, COMPARE_SEARCH_LIMIT, NULL
+  );
+}
+
+static int
+compare_delta_create(const compare_tool_t *tool, compare_state_t *state) {
+  int len = compare_delta_raw(state, state->patch);
+  if (len < 0) return -1;
+
+  state->patch_len = (size_t)len;
+  return 0;
+}
+
+static int
+compare_delta_apply(const compare_tool_t *tool, compare_state_t *state) {
+  int len = delta_apply(state->source, state->source_len, state->patch, state->patch_len, state->output);
+  return len == (int)state->target_len ? 0 : -1;
+}
+
+static int
+compare_delta_zstd_create(const compare_tool_t *tool, compare_state_t *state) {
+  int len = compare_delta_raw(state, state->scratch);
+  if (len < 0 || compare_cctx(state) == NULL) return -1;
+
+  size_t packed = ZSTD_compressCCtx(state->cctx, state->patch, state->patch_cap, state->scratch, (size_t)len, tool->level);
+  if (ZSTD_isError(packed)) return -1;
+
+  state->patch_len = packed;
+  return 0;
+}
+
+static int
+compare_delta_zstd_apply(const compare_tool_t *tool, compare_state_t *state) {
+  if (compare_dctx(state) == NULL) return -1;
+
+  size_t len = ZSTD_decompressDCtx(state->dctx, state->scratch, state->scratch_cap, state->patch, state->patch_len);
+  if (ZSTD_isError(len)) return -1;
+
+  int out = delta_apply(state->source, state->source_len, state->scratch, len, state->output);
+  return out == (int)state->target_len ? 0 : -1;
+}
+
+static int
+compare_delta_lz4_create(const compare_tool_t *tool, compare_state_t *state) {
+  int len = compare_delta_raw(state, state->scratch);
+  if (len < 0) return -1;
+
+  LZ4F_preferences_t prefs = LZ4F_INIT_PREFERENCES;
+  prefs.frameInfo.contentSize = (unsigned long long)len;
+
+  size_t packed = LZ4F_compressFrame(state->patch, state->patch_cap, state->scratch, (size_t)len, &prefs);
+  if (LZ4F_isError(packed)) return -1;
+
+  state->patch_len = packed;
+  return 0;
+}
+
+static int
+compare_delta_lz4_apply(const compare_tool_t *tool, compare_state_t *state) {
+  if (state->lz4_dctx == NULL) {
+    if (LZ4F_isError(LZ4F_createDecompressionContext(&state->lz4_dctx, LZ4F_VERSION))) {
+      state->lz4_dctx = NULL;
+      return -1;
+    }
+  } else {
+    LZ4F_resetDecompressionContext(state->lz4_dctx);
+  }
+
+  size_t dst_pos = 0;
+  size_t src_pos = 0;
+  size_t ret = 1;
+
+  while (ret != 0 && src_pos < state->patch_len) {
+    size_t dst_size = state->scratch_cap - dst_pos;
+    size_t src_size = state->patch_len - src_pos;
+
+    ret = LZ4F_decompress(state->lz4_dctx, state->scratch + dst_pos, &dst_size, state->patch + src_pos, &src_size, NULL);
+    if (LZ4F_isError(ret) || (dst_size == 0 && src_size == 0)) return -1;
+
+    dst_pos += dst_size;
+    src_pos += src_size;
+  }
+
+  int out = delta_apply(state->source, state->source_len, state->scratch, dst_pos, state->output);
+  return out == (int)state->target_len ? 0 : -1;
+}
+
+// zstd --patch-from: the source is a prefix the target is compressed
+// against, with long distance matching and a window that covers both
+
+static int
+compare_window_log(const compare_state_t *state) {
+  size_t span = state->source_len + state->target_len;
+  int log = 10;
+
+  while (log < 30 && ((size_t)1 << log) < span) log++;
+
+  return log;
+}
+
+static int
+compare_zstd_create(const compare_tool_t *tool, compare_state_t *state) {
+  ZSTD_CCtx *cctx = compare_cctx(state);
+  if (cctx == NULL) return -1;
+
+  ZSTD_CCtx_reset(cctx, ZSTD_reset_session_and_parameters);
+
+  if (ZSTD_isError(ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, tool->level)) ||
+      ZSTD_isError(ZSTD_CCtx_setParameter(cctx, ZSTD_c_windowLog, compare_window_log(state))) ||
+      ZSTD_isError(ZSTD_CCtx_setParameter(cctx, ZSTD_c_enableLongDistanceMatching, 1)) ||
+      ZSTD_isError(ZSTD_CCtx_refPrefix(cctx, state->source, state->source_len))) {
+    return -1;
+  }
+
+  size_t len = ZSTD_compress2(cctx, state->patch, state->patch_cap, state->target, state->target_len);
+  if (ZSTD_isError(len)) return -1;
+
+  state->patch_len = len;
+  return 0;
+}
+
+static int
+compare_zstd_apply(const compare_tool_t *tool, compare_state_t *state) {
+  ZSTD_DCtx *dctx = compare_dctx(state);
+  if (dctx == NULL) return -1;
+
+  ZSTD_DCtx_reset(dctx, ZSTD_reset_session_and_parameters);
+
+  if (ZSTD_isError(ZSTD_DCtx_setParameter(dctx, ZSTD_d_windowLogMax, compare_window_log(state))) ||
+      ZSTD_isError(ZSTD_DCtx_refPrefix(dctx, state->source, state->source_len))) {
+    return -1;
+  }
+
+  size_t len = ZSTD_decompressDCtx(dctx, state->output, state->target_len + 1, state->patch, state->patch_len);
+  return !ZSTD_isError(len) && len == state->target_len ? 0 : -1;
+}
+
+// xdelta3 with DJW secondary compression, the VCDIFF encoder most
+// distributions ship
+
+static int
+compare_xdelta3_create(const compare_tool_t *tool, compare_state_t *state) {
+  usize_t len = 0;
+
+  int err = xd3_encode_memory(
+    (const uint8_t *)state->target, (usize_t)state->target_len,
+    (const uint8_t *)state->source, (usize_t)state->source_len,
+    (uint8_t *)state->patch, &len, (usize_t)state->patch_cap,
+    XD3_SEC_DJW
+  );
+
+  if (err != 0) return -1;
+
+  state->patch_len = len;
+  return 0;
+}
+
+static int
+compare_xdelta3_apply(const compare_tool_t *tool, compare_state_t *state) {
+  usize_t len = 0;
+
+  int err = xd3_decode_memory(
+    (const uint8_t *)state->patch, (usize_t)state->patch_len,
+    (const uint8_t *)state->source, (usize_t)state->source_len,
+    (uint8_t *)state->output, &len, (usize_t)(state->target_len + 1),
+    0
+  );
+
+  return err == 0 && len == state->target_len ? 0 : -1;
+}
+
+// bsdiff: the target length, then the zstd compressed control, diff and
+// extra stream
+
+static int
+compare_bsdiff_write(struct bsdiff_stream *stream, const void *buffer, int size) {
+  compare_state_t *state = stream->opaque;
+
+  if (!compare_reserve(&state->scratch, &state->scratch_cap, state->scratch_len + (size_t)size)) return -1;
+
+  memcpy(state->scratch + state->scratch_len, buffer, (size_t)size);
+  state->scratch_len += (size_t)size;
+  return 0;
+}
+
+static int
+compare_bsdiff_create(const compare_tool_t *tool, compare_state_t *state) {
+  struct bsdiff_stream stream = {state, malloc, free, compare_bsdiff_write};
+
+  state->scratch_len = 0;
+
+  if (bsdiff((const uint8_t *)state->source, (int64_t)state->source_len, (const uint8_t *)state->target, (int64_t)state->target_len, &stream) != 0) {
+    return -1;
+  }
+
+  if (compare_cctx(state) == NULL) return -1;
+
+  uint64_t target_len = state->target_len;
+  memcpy(state->patch, &target_len, sizeof(target_len));
+
+  size_t len = ZSTD_compressCCtx(
+    state->cctx, state->patch + sizeof(target_len), state->patch_cap - sizeof(target_len),
+    state->scratch, state->scratch_len, tool->level
+  );
+
+  if (ZSTD_isError(len)) return -1;
+
+  state->patch_len = sizeof(target_len) + len;
+  return 0;
+}
+
+typedef struct {
+  const char *data;
+  size_t len;
+  size_t pos;
+} compare_bspatch_input_t;
+
+static int
+compare_bspatch_read(const struct bspatch_stream *stream, void *buffer, int length) {
+  compare_bspatch_input_t *input = stream->opaque;
+
+  if ((size_t)length > input->len - input->pos) return -1;
+
+  memcpy(buffer, input->data + input->pos, (size_t)length);
+  input->pos += (size_t)length;
+  return 0;
+}
+
+static int
+compare_bsdiff_apply(const compare_tool_t *tool, compare_state_t *state) {
+  uint64_t target_len;
+
+  if (state->patch_len < sizeof(target_len) || compare_dctx(state) == NULL) return -1;
+
+  memcpy(&target_len, state->patch, sizeof(target_len));
+
+  unsigned long long raw_len = ZSTD_getFrameContentSize(state->patch + sizeof(target_len), state->patch_len - sizeof(target_len));
+
+  if (raw_len == ZSTD_CONTENTSIZE_ERROR || raw_len == ZSTD_CONTENTSIZE_UNKNOWN ||
+      !compare_reserve(&state->scratch, &state->scratch_cap, (size_t)raw_len)) {
+    return -1;
+  }
+
+  size_t len = ZSTD_decompressDCtx(
+    state->dctx, state->scratch, state->scratch_cap,
+    state->patch + sizeof(target_len), state->patch_len - sizeof(target_len)
+  );
+
+  if (ZSTD_isError(len)) return -1;
+
+  compare_bspatch_input_t input = {state->scratch, len, 0};
+  struct bspatch_stream stream = {&input, compare_bspatch_read};
+
+  int err = bspatch(
+    (const uint8_t *)state->source, (int64_t)state->source_len,
+    (uint8_t *)state->output, (int64_t)target_len,
+    &stream
+  );
+
+  return err == 0 && target_len == state->target_len ? 0 : -1;
+}
+
+// Measurement
+
+typedef int (*compare_fn)(const compare_tool_t *tool, compare_state_t *state);
+
+static int
+compare_time(const compare_options_t *options, const compare_tool_t *tool, compare_fn fn, compare_state_t *state, bench_summary_t *summary) {
+  for (int i = 0; i < options->warmup; i++) {
+    if (fn(tool, state) != 0) return -1;
+  }
+
+  uint64_t *samples = malloc(sizeof(uint64_t) * options->iterations);
+  if (samples == NULL) return -1;
+
+  for (int i = 0; i < options->iterations; i++) {
+    uint64_t start = bench_now();
+    int err = fn(tool, state);
+    samples[i] = bench_now() - start;
+
+    if (err != 0) {
+      free(samples);
+      return -1;
+    }
+  }
+
+  bench_summarize(samples, options->iterations, summary);
+  free(samples);
+
+  return 0;
+}
+
+// One untimed run from cold contexts, watching resident memory
+static int
+compare_peak(const compare_tool_t *tool, compare_fn fn, compare_state_t *state, int64_t *peak) {
+  compare_drop_contexts(state);
+  bench_peak_reset();
+
+  int err = fn(tool, state);
+
+  *peak = bench_peak_bytes();
+  return err;
+}
+
+static int
+compare_tool_run(const compare_options_t *options, const compare_tool_t *tool, compare_state_t *state, compare_result_t *result) {
+  memset(result, 0, sizeof(*result));
+
+  if (compare_peak(tool, tool->create, state, &result->create_peak) != 0) return -1;
+  if (compare_time(options, tool, tool->create, state, &result->create) != 0) return -1;
+
+  result->patch_len = state->patch_len;
+
+  memset(state->output, 0, state->target_len + 1);
+
+  if (compare_peak(tool, tool->apply, state, &result->apply_peak) != 0) return -1;
+  if (memcmp(state->output, state->target, state->target_len) != 0) return -1;
+  if (compare_time(options, tool, tool->apply, state, &result->apply) != 0) return -1;
+
+  return 0;
+}
+
+// Reporting
+
+static double
+compare_throughput(size_t bytes, const bench_summary_t *summary) {
+  if (summary->median_ns == 0) return 0;
+  return (double)bytes / (1024.0 * 1024.0) / ((double)summary->median_ns / 1e9);
+}
+
+static void
+compare_print_header(void) {
+  printf(
+    "%-24s %-18s %10s %7s %10s %10s %10s %10s\n",
+    "corpus", "tool", "patch", "ratio", "create/s", "apply/s", "create mem", "apply mem"
+  );
+}
+
+static void
+compare_print_memory(int64_t bytes) {
+  if (bytes < 0) printf(" %10s", "-");
+  else printf(" %8.1fMB", (double)bytes / (1024.0 * 1024.0));
+}
+
+static void
+compare_print_result(const char *name, const compare_tool_t *tool, const compare_state_t *state, const compare_result_t *result) {
+  printf(
+    "%-24.24s %-18s %10zu %6.2f%% %8.1fMB %8.1fMB",
+    name, tool->name, result->patch_len,
+    state->target_len ? 100.0 * result->patch_len / state->target_len : 0.0,
+    compare_throughput(state->target_len, &result->create),
+    compare_throughput(state->target_len, &result->apply)
+  );
+
+  compare_print_memory(result->create_peak);
+  compare_print_memory(result->apply_peak);
+  printf("\n");
+}
+
+static void
+compare_json_memory(FILE *out, const char *key, int64_t bytes) {
+  if (bytes < 0) fprintf(out, ", \"%s\": null", key);
+  else fprintf(out, ", \"%s\": %" PRId64, key, bytes);
+}
+
+static void
+compare_json_result(FILE *out, const char *name, const compare_tool_t *tool, const compare_state_t *state, const compare_result_t *result, bool first) {
+  fprintf(out, "%s\n    {\"corpus\": ", first ? "" : ",");
+  bench_json_string(out, name);
+  fprintf(out, ", \"tool\": ");
+  bench_json_string(out, tool->name);
+  fprintf(
+    out,
+    ", \"sourceLength\": %zu, \"targetLength\": %zu, \"patchLength\": %zu"
+    ", \"createMedianNs\": %" PRIu64 ", \"createP99Ns\": %" PRIu64
+    ", \"applyMedianNs\": %" PRIu64 ", \"applyP99Ns\": %" PRIu64
+    ", \"createMbPerSecond\": %.3f, \"applyMbPerSecond\": %.3f",
+    state->source_len, state->target_len, result->patch_len,
+    result->create.median_ns, result->create.p99_ns,
+    result->apply.median_ns, result->apply.p99_ns,
+    compare_throughput(state->target_len, &result->create),
+    compare_throughput(state->target_len, &result->apply)
+  );
+
+  compare_json_memory(out, "createPeakBytes", result->create_peak);
+  compare_json_memory(out, "applyPeakBytes", result->apply_peak);
+  fprintf(out, "}");
+}
+
+// Tools
+
+static int
+compare_tools(const compare_options_t *options, compare_tool_t *tools) {
+  int n = 0;
+
+  tools[n++] = (compare_tool_t){"bare-delta", 0, compare_delta_create, compare_delta_apply};
+
+  for (int i = 0; i < options->nlevels; i++) {
+    compare_tool_t tool = {"", options->levels[i], compare_delta_zstd_create, compare_delta_zstd_apply};
+    snprintf(tool.name, sizeof(tool.name), "bare-delta+zstd-%d", options->levels[i]);
+    tools[n++] = tool;
+  }
+
+  tools[n++] = (compare_tool_t){"bare-delta+lz4", 0, compare_delta_lz4_create, compare_delta_lz4_apply};
+
+  for (int i = 0; i < options->nlevels; i++) {
+    compare_tool_t tool = {"", options->levels[i], compare_zstd_create, compare_zstd_apply};
+    snprintf(tool.name, sizeof(tool.name), "zstd-patch-from-%d", options->levels[i]);
+    tools[n++] = tool;
+  }
+
+  tools[n++] = (compare_tool_t){"xdelta3", 0, compare_xdelta3_create, compare_xdelta3_apply};
+  tools[n++] = (compare_tool_t){"bsdiff", COMPARE_BSDIFF_LEVEL, compare_bsdiff_create, compare_bsdiff_apply};
+
+  // Keep the tools named on the command line, by prefix
+  if (options->ntools > 0) {
+    int kept = 0;
+
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < options->ntools; j++) {
+        if (strncmp(tools[i].name, options->tools[j], strlen(options->tools[j])) == 0) {
+          tools[kept++] = tools[i];
+          break;
+        }
+      }
+    }
+
+    n = kept;
+  }
+
+  return n;
+}
+
+static int
+compare_pair(const compare_options_t *options, const compare_tool_t *tools, int ntools, const char *name, const bench_version_t *source, const bench_version_t *target, FILE *json, bool *first) {
+  compare_state_t state;
+  memset(&state, 0, sizeof(state));
+
+  state.source = source->data;
+  state.source_len = source->len;
+  state.target = target->data;
+  state.target_len = target->len;
+
+  // Every patch here fits in the worst-case zstd frame of twice the target
+  size_t cap = ZSTD_compressBound(2 * target->len + COMPARE_CREATE_OVERHEAD);
+
+  int err = -1;
+
+  if (!compare_reserve(&state.patch, &state.patch_cap, cap) ||
+      !compare_reserve(&state.scratch, &state.scratch_cap, cap) ||
+      (state.output = malloc(target->len + 1)) == NULL) {
+    fprintf(stderr, "bench_compare: out of memory\n");
+    goto done;
+  }
+
+  for (int i = 0; i < ntools; i++) {
+    compare_result_t result;
+
+    if (compare_tool_run(options, &tools[i], &state, &result) != 0) {
+      fprintf(stderr, "bench_compare: %s failed on %s\n", tools[i].name, name);
+      goto done;
+    }
+
+    compare_print_result(name, &tools[i], &state, &result);
+
+    if (json) {
+      compare_json_result(json, name, &tools[i], &state, &result, *first);
+      *first = false;
+    }
+  }
+
+  err = 0;
+
+done:
+  compare_drop_contexts(&state);
+  free(state.patch);
+  free(state.scratch);
+  free(state.output);
+
+  return err;
+}
+
+static void
+compare_usage(void) {
+  fprintf(
+    stderr,
+    "usage: bench_compare [options] [<source> <target>]...\n"
+    "\n"
+    "  --warmup <n>         Untimed iterations per operation (default 1)\n"
+    "  --iterations <n>     Timed iterations per operation (default 5)\n"
+    "  --levels <n,...>     zstd levels to compare (default 1,3,9,19)\n"
+    "  --tool <name>        Tools to run, by name prefix, repeatable (default all)\n"
+    "  --corpus <kind>      Generated corpus to use, repeatable (default all)\n"
+    "  --versions <n>       Versions generated of each corpus (default 2)\n"
+    "  --size <bytes>       Size of their first version (default 1048576)\n"
+    "  --churn <rate>       Fraction of bytes changed per version (default 0.02)\n"
+    "  --seed <n>           Seed of the generator (default 1)\n"
+    "  --json <file>        Also write the results as JSON\n"
+  );
+}
+
+static int
+compare_parse_levels(compare_options_t *options, const char *value) {
+  options->nlevels = 0;
+
+  while (*value && options->nlevels < (int)(sizeof(options->levels) / sizeof(options->levels[0]))) {
+    char *end;
+    long level = strtol(value, &end, 10);
+
+    if (end == value || level < 1 || level > 22) return -1;
+
+    options->levels[options->nlevels++] = (int)level;
+    value = *end == ',' ? end + 1 : end;
+  }
+
+  return *value ? -1 : 0;
+}
+
+int
+main(int argc, char **argv) {
+  compare_options_t options = {
+    .warmup = 1,
+    .iterations = 5,
+    .size = 1024 * 1024,
+    .churn = 0.02,
+    .versions = 2,
+    .seed = 1,
+    .levels = {1, 3, 9, 19},
+    .nlevels = 4,
+    .json = NULL
+  };
+
+  int nknown = 0;
+  while (bench_corpus_kind(nknown)) nknown++;
+
+  const char **files = calloc(argc, sizeof(char *));
+  int nfiles = 0;
+
+  options.kinds = calloc(argc + nknown, sizeof(char *));
+  options.tools = calloc(argc, sizeof(char *));
+
+  if (files == NULL || options.kinds == NULL || options.tools == NULL) return 1;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+    if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+      compare_usage();
+      return 0;
+    }
+
+    if (strncmp(arg, "--", 2) != 0) {
+      files[nfiles++] = arg;
+      continue;
+    }
+
+    if (value == NULL) {
+      compare_usage();
+      return 1;
+    }
+
+    int err = 0;
+
+    if (strcmp(arg, "--warmup") == 0) options.warmup = atoi(value);
+    else if (strcmp(arg, "--iterations") == 0) options.iterations = atoi(value);
+    else if (strcmp(arg, "--levels") == 0) err = compare_parse_levels(&options, value);
+    else if (strcmp(arg, "--tool") == 0) options.tools[options.ntools++] = value;
+    else if (strcmp(arg, "--corpus") == 0) options.kinds[options.nkinds++] = value;
+    else if (strcmp(arg, "--versions") == 0) options.versions = atoi(value);
+    else if (strcmp(arg, "--size") == 0) options.size = strtoull(value, NULL, 10);
+    else if (strcmp(arg, "--churn") == 0) options.churn = atof(value);
+    else if (strcmp(arg, "--seed") == 0) options.seed = strtoull(value, NULL, 10);
+    else if (strcmp(arg, "--json") == 0) options.json = value;
+    else err = -1;
+
+    if (err != 0) {
+      compare_usage();
+      return 1;
+    }
+
+    i++;
+  }
+
+  if (nfiles % 2 != 0 || options.iterations < 1 || options.warmup < 0 || options.versions < 2) {
+    compare_usage();
+    return 1;
+  }
+
+  if (options.nkinds == 0) {
+    for (; options.nkinds < nknown; options.nkinds++) options.kinds[options.nkinds] = bench_corpus_kind(options.nkinds);
+  }
+
+  compare_tool_t tools[32];
+  int ntools = compare_tools(&options, tools);
+
+  FILE *json = NULL;
+
+  if (options.json) {
+    json = fopen(options.json, "w");
+
+    if (json == NULL) {
+      fprintf(stderr, "bench_compare: cannot write %s\n", options.json);
+      return 1;
+    }
+
+    fprintf(
+      json,
+      "{\n  \"warmup\": %d,\n  \"iterations\": %d,\n  \"size\": %zu,\n  \"churn\": %g,\n  \"seed\": %" PRIu64 ",\n  \"results\": [",
+      options.warmup, options.iterations, options.size, options.churn, options.seed
+    );
+  }
+
+  compare_print_header();
+
+  bool first = true;
+  int status = 0;
+
+  for (int i = 0; i < nfiles && status == 0; i += 2) {
+    bench_version_t pair[2] = {{NULL, 0}, {NULL, 0}};
+
+    pair[0].data = bench_read_file(files[i], &pair[0].len);
+    pair[1].data = bench_read_file(files[i + 1], &pair[1].len);
+
+    if (pair[0].data == NULL || pair[1].data == NULL) {
+      fprintf(stderr, "bench_compare: cannot read %s\n", pair[0].data == NULL ? files[i] : files[i + 1]);
+      status = 1;
+    } else if (compare_pair(&options, tools, ntools, files[i + 1], &pair[0], &pair[1], json, &first) != 0) {
+      status = 1;
+    }
+
+    free(pair[0].data);
+    free(pair[1].data);
+  }
+
+  for (int i = 0; i < options.nkinds && nfiles == 0 && status == 0; i++) {
+    bench_version_t *versions = calloc(options.versions, sizeof(bench_version_t));
+
+    if (versions == NULL || bench_corpus_generate(options.kinds[i], options.size, options.churn, options.seed, versions, options.versions) != 0) {
+      fprintf(stderr, "bench_compare: cannot generate %s\n", options.kinds[i]);
+      free(versions);
+      status = 1;
+      break;
+    }
+
+    for (int v = 1; v < options.versions && status == 0; v++) {
+      char name[256];
+      snprintf(name, sizeof(name), "%s v%d", options.kinds[i], v);
+
+      if (compare_pair(&options, tools, ntools, name, &versions[v - 1], &versions[v], json, &first) != 0) status = 1;
+    }
+
+    bench_corpus_release(versions, options.versions);
+    free(versions);
+  }
+
+  if (json) {
+    fprintf(json, "\n  ]\n}\n");
+    fclose(json);
+  }
+
+  free(options.tools);
+  free(options.kinds);
+  free(files);
+
+  return status;
+}
@@ -0,0 +1,154 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+#include "corpus.h"
+
+// Write the generated corpora to disk, one directory per kind holding
+// 0.bin, 1.bin, ... so tools outside this tree can be run on the same
+// versions as bench_delta.
+//
+//   bench_corpus [options] <directory>
+
+static int
+corpus_mkdir(const char *path) {
+#ifdef _WIN32
+  int err = mkdir(path);
+#else
+  int err = mkdir(path, 0777);
+#endif
+
+  return err == 0 || errno == EEXIST ? 0 : -1;
+}
+
+static int
+corpus_write(const char *path, const bench_version_t *version) {
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) return -1;
+
+  size_t written = fwrite(version->data, 1, version->len, file);
+
+  return fclose(file) == 0 && written == version->len ? 0 : -1;
+}
+
+static void
+corpus_usage(void) {
+  fprintf(
+    stderr,
+    "usage: bench_corpus [options] <directory>\n"
+    "\n"
+    "  --corpus <kind>      Corpus to write, repeatable (default all)\n"
+    "  --versions <n>       Versions of each corpus (default 2)\n"
+    "  --size <bytes>       Size of the first version (default 1048576)\n"
+    "  --churn <rate>       Fraction of bytes changed per version (default 0.02)\n"
+    "  --seed <n>           Seed of the generator (default 1)\n"
+    "\n"
+    "kinds:"
+  );
+
+  for (size_t i = 0; bench_corpus_kind(i); i++) fprintf(stderr, " %s", bench_corpus_kind(i));
+
+  fprintf(stderr, "\n");
+}
+
+int
+main(int argc, char **argv) {
+  int versions = 2;
+  size_t size = 1024 * 1024;
+  double churn = 0.02;
+  uint64_t seed = 1;
+  const char *dir = NULL;
+
+  const char **kinds = calloc(argc, sizeof(char *));
+  int nkinds = 0;
+
+  if (kinds == NULL) return 1;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+    if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+      corpus_usage();
+      return 0;
+    }
+
+    if (strncmp(arg, "--", 2) != 0) {
+      dir = arg;
+      continue;
+    }
+
+    if (value == NULL) {
+      corpus_usage();
+      return 1;
+    }
+
+    if (strcmp(arg, "--corpus") == 0) kinds[nkinds++] = value;
+    else if (strcmp(arg, "--versions") == 0) versions = atoi(value);
+    else if (strcmp(arg, "--size") == 0) size = strtoull(value, NULL, 10);
+    else if (strcmp(arg, "--churn") == 0) churn = atof(value);
+    else if (strcmp(arg, "--seed") == 0) seed = strtoull(value, NULL, 10);
+    else {
+      corpus_usage();
+      return 1;
+    }
+
+    i++;
+  }
+
+  if (dir == NULL || versions < 1) {
+    corpus_usage();
+    return 1;
+  }
+
+  if (corpus_mkdir(dir) != 0) {
+    fprintf(stderr, "bench_corpus: cannot create %s\n", dir);
+    return 1;
+  }
+
+  bench_version_t *generated = calloc(versions, sizeof(bench_version_t));
+  if (generated == NULL) return 1;
+
+  int status = 0;
+
+  for (size_t i = 0; status == 0; i++) {
+    const char *kind = nkinds > 0 ? (i < (size_t)nkinds ? kinds[i] : NULL) : bench_corpus_kind(i);
+    if (kind == NULL) break;
+
+    if (bench_corpus_generate(kind, size, churn, seed, generated, versions) != 0) {
+      fprintf(stderr, "bench_corpus: cannot generate %s\n", kind);
+      status = 1;
+      break;
+    }
+
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s", dir, kind);
+
+    if (corpus_mkdir(path) != 0) {
+      fprintf(stderr, "bench_corpus: cannot create %s\n", path);
+      status = 1;
+    }
+
+    for (int v = 0; v < versions && status == 0; v++) {
+      snprintf(path, sizeof(path), "%s/%s/%d.bin", dir, kind, v);
+
+      if (corpus_write(path, &generated[v]) != 0) {
+        fprintf(stderr, "bench_corpus: cannot write %s\n", path);
+        status = 1;
+      }
+    }
+
+    bench_corpus_release(generated, versions);
+  }
+
+  free(generated);
+  free(kinds);
+
+  return status;
+}
@@ -0,0 +1,523 @@
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zstd.h>
+
+#include <delta.h>
+
+#include "corpus.h"
+#include "harness.h"
+
+// Native benchmark of the delta engine.  Each kernel runs warmup
+// iterations, then the measured ones, timing every iteration on its own so
+// the report carries a distribution rather than a single sample.  Nothing
+// here goes through the binding, so the numbers are the engine alone.
+//
+//   bench_delta [options] [<source> <target>]...
+//
+// Without file pairs, every pair of consecutive versions of the generated
+// corpora in corpus.c is used.
+
+// Same defaults as the JavaScript API
+#define BENCH_NHASH_DEFAULT 16
+#define BENCH_SEARCH_LIMIT_DEFAULT 250
+#define BENCH_ZSTD_LEVEL_DEFAULT 1
+
+// Slack delta_create() needs past the target length
+#define BENCH_CREATE_OVERHEAD 1024
+
+typedef struct {
+  int warmup;
+  int iterations;
+  size_t size;
+  double churn;
+  int versions;
+  const char **kinds;
+  int nkinds;
+  uint64_t seed;
+  int nhash;
+  int search_limit;
+  int level;
+  bool perf;
+  const char *json;
+} bench_options_t;
+
+// A source and the target to create a delta to
+typedef struct {
+  char name[256];
+  const char *source;
+  size_t source_len;
+  const char *target;
+  size_t target_len;
+} bench_pair_t;
+
+// Buffers shared by the kernels of one pair
+typedef struct {
+  const bench_options_t *options;
+  const bench_pair_t *pair;
+  char *delta;
+  int delta_len;
+  char *packed;
+  size_t packed_len;
+  size_t packed_bound;
+  char *scratch;
+  char *output;
+  ZSTD_CCtx *cctx;
+  ZSTD_DCtx *dctx;
+} bench_state_t;
+
+typedef int (*bench_kernel_fn)(bench_state_t *state);
+
+typedef struct {
+  const char *kernel;
+  size_t bytes;
+  size_t output;
+  bench_summary_t summary;
+  bool has_counters;
+  bench_counters_t counters; // Means per iteration
+} bench_result_t;
+
+// Kernels
+
+static int
+bench_kernel_create(bench_state_t *state) {
+  const bench_pair_t *pair = state->pair;
+
+  state->delta_len = delta_create_with_options(
+    pair->source, pair->source_len,
+    pair->target, pair->target_len,
+    state->delta,
+    state->options->nhash, state->options->search_limit, NULL
+  );
+
+  return state->delta_len < 0 ? -1 : 0;
+}
+
+static int
+bench_kernel_apply(bench_state_t *state) {
+  const bench_pair_t *pair = state->pair;
+
+  int len = delta_apply(pair->source, pair->source_len, state->delta, state->delta_len, state->output);
+
+  return len == (int)pair->target_len ? 0 : -1;
+}
+
+// create with { compressed: 'zstd' }: delta, then compress it
+static int
+bench_kernel_create_zstd(bench_state_t *state) {
+  if (bench_kernel_create(state) != 0) return -1;
+
+  size_t len = ZSTD_compressCCtx(
+    state->cctx, state->packed, state->packed_bound,
+    state->delta, state->delta_len, state->options->level
+  );
+
+  if (ZSTD_isError(len)) return -1;
+
+  state->packed_len = len;
+  return 0;
+}
+
+// apply of a zstd delta: decompress, then apply
+static int
+bench_kernel_apply_zstd(bench_state_t *state) {
+  const bench_pair_t *pair = state->pair;
+
+  size_t len = ZSTD_decompressDCtx(
+    state->dctx, state->scratch, (size_t)state->delta_len,
+    state->packed, state->packed_len
+  );
+
+  if (ZSTD_isError(len)) return -1;
+
+  int out = delta_apply(pair->source, pair->source_len, state->scratch, len, state->output);
+
+  return out == (int)pair->target_len ? 0 : -1;
+}
+
+static int
+bench_run(bench_state_t *state, const char *kernel, bench_kernel_fn fn, size_t bytes, bool perf, bench_result_t *result) {
+  const bench_options_t *options = state->options;
+
+  for (int i = 0; i < options->warmup; i++) {
+    if (fn(state) != 0) return -1;
+  }
+
+  uint64_t *samples = malloc(sizeof(uint64_t) * options->iterations);
+  if (samples == NULL) return -1;
+
+  bench_counters_t counters = {0, 0, 0};
+  bool counted = perf;
+
+  for (int i = 0; i < options->iterations; i++) {
+    if (counted) bench_perf_start();
+
+    uint64_t start = bench_now();
+    int err = fn(state);
+    samples[i] = bench_now() - start;
+
+    if (counted && !bench_perf_stop(&counters)) counted = false;
+
+    if (err != 0) {
+      free(samples);
+      return -1;
+    }
+  }
+
+  bench_summarize(samples, options->iterations, &result->summary);
+
+  result->kernel = kernel;
+  result->bytes = bytes;
+  result->has_counters = counted;
+
+  if (counted) {
+    result->counters.cycles = counters.cycles / options->iterations;
+    result->counters.cache_misses = counters.cache_misses / options->iterations;
+    result->counters.branch_misses = counters.branch_misses / options->iterations;
+  }
+
+  free(samples);
+  return 0;
+}
+
+// Reporting
+
+// Where the human-readable table goes
+static FILE *bench_table;
+
+static double
+bench_throughput(const bench_result_t *result) {
+  if (result->summary.median_ns == 0) return 0;
+  return (double)result->bytes / (1024.0 * 1024.0) / ((double)result->summary.median_ns / 1e9);
+}
+
+static void
+bench_print_header(bool perf) {
+  fprintf(bench_table, "%-28s %-11s %9s %9s %9s %10s", "corpus", "kernel", "median", "p99", "output", "MB/s");
+  if (perf) fprintf(bench_table, " %11s %12s %13s", "cycles/byte", "cache-misses", "branch-misses");
+  fprintf(bench_table, "\n");
+}
+
+static void
+bench_print_result(const bench_pair_t *pair, const bench_result_t *result, bool perf) {
+  fprintf(
+    bench_table,
+    "%-28.28s %-11s %7.3fms %7.3fms %9zu %10.1f",
+    pair->name, result->kernel,
+    result->summary.median_ns / 1e6, result->summary.p99_ns / 1e6,
+    result->output, bench_throughput(result)
+  );
+
+  if (perf) {
+    if (result->has_counters) {
+      fprintf(
+        bench_table,
+        " %11.2f %12" PRIu64 " %13" PRIu64,
+        result->bytes > 0 ? (double)result->counters.cycles / result->bytes : 0.0,
+        result->counters.cache_misses, result->counters.branch_misses
+      );
+    } else {
+      fprintf(bench_table, " %11s %12s %13s", "-", "-", "-");
+    }
+  }
+
+  fprintf(bench_table, "\n");
+}
+
+static void
+bench_json_result(FILE *out, const bench_pair_t *pair, const bench_result_t *result, bool first) {
+  fprintf(out, "%s\n    {\"corpus\": ", first ? "" : ",");
+  bench_json_string(out, pair->name);
+  fprintf(out, ", \"kernel\": ");
+  bench_json_string(out, result->kernel);
+  fprintf(
+    out,
+    ", \"sourceLength\": %zu, \"targetLength\": %zu, \"bytes\": %zu, \"output\": %zu"
+    ", \"medianNs\": %" PRIu64 ", \"p99Ns\": %" PRIu64 ", \"minNs\": %" PRIu64 ", \"maxNs\": %" PRIu64
+    ", \"meanNs\": %.1f, \"mbPerSecond\": %.3f",
+    pair->source_len, pair->target_len, result->bytes, result->output,
+    result->summary.median_ns, result->summary.p99_ns, result->summary.min_ns, result->summary.max_ns,
+    result->summary.mean_ns, bench_throughput(result)
+  );
+
+  if (result->has_counters) {
+    fprintf(
+      out,
+      ", \"cycles\": %" PRIu64 ", \"cacheMisses\": %" PRIu64 ", \"branchMisses\": %" PRIu64,
+      result->counters.cycles, result->counters.cache_misses, result->counters.branch_misses
+    );
+  } else {
+    fprintf(out, ", \"cycles\": null, \"cacheMisses\": null, \"branchMisses\": null");
+  }
+
+  fprintf(out, "}");
+}
+
+// Benchmark every kernel over one pair, checking first that the delta
+// round-trips
+static int
+bench_pair(const bench_options_t *options, const bench_pair_t *pair, FILE *json, bool *first) {
+  int err = -1;
+
+  bench_state_t state;
+  memset(&state, 0, sizeof(state));
+
+  state.options = options;
+  state.pair = pair;
+  state.delta = malloc(pair->target_len + BENCH_CREATE_OVERHEAD);
+  state.packed_bound = ZSTD_compressBound(pair->target_len + BENCH_CREATE_OVERHEAD);
+  state.packed = malloc(state.packed_bound);
+  state.scratch = malloc(pair->target_len + BENCH_CREATE_OVERHEAD);
+  state.output = malloc(pair->target_len + 1);
+  state.cctx = ZSTD_createCCtx();
+  state.dctx = ZSTD_createDCtx();
+
+  if (!state.delta || !state.packed || !state.scratch || !state.output || !state.cctx || !state.dctx) {
+    fprintf(stderr, "bench_delta: out of memory\n");
+    goto done;
+  }
+
+  if (bench_kernel_create_zstd(&state) != 0 || bench_kernel_apply_zstd(&state) != 0 ||
+      memcmp(state.output, pair->target, pair->target_len) != 0) {
+    fprintf(stderr, "bench_delta: %s does not round-trip\n", pair->name);
+    goto done;
+  }
+
+  static const struct {
+    const char *name;
+    bench_kernel_fn fn;
+  } kernels[] = {
+    {"create", bench_kernel_create},
+    {"apply", bench_kernel_apply},
+    {"create-zstd", bench_kernel_create_zstd},
+    {"apply-zstd", bench_kernel_apply_zstd}
+  };
+
+  for (size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++) {
+    bench_result_t result;
+    memset(&result, 0, sizeof(result));
+
+    if (bench_run(&state, kernels[i].name, kernels[i].fn, pair->target_len, options->perf, &result) != 0) {
+      fprintf(stderr, "bench_delta: %s failed on %s\n", kernels[i].name, pair->name);
+      goto done;
+    }
+
+    // Create kernels report the delta they produce, apply kernels the one
+    // they consume
+    result.output = strstr(kernels[i].name, "zstd") ? state.packed_len : (size_t)state.delta_len;
+
+    bench_print_result(pair, &result, options->perf);
+
+    if (json) {
+      bench_json_result(json, pair, &result, *first);
+      *first = false;
+    }
+  }
+
+  err = 0;
+
+done:
+  if (state.cctx) ZSTD_freeCCtx(state.cctx);
+  if (state.dctx) ZSTD_freeDCtx(state.dctx);
+  free(state.delta);
+  free(state.packed);
+  free(state.scratch);
+  free(state.output);
+
+  return err;
+}
+
+static void
+bench_usage(void) {
+  fprintf(
+    stderr,
+    "usage: bench_delta [options] [<source> <target>]...\n"
+    "\n"
+    "  --warmup <n>         Untimed iterations per kernel (default 3)\n"
+    "  --iterations <n>     Timed iterations per kernel (default 20)\n"
+    "  --corpus <kind>      Generated corpus to use, repeatable (default all)\n"
+    "  --versions <n>       Versions generated of each corpus (default 2)\n"
+    "  --size <bytes>       Size of their first version (default 1048576)\n"
+    "  --churn <rate>       Fraction of bytes changed per version (default 0.02)\n"
+    "  --seed <n>           Seed of the generator (default 1)\n"
+    "  --hash-window <n>    Hash window size (default 16)\n"
+    "  --search-limit <n>   Search depth (default 250)\n"
+    "  --level <n>          zstd level of the compressed kernels (default 1)\n"
+    "  --json <file>        Also write the results as JSON, - for stdout\n"
+    "  --no-perf            Do not read hardware counters\n"
+  );
+}
+
+int
+main(int argc, char **argv) {
+  bench_options_t options = {
+    .warmup = 3,
+    .iterations = 20,
+    .size = 1024 * 1024,
+    .churn = 0.02,
+    .versions = 2,
+    .seed = 1,
+    .nhash = BENCH_NHASH_DEFAULT,
+    .search_limit = BENCH_SEARCH_LIMIT_DEFAULT,
+    .level = BENCH_ZSTD_LEVEL_DEFAULT,
+    .perf = true,
+    .json = NULL
+  };
+
+  const char **files = calloc(argc, sizeof(char *));
+  int nfiles = 0;
+
+  int nknown = 0;
+  while (bench_corpus_kind(nknown)) nknown++;
+
+  // Room for every --corpus given, or else every kind there is
+  options.kinds = calloc(argc + nknown, sizeof(char *));
+
+  if (files == NULL || options.kinds == NULL) return 1;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+    if (strcmp(arg, "--no-perf") == 0) {
+      options.perf = false;
+      continue;
+    }
+
+    if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+      bench_usage();
+      return 0;
+    }
+
+    if (strncmp(arg, "--", 2) != 0) {
+      files[nfiles++] = arg;
+      continue;
+    }
+
+    if (value == NULL) {
+      bench_usage();
+      return 1;
+    }
+
+    if (strcmp(arg, "--warmup") == 0) options.warmup = atoi(value);
+    else if (strcmp(arg, "--iterations") == 0) options.iterations = atoi(value);
+    else if (strcmp(arg, "--size") == 0) options.size = strtoull(value, NULL, 10);
+    else if (strcmp(arg, "--corpus") == 0) options.kinds[options.nkinds++] = value;
+    else if (strcmp(arg, "--versions") == 0) options.versions = atoi(value);
+    else if (strcmp(arg, "--churn") == 0) options.churn = atof(value);
+    else if (strcmp(arg, "--seed") == 0) options.seed = strtoull(value, NULL, 10);
+    else if (strcmp(arg, "--hash-window") == 0) options.nhash = atoi(value);
+    else if (strcmp(arg, "--search-limit") == 0) options.search_limit = atoi(value);
+    else if (strcmp(arg, "--level") == 0) options.level = atoi(value);
+    else if (strcmp(arg, "--json") == 0) options.json = value;
+    else {
+      bench_usage();
+      return 1;
+    }
+
+    i++;
+  }
+
+  if (nfiles % 2 != 0 || options.iterations < 1 || options.warmup < 0 || options.versions < 2 ||
+      options.nhash < 1 || (options.nhash & (options.nhash - 1)) != 0) {
+    bench_usage();
+    return 1;
+  }
+
+  if (options.perf) options.perf = bench_perf_open();
+
+  bench_table = stdout;
+
+  FILE *json = NULL;
+
+  if (options.json) {
+    json = strcmp(options.json, "-") == 0 ? stdout : fopen(options.json, "w");
+
+    if (json == NULL) {
+      fprintf(stderr, "bench_delta: cannot write %s\n", options.json);
+      return 1;
+    }
+
+    fprintf(
+      json,
+      "{\n  \"warmup\": %d,\n  \"iterations\": %d,\n  \"hashWindowSize\": %d,\n  \"searchLimit\": %d,\n  \"level\": %d,\n"
+      "  \"size\": %zu,\n  \"churn\": %g,\n  \"seed\": %" PRIu64 ",\n  \"results\": [",
+      options.warmup, options.iterations, options.nhash, options.search_limit, options.level,
+      options.size, options.churn, options.seed
+    );
+  }
+
+  // Keep the table off stdout when the JSON goes there
+  if (json == stdout) bench_table = stderr;
+
+  bench_print_header(options.perf);
+
+  if (options.nkinds == 0) {
+    for (; options.nkinds < nknown; options.nkinds++) options.kinds[options.nkinds] = bench_corpus_kind(options.nkinds);
+  }
+
+  bool first = true;
+  int status = 0;
+
+  for (int i = 0; i < nfiles && status == 0; i += 2) {
+    bench_pair_t pair;
+    snprintf(pair.name, sizeof(pair.name), "%s", files[i + 1]);
+
+    char *source = bench_read_file(files[i], &pair.source_len);
+    char *target = bench_read_file(files[i + 1], &pair.target_len);
+
+    if (source == NULL || target == NULL) {
+      fprintf(stderr, "bench_delta: cannot read %s\n", source == NULL ? files[i] : files[i + 1]);
+      status = 1;
+    } else {
+      pair.source = source;
+      pair.target = target;
+
+      if (bench_pair(&options, &pair, json, &first) != 0) status = 1;
+    }
+
+    free(source);
+    free(target);
+  }
+
+  for (int i = 0; i < options.nkinds && nfiles == 0 && status == 0; i++) {
+    bench_version_t *versions = calloc(options.versions, sizeof(bench_version_t));
+
+    if (versions == NULL || bench_corpus_generate(options.kinds[i], options.size, options.churn, options.seed, versions, options.versions) != 0) {
+      fprintf(stderr, "bench_delta: cannot generate %s\n", options.kinds[i]);
+      free(versions);
+      status = 1;
+      break;
+    }
+
+    for (int v = 1; v < options.versions && status == 0; v++) {
+      bench_pair_t pair = {
+        .source = versions[v - 1].data,
+        .source_len = versions[v - 1].len,
+        .target = versions[v].data,
+        .target_len = versions[v].len
+      };
+
+      snprintf(pair.name, sizeof(pair.name), "%s v%d", options.kinds[i], v);
+
+      if (bench_pair(&options, &pair, json, &first) != 0) status = 1;
+    }
+
+    bench_corpus_release(versions, options.versions);
+    free(versions);
+  }
+
+  if (json) {
+    fprintf(json, "\n  ]\n}\n");
+    if (json != stdout) fclose(json);
+  }
+
+  bench_perf_close();
+  free(options.kinds);
+  free(files);
+
+  return status;
+}
@@ -0,0 +1,643 @@
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "corpus.h"
+#include "harness.h"
+
+// The engine is compiled into this file so its static kernels can be
+// called on their own
+#include "../delta.c"
+
+// Microbenchmarks of the engine's inner kernels: the rolling hash, match
+// extension, the checksum, the compact integer wrappers and the op loop of
+// delta_apply().  Inputs come from a fixed seed, so two runs time the same
+// work, and every kernel reports its cost per byte or per op.
+//
+//   bench_kernels [options]
+
+#define KERNEL_NHASH_DEFAULT 16
+
+typedef struct {
+  int warmup;
+  int iterations;
+  size_t size;
+  uint64_t seed;
+  int nhash;
+  const char *filter;
+  bool perf;
+  const char *json;
+} kernel_options_t;
+
+typedef struct kernel_case_s kernel_case_t;
+
+// One pass of a kernel over its inputs.  The result is folded into a sink
+// so the compiler cannot drop the work.
+typedef uint64_t (*kernel_fn)(const kernel_case_t *c);
+
+struct kernel_case_s {
+  const char *kernel;
+  char variant[32];
+  const char *unit;  // "byte" or "op"
+  size_t units;      // Bytes or ops of one pass
+  kernel_fn fn;
+  char *a;
+  char *b;
+  size_t len;
+  int param;
+  uint32_t *values;
+  char *out;
+};
+
+typedef struct {
+  bench_summary_t summary;
+  bool has_counters;
+  bench_counters_t counters; // Means per pass
+} kernel_result_t;
+
+static volatile uint64_t kernel_sink;
+
+// Kernels
+
+// Hash every block of the source, as the index is built
+static uint64_t
+kernel_hash_once(const kernel_case_t *c) {
+  uint64_t sink = 0;
+
+  for (size_t i = 0; i + c->param <= c->len; i += c->param) sink += hash_once(c->a + i, c->param);
+
+  return sink;
+}
+
+// Roll the hash over every byte, as the target is scanned
+static uint64_t
+kernel_hash_next(const kernel_case_t *c) {
+  hash h;
+  uint64_t sink = 0;
+
+  if (!hash_alloc(&h, c->param)) return 0;
+
+  hash_init(&h, c->a, c->param);
+
+  for (size_t i = c->param; i < c->len; i++) {
+    hash_next(&h, c->a[i]);
+    sink += hash_32bit(&h);
+  }
+
+  hash_free(&h);
+  return sink;
+}
+
+// b differs from a every param + 1 bytes, so each call matches param bytes
+static uint64_t
+kernel_match_forward(const kernel_case_t *c) {
+  uint64_t sink = 0;
+  size_t step = c->param + 1;
+
+  for (size_t i = 1; i + c->param < c->len; i += step) {
+    sink += match_forward(c->a + i, c->b + i, (int)(c->len - i));
+  }
+
+  return sink;
+}
+
+static uint64_t
+kernel_match_backward(const kernel_case_t *c) {
+  uint64_t sink = 0;
+  size_t step = c->param + 1;
+
+  for (size_t i = step; i < c->len; i += step) {
+    sink += match_backward(c->a + i, c->b + i, (int)i);
+  }
+
+  return sink;
+}
+
+static uint64_t
+kernel_checksum(const kernel_case_t *c) {
+  return checksum(c->a, c->len);
+}
+
+static uint64_t
+kernel_checksum_update(const kernel_case_t *c) {
+  return checksum_update(0, 0, c->a, c->len);
+}
+
+static uint64_t
+kernel_put_int(const kernel_case_t *c) {
+  char *z = c->out;
+
+  for (size_t i = 0; i < c->units; i++) putInt(c->values[i], &z);
+
+  return (uint64_t)(z - c->out);
+}
+
+static uint64_t
+kernel_get_int(const kernel_case_t *c) {
+  const char *z = c->b;
+  size_t len = c->len;
+  uint64_t sink = 0;
+
+  for (size_t i = 0; i < c->units; i++) sink += getInt(&z, &len);
+
+  return sink;
+}
+
+// The op loop alone, without the stats and cancellation wrappers
+static uint64_t
+kernel_apply(const kernel_case_t *c) {
+  return (uint64_t)delta_apply_int(c->a, c->len, c->b, (size_t)c->param, c->out, NULL, NULL);
+}
+
+// Inputs
+
+static char *
+kernel_random_bytes(uint64_t *state, size_t len) {
+  char *data = malloc(len > 0 ? len : 1);
+  if (data == NULL) return NULL;
+
+  for (size_t i = 0; i < len; i++) data[i] = (char)(bench_corpus_random(state) >> 56);
+
+  return data;
+}
+
+// Values of a compact integer mix.  small fits in 1 byte, medium in 3 and
+// large in 5; mixed is weighted like the counts and offsets of real deltas.
+static uint32_t
+kernel_int_value(uint64_t *state, const char *mix) {
+  uint64_t r = bench_corpus_random(state);
+
+  int width = 0;
+
+  if (strcmp(mix, "small") == 0) width = 1;
+  else if (strcmp(mix, "medium") == 0) width = 3;
+  else if (strcmp(mix, "large") == 0) width = 5;
+  else width = r % 10 < 7 ? 1 : r % 10 < 9 ? 3 : 5;
+
+  r >>= 8;
+
+  // UINT32_MAX is the error value of getInt(), so leave it out
+  if (width == 1) return (uint32_t)(r % 0xfd);
+  if (width == 3) return 0xfd + (uint32_t)(r % (0x10000 - 0xfd));
+  return 0x10000 + (uint32_t)(r % (UINT32_MAX - 0x10000));
+}
+
+// Lengths of the next insert and copy of an op mix; 0 leaves the op out
+static void
+kernel_op_lengths(uint64_t *state, const char *mix, size_t *insert, size_t *copy) {
+  *insert = 0;
+  *copy = 0;
+
+  if (strcmp(mix, "copy-16") == 0) *copy = 16;
+  else if (strcmp(mix, "copy-256") == 0) *copy = 256;
+  else if (strcmp(mix, "copy-4096") == 0) *copy = 4096;
+  else if (strcmp(mix, "insert-16") == 0) *insert = 16;
+  else {
+    uint64_t r = bench_corpus_random(state);
+    *insert = 1 + r % 32;
+    *copy = 16 + (r >> 8) % 497;
+  }
+}
+
+// Build a delta of the op mix that turns the source c->a into a target of
+// the same length, and the target itself in c->out
+static int
+kernel_apply_setup(kernel_case_t *c, uint64_t *state, const char *mix) {
+  size_t len = c->len;
+
+  c->b = malloc(2 * len + 64);
+  c->out = malloc(len + 1);
+
+  if (c->b == NULL || c->out == NULL) return -1;
+
+  char *z = c->b;
+  size_t total = 0;
+
+  c->units = 0;
+
+  putInt((uint32_t)len, &z);
+
+  while (total < len) {
+    size_t insert, copy;
+    kernel_op_lengths(state, mix, &insert, &copy);
+
+    if (insert > len - total) insert = len - total;
+
+    if (insert > 0) {
+      putInt((uint32_t)insert, &z);
+      *(z++) = ':';
+
+      for (size_t i = 0; i < insert; i++) {
+        c->out[total + i] = (char)(bench_corpus_random(state) >> 56);
+      }
+
+      memcpy(z, c->out + total, insert);
+      z += insert;
+      total += insert;
+      c->units++;
+    }
+
+    if (copy > len - total) copy = len - total;
+
+    if (copy > 0) {
+      size_t offset = bench_corpus_random(state) % (len - copy + 1);
+
+      putInt((uint32_t)copy, &z);
+      *(z++) = '@';
+      putInt((uint32_t)offset, &z);
+      *(z++) = ',';
+
+      memcpy(c->out + total, c->a + offset, copy);
+      total += copy;
+      c->units++;
+    }
+  }
+
+  putInt(checksum(c->out, len), &z);
+  *(z++) = ';';
+
+  c->param = (int)(z - c->b);
+
+  return delta_apply_int(c->a, len, c->b, (size_t)c->param, c->out, NULL, NULL) == (int)len ? 0 : -1;
+}
+
+static void
+kernel_case_free(kernel_case_t *c) {
+  free(c->a);
+  free(c->b);
+  free(c->values);
+  free(c->out);
+}
+
+// Build the named case.  Every case draws its inputs from its own copy of
+// the seed, so filtering cases does not change the others.
+static int
+kernel_case_init(kernel_case_t *c, const kernel_options_t *options, const char *kernel, const char *variant) {
+  memset(c, 0, sizeof(*c));
+
+  uint64_t state = options->seed ? options->seed : 1;
+
+  c->kernel = kernel;
+  c->unit = "byte";
+  c->len = options->size;
+  snprintf(c->variant, sizeof(c->variant), "%s", variant);
+
+  c->a = kernel_random_bytes(&state, c->len);
+  if (c->a == NULL) return -1;
+
+  if (strcmp(kernel, "hash_once") == 0 || strcmp(kernel, "hash_next") == 0) {
+    c->param = options->nhash;
+    snprintf(c->variant, sizeof(c->variant), "nhash=%d", options->nhash);
+
+    if (c->len < (size_t)c->param) return -1;
+
+    if (kernel[5] == 'o') {
+      c->fn = kernel_hash_once;
+      c->units = c->len / c->param * c->param;
+    } else {
+      c->fn = kernel_hash_next;
+      c->units = c->len - c->param;
+    }
+
+    return 0;
+  }
+
+  if (strcmp(kernel, "match_forward") == 0 || strcmp(kernel, "match_backward") == 0) {
+    c->param = atoi(variant);
+    snprintf(c->variant, sizeof(c->variant), "len=%d", c->param);
+
+    size_t step = c->param + 1;
+
+    c->b = malloc(c->len);
+    if (c->b == NULL) return -1;
+
+    memcpy(c->b, c->a, c->len);
+
+    for (size_t i = 0; i < c->len; i += step) c->b[i] = c->a[i] ^ 0x5a;
+
+    c->fn = kernel[6] == 'f' ? kernel_match_forward : kernel_match_backward;
+    c->units = c->len > step ? (c->len - 1) / step * c->param : 0;
+
+    return 0;
+  }
+
+  if (strcmp(kernel, "checksum") == 0) {
+    c->fn = kernel_checksum;
+    c->units = c->len;
+    return 0;
+  }
+
+  if (strcmp(kernel, "checksum_update") == 0) {
+    c->fn = kernel_checksum_update;
+    c->units = c->len;
+    return 0;
+  }
+
+  if (strcmp(kernel, "putInt") == 0 || strcmp(kernel, "getInt") == 0) {
+    c->unit = "op";
+    c->units = c->len / 16 > 0 ? c->len / 16 : 1;
+    c->values = malloc(c->units * sizeof(uint32_t));
+    c->out = malloc(c->units * 5);
+
+    if (c->values == NULL || c->out == NULL) return -1;
+
+    for (size_t i = 0; i < c->units; i++) c->values[i] = kernel_int_value(&state, variant);
+
+    if (kernel[0] == 'p') {
+      c->fn = kernel_put_int;
+      return 0;
+    }
+
+    // Decode what putInt() wrote
+    c->len = (size_t)kernel_put_int(c);
+    c->b = c->out;
+    c->out = NULL;
+    c->fn = kernel_get_int;
+
+    uint64_t expected = 0;
+    for (size_t i = 0; i < c->units; i++) expected += c->values[i];
+
+    return kernel_get_int(c) == expected ? 0 : -1;
+  }
+
+  if (strcmp(kernel, "apply") == 0) {
+    c->unit = "op";
+    c->fn = kernel_apply;
+    return kernel_apply_setup(c, &state, variant);
+  }
+
+  return -1;
+}
+
+static int
+kernel_run(const kernel_options_t *options, const kernel_case_t *c, bool perf, kernel_result_t *result) {
+  for (int i = 0; i < options->warmup; i++) kernel_sink += c->fn(c);
+
+  uint64_t *samples = malloc(sizeof(uint64_t) * options->iterations);
+  if (samples == NULL) return -1;
+
+  bench_counters_t counters = {0, 0, 0};
+  bool counted = perf;
+
+  for (int i = 0; i < options->iterations; i++) {
+    if (counted) bench_perf_start();
+
+    uint64_t start = bench_now();
+    kernel_sink += c->fn(c);
+    samples[i] = bench_now() - start;
+
+    if (counted && !bench_perf_stop(&counters)) counted = false;
+  }
+
+  bench_summarize(samples, options->iterations, &result->summary);
+
+  result->has_counters = counted;
+
+  if (counted) {
+    result->counters.cycles = counters.cycles / options->iterations;
+    result->counters.cache_misses = counters.cache_misses / options->iterations;
+    result->counters.branch_misses = counters.branch_misses / options->iterations;
+  }
+
+  free(samples);
+  return 0;
+}
+
+// Reporting
+
+static FILE *kernel_table;
+
+static double
+kernel_per_unit(const kernel_case_t *c, double value) {
+  return c->units > 0 ? value / c->units : 0;
+}
+
+static void
+kernel_print_header(bool perf) {
+  fprintf(kernel_table, "%-16s %-12s %-5s %10s %10s %10s", "kernel", "variant", "unit", "median", "ns/unit", "Munit/s");
+  if (perf) fprintf(kernel_table, " %11s %13s", "cycles/unit", "branch-misses");
+  fprintf(kernel_table, "\n");
+}
+
+static void
+kernel_print_result(const kernel_case_t *c, const kernel_result_t *result, bool perf) {
+  double ns = kernel_per_unit(c, (double)result->summary.median_ns);
+
+  fprintf(
+    kernel_table,
+    "%-16s %-12s %-5s %8.3fms %10.3f %10.1f",
+    c->kernel, c->variant, c->unit,
+    result->summary.median_ns / 1e6, ns, ns > 0 ? 1e3 / ns : 0.0
+  );
+
+  if (perf) {
+    if (result->has_counters) {
+      fprintf(
+        kernel_table,
+        " %11.3f %13" PRIu64,
+        kernel_per_unit(c, (double)result->counters.cycles), result->counters.branch_misses
+      );
+    } else {
+      fprintf(kernel_table, " %11s %13s", "-", "-");
+    }
+  }
+
+  fprintf(kernel_table, "\n");
+}
+
+static void
+kernel_json_result(FILE *out, const kernel_case_t *c, const kernel_result_t *result, bool first) {
+  fprintf(out, "%s\n    {\"kernel\": ", first ? "" : ",");
+  bench_json_string(out, c->kernel);
+  fprintf(out, ", \"variant\": ");
+  bench_json_string(out, c->variant);
+  fprintf(out, ", \"unit\": ");
+  bench_json_string(out, c->unit);
+  fprintf(
+    out,
+    ", \"units\": %zu, \"medianNs\": %" PRIu64 ", \"p99Ns\": %" PRIu64 ", \"minNs\": %" PRIu64 ", \"maxNs\": %" PRIu64
+    ", \"meanNs\": %.1f, \"nsPerUnit\": %.4f",
+    c->units, result->summary.median_ns, result->summary.p99_ns, result->summary.min_ns, result->summary.max_ns,
+    result->summary.mean_ns, kernel_per_unit(c, (double)result->summary.median_ns)
+  );
+
+  if (result->has_counters) {
+    fprintf(
+      out,
+      ", \"cycles\": %" PRIu64 ", \"cyclesPerUnit\": %.4f, \"cacheMisses\": %" PRIu64 ", \"branchMisses\": %" PRIu64,
+      result->counters.cycles, kernel_per_unit(c, (double)result->counters.cycles),
+      result->counters.cache_misses, result->counters.branch_misses
+    );
+  } else {
+    fprintf(out, ", \"cycles\": null, \"cyclesPerUnit\": null, \"cacheMisses\": null, \"branchMisses\": null");
+  }
+
+  fprintf(out, "}");
+}
+
+static void
+kernel_usage(void) {
+  fprintf(
+    stderr,
+    "usage: bench_kernels [options]\n"
+    "\n"
+    "  --warmup <n>         Untimed passes per kernel (default 3)\n"
+    "  --iterations <n>     Timed passes per kernel (default 20)\n"
+    "  --size <bytes>       Input size of each pass (default 1048576)\n"
+    "  --seed <n>           Seed of the inputs (default 1)\n"
+    "  --hash-window <n>    Hash window size (default 16)\n"
+    "  --kernel <prefix>    Only run kernels whose name starts with prefix\n"
+    "  --json <file>        Also write the results as JSON, - for stdout\n"
+    "  --no-perf            Do not read hardware counters\n"
+  );
+}
+
+int
+main(int argc, char **argv) {
+  kernel_options_t options = {
+    .warmup = 3,
+    .iterations = 20,
+    .size = 1024 * 1024,
+    .seed = 1,
+    .nhash = KERNEL_NHASH_DEFAULT,
+    .filter = NULL,
+    .perf = true,
+    .json = NULL
+  };
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+    if (strcmp(arg, "--no-perf") == 0) {
+      options.perf = false;
+      continue;
+    }
+
+    if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+      kernel_usage();
+      return 0;
+    }
+
+    if (value == NULL) {
+      kernel_usage();
+      return 1;
+    }
+
+    if (strcmp(arg, "--warmup") == 0) options.warmup = atoi(value);
+    else if (strcmp(arg, "--iterations") == 0) options.iterations = atoi(value);
+    else if (strcmp(arg, "--size") == 0) options.size = strtoull(value, NULL, 10);
+    else if (strcmp(arg, "--seed") == 0) options.seed = strtoull(value, NULL, 10);
+    else if (strcmp(arg, "--hash-window") == 0) options.nhash = atoi(value);
+    else if (strcmp(arg, "--kernel") == 0) options.filter = value;
+    else if (strcmp(arg, "--json") == 0) options.json = value;
+    else {
+      kernel_usage();
+      return 1;
+    }
+
+    i++;
+  }
+
+  if (options.iterations < 1 || options.warmup < 0 || options.size < 4096 || options.size > INT32_MAX ||
+      options.nhash < 1 || (options.nhash & (options.nhash - 1)) != 0) {
+    kernel_usage();
+    return 1;
+  }
+
+  static const struct {
+    const char *kernel;
+    const char *variant;
+  } cases[] = {
+    {"hash_once", ""},
+    {"hash_next", ""},
+    {"match_forward", "16"},
+    {"match_forward", "64"},
+    {"match_forward", "256"},
+    {"match_forward", "4096"},
+    {"match_backward", "16"},
+    {"match_backward", "64"},
+    {"match_backward", "256"},
+    {"match_backward", "4096"},
+    {"checksum", ""},
+    {"checksum_update", ""},
+    {"putInt", "small"},
+    {"putInt", "medium"},
+    {"putInt", "large"},
+    {"putInt", "mixed"},
+    {"getInt", "small"},
+    {"getInt", "medium"},
+    {"getInt", "large"},
+    {"getInt", "mixed"},
+    {"apply", "copy-16"},
+    {"apply", "copy-256"},
+    {"apply", "copy-4096"},
+    {"apply", "insert-16"},
+    {"apply", "mixed"}
+  };
+
+  if (options.perf) options.perf = bench_perf_open();
+
+  kernel_table = stdout;
+
+  FILE *json = NULL;
+
+  if (options.json) {
+    json = strcmp(options.json, "-") == 0 ? stdout : fopen(options.json, "w");
+
+    if (json == NULL) {
+      fprintf(stderr, "bench_kernels: cannot write %s\n", options.json);
+      return 1;
+    }
+
+    fprintf(
+      json,
+      "{\n  \"warmup\": %d,\n  \"iterations\": %d,\n  \"size\": %zu,\n  \"seed\": %" PRIu64 ",\n"
+      "  \"hashWindowSize\": %d,\n  \"results\": [",
+      options.warmup, options.iterations, options.size, options.seed, options.nhash
+    );
+  }
+
+  // Keep the table off stdout when the JSON goes there
+  if (json == stdout) kernel_table = stderr;
+
+  kernel_print_header(options.perf);
+
+  int status = 0;
+  bool first = true;
+
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]) && status == 0; i++) {
+    if (options.filter && strncmp(cases[i].kernel, options.filter, strlen(options.filter)) != 0) continue;
+
+    kernel_case_t c;
+    kernel_result_t result;
+    memset(&result, 0, sizeof(result));
+
+    if (kernel_case_init(&c, &options, cases[i].kernel, cases[i].variant) != 0 ||
+        kernel_run(&options, &c, options.perf, &result) != 0) {
+      fprintf(stderr, "bench_kernels: %s %s failed\n", cases[i].kernel, cases[i].variant);
+      status = 1;
+    } else {
+      kernel_print_result(&c, &result, options.perf);
+
+      if (json) {
+        kernel_json_result(json, &c, &result, first);
+        first = false;
+      }
+    }
+
+    kernel_case_free(&c);
+  }
+
+  if (json) {
+    fprintf(json, "\n  ]\n}\n");
+    if (json != stdout) fclose(json);
+  }
+
+  if (options.perf) bench_perf_close();
+
+  return status;
+}
@@ -0,0 +1,917 @@
+#include <assert.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <delta.h>
+
+#include "corpus.h"
+#include "harness.h"
+
+// Performance fuzzer.  It searches for inputs that make the engine slow:
+// sources and targets that maximise delta_create() time per target byte,
+// and deltas that maximise delta_apply() time per byte of delta and output
+// (the output length is part of the input, as the delta declares it).
+// Deltas that write little or nothing are not measured.
+//
+// Inputs are recipes rather than bytes: a few segments of fill, pattern,
+// random and copied-from-source bytes for create, and repeated copy and
+// insert commands for apply.  Each family of seed recipes is hill-climbed
+// by timing mutants and keeping the slowest.  The slowest recipes, with a
+// benign baseline of the same size, are written as JSON fixtures that
+// test/index.js and bench-worstcase.js rebuild with buildRecipe() in
+// test/helpers.js and hold to a time budget relative to the baseline.
+//
+//   bench_worstcase [options] [--out <fixtures.json>]
+
+// Same defaults as the JavaScript API
+#define WORST_NHASH_DEFAULT 16
+#define WORST_SEARCH_LIMIT_DEFAULT 250
+
+// Slack delta_create() needs past the target length
+#define WORST_CREATE_OVERHEAD 1024
+
+#define WORST_MAX_SEGMENTS 16
+#define WORST_MAX_OPS 8
+#define WORST_MAX_PATTERN 16
+
+// Timed runs per measurement, of which the fastest counts
+#define WORST_RUNS 3
+
+// Cases must keep at least this fraction of the size to be measured
+#define WORST_MIN_FRACTION 4
+
+// Deltas must also write at least this fraction of the size, or a delta
+// of empty commands would pass for slow apply
+#define WORST_MIN_OUTPUT_FRACTION 16
+
+enum {
+  WORST_FILL,
+  WORST_PATTERN,
+  WORST_RANDOM,
+  WORST_SOURCE
+};
+
+enum {
+  WORST_CREATE,
+  WORST_APPLY
+};
+
+// A run of bytes: length bytes of value (fill), of pattern repeated, from
+// xorshift32 seeded with value (random), or from the source at offset value
+typedef struct {
+  int kind;
+  uint32_t length;
+  uint32_t value;
+  uint8_t pattern[WORST_MAX_PATTERN];
+  int pattern_len;
+} worst_segment_t;
+
+// repeat copy commands of length bytes from source offset value, or insert
+// commands of length bytes equal to value
+typedef struct {
+  bool copy;
+  uint32_t length;
+  uint32_t value;
+  uint32_t repeat;
+} worst_op_t;
+
+typedef struct {
+  int op;
+  const char *family;
+  worst_segment_t source[WORST_MAX_SEGMENTS];
+  int nsource;
+  worst_segment_t target[WORST_MAX_SEGMENTS];
+  int ntarget;
+  worst_op_t ops[WORST_MAX_OPS];
+  int nops;
+  uint32_t rounds;
+  double ns_per_byte;
+} worst_case_t;
+
+// The slowest case of a family and its baseline
+typedef struct {
+  worst_case_t worst;
+  worst_case_t baseline;
+  double ratio;
+} worst_result_t;
+
+typedef struct {
+  size_t size;
+  int generations;
+  int mutants;
+  int keep;
+  uint64_t seed;
+  int nhash;
+  int search_limit;
+  const char *out;
+} worst_options_t;
+
+// Buffers built from a recipe.  Every buffer holds size bytes, plus room
+// for the delta and its slack.
+typedef struct {
+  char *source;
+  size_t source_len;
+  char *target;
+  size_t target_len;
+  char *delta;
+  size_t delta_len;
+  char *output;
+} worst_buffers_t;
+
+// Building
+
+static uint32_t
+worst_xorshift32(uint32_t *x) {
+  *x ^= *x << 13;
+  *x ^= *x >> 17;
+  *x ^= *x << 5;
+  return *x;
+}
+
+static size_t
+worst_build_segments(const worst_segment_t *segments, int n, size_t max, const char *source, size_t source_len, char *out) {
+  size_t len = 0;
+
+  for (int i = 0; i < n && len < max; i++) {
+    const worst_segment_t *s = &segments[i];
+    size_t count = s->length < max - len ? s->length : max - len;
+
+    switch (s->kind) {
+    case WORST_FILL:
+      memset(out + len, (int)(s->value & 0xff), count);
+      break;
+
+    case WORST_PATTERN:
+      if (s->pattern_len == 0) {
+        memset(out + len, 0, count);
+        break;
+      }
+
+      for (size_t j = 0; j < count; j++) out[len + j] = (char)s->pattern[j % s->pattern_len];
+      break;
+
+    case WORST_RANDOM: {
+      uint32_t x = s->value ? s->value : 1;
+      for (size_t j = 0; j < count; j++) out[len + j] = (char)(worst_xorshift32(&x) >> 24);
+      break;
+    }
+
+    case WORST_SOURCE: {
+      if (source_len == 0) {
+        count = 0;
+        break;
+      }
+
+      size_t offset = s->value % source_len;
+      if (count > source_len - offset) count = source_len - offset;
+
+      memcpy(out + len, source + offset, count);
+      break;
+    }
+    }
+
+    len += count;
+  }
+
+  return len;
+}
+
+// The compact-encoding uint the delta format uses
+static size_t
+worst_put_int(uint32_t v, char *out) {
+  uint8_t *z = (uint8_t *)out;
+
+  if (v <= 0xfc) {
+    z[0] = (uint8_t)v;
+    return 1;
+  }
+
+  if (v <= 0xffff) {
+    z[0] = 0xfd;
+    z[1] = (uint8_t)v;
+    z[2] = (uint8_t)(v >> 8);
+    return 3;
+  }
+
+  z[0] = 0xfe;
+  for (int i = 0; i < 4; i++) z[1 + i] = (uint8_t)(v >> (8 * i));
+  return 5;
+}
+
+// The big-endian word sum that ends a delta
+static uint32_t
+worst_checksum(const char *data, size_t len) {
+  const uint8_t *z = (const uint8_t *)data;
+  uint32_t sum = 0;
+
+  for (size_t i = 0; i < len; i++) sum += (uint32_t)z[i] << (24 - 8 * (i & 3));
+
+  return sum;
+}
+
+// Encode the commands of a recipe until the output or the delta reaches
+// max bytes, building the target they produce on the way
+static void
+worst_build_delta(const worst_case_t *c, size_t max, worst_buffers_t *b) {
+  char *ops = b->output; // Commands before the header is known
+  size_t nops = 0;
+  size_t total = 0;
+  bool full = false;
+
+  for (uint32_t r = 0; r < c->rounds && !full; r++) {
+    for (int i = 0; i < c->nops && !full; i++) {
+      const worst_op_t *op = &c->ops[i];
+
+      if (op->copy && b->source_len == 0) continue;
+
+      for (uint32_t k = 0; k < op->repeat; k++) {
+        if (total >= max || nops + 16 > max) {
+          full = true;
+          break;
+        }
+
+        size_t count = op->length < max - total ? op->length : max - total;
+        size_t offset = 0;
+
+        if (op->copy) {
+          offset = op->value % b->source_len;
+          if (count > b->source_len - offset) count = b->source_len - offset;
+        }
+
+        if (!op->copy && nops + count + 16 > max) {
+          full = true;
+          break;
+        }
+
+        nops += worst_put_int((uint32_t)count, ops + nops);
+
+        if (op->copy) {
+          ops[nops++] = '@';
+          nops += worst_put_int((uint32_t)offset, ops + nops);
+          ops[nops++] = ',';
+          memcpy(b->target + total, b->source + offset, count);
+        } else {
+          ops[nops++] = ':';
+          memset(ops + nops, (int)(op->value & 0xff), count);
+          memset(b->target + total, (int)(op->value & 0xff), count);
+          nops += count;
+        }
+
+        total += count;
+      }
+    }
+  }
+
+  b->target_len = total;
+
+  size_t len = worst_put_int((uint32_t)total, b->delta);
+  memcpy(b->delta + len, ops, nops);
+  len += nops;
+  len += worst_put_int(worst_checksum(b->target, total), b->delta + len);
+  b->delta[len++] = ';';
+
+  b->delta_len = len;
+}
+
+static void
+worst_build(const worst_case_t *c, size_t max, worst_buffers_t *b) {
+  b->source_len = worst_build_segments(c->source, c->nsource, max, NULL, 0, b->source);
+
+  if (c->op == WORST_CREATE) {
+    b->target_len = worst_build_segments(c->target, c->ntarget, max, b->source, b->source_len, b->target);
+  } else {
+    worst_build_delta(c, max, b);
+  }
+}
+
+static int
+worst_buffers_init(worst_buffers_t *b, size_t max) {
+  memset(b, 0, sizeof(*b));
+
+  b->source = malloc(max);
+  b->target = malloc(max);
+  b->delta = malloc(max + WORST_CREATE_OVERHEAD);
+  b->output = malloc(max + WORST_CREATE_OVERHEAD);
+
+  return b->source && b->target && b->delta && b->output ? 0 : -1;
+}
+
+static void
+worst_buffers_free(worst_buffers_t *b) {
+  free(b->source);
+  free(b->target);
+  free(b->delta);
+  free(b->output);
+}
+
+// Measuring
+
+// Nanoseconds per byte of the case, the fastest of WORST_RUNS runs, 0 when
+// it is too small or writes too little to count or a negative value when
+// the engine fails on it
+static double
+worst_measure(const worst_options_t *options, const worst_case_t *c, worst_buffers_t *b) {
+  worst_build(c, options->size, b);
+
+  uint64_t best = UINT64_MAX;
+
+  for (int i = 0; i < WORST_RUNS; i++) {
+    uint64_t start = bench_now();
+    int len;
+
+    if (c->op == WORST_CREATE) {
+      len = delta_create_with_options(
+        b->source, b->source_len, b->target, b->target_len, b->delta,
+        options->nhash, options->search_limit, NULL
+      );
+    } else {
+      len = delta_apply(b->source, b->source_len, b->delta, b->delta_len, b->output);
+    }
+
+    uint64_t elapsed = bench_now() - start;
+    if (elapsed < best) best = elapsed;
+
+    if (len < 0) return -1;
+
+    if (c->op == WORST_CREATE) b->delta_len = (size_t)len;
+  }
+
+  // A slow create is only interesting if its delta is still right
+  if (c->op == WORST_CREATE) {
+    int len = delta_apply(b->source, b->source_len, b->delta, b->delta_len, b->output);
+
+    if (len != (int)b->target_len || memcmp(b->output, b->target, b->target_len) != 0) {
+      fprintf(stderr, "bench_worstcase: %s does not round-trip\n", c->family);
+      return -1;
+    }
+  }
+
+  size_t bytes = c->op == WORST_CREATE ? b->target_len : b->delta_len + b->target_len;
+
+  // Fixed costs dominate small inputs, so shrinking would pass for slowness
+  if (bytes < options->size / WORST_MIN_FRACTION) return 0;
+  if (c->op == WORST_APPLY && b->target_len < options->size / WORST_MIN_OUTPUT_FRACTION) return 0;
+
+  return (double)best / (double)bytes;
+}
+
+// A benign pair of the same size: a random source and a target that is the
+// source with a few edits.  For create the target is as long as the one of
+// c, and for apply as long as the delta and output of c together, as the
+// few edits keep the baseline delta small.
+static void
+worst_baseline(const worst_case_t *c, const worst_buffers_t *b, size_t max, worst_case_t *baseline) {
+  memset(baseline, 0, sizeof(*baseline));
+
+  size_t len = c->op == WORST_CREATE ? b->target_len : b->delta_len + b->target_len;
+  if (len > max) len = max;
+  uint32_t half = (uint32_t)(len / 2);
+
+  baseline->op = WORST_CREATE;
+  baseline->family = "baseline";
+  baseline->nsource = 1;
+  baseline->source[0] = (worst_segment_t) {WORST_RANDOM, (uint32_t)len, 1};
+  baseline->ntarget = 3;
+  baseline->target[0] = (worst_segment_t) {WORST_SOURCE, half, 0};
+  baseline->target[1] = (worst_segment_t) {WORST_RANDOM, 64, 2};
+  baseline->target[2] = (worst_segment_t) {WORST_SOURCE, (uint32_t)len - half - 64, half + 64};
+}
+
+// Nanoseconds per byte of the operation of c on the baseline pair.  For
+// apply, the baseline delta is the one the engine creates.
+static double
+worst_measure_baseline(const worst_options_t *options, const worst_case_t *c, const worst_case_t *baseline, worst_buffers_t *b) {
+  double ns = worst_measure(options, baseline, b);
+
+  if (c->op == WORST_CREATE || ns < 0) return ns;
+
+  uint64_t best = UINT64_MAX;
+
+  for (int i = 0; i < WORST_RUNS; i++) {
+    uint64_t start = bench_now();
+    int len = delta_apply(b->source, b->source_len, b->delta, b->delta_len, b->output);
+    uint64_t elapsed = bench_now() - start;
+
+    if (len < 0) return -1;
+    if (elapsed < best) best = elapsed;
+  }
+
+  return (double)best / (double)(b->delta_len + b->target_len);
+}
+
+// Mutation
+
+static uint32_t
+worst_random(uint64_t *state, uint32_t n) {
+  return n > 0 ? (uint32_t)(bench_corpus_random(state) % n) : 0;
+}
+
+static uint32_t
+worst_mutate_length(uint64_t *state, uint32_t length, size_t max) {
+  uint64_t next;
+
+  switch (worst_random(state, 4)) {
+  case 0: next = (uint64_t)length * 2; break;
+  case 1: next = length / 2; break;
+  case 2: next = length + worst_random(state, 64); break;
+  default: next = 1 + worst_random(state, (uint32_t)max); break;
+  }
+
+  return (uint32_t)(next > max ? max : next);
+}
+
+static void
+worst_random_segment(uint64_t *state, worst_segment_t *s, size_t max) {
+  memset(s, 0, sizeof(*s));
+
+  s->kind = (int)worst_random(state, 4);
+  s->length = 1 + worst_random(state, (uint32_t)max);
+  s->value = (uint32_t)bench_corpus_random(state);
+  s->pattern_len = 1 + (int)worst_random(state, WORST_MAX_PATTERN);
+
+  for (int i = 0; i < s->pattern_len; i++) s->pattern[i] = (uint8_t)worst_random(state, 4);
+}
+
+static void
+worst_mutate_segments(uint64_t *state, worst_segment_t *segments, int *n, size_t max) {
+  int i = (int)worst_random(state, (uint32_t)*n);
+  worst_segment_t *s = &segments[i];
+
+  switch (worst_random(state, 7)) {
+  case 0:
+    s->length = worst_mutate_length(state, s->length, max);
+    break;
+
+  case 1:
+    s->value = s->kind == WORST_FILL ? worst_random(state, 256) : (uint32_t)bench_corpus_random(state);
+    break;
+
+  case 2:
+    if (s->pattern_len == 0) s->pattern_len = 1;
+    s->pattern[worst_random(state, (uint32_t)s->pattern_len)] = (uint8_t)worst_random(state, 256);
+    break;
+
+  case 3:
+    s->pattern_len = 1 + (int)worst_random(state, WORST_MAX_PATTERN);
+    break;
+
+  case 4:
+    s->kind = (int)worst_random(state, 4);
+    if (s->pattern_len == 0) s->pattern_len = 1;
+    break;
+
+  case 5:
+    if (*n < WORST_MAX_SEGMENTS) {
+      int at = (int)worst_random(state, (uint32_t)*n + 1);
+      memmove(&segments[at + 1], &segments[at], sizeof(worst_segment_t) * (*n - at));
+      worst_random_segment(state, &segments[at], max);
+      (*n)++;
+    }
+    break;
+
+  default:
+    if (*n > 1) {
+      memmove(&segments[i], &segments[i + 1], sizeof(worst_segment_t) * (*n - i - 1));
+      (*n)--;
+    }
+    break;
+  }
+}
+
+// The first command keeps its kind and stays, so that a family keeps to
+// what its name says
+static void
+worst_mutate_ops(uint64_t *state, worst_case_t *c, size_t max) {
+  int i = (int)worst_random(state, (uint32_t)c->nops);
+  worst_op_t *op = &c->ops[i];
+
+  switch (worst_random(state, 7)) {
+  case 0:
+    // Now and then an empty command, which produces nothing
+    op->length = worst_random(state, 8) == 0 ? 0 : worst_mutate_length(state, op->length, max);
+    break;
+
+  case 1:
+    op->value = (uint32_t)bench_corpus_random(state);
+    break;
+
+  case 2:
+    op->repeat = 1 + worst_mutate_length(state, op->repeat, max);
+    break;
+
+  case 3:
+    if (i > 0) op->copy = !op->copy;
+    break;
+
+  case 4:
+    c->rounds = 1 + worst_mutate_length(state, c->rounds, max);
+    break;
+
+  case 5:
+    if (c->nops < WORST_MAX_OPS) {
+      worst_op_t *next = &c->ops[c->nops++];
+      next->copy = worst_random(state, 2) == 0;
+      next->length = worst_random(state, 32);
+      next->value = (uint32_t)bench_corpus_random(state);
+      next->repeat = 1 + worst_random(state, 1024);
+    }
+    break;
+
+  default:
+    if (i > 0) {
+      memmove(&c->ops[i], &c->ops[i + 1], sizeof(worst_op_t) * (c->nops - i - 1));
+      c->nops--;
+    }
+    break;
+  }
+}
+
+static void
+worst_mutate(uint64_t *state, worst_case_t *c, size_t max) {
+  // One to four mutations at a time, to get across flat stretches
+  int n = 1 + (int)worst_random(state, 4);
+
+  for (int i = 0; i < n; i++) {
+    if (c->op == WORST_APPLY) {
+      if (worst_random(state, 4) == 0) worst_mutate_segments(state, c->source, &c->nsource, max);
+      else worst_mutate_ops(state, c, max);
+    } else if (worst_random(state, 2) == 0) {
+      worst_mutate_segments(state, c->source, &c->nsource, max);
+    } else {
+      worst_mutate_segments(state, c->target, &c->ntarget, max);
+    }
+  }
+}
+
+// Seeds
+
+static worst_segment_t
+worst_pattern(const char *pattern, uint32_t length) {
+  worst_segment_t s = {WORST_PATTERN, length, 0};
+  s.pattern_len = (int)strlen(pattern);
+  assert(s.pattern_len <= WORST_MAX_PATTERN);
+  memcpy(s.pattern, pattern, s.pattern_len);
+  return s;
+}
+
+// Starting points of the search: shapes known to be hard for hash chain
+// matchers and for command interpreters
+static int
+worst_seeds(size_t max, worst_case_t *seeds) {
+  uint32_t n = (uint32_t)max;
+  int count = 0;
+  worst_case_t *c;
+
+  // Every source block hashes alike and every candidate matches
+  c = &seeds[count++];
+  memset(c, 0, sizeof(*c));
+  c->family = "uniform";
+  c->source[c->nsource++] = (worst_segment_t) {WORST_FILL, n, 0};
+  c->target[c->ntarget++] = (worst_segment_t) {WORST_FILL, n, 0};
+
+  // A period that is not a multiple of the hash window
+  c = &seeds[count++];
+  memset(c, 0, sizeof(*c));
+  c->family = "period";
+  c->source[c->nsource++] = worst_pattern("abcdefghijklmno", n);
+  c->target[c->ntarget++] = worst_pattern("bcdefghijklmnoa", n);
+
+  // Blocks that share a hash and differ in one byte past the window
+  c = &seeds[count++];
+  memset(c, 0, sizeof(*c));
+  c->family = "near-miss";
+  c->source[c->nsource++] = worst_pattern("aaaaaaaaaaaaaaab", n);
+  c->target[c->ntarget++] = worst_pattern("aaaaaaaaaaaaaaac", n);
+
+  // Nothing matches
+  c = &seeds[count++];
+  memset(c, 0, sizeof(*c));
+  c->family = "unmatched";
+  c->source[c->nsource++] = (worst_segment_t) {WORST_FILL, n, 0};
+  c->target[c->ntarget++] = (worst_segment_t) {WORST_RANDOM, n, 7};
+
+  // Short copies from all over the source
+  c = &seeds[count++];
+  memset(c, 0, sizeof(*c));
+  c->family = "scattered";
+  c->source[c->nsource++] = (worst_segment_t) {WORST_RANDOM, n, 3};
+  for (int i = 0; i < 12; i++) {
+    c->target[c->ntarget++] = (worst_segment_t) {WORST_SOURCE, n / 12, (uint32_t)i * 7919 * 31};
+  }
+
+  // The same with the commands written directly
+  c = &seeds[count++];
+  memset(c, 0, sizeof(*c));
+  c->op = WORST_APPLY;
+  c->family = "tiny-copies";
+  c->source[c->nsource++] = (worst_segment_t) {WORST_RANDOM, n, 3};
+  c->ops[c->nops++] = (worst_op_t) {true, 1, 12345, n};
+  c->rounds = 1;
+
+  c = &seeds[count++];
+  memset(c, 0, sizeof(*c));
+  c->op = WORST_APPLY;
+  c->family = "tiny-inserts";
+  c->source[c->nsource++] = (worst_segment_t) {WORST_FILL, 1, 0};
+  c->ops[c->nops++] = (worst_op_t) {false, 1, 'x', n};
+  c->rounds = 1;
+
+  // Commands that produce nothing, between single bytes
+  c = &seeds[count++];
+  memset(c, 0, sizeof(*c));
+  c->op = WORST_APPLY;
+  c->family = "empty-commands";
+  c->source[c->nsource++] = (worst_segment_t) {WORST_RANDOM, n, 3};
+  c->ops[c->nops++] = (worst_op_t) {true, 0, 0, 1};
+  c->ops[c->nops++] = (worst_op_t) {false, 0, 0, 1};
+  c->ops[c->nops++] = (worst_op_t) {false, 1, 'x', 1};
+  c->rounds = n;
+
+  // Copies far apart in the source, so each one misses the cache
+  c = &seeds[count++];
+  memset(c, 0, sizeof(*c));
+  c->op = WORST_APPLY;
+  c->family = "far-copies";
+  c->source[c->nsource++] = (worst_segment_t) {WORST_RANDOM, n, 3};
+  c->ops[c->nops++] = (worst_op_t) {true, 8, 0, 1};
+  c->ops[c->nops++] = (worst_op_t) {true, 8, n / 2 + 4099, 1};
+  c->rounds = n / 16;
+
+  return count;
+}
+
+// Output
+
+static void
+worst_json_segments(FILE *out, const worst_segment_t *segments, int n) {
+  fprintf(out, "[");
+
+  for (int i = 0; i < n; i++) {
+    const worst_segment_t *s = &segments[i];
+
+    fprintf(out, "%s{", i ? ", " : "");
+
+    switch (s->kind) {
+    case WORST_FILL:
+      fprintf(out, "\"fill\": %" PRIu32, s->value & 0xff);
+      break;
+
+    case WORST_PATTERN:
+      fprintf(out, "\"pattern\": \"");
+      for (int j = 0; j < s->pattern_len; j++) fprintf(out, "%02x", s->pattern[j]);
+      fprintf(out, "\"");
+      break;
+
+    case WORST_RANDOM:
+      fprintf(out, "\"random\": %" PRIu32, s->value);
+      break;
+
+    case WORST_SOURCE:
+      fprintf(out, "\"source\": %" PRIu32, s->value);
+      break;
+    }
+
+    fprintf(out, ", \"length\": %" PRIu32 "}", s->length);
+  }
+
+  fprintf(out, "]");
+}
+
+static void
+worst_json_case(FILE *out, const worst_case_t *c) {
+  fprintf(out, "\"source\": ");
+  worst_json_segments(out, c->source, c->nsource);
+
+  if (c->op == WORST_CREATE) {
+    fprintf(out, ", \"target\": ");
+    worst_json_segments(out, c->target, c->ntarget);
+    return;
+  }
+
+  fprintf(out, ", \"delta\": {\"rounds\": %" PRIu32 ", \"ops\": [", c->rounds);
+
+  for (int i = 0; i < c->nops; i++) {
+    const worst_op_t *op = &c->ops[i];
+
+    fprintf(
+      out,
+      "%s{\"%s\": %" PRIu32 ", \"%s\": %" PRIu32 ", \"repeat\": %" PRIu32 "}",
+      i ? ", " : "", op->copy ? "copy" : "insert", op->length,
+      op->copy ? "offset" : "byte", op->copy ? op->value : op->value & 0xff, op->repeat
+    );
+  }
+
+  fprintf(out, "]}");
+}
+
+// Slowest first relative to the baseline, creates before applies
+static int
+worst_compare(const void *a, const void *b) {
+  const worst_result_t *x = a;
+  const worst_result_t *y = b;
+
+  if (x->worst.op != y->worst.op) return x->worst.op - y->worst.op;
+  return x->ratio < y->ratio ? 1 : x->ratio > y->ratio ? -1 : 0;
+}
+
+// The tests allow a fixture this many times the ratio it was recorded at,
+// enough to absorb machine differences but not a change of complexity
+#define WORST_BUDGET_FACTOR 3
+#define WORST_BUDGET_MIN 4
+
+static void
+worst_write_fixtures(FILE *out, const worst_options_t *options, worst_result_t *results, int n) {
+  qsort(results, n, sizeof(worst_result_t), worst_compare);
+
+  fprintf(
+    out,
+    "{\n  \"size\": %zu,\n  \"hashWindowSize\": %d,\n  \"searchLimit\": %d,\n  \"seed\": %" PRIu64 ",\n"
+    "  \"generations\": %d,\n  \"fixtures\": [",
+    options->size, options->nhash, options->search_limit, options->seed, options->generations
+  );
+
+  bool first = true;
+  int kept[2] = {0, 0};
+
+  for (int i = 0; i < n; i++) {
+    const worst_result_t *r = &results[i];
+
+    if (kept[r->worst.op]++ >= options->keep) continue;
+
+    double budget = r->ratio * WORST_BUDGET_FACTOR;
+    if (budget < WORST_BUDGET_MIN) budget = WORST_BUDGET_MIN;
+
+    const char *op = r->worst.op == WORST_CREATE ? "create" : "apply";
+
+    fprintf(
+      out,
+      "%s\n    {\"name\": \"%s-%s\", \"op\": \"%s\", \"nsPerByte\": %.3f, \"baselineNsPerByte\": %.3f"
+      ", \"ratio\": %.1f, \"budget\": %.0f,\n     ",
+      first ? "" : ",", op, r->worst.family, op, r->worst.ns_per_byte, r->baseline.ns_per_byte, r->ratio, budget
+    );
+
+    worst_json_case(out, &r->worst);
+    fprintf(out, ",\n     \"baseline\": {");
+    worst_json_case(out, &r->baseline);
+    fprintf(out, "}}");
+
+    first = false;
+  }
+
+  fprintf(out, "\n  ]\n}\n");
+}
+
+static void
+worst_usage(void) {
+  fprintf(
+    stderr,
+    "usage: bench_worstcase [options]\n"
+    "\n"
+    "  --size <bytes>       Largest source, target and delta (default 262144)\n"
+    "  --generations <n>    Rounds of mutation per family (default 40)\n"
+    "  --mutants <n>        Mutants timed per round (default 4)\n"
+    "  --keep <n>           Slowest cases kept per operation (default 3)\n"
+    "  --seed <n>           Seed of the mutations (default 1)\n"
+    "  --hash-window <n>    Hash window size (default 16)\n"
+    "  --search-limit <n>   Search depth (default 250)\n"
+    "  --out <file>         Write the kept cases as test fixtures\n"
+  );
+}
+
+int
+main(int argc, char **argv) {
+  worst_options_t options = {
+    .size = 256 * 1024,
+    .generations = 40,
+    .mutants = 4,
+    .keep = 3,
+    .seed = 1,
+    .nhash = WORST_NHASH_DEFAULT,
+    .search_limit = WORST_SEARCH_LIMIT_DEFAULT,
+    .out = NULL
+  };
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+    if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+      worst_usage();
+      return 0;
+    }
+
+    if (value == NULL) {
+      worst_usage();
+      return 1;
+    }
+
+    if (strcmp(arg, "--size") == 0) options.size = strtoull(value, NULL, 10);
+    else if (strcmp(arg, "--generations") == 0) options.generations = atoi(value);
+    else if (strcmp(arg, "--mutants") == 0) options.mutants = atoi(value);
+    else if (strcmp(arg, "--keep") == 0) options.keep = atoi(value);
+    else if (strcmp(arg, "--seed") == 0) options.seed = strtoull(value, NULL, 10);
+    else if (strcmp(arg, "--hash-window") == 0) options.nhash = atoi(value);
+    else if (strcmp(arg, "--search-limit") == 0) options.search_limit = atoi(value);
+    else if (strcmp(arg, "--out") == 0) options.out = value;
+    else {
+      worst_usage();
+      return 1;
+    }
+
+    i++;
+  }
+
+  if (options.size < 1024 || options.size > UINT32_MAX / 2 || options.generations < 0 || options.mutants < 1 ||
+      options.keep < 1 || options.nhash < 1 || (options.nhash & (options.nhash - 1)) != 0) {
+    worst_usage();
+    return 1;
+  }
+
+  worst_buffers_t buffers;
+
+  if (worst_buffers_init(&buffers, options.size) != 0) {
+    fprintf(stderr, "bench_worstcase: out of memory\n");
+    worst_buffers_free(&buffers);
+    return 1;
+  }
+
+  worst_case_t seeds[16];
+  int nseeds = worst_seeds(options.size, seeds);
+
+  worst_result_t *results = calloc(nseeds, sizeof(worst_result_t));
+
+  if (results == NULL) {
+    worst_buffers_free(&buffers);
+    return 1;
+  }
+
+  uint64_t state = options.seed ? options.seed : 1;
+  int status = 0;
+
+  printf("%-16s %-7s %11s %11s %11s %8s\n", "family", "op", "seed ns/B", "worst ns/B", "base ns/B", "ratio");
+
+  for (int f = 0; f < nseeds && status == 0; f++) {
+    worst_case_t *best = &results[f].worst;
+
+    *best = seeds[f];
+    best->ns_per_byte = worst_measure(&options, best, &buffers);
+
+    if (best->ns_per_byte < 0) {
+      status = 1;
+      break;
+    }
+
+    double initial = best->ns_per_byte;
+
+    // Hill-climb: keep the slowest of the family and its mutants
+    for (int g = 0; g < options.generations; g++) {
+      for (int m = 0; m < options.mutants; m++) {
+        worst_case_t mutant = *best;
+        worst_mutate(&state, &mutant, options.size);
+
+        mutant.ns_per_byte = worst_measure(&options, &mutant, &buffers);
+
+        if (mutant.ns_per_byte > best->ns_per_byte) *best = mutant;
+      }
+    }
+
+    worst_build(best, options.size, &buffers);
+    worst_baseline(best, &buffers, options.size, &results[f].baseline);
+
+    results[f].baseline.ns_per_byte = worst_measure_baseline(&options, best, &results[f].baseline, &buffers);
+
+    if (results[f].baseline.ns_per_byte <= 0) {
+      status = 1;
+      break;
+    }
+
+    results[f].ratio = best->ns_per_byte / results[f].baseline.ns_per_byte;
+
+    printf(
+      "%-16s %-7s %11.3f %11.3f %11.3f %8.1f\n",
+      best->family, best->op == WORST_CREATE ? "create" : "apply",
+      initial, best->ns_per_byte, results[f].baseline.ns_per_byte, results[f].ratio
+    );
+  }
+
+  if (status == 0 && options.out) {
+    FILE *out = fopen(options.out, "w");
+
+    if (out == NULL) {
+      fprintf(stderr, "bench_worstcase: cannot write %s\n", options.out);
+      status = 1;
+    } else {
+      worst_write_fixtures(out, &options, results, nseeds);
+      if (fclose(out) != 0) status = 1;
+    }
+  }
+
+  free(results);
+  worst_buffers_free(&buffers);
+
+  return status;
+}
@@ -0,0 +1,1110 @@
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "corpus.h"
+
+// Growable byte buffer.  Allocation failures are sticky so the generators
+// can build a whole version and check once at the end.
+typedef struct {
+  char *data;
+  size_t len;
+  size_t cap;
+  bool failed;
+} corpus_buf_t;
+
+typedef struct {
+  uint32_t id;
+  uint32_t name;
+  uint32_t count;
+  uint64_t updated;
+  uint8_t tags;
+  bool active;
+} corpus_record_t;
+
+typedef struct {
+  uint64_t rng;
+  size_t size;
+  double churn;
+  uint64_t clock;             // Milliseconds since the first log line or row
+  corpus_buf_t buf;           // The current version
+  corpus_buf_t tmp;           // Bytes about to be spliced into buf
+  size_t code_len;            // executable: length of the code section
+  uint32_t next_id;           // sqlite, json: next row or record id
+  corpus_record_t *records;   // json: the document model
+  size_t nrecords;
+  size_t crecords;
+  uint8_t *used;              // vm-image: allocated blocks
+  size_t nblocks;
+  uint32_t generation;        // sqlite, vm-image: bumped every version
+} corpus_t;
+
+typedef struct {
+  const char *name;
+  void (*init)(corpus_t *c);
+  void (*next)(corpus_t *c);
+} corpus_kind_t;
+
+static const char *const corpus_words[] = {
+  "buffer", "length", "index", "offset", "count", "result", "state", "options",
+  "value", "entry", "node", "table", "cursor", "hash", "block", "queue",
+  "request", "handle", "source", "target"
+};
+
+#define CORPUS_NWORDS (sizeof(corpus_words) / sizeof(corpus_words[0]))
+
+static const char *const corpus_types[] = {
+  "int", "size_t", "char *", "uint32_t", "bool", "const char *"
+};
+
+#define CORPUS_NTYPES (sizeof(corpus_types) / sizeof(corpus_types[0]))
+
+uint64_t
+bench_corpus_random(uint64_t *state) {
+  uint64_t x = *state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *state = x;
+  return x * 0x2545F4914F6CDD1DULL;
+}
+
+static size_t
+corpus_below(corpus_t *c, size_t n) {
+  return n == 0 ? 0 : (size_t)(bench_corpus_random(&c->rng) % n);
+}
+
+static const char *
+corpus_word(corpus_t *c) {
+  return corpus_words[corpus_below(c, CORPUS_NWORDS)];
+}
+
+static const char *
+corpus_type(corpus_t *c) {
+  return corpus_types[corpus_below(c, CORPUS_NTYPES)];
+}
+
+// Bytes each version changes, at least one
+static size_t
+corpus_budget(corpus_t *c) {
+  size_t budget = (size_t)(c->size * c->churn);
+  return budget > 0 ? budget : 1;
+}
+
+// Buffers
+
+static bool
+corpus_reserve(corpus_buf_t *b, size_t n) {
+  if (b->failed) return false;
+  if (b->len + n <= b->cap) return true;
+
+  size_t cap = b->cap ? b->cap : 4096;
+  while (cap < b->len + n) cap *= 2;
+
+  char *data = realloc(b->data, cap);
+
+  if (data == NULL) {
+    b->failed = true;
+    return false;
+  }
+
+  b->data = data;
+  b->cap = cap;
+  return true;
+}
+
+// Replace del bytes at pos with n bytes of src, or n zero bytes when src is
+// NULL
+static void
+corpus_splice(corpus_buf_t *b, size_t pos, size_t del, const char *src, size_t n) {
+  if (n > del && !corpus_reserve(b, n - del)) return;
+  if (b->failed) return;
+
+  memmove(b->data + pos + n, b->data + pos + del, b->len - pos - del);
+
+  if (src) memcpy(b->data + pos, src, n);
+  else memset(b->data + pos, 0, n);
+
+  b->len = b->len - del + n;
+}
+
+static void
+corpus_append(corpus_buf_t *b, const char *src, size_t n) {
+  corpus_splice(b, b->len, 0, src, n);
+}
+
+static void
+corpus_printf(corpus_buf_t *b, const char *fmt, ...) {
+  char line[512];
+
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(line, sizeof(line), fmt, args);
+  va_end(args);
+
+  if (n < 0) return;
+  if ((size_t)n >= sizeof(line)) n = sizeof(line) - 1;
+
+  corpus_append(b, line, (size_t)n);
+}
+
+static void
+corpus_put32be(char *p, uint32_t v) {
+  p[0] = (char)(v >> 24);
+  p[1] = (char)(v >> 16);
+  p[2] = (char)(v >> 8);
+  p[3] = (char)v;
+}
+
+static void
+corpus_put16be(char *p, uint16_t v) {
+  p[0] = (char)(v >> 8);
+  p[1] = (char)v;
+}
+
+static uint16_t
+corpus_get16be(const char *p) {
+  const uint8_t *u = (const uint8_t *)p;
+  return (uint16_t)((u[0] << 8) | u[1]);
+}
+
+static void
+corpus_put32le(char *p, uint32_t v) {
+  p[0] = (char)v;
+  p[1] = (char)(v >> 8);
+  p[2] = (char)(v >> 16);
+  p[3] = (char)(v >> 24);
+}
+
+static uint32_t
+corpus_get32le(const char *p) {
+  const uint8_t *u = (const uint8_t *)p;
+  return u[0] | ((uint32_t)u[1] << 8) | ((uint32_t)u[2] << 16) | ((uint32_t)u[3] << 24);
+}
+
+static size_t
+corpus_line_start(const corpus_buf_t *b, size_t pos) {
+  while (pos > 0 && b->data[pos - 1] != '\n') pos--;
+  return pos;
+}
+
+static size_t
+corpus_line_skip(const corpus_buf_t *b, size_t pos, size_t lines) {
+  while (lines > 0 && pos < b->len) {
+    if (b->data[pos++] == '\n') lines--;
+  }
+  return pos;
+}
+
+// binary, text, random: the shapes of test/helpers.js with point mutations
+
+static void
+corpus_point_mutations(corpus_t *c) {
+  size_t n = corpus_budget(c);
+
+  for (size_t i = 0; i < n && c->buf.len > 0; i++) {
+    c->buf.data[corpus_below(c, c->buf.len)] = (char)bench_corpus_random(&c->rng);
+  }
+}
+
+static void
+corpus_binary_init(corpus_t *c) {
+  if (!corpus_reserve(&c->buf, c->size)) return;
+  for (size_t i = 0; i < c->size; i++) c->buf.data[i] = (char)((i * 37) % 256);
+  c->buf.len = c->size;
+}
+
+static void
+corpus_text_init(corpus_t *c) {
+  static const char line[] = "This is line content with some text and numbers 123456789\n";
+
+  if (!corpus_reserve(&c->buf, c->size)) return;
+  for (size_t i = 0; i < c->size; i++) c->buf.data[i] = line[i % (sizeof(line) - 1)];
+  c->buf.len = c->size;
+}
+
+static void
+corpus_random_init(corpus_t *c) {
+  if (!corpus_reserve(&c->buf, c->size)) return;
+  for (size_t i = 0; i < c->size; i++) c->buf.data[i] = (char)bench_corpus_random(&c->rng);
+  c->buf.len = c->size;
+}
+
+// source-tree: a concatenated snapshot of C sources, edited line by line
+// between versions the way commits touch a tree
+
+static void
+corpus_source_line(corpus_t *c, corpus_buf_t *b) {
+  const char *x = corpus_word(c);
+  const char *y = corpus_word(c);
+  const char *z = corpus_word(c);
+  unsigned n = (unsigned)corpus_below(c, 4096);
+
+  switch (corpus_below(c, 6)) {
+  case 0:
+    corpus_printf(b, "  %s %s_%s = %s_%s(%s, %u);\n", corpus_type(c), x, y, z, x, y, n);
+    break;
+  case 1:
+    corpus_printf(b, "  if (%s->%s > %u) return %s;\n", x, y, n, z);
+    break;
+  case 2:
+    corpus_printf(b, "  for (size_t i = 0; i < %s; i++) %s[i] = %s[i];\n", x, y, z);
+    break;
+  case 3:
+    corpus_printf(b, "  // Keep the %s of the %s in the %s\n", x, y, z);
+    break;
+  case 4:
+    corpus_printf(b, "  %s->%s += %s;\n", x, y, z);
+    break;
+  default:
+    corpus_printf(b, "  if (%s == NULL) goto %s_%s;\n", x, y, z);
+    break;
+  }
+}
+
+static void
+corpus_source_function(corpus_t *c, corpus_buf_t *b) {
+  // Draw the words one statement at a time, argument evaluation order is
+  // unspecified
+  const char *type = corpus_type(c);
+  const char *prefix = corpus_word(c);
+  const char *name = corpus_word(c);
+  const char *arg_type = corpus_type(c);
+  const char *arg = corpus_word(c);
+
+  corpus_printf(b, "static %s\n%s_%s(%s %s) {\n", type, prefix, name, arg_type, arg);
+
+  size_t lines = 3 + corpus_below(c, 16);
+  for (size_t i = 0; i < lines; i++) corpus_source_line(c, b);
+
+  corpus_printf(b, "  return %s;\n}\n\n", corpus_word(c));
+}
+
+static void
+corpus_source_init(corpus_t *c) {
+  while (c->buf.len < c->size && !c->buf.failed) {
+    const char *dir = corpus_word(c);
+    const char *name = corpus_word(c);
+
+    corpus_printf(&c->buf, "// ==== src/%s/%s_%u.c ====\n\n#include \"%s.h\"\n\n", dir, name, (unsigned)corpus_below(c, 100), dir);
+
+    size_t functions = 2 + corpus_below(c, 8);
+    for (size_t i = 0; i < functions; i++) corpus_source_function(c, &c->buf);
+  }
+}
+
+static void
+corpus_source_next(corpus_t *c) {
+  size_t budget = corpus_budget(c);
+  size_t touched = 0;
+
+  while (touched < budget && c->buf.len > 0 && !c->buf.failed) {
+    size_t pos = corpus_line_start(&c->buf, corpus_below(c, c->buf.len));
+    size_t del = 0;
+    size_t op = corpus_below(c, 20);
+
+    c->tmp.len = 0;
+
+    if (op < 12) {
+      // Change a line
+      del = corpus_line_skip(&c->buf, pos, 1) - pos;
+      corpus_source_line(c, &c->tmp);
+    } else if (op < 16) {
+      size_t lines = 1 + corpus_below(c, 10);
+      for (size_t i = 0; i < lines; i++) corpus_source_line(c, &c->tmp);
+    } else if (op < 19) {
+      del = corpus_line_skip(&c->buf, pos, 1 + corpus_below(c, 10)) - pos;
+    } else {
+      // Add a function after the one the position falls in
+      while (pos < c->buf.len && !(pos >= 3 && memcmp(c->buf.data + pos - 3, "}\n\n", 3) == 0)) pos++;
+      corpus_source_function(c, &c->tmp);
+    }
+
+    if (c->tmp.failed) c->buf.failed = true;
+
+    corpus_splice(&c->buf, pos, del, c->tmp.data, c->tmp.len);
+    touched += del + c->tmp.len;
+  }
+}
+
+// executable: fixed-width instructions followed by read-only data.  Code is
+// inserted and removed between versions like a recompile, and every
+// absolute address past the edit shifts with it, which scatters small
+// changes over the whole image.
+
+#define CORPUS_INSN 8
+#define CORPUS_OP_BRANCH 0x40   // Ops below this branch into the code
+#define CORPUS_OP_LOAD 0x80     // Ops below this load from the data
+
+static const uint8_t corpus_ops[] = {
+  0x01, 0x02, 0x08, 0x10, 0x41, 0x42, 0x48, 0x81, 0x82, 0x83, 0x84, 0x88, 0x90, 0xa0
+};
+
+static void
+corpus_insn(corpus_t *c, char *out, size_t at, size_t code_len, size_t data_len) {
+  uint8_t op = corpus_ops[corpus_below(c, sizeof(corpus_ops))];
+  uint32_t addr;
+
+  if (op < CORPUS_OP_BRANCH) {
+    // Mostly short branches within the same function
+    size_t n = code_len / CORPUS_INSN;
+    size_t i = at / CORPUS_INSN + corpus_below(c, 64);
+    i = i > 32 ? i - 32 : 0;
+    addr = (uint32_t)((corpus_below(c, 4) == 0 ? corpus_below(c, n) : (i < n ? i : n - 1)) * CORPUS_INSN);
+  } else if (op < CORPUS_OP_LOAD) {
+    addr = (uint32_t)(code_len + corpus_below(c, data_len / 4) * 4);
+  } else {
+    addr = (uint32_t)corpus_below(c, 256);
+  }
+
+  out[0] = (char)op;
+  out[1] = (char)corpus_below(c, 16);
+  out[2] = (char)corpus_below(c, 8);
+  out[3] = 0;
+  corpus_put32le(out + 4, addr);
+}
+
+static void
+corpus_executable_data(corpus_t *c, corpus_buf_t *b, size_t len) {
+  size_t end = b->len + len;
+
+  while (b->len < end && !b->failed) {
+    const char *subject = corpus_word(c);
+    const char *verb = corpus_word(c);
+    const char *object = corpus_word(c);
+
+    corpus_printf(b, "%s: cannot %s the %s", subject, verb, object);
+    corpus_append(b, NULL, 1);
+  }
+
+  if (!b->failed) b->len = end;
+}
+
+static void
+corpus_executable_init(corpus_t *c) {
+  size_t n = c->size * 3 / 4 / CORPUS_INSN;
+  if (n == 0) n = 1;
+
+  size_t data_len = c->size > n * CORPUS_INSN ? c->size - n * CORPUS_INSN : 64;
+
+  c->code_len = n * CORPUS_INSN;
+
+  if (!corpus_reserve(&c->buf, c->code_len + data_len + 512)) return;
+
+  for (size_t i = 0; i < n; i++) {
+    corpus_insn(c, c->buf.data + i * CORPUS_INSN, i * CORPUS_INSN, c->code_len, data_len);
+  }
+
+  c->buf.len = c->code_len;
+  corpus_executable_data(c, &c->buf, data_len);
+}
+
+// Move every absolute address at or past pos by shift bytes.  Addresses
+// into removed code land on the removal point.
+static void
+corpus_executable_relocate(corpus_t *c, size_t pos, size_t removed, size_t added) {
+  for (size_t i = 0; i < c->code_len; i += CORPUS_INSN) {
+    char *insn = c->buf.data + i;
+    uint8_t op = (uint8_t)insn[0];
+
+    if (op >= CORPUS_OP_LOAD) continue;
+
+    uint32_t addr = corpus_get32le(insn + 4);
+
+    if (addr < pos) continue;
+
+    if (addr < pos + removed) addr = (uint32_t)pos;
+    else addr = (uint32_t)(addr - removed + added);
+
+    corpus_put32le(insn + 4, addr);
+  }
+}
+
+static void
+corpus_executable_next(corpus_t *c) {
+  size_t budget = corpus_budget(c);
+  size_t touched = 0;
+
+  while (touched < budget && !c->buf.failed) {
+    size_t n = c->code_len / CORPUS_INSN;
+    size_t pos = corpus_below(c, n + 1) * CORPUS_INSN;
+    size_t k = 1 + corpus_below(c, 16);
+    size_t removed = 0;
+    size_t added = 0;
+
+    if (corpus_below(c, 4) == 0 && n > k && pos + k * CORPUS_INSN <= c->code_len) {
+      removed = k * CORPUS_INSN;
+    } else {
+      added = k * CORPUS_INSN;
+    }
+
+    corpus_executable_relocate(c, pos, removed, added);
+
+    size_t code_len = c->code_len - removed + added;
+    size_t data_len = c->buf.len - c->code_len;
+
+    c->tmp.len = 0;
+
+    if (added && corpus_reserve(&c->tmp, added)) {
+      for (size_t i = 0; i < k; i++) {
+        corpus_insn(c, c->tmp.data + i * CORPUS_INSN, pos + i * CORPUS_INSN, code_len, data_len);
+      }
+
+      c->tmp.len = added;
+    }
+
+    if (c->tmp.failed) c->buf.failed = true;
+
+    corpus_splice(&c->buf, pos, removed, c->tmp.data, c->tmp.len);
+    c->code_len = code_len;
+    touched += removed + added;
+
+    // Now and then a string changes too
+    if (corpus_below(c, 8) == 0 && data_len > 16) {
+      const char *word = corpus_word(c);
+      memcpy(c->buf.data + c->code_len + corpus_below(c, data_len - 16), word, strlen(word));
+    }
+  }
+}
+
+// log: timestamped lines appended to, and rotated now and then
+
+static void
+corpus_log_line(corpus_t *c, corpus_buf_t *b) {
+  static const char *const levels[] = {"INFO ", "INFO ", "INFO ", "INFO ", "DEBUG", "WARN ", "ERROR"};
+  static const char *const components[] = {"http", "db", "cache", "auth", "queue"};
+  static const char *const events[] = {"request", "query", "lookup", "flush", "retry"};
+
+  uint64_t t = c->clock;
+  c->clock += corpus_below(c, 250);
+
+  const char *level = levels[corpus_below(c, 7)];
+  const char *component = components[corpus_below(c, 5)];
+  unsigned worker = (unsigned)corpus_below(c, 8);
+  const char *event = events[corpus_below(c, 5)];
+  unsigned id = (unsigned)bench_corpus_random(&c->rng);
+  unsigned ms = (unsigned)corpus_below(c, 200);
+  unsigned status = corpus_below(c, 10) == 0 ? 500 : 200;
+  unsigned bytes = (unsigned)corpus_below(c, 65536);
+
+  corpus_printf(
+    b,
+    "2026-10-%02uT%02u:%02u:%02u.%03uZ %s [%s-%u] %s %08x completed in %ums status=%u bytes=%u\n",
+    (unsigned)(1 + (t / 86400000) % 28), (unsigned)((t / 3600000) % 24), (unsigned)((t / 60000) % 60),
+    (unsigned)((t / 1000) % 60), (unsigned)(t % 1000),
+    level, component, worker, event, id, ms, status, bytes
+  );
+}
+
+static void
+corpus_log_init(corpus_t *c) {
+  while (c->buf.len < c->size && !c->buf.failed) corpus_log_line(c, &c->buf);
+}
+
+static void
+corpus_log_next(corpus_t *c) {
+  if (corpus_below(c, 10) == 0) {
+    corpus_splice(&c->buf, 0, corpus_line_skip(&c->buf, c->buf.len / 10, 1), NULL, 0);
+  }
+
+  size_t end = c->buf.len + corpus_budget(c);
+  while (c->buf.len < end && !c->buf.failed) corpus_log_line(c, &c->buf);
+}
+
+// sqlite: a database file of 4 KiB table b-tree leaf pages.  Rows are
+// updated in place, inserted into the last page, and deleted with the page
+// defragmented, and the header counters change on every version.
+
+#define CORPUS_PAGE 4096
+#define CORPUS_PAGE_HEADER 8
+
+static void
+corpus_sqlite_row(corpus_t *c, corpus_buf_t *b) {
+  char text[128];
+  size_t text_len = 0;
+  size_t want = 20 + corpus_below(c, 100);
+
+  while (text_len < want) {
+    int n = snprintf(text + text_len, sizeof(text) - text_len, "%s ", corpus_word(c));
+    if (n < 0 || (size_t)n >= sizeof(text) - text_len) break;
+    text_len += (size_t)n;
+  }
+
+  const char *kind = corpus_word(c);
+  size_t kind_len = strlen(kind);
+  size_t len = 2 + 4 + 1 + kind_len + 1 + text_len + 8;
+
+  if (!corpus_reserve(b, len)) return;
+
+  char *p = b->data + b->len;
+
+  c->clock += corpus_below(c, 1000);
+
+  corpus_put16be(p, (uint16_t)len);
+  corpus_put32be(p + 2, c->next_id++);
+  p[6] = (char)kind_len;
+  memcpy(p + 7, kind, kind_len);
+  p[7 + kind_len] = (char)text_len;
+  memcpy(p + 8 + kind_len, text, text_len);
+  corpus_put32be(p + len - 8, (uint32_t)(c->clock >> 32));
+  corpus_put32be(p + len - 4, (uint32_t)c->clock);
+
+  b->len += len;
+}
+
+static char *
+corpus_sqlite_page(corpus_t *c, size_t pgno) {
+  return c->buf.data + pgno * CORPUS_PAGE;
+}
+
+static void
+corpus_sqlite_page_init(char *page) {
+  memset(page, 0, CORPUS_PAGE);
+  page[0] = 0x0d;
+  corpus_put16be(page + 5, 0); // 0 stands for 65536, an empty content area
+}
+
+static size_t
+corpus_sqlite_content(const char *page) {
+  uint16_t start = corpus_get16be(page + 5);
+  return start == 0 ? CORPUS_PAGE : start;
+}
+
+static bool
+corpus_sqlite_insert(char *page, const char *cell, size_t len) {
+  size_t ncells = corpus_get16be(page + 3);
+  size_t start = corpus_sqlite_content(page);
+
+  if (CORPUS_PAGE_HEADER + 2 * (ncells + 1) + len > start) return false;
+
+  start -= len;
+  memcpy(page + start, cell, len);
+  corpus_put16be(page + CORPUS_PAGE_HEADER + 2 * ncells, (uint16_t)start);
+  corpus_put16be(page + 3, (uint16_t)(ncells + 1));
+  corpus_put16be(page + 5, (uint16_t)start);
+
+  return true;
+}
+
+// Remove cell idx and pack the remaining cells against the page end
+static void
+corpus_sqlite_delete(corpus_t *c, char *page, size_t idx) {
+  size_t ncells = corpus_get16be(page + 3);
+
+  c->tmp.len = 0;
+  corpus_append(&c->tmp, page, CORPUS_PAGE);
+  if (c->tmp.failed) {
+    c->buf.failed = true;
+    return;
+  }
+
+  corpus_sqlite_page_init(page);
+
+  for (size_t i = 0; i < ncells; i++) {
+    if (i == idx) continue;
+
+    const char *cell = c->tmp.data + corpus_get16be(c->tmp.data + CORPUS_PAGE_HEADER + 2 * i);
+    corpus_sqlite_insert(page, cell, corpus_get16be(cell));
+  }
+}
+
+static void
+corpus_sqlite_update(corpus_t *c, char *page, size_t idx) {
+  char *cell = page + corpus_get16be(page + CORPUS_PAGE_HEADER + 2 * idx);
+  size_t len = corpus_get16be(cell);
+  size_t kind_len = (uint8_t)cell[6];
+  size_t text_len = (uint8_t)cell[7 + kind_len];
+  char *text = cell + 8 + kind_len;
+
+  // Rewrite a stretch of the text with words of the same total length
+  size_t at = corpus_below(c, text_len);
+
+  while (at < text_len) {
+    const char *word = corpus_word(c);
+    size_t n = strlen(word);
+    if (n > text_len - at) n = text_len - at;
+    memcpy(text + at, word, n);
+    at += n + 1 + corpus_below(c, 16);
+  }
+
+  c->clock += corpus_below(c, 1000);
+  corpus_put32be(cell + len - 8, (uint32_t)(c->clock >> 32));
+  corpus_put32be(cell + len - 4, (uint32_t)c->clock);
+}
+
+static void
+corpus_sqlite_header(corpus_t *c) {
+  char *header = corpus_sqlite_page(c, 0);
+  uint32_t npages = (uint32_t)(c->buf.len / CORPUS_PAGE);
+
+  corpus_put32be(header + 24, c->generation);
+  corpus_put32be(header + 28, npages);
+  corpus_put32be(header + 92, c->generation);
+}
+
+static void
+corpus_sqlite_add_page(corpus_t *c) {
+  corpus_append(&c->buf, NULL, CORPUS_PAGE);
+  if (c->buf.failed) return;
+
+  corpus_sqlite_page_init(corpus_sqlite_page(c, c->buf.len / CORPUS_PAGE - 1));
+}
+
+// Insert a new row into the last page, starting a page when it is full
+static size_t
+corpus_sqlite_append_row(corpus_t *c) {
+  c->tmp.len = 0;
+  corpus_sqlite_row(c, &c->tmp);
+
+  if (c->tmp.failed) {
+    c->buf.failed = true;
+    return 0;
+  }
+
+  size_t last = c->buf.len / CORPUS_PAGE - 1;
+
+  if (last == 0 || !corpus_sqlite_insert(corpus_sqlite_page(c, last), c->tmp.data, c->tmp.len)) {
+    corpus_sqlite_add_page(c);
+    if (c->buf.failed) return 0;
+
+    corpus_sqlite_insert(corpus_sqlite_page(c, last + 1), c->tmp.data, c->tmp.len);
+  }
+
+  return c->tmp.len;
+}
+
+static void
+corpus_sqlite_init(corpus_t *c) {
+  static const char schema[] = "CREATE TABLE events(id INTEGER PRIMARY KEY, kind TEXT, payload TEXT, ts INTEGER)";
+
+  corpus_append(&c->buf, NULL, CORPUS_PAGE);
+  if (c->buf.failed) return;
+
+  char *header = c->buf.data;
+
+  memcpy(header, "SQLite format 3", 16);
+  corpus_put16be(header + 16, CORPUS_PAGE);
+  header[18] = 1;
+  header[19] = 1;
+  header[21] = 64;
+  header[22] = 32;
+  header[23] = 32;
+  corpus_put32be(header + 96, 3045001);
+  header[100] = 0x0d;
+  memcpy(header + CORPUS_PAGE - sizeof(schema), schema, sizeof(schema));
+
+  c->next_id = 1;
+
+  while (c->buf.len < c->size && !c->buf.failed) corpus_sqlite_append_row(c);
+
+  if (!c->buf.failed) corpus_sqlite_header(c);
+}
+
+static void
+corpus_sqlite_next(corpus_t *c) {
+  size_t budget = corpus_budget(c);
+  size_t touched = 0;
+
+  c->generation++;
+
+  while (touched < budget && !c->buf.failed) {
+    size_t npages = c->buf.len / CORPUS_PAGE;
+    size_t op = corpus_below(c, 10);
+
+    if (op >= 7 && op < 9) {
+      touched += corpus_sqlite_append_row(c) + 1;
+      continue;
+    }
+
+    if (npages < 2) {
+      touched += corpus_sqlite_append_row(c) + 1;
+      continue;
+    }
+
+    char *page = corpus_sqlite_page(c, 1 + corpus_below(c, npages - 1));
+    size_t ncells = corpus_get16be(page + 3);
+
+    if (ncells == 0) {
+      touched++;
+      continue;
+    }
+
+    size_t idx = corpus_below(c, ncells);
+
+    if (op < 7) {
+      corpus_sqlite_update(c, page, idx);
+      touched += corpus_get16be(page + corpus_get16be(page + CORPUS_PAGE_HEADER + 2 * idx));
+    } else {
+      corpus_sqlite_delete(c, page, idx);
+      touched += CORPUS_PAGE / 4;
+    }
+  }
+
+  if (!c->buf.failed) corpus_sqlite_header(c);
+}
+
+// json: an array of user records, serialised one per line.  Records are
+// updated, inserted and removed between versions and the document is
+// written out again, so numbers and timestamps change length.
+
+static const char *const corpus_tags[] = {"admin", "beta", "billing", "mobile", "trial", "vip"};
+
+static void
+corpus_json_record(corpus_t *c, corpus_record_t *r) {
+  c->clock += corpus_below(c, 60000);
+
+  r->id = c->next_id++;
+  r->name = (uint32_t)corpus_below(c, CORPUS_NWORDS * CORPUS_NWORDS);
+  r->count = (uint32_t)corpus_below(c, 1000);
+  r->updated = c->clock;
+  r->tags = (uint8_t)corpus_below(c, 64);
+  r->active = corpus_below(c, 4) != 0;
+}
+
+static bool
+corpus_json_insert(corpus_t *c, size_t at) {
+  if (c->nrecords == c->crecords) {
+    size_t cap = c->crecords ? c->crecords * 2 : 256;
+    corpus_record_t *records = realloc(c->records, cap * sizeof(corpus_record_t));
+
+    if (records == NULL) {
+      c->buf.failed = true;
+      return false;
+    }
+
+    c->records = records;
+    c->crecords = cap;
+  }
+
+  memmove(c->records + at + 1, c->records + at, (c->nrecords - at) * sizeof(corpus_record_t));
+  corpus_json_record(c, c->records + at);
+  c->nrecords++;
+
+  return true;
+}
+
+static void
+corpus_json_write(corpus_t *c) {
+  c->buf.len = 0;
+  corpus_append(&c->buf, "[\n", 2);
+
+  for (size_t i = 0; i < c->nrecords && !c->buf.failed; i++) {
+    const corpus_record_t *r = c->records + i;
+    const char *first = corpus_words[r->name % CORPUS_NWORDS];
+    const char *last = corpus_words[r->name / CORPUS_NWORDS];
+    uint64_t t = r->updated;
+
+    char tags[128];
+    size_t tags_len = 0;
+    tags[0] = 0;
+
+    for (size_t j = 0; j < sizeof(corpus_tags) / sizeof(corpus_tags[0]); j++) {
+      if (!(r->tags & (1 << j))) continue;
+      tags_len += (size_t)snprintf(tags + tags_len, sizeof(tags) - tags_len, "%s\"%s\"", tags_len ? ", " : "", corpus_tags[j]);
+    }
+
+    corpus_printf(
+      &c->buf,
+      "  {\"id\": %u, \"name\": \"%s %s\", \"email\": \"%s.%s%u@example.com\", \"active\": %s, \"count\": %u, "
+      "\"updated\": \"2026-10-%02uT%02u:%02u:%02uZ\", \"tags\": [%s]}%s\n",
+      r->id, first, last, first, last, r->id, r->active ? "true" : "false", r->count,
+      (unsigned)(1 + (t / 86400000) % 28), (unsigned)((t / 3600000) % 24), (unsigned)((t / 60000) % 60),
+      (unsigned)((t / 1000) % 60), tags, i + 1 < c->nrecords ? "," : ""
+    );
+  }
+
+  corpus_append(&c->buf, "]\n", 2);
+}
+
+static void
+corpus_json_init(corpus_t *c) {
+  c->next_id = 1;
+
+  // Records serialise to about 180 bytes
+  size_t n = c->size / 180;
+  if (n == 0) n = 1;
+
+  for (size_t i = 0; i < n && !c->buf.failed; i++) corpus_json_insert(c, i);
+
+  corpus_json_write(c);
+}
+
+static void
+corpus_json_next(corpus_t *c) {
+  size_t ops = corpus_budget(c) / 180;
+  if (ops == 0) ops = 1;
+
+  for (size_t i = 0; i < ops && !c->buf.failed; i++) {
+    size_t op = corpus_below(c, 10);
+
+    if (op == 8 || c->nrecords < 2) {
+      corpus_json_insert(c, corpus_below(c, c->nrecords + 1));
+    } else if (op == 9) {
+      size_t at = corpus_below(c, c->nrecords);
+      memmove(c->records + at, c->records + at + 1, (c->nrecords - at - 1) * sizeof(corpus_record_t));
+      c->nrecords--;
+    } else {
+      corpus_record_t *r = c->records + corpus_below(c, c->nrecords);
+
+      c->clock += corpus_below(c, 60000);
+      r->count += (uint32_t)corpus_below(c, 100);
+      r->updated = c->clock;
+      if (corpus_below(c, 8) == 0) r->active = !r->active;
+      if (corpus_below(c, 4) == 0) r->tags ^= (uint8_t)(1 << corpus_below(c, 6));
+    }
+  }
+
+  corpus_json_write(c);
+}
+
+// vm-image: a sparse disk image of 4 KiB blocks.  Block 0 is a superblock,
+// block 1 the allocation bitmap and block 2 a journal.  Versions write,
+// allocate and discard blocks and rewrite single sectors.
+
+#define CORPUS_BLOCK 4096
+#define CORPUS_SECTOR 512
+#define CORPUS_FIRST_DATA 3
+
+static void
+corpus_vm_fill(corpus_t *c, char *p, size_t len) {
+  switch (corpus_below(c, 3)) {
+  case 0:
+    // Already compressed file contents
+    for (size_t i = 0; i < len; i++) p[i] = (char)bench_corpus_random(&c->rng);
+    break;
+
+  case 1: {
+    // Text
+    size_t i = 0;
+
+    while (i < len) {
+      const char *word = corpus_word(c);
+      size_t n = strlen(word);
+      if (n > len - i) n = len - i;
+      memcpy(p + i, word, n);
+      i += n;
+      if (i < len) p[i++] = corpus_below(c, 10) == 0 ? '\n' : ' ';
+    }
+    break;
+  }
+
+  default: {
+    // Fixed-size records with a counter, like an inode table
+    uint32_t base = (uint32_t)bench_corpus_random(&c->rng);
+
+    for (size_t i = 0; i + 64 <= len; i += 64) {
+      memset(p + i, 0, 64);
+      corpus_put32le(p + i, base + (uint32_t)i / 64);
+      corpus_put32le(p + i + 4, 0x81a4);
+      corpus_put32le(p + i + 8, (uint32_t)corpus_below(c, 1 << 20));
+    }
+    break;
+  }
+  }
+}
+
+static void
+corpus_vm_mark(corpus_t *c, size_t block, bool used) {
+  char *bitmap = c->buf.data + CORPUS_BLOCK;
+
+  c->used[block] = used;
+
+  if (block / 8 < CORPUS_BLOCK) {
+    if (used) bitmap[block / 8] |= (char)(1 << (block % 8));
+    else bitmap[block / 8] &= (char)~(1 << (block % 8));
+  }
+}
+
+static void
+corpus_vm_write(corpus_t *c, size_t block) {
+  corpus_vm_fill(c, c->buf.data + block * CORPUS_BLOCK, CORPUS_BLOCK);
+  corpus_vm_mark(c, block, true);
+}
+
+static void
+corpus_vm_metadata(corpus_t *c, const uint32_t *written, size_t nwritten) {
+  char *super = c->buf.data;
+  char *journal = c->buf.data + 2 * CORPUS_BLOCK;
+
+  memcpy(super, "VMIMG01", 8);
+  corpus_put32le(super + 8, (uint32_t)c->nblocks);
+  corpus_put32le(super + 12, c->generation);
+
+  memset(journal, 0, CORPUS_BLOCK);
+  corpus_put32le(journal, c->generation);
+  corpus_put32le(journal + 4, (uint32_t)nwritten);
+
+  for (size_t i = 0; i < nwritten && 8 + 4 * (i + 1) <= CORPUS_BLOCK; i++) {
+    corpus_put32le(journal + 8 + 4 * i, written[i]);
+  }
+}
+
+static void
+corpus_vm_init(corpus_t *c) {
+  c->nblocks = c->size / CORPUS_BLOCK;
+  if (c->nblocks < 16) c->nblocks = 16;
+
+  c->used = calloc(c->nblocks, 1);
+
+  if (c->used == NULL) {
+    c->buf.failed = true;
+    return;
+  }
+
+  corpus_append(&c->buf, NULL, c->nblocks * CORPUS_BLOCK);
+  if (c->buf.failed) return;
+
+  // Allocate about 40% of the disk in extents
+  size_t data_blocks = c->nblocks - CORPUS_FIRST_DATA;
+  size_t allocated = 0;
+
+  while (allocated < data_blocks * 2 / 5) {
+    size_t start = CORPUS_FIRST_DATA + corpus_below(c, data_blocks);
+    size_t len = 1 + corpus_below(c, 64);
+
+    for (size_t b = start; b < start + len && b < c->nblocks; b++) {
+      if (!c->used[b]) allocated++;
+      corpus_vm_write(c, b);
+    }
+  }
+
+  corpus_vm_metadata(c, NULL, 0);
+}
+
+static size_t
+corpus_vm_pick(corpus_t *c, bool used) {
+  size_t data_blocks = c->nblocks - CORPUS_FIRST_DATA;
+  size_t block = CORPUS_FIRST_DATA;
+
+  for (int tries = 0; tries < 16; tries++) {
+    block = CORPUS_FIRST_DATA + corpus_below(c, data_blocks);
+    if (c->used[block] == used) break;
+  }
+
+  return block;
+}
+
+static void
+corpus_vm_next(corpus_t *c) {
+  size_t writes = corpus_budget(c) / CORPUS_BLOCK;
+  if (writes == 0) writes = 1;
+
+  uint32_t *written = malloc(writes * sizeof(uint32_t));
+
+  if (written == NULL) {
+    c->buf.failed = true;
+    return;
+  }
+
+  c->generation++;
+
+  for (size_t i = 0; i < writes; i++) {
+    size_t op = corpus_below(c, 10);
+    size_t block;
+
+    if (op < 5) {
+      block = corpus_vm_pick(c, true);
+      corpus_vm_write(c, block);
+    } else if (op < 7) {
+      block = corpus_vm_pick(c, false);
+      corpus_vm_write(c, block);
+    } else if (op == 7) {
+      // Discarded blocks read back as zeros
+      block = corpus_vm_pick(c, true);
+      memset(c->buf.data + block * CORPUS_BLOCK, 0, CORPUS_BLOCK);
+      corpus_vm_mark(c, block, false);
+    } else {
+      block = corpus_vm_pick(c, true);
+      size_t sector = corpus_below(c, CORPUS_BLOCK / CORPUS_SECTOR);
+      corpus_vm_fill(c, c->buf.data + block * CORPUS_BLOCK + sector * CORPUS_SECTOR, CORPUS_SECTOR);
+      corpus_vm_mark(c, block, true);
+    }
+
+    written[i] = (uint32_t)block;
+  }
+
+  corpus_vm_metadata(c, written, writes);
+  free(written);
+}
+
+static const corpus_kind_t corpus_kinds[] = {
+  {"source-tree", corpus_source_init, corpus_source_next},
+  {"executable", corpus_executable_init, corpus_executable_next},
+  {"log", corpus_log_init, corpus_log_next},
+  {"sqlite", corpus_sqlite_init, corpus_sqlite_next},
+  {"json", corpus_json_init, corpus_json_next},
+  {"vm-image", corpus_vm_init, corpus_vm_next},
+  {"binary", corpus_binary_init, corpus_point_mutations},
+  {"text", corpus_text_init, corpus_point_mutations},
+  {"random", corpus_random_init, corpus_point_mutations}
+};
+
+#define CORPUS_NKINDS (sizeof(corpus_kinds) / sizeof(corpus_kinds[0]))
+
+const char *
+bench_corpus_kind(size_t i) {
+  return i < CORPUS_NKINDS ? corpus_kinds[i].name : NULL;
+}
+
+void
+bench_corpus_release(bench_version_t *versions, int count) {
+  for (int i = 0; i < count; i++) {
+    free(versions[i].data);
+    versions[i].data = NULL;
+    versions[i].len = 0;
+  }
+}
+
+int
+bench_corpus_generate(const char *kind, size_t size, double churn, uint64_t seed, bench_version_t *versions, int count) {
+  const corpus_kind_t *k = NULL;
+
+  for (size_t i = 0; i < CORPUS_NKINDS; i++) {
+    if (strcmp(corpus_kinds[i].name, kind) == 0) k = &corpus_kinds[i];
+  }
+
+  if (k == NULL) return -1;
+
+  corpus_t c;
+  memset(&c, 0, sizeof(c));
+
+  c.rng = seed ? seed : 1;
+  c.size = size;
+  c.churn = churn;
+
+  int err = 0;
+  int done = 0;
+
+  k->init(&c);
+
+  for (; done < count; done++) {
+    if (done > 0) k->next(&c);
+
+    if (c.buf.failed || c.tmp.failed) {
+      err = -1;
+      break;
+    }
+
+    versions[done].data = malloc(c.buf.len > 0 ? c.buf.len : 1);
+
+    if (versions[done].data == NULL) {
+      err = -1;
+      break;
+    }
+
+    if (c.buf.len > 0) memcpy(versions[done].data, c.buf.data, c.buf.len);
+    versions[done].len = c.buf.len;
+  }
+
+  if (err) bench_corpus_release(versions, done);
+
+  free(c.buf.data);
+  free(c.tmp.data);
+  free(c.records);
+  free(c.used);
+
+  return err;
+}
@@ -0,0 +1,35 @@
+#ifndef BENCH_CORPUS_H
+#define BENCH_CORPUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Deterministic versioned corpora for the benchmarks.  Every kind starts
+// from a base version of roughly the requested size and derives each
+// following version from the previous one, changing about churn of its
+// bytes the way that kind of data changes in practice.  The output depends
+// only on the arguments, never on the platform or the C library.
+
+typedef struct {
+  char *data;
+  size_t len;
+} bench_version_t;
+
+// Name of the i-th corpus kind, or NULL past the last one
+const char *
+bench_corpus_kind(size_t i);
+
+// xorshift64* step shared by the benchmarks.  *state must not be zero.
+uint64_t
+bench_corpus_random(uint64_t *state);
+
+// Fill versions[0..count) with successive versions of the named kind.
+// Returns 0, or -1 for an unknown kind or when memory runs out, in which
+// case nothing is left allocated.
+int
+bench_corpus_generate(const char *kind, size_t size, double churn, uint64_t seed, bench_version_t *versions, int count);
+
+void
+bench_corpus_release(bench_version_t *versions, int count);
+
+#endif // BENCH_CORPUS_H
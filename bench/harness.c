@@ -0,0 +1,276 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "harness.h"
+
+uint64_t
+bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Hardware counters
+
+#ifdef __linux__
+
+static int bench_perf_fd[3] = {-1, -1, -1};
+
+static int
+bench_perf_open_counter(uint64_t config, int group) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.disabled = group == -1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+
+  return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+void
+bench_perf_close(void) {
+  for (int i = 2; i >= 0; i--) {
+    if (bench_perf_fd[i] != -1) close(bench_perf_fd[i]);
+    bench_perf_fd[i] = -1;
+  }
+}
+
+// Fails in containers and VMs without a PMU, or when perf_event_paranoid
+// forbids it
+bool
+bench_perf_open(void) {
+  static const uint64_t configs[3] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES
+  };
+
+  for (int i = 0; i < 3; i++) {
+    bench_perf_fd[i] = bench_perf_open_counter(configs[i], i == 0 ? -1 : bench_perf_fd[0]);
+
+    if (bench_perf_fd[i] == -1) {
+      fprintf(stderr, "bench: hardware counters unavailable (%s)\n", strerror(errno));
+      bench_perf_close();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void
+bench_perf_start(void) {
+  ioctl(bench_perf_fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(bench_perf_fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+bool
+bench_perf_stop(bench_counters_t *counters) {
+  ioctl(bench_perf_fd[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+  uint64_t values[4]; // nr followed by one value per counter
+
+  if (read(bench_perf_fd[0], values, sizeof(values)) != sizeof(values)) return false;
+
+  counters->cycles += values[1];
+  counters->cache_misses += values[2];
+  counters->branch_misses += values[3];
+
+  return true;
+}
+
+#else
+
+bool
+bench_perf_open(void) {
+  fprintf(stderr, "bench: hardware counters are only supported on Linux\n");
+  return false;
+}
+
+void
+bench_perf_close(void) {}
+
+void
+bench_perf_start(void) {}
+
+bool
+bench_perf_stop(bench_counters_t *counters) {
+  return false;
+}
+
+#endif
+
+// Statistics
+
+static int
+bench_compare_u64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a;
+  uint64_t y = *(const uint64_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+uint64_t
+bench_percentile(const uint64_t *samples, size_t n, double p) {
+  if (n == 0) return 0;
+
+  size_t rank = (size_t)(p * n + 0.999999);
+  if (rank < 1) rank = 1;
+  if (rank > n) rank = n;
+  return samples[rank - 1];
+}
+
+void
+bench_summarize(uint64_t *samples, size_t n, bench_summary_t *summary) {
+  memset(summary, 0, sizeof(*summary));
+  if (n == 0) return;
+
+  double total = 0;
+  for (size_t i = 0; i < n; i++) total += (double)samples[i];
+
+  qsort(samples, n, sizeof(uint64_t), bench_compare_u64);
+
+  summary->median_ns = bench_percentile(samples, n, 0.5);
+  summary->p99_ns = bench_percentile(samples, n, 0.99);
+  summary->p999_ns = bench_percentile(samples, n, 0.999);
+  summary->min_ns = samples[0];
+  summary->max_ns = samples[n - 1];
+  summary->mean_ns = total / n;
+}
+
+// Files and output
+
+char *
+bench_read_file(const char *path, size_t *len) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) return NULL;
+
+  char *data = NULL;
+
+  if (fseek(file, 0, SEEK_END) == 0) {
+    long size = ftell(file);
+
+    if (size >= 0 && fseek(file, 0, SEEK_SET) == 0) {
+      data = malloc(size > 0 ? (size_t)size : 1);
+
+      if (data != NULL && fread(data, 1, (size_t)size, file) != (size_t)size) {
+        free(data);
+        data = NULL;
+      }
+
+      *len = (size_t)size;
+    }
+  }
+
+  fclose(file);
+  return data;
+}
+
+void
+bench_json_string(FILE *out, const char *s) {
+  fputc('"', out);
+
+  for (; *s; s++) {
+    unsigned char c = (unsigned char)*s;
+
+    if (c == '"' || c == '\\') fprintf(out, "\\%c", c);
+    else if (c < 0x20) fprintf(out, "\\u%04x", c);
+    else fputc(c, out);
+  }
+
+  fputc('"', out);
+}
+
+// Peak memory.  Writing 5 to /proc/self/clear_refs resets VmHWM to the
+// current RSS, so the high-water mark read afterwards belongs to the code
+// that ran in between.
+
+#ifdef __linux__
+
+static int64_t bench_peak_base = -1;
+
+// Read a "Name:   1234 kB" line of /proc/self/status in bytes
+static int64_t
+bench_proc_status(const char *name) {
+  FILE *file = fopen("/proc/self/status", "r");
+  if (file == NULL) return -1;
+
+  char line[256];
+  size_t len = strlen(name);
+  int64_t value = -1;
+
+  while (fgets(line, sizeof(line), file)) {
+    if (strncmp(line, name, len) == 0 && line[len] == ':') {
+      value = strtoll(line + len + 1, NULL, 10) * 1024;
+      break;
+    }
+  }
+
+  fclose(file);
+  return value;
+}
+
+void
+bench_peak_reset(void) {
+#ifdef __GLIBC__
+  static bool tuned = false;
+
+  // Serve large blocks straight from mmap() and give them back on free(),
+  // so each measurement sees its own allocations rather than reused heap
+  if (!tuned) {
+    mallopt(M_MMAP_THRESHOLD, 64 * 1024);
+    mallopt(M_TRIM_THRESHOLD, 128 * 1024);
+    tuned = true;
+  }
+
+  malloc_trim(0);
+#endif
+
+  FILE *file = fopen("/proc/self/clear_refs", "w");
+  bool cleared = file != NULL && fputs("5", file) >= 0;
+
+  if (file != NULL && fclose(file) != 0) cleared = false;
+
+  bench_peak_base = cleared ? bench_proc_status("VmRSS") : -1;
+}
+
+int64_t
+bench_peak_bytes(void) {
+  if (bench_peak_base < 0) return -1;
+
+  int64_t peak = bench_proc_status("VmHWM");
+  if (peak < 0) return -1;
+
+  return peak > bench_peak_base ? peak - bench_peak_base : 0;
+}
+
+#else
+
+void
+bench_peak_reset(void) {}
+
+int64_t
+bench_peak_bytes(void) {
+  return -1;
+}
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Measurement helpers shared by the native benchmarks
+
+typedef struct {
+  uint64_t cycles;
+  uint64_t cache_misses;
+  uint64_t branch_misses;
+} bench_counters_t;
+
+typedef struct {
+  uint64_t median_ns;
+  uint64_t p99_ns;
+  uint64_t p999_ns;
+  uint64_t min_ns;
+  uint64_t max_ns;
+  double mean_ns;
+} bench_summary_t;
+
+// Monotonic clock in nanoseconds
+uint64_t
+bench_now(void);
+
+// Open cycles, cache misses and branch misses as one perf_event group of
+// the calling thread.  Returns false, after saying why on stderr, when the
+// counters are unavailable.
+bool
+bench_perf_open(void);
+
+void
+bench_perf_close(void);
+
+void
+bench_perf_start(void);
+
+// Stop counting and add the counts since bench_perf_start() to *counters
+bool
+bench_perf_stop(bench_counters_t *counters);
+
+// Nearest-rank percentile of n sorted samples
+uint64_t
+bench_percentile(const uint64_t *samples, size_t n, double p);
+
+// Sort the samples in place and summarise them
+void
+bench_summarize(uint64_t *samples, size_t n, bench_summary_t *summary);
+
+// Read a whole file into a malloc()ed buffer, or return NULL
+char *
+bench_read_file(const char *path, size_t *len);
+
+void
+bench_json_string(FILE *out, const char *s);
+
+// Peak resident memory.  bench_peak_reset() starts a new measurement and
+// bench_peak_bytes() returns how far resident memory rose above where it
+// was then, or -1 where this cannot be measured.  Only Linux supports it.
+void
+bench_peak_reset(void);
+
+int64_t
+bench_peak_bytes(void);
+
+#endif // BENCH_HARNESS_H
@@ -1,41 +1,16 @@
 #include <assert.h>
 #include <bare.h>
+#include <delta.h>
 #include <js.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <lz4frame.h>
 #include <uv.h>
 #include <zstd.h>
 
-// Forward declarations for delta.c functions
-int delta_create(
-  const char *zSrc,      
-  size_t lenSrc,         
-  const char *zOut,      
-  size_t lenOut,         
-  char *zDelta          
-);
-
-int delta_apply(
-  const char *zSrc,      
-  size_t lenSrc,         
-  const char *zDelta,    
-  size_t lenDelta,       
-  char *zOut             
-);
-
-int delta_output_size(const char *zDelta, size_t lenDelta);
-
-int delta_create_with_options(
-  const char *zSrc,
-  size_t lenSrc,
-  const char *zOut,
-  size_t lenOut,
-  char *zDelta,
-  int nhash,
-  int searchLimit
-);
-
+#include "probes.h"
 
 // Extract and validate buffer from JavaScript value
 static int
@@ -52,6 +27,170 @@ extract_buffer(js_env_t *env, js_value_t *value, void **data, size_t *len, const
   return result;
 }
 
+// Release a native result once the ArrayBuffer wrapping it is collected
+static void
+bare_delta_finalize_result(js_env_t *env, void *data, void *finalize_hint) {
+  free(data);
+}
+
+// Hand a malloc'd result to JavaScript as a Uint8Array without copying it.
+// The ArrayBuffer takes ownership of the memory and frees it when collected.
+static int
+bare_delta_create_result(js_env_t *env, char *data, size_t len, js_value_t **result) {
+  int err;
+  js_value_t *arraybuffer;
+  
+  if (data == NULL || len == 0) {
+    // Handle edge case where result is empty but not an error
+    free(data);
+    
+    void *empty;
+    err = js_create_arraybuffer(env, 0, &empty, &arraybuffer);
+    if (err != 0) return err;
+  } else {
+    err = js_create_external_arraybuffer(env, data, len, bare_delta_finalize_result, NULL, &arraybuffer);
+    if (err != 0) {
+      free(data);
+      return err;
+    }
+  }
+  
+  return js_create_typedarray(env, js_uint8array, len, arraybuffer, 0, result);
+}
+
+// Hand a packed buffer of results to JavaScript as an array of Uint8Array
+// views, one per offsets[i]..offsets[i + 1], all sharing one ArrayBuffer.
+static int
+bare_delta_create_results(js_env_t *env, char *data, size_t len, const size_t *offsets, size_t count, js_value_t **result) {
+  int err;
+  js_value_t *arraybuffer;
+  
+  if (data == NULL || len == 0) {
+    free(data);
+    
+    void *empty;
+    err = js_create_arraybuffer(env, 0, &empty, &arraybuffer);
+    if (err != 0) return err;
+  } else {
+    err = js_create_external_arraybuffer(env, data, len, bare_delta_finalize_result, NULL, &arraybuffer);
+    if (err != 0) {
+      free(data);
+      return err;
+    }
+  }
+  
+  err = js_create_array_with_length(env, count, result);
+  if (err != 0) return err;
+  
+  for (size_t i = 0; i < count; i++) {
+    js_value_t *view;
+    err = js_create_typedarray(env, js_uint8array, offsets[i + 1] - offsets[i], arraybuffer, offsets[i], &view);
+    if (err != 0) return err;
+    
+    err = js_set_element(env, *result, (uint32_t)i, view);
+    if (err != 0) return err;
+  }
+  
+  return 0;
+}
+
+static void
+bare_delta_set_uint32(js_env_t *env, js_value_t *object, const char *name, uint32_t value) {
+  js_value_t *prop;
+  int err = js_create_uint32(env, value, &prop);
+  assert(err == 0);
+  err = js_set_named_property(env, object, name, prop);
+  assert(err == 0);
+}
+
+static void
+bare_delta_set_double(js_env_t *env, js_value_t *object, const char *name, double value) {
+  js_value_t *prop;
+  int err = js_create_double(env, value, &prop);
+  assert(err == 0);
+  err = js_set_named_property(env, object, name, prop);
+  assert(err == 0);
+}
+
+// Counters for a single create or apply requested with the `stats` option
+typedef struct {
+  delta_stats engine;
+  uint64_t compress_ns;
+  uint64_t decompress_ns;
+} bare_delta_stats_t;
+
+// Hand a result over as { delta, stats } for create or { target, stats } for
+// apply, with times in milliseconds
+static int
+bare_delta_create_stats_result(js_env_t *env, char *data, size_t len, const bare_delta_stats_t *stats, bool apply, js_value_t **result) {
+  int err;
+  js_value_t *buffer;
+  err = bare_delta_create_result(env, data, len, &buffer);
+  if (err != 0) return err;
+  
+  err = js_create_object(env, result);
+  if (err != 0) return err;
+  
+  err = js_set_named_property(env, *result, apply ? "target" : "delta", buffer);
+  if (err != 0) return err;
+  
+  js_value_t *object;
+  err = js_create_object(env, &object);
+  if (err != 0) return err;
+  
+  const delta_stats *engine = &stats->engine;
+  
+  if (apply) {
+    bare_delta_set_double(env, object, "decompressTime", stats->decompress_ns / 1e6);
+    bare_delta_set_double(env, object, "applyTime", engine->nsApply / 1e6);
+  } else {
+    bare_delta_set_double(env, object, "indexTime", engine->nsIndex / 1e6);
+    bare_delta_set_double(env, object, "scanTime", engine->nsScan / 1e6);
+    bare_delta_set_double(env, object, "compressTime", stats->compress_ns / 1e6);
+    bare_delta_set_double(env, object, "probes", (double)engine->nProbe);
+    bare_delta_set_double(env, object, "chainSteps", (double)engine->nChain);
+    bare_delta_set_double(env, object, "rejections", (double)engine->nReject);
+    bare_delta_set_double(env, object, "forwardBytes", (double)engine->nForward);
+    bare_delta_set_double(env, object, "backwardBytes", (double)engine->nBackward);
+  }
+  
+  bare_delta_set_double(env, object, "copies", (double)engine->nCopy);
+  bare_delta_set_double(env, object, "copyBytes", (double)engine->nCopyBytes);
+  bare_delta_set_double(env, object, "literals", (double)engine->nInsert);
+  bare_delta_set_double(env, object, "literalBytes", (double)engine->nInsertBytes);
+  
+  return js_set_named_property(env, *result, "stats", object);
+}
+
+// Compression modes accepted by the `compressed` option
+enum {
+  BARE_DELTA_COMPRESSION_NONE = 0,
+  BARE_DELTA_COMPRESSION_ZSTD = 1,
+  BARE_DELTA_COMPRESSION_AUTO = 2,
+  BARE_DELTA_COMPRESSION_LZ4 = 3,
+};
+
+// Deltas smaller than this are never worth compressing in auto mode
+#define BARE_DELTA_AUTO_MIN_SIZE 64
+
+// Maximum number of bytes sampled when estimating delta entropy
+#define BARE_DELTA_AUTO_SAMPLE_SIZE 4096
+
+// Skip compression in auto mode when sampled entropy exceeds this many bits per byte
+#define BARE_DELTA_AUTO_MAX_ENTROPY 7.5
+
+// Keep the raw delta in auto mode unless compression saves at least 1/N of it
+#define BARE_DELTA_AUTO_MIN_SAVINGS 16
+
+// Worst-case number of bytes an uncompressed delta adds on top of the target
+#define BARE_DELTA_CREATE_OVERHEAD 1024
+
+// Returned when a caller-provided output buffer is too small
+#define BARE_DELTA_OUT_OF_RANGE (-8)
+
+// Set on requests turned away by admission control
+#define BARE_DELTA_OVERLOADED (-9)
+
 // Parse delta creation options from JavaScript object
 static void
 parse_create_options(js_env_t *env, js_value_t *options, int *nhash, int *searchLimit, int *compressed) {
@@ -59,8 +198,8 @@ parse_create_options(js_env_t *env, js_value_t *options, int *nhash, int *search
   js_value_t *prop;
   
   // Set defaults
-  *nhash = 16;  // NHASH_DEFAULT
-  *searchLimit = 250;  // SEARCH_LIMIT_DEFAULT
+  *nhash = DELTA_NHASH_DEFAULT;
+  *searchLimit = DELTA_SEARCH_LIMIT_DEFAULT;
   *compressed = 0;  // No compression by default
   
   // Check if options is null (passed from C code) or JS null/undefined
@@ -98,18 +237,124 @@ parse_create_options(js_env_t *env, js_value_t *options, int *nhash, int *search
   // compressed
   if (js_get_named_property(env, options, "compressed", &prop) == 0) {
     js_value_type_t prop_type;
-    if (js_typeof(env, prop, &prop_type) == 0 && prop_type == js_boolean) {
+    err = js_typeof(env, prop, &prop_type);
+    if (err != 0) return;
+
+    if (prop_type == js_boolean) {
       bool value;
       if (js_get_value_bool(env, prop, &value) == 0) {
-        *compressed = value ? 1 : 0;
+        *compressed = value ? BARE_DELTA_COMPRESSION_ZSTD : BARE_DELTA_COMPRESSION_NONE;
+      }
+    } else if (prop_type == js_string) {
+      utf8_t value[8] = {0};
+      size_t len;
+      if (js_get_value_string_utf8(env, prop, value, sizeof(value) - 1, &len) == 0) {
+        if (strcmp((const char *)value, "auto") == 0) {
+          *compressed = BARE_DELTA_COMPRESSION_AUTO;
+        } else if (strcmp((const char *)value, "zstd") == 0) {
+          *compressed = BARE_DELTA_COMPRESSION_ZSTD;
+        } else if (strcmp((const char *)value, "lz4") == 0) {
+          *compressed = BARE_DELTA_COMPRESSION_LZ4;
+        }
       }
     }
   }
 }
 
-// Request structure for async operations - following bare-xdiff pattern
+// Scheduling lanes for the worker pool, drained in priority order
+enum {
+  BARE_DELTA_LANE_INTERACTIVE = 0,
+  BARE_DELTA_LANE_BACKGROUND = 1,
+  BARE_DELTA_LANE_COUNT = 2,
+};
+
+// Default number of worker threads, started lazily on first use
+#define BARE_DELTA_POOL_THREADS_DEFAULT 2
+
+// Upper bound on the number of worker threads
+#define BARE_DELTA_POOL_THREADS_MAX 64
+
+// Passed to bare_delta_pool_next() when the JS thread runs queued requests
+// itself, because the pool has no threads
+#define BARE_DELTA_POOL_JS_THREAD UINT32_MAX
+
+// Default number of requests that may wait in the queues before new ones are rejected
+#define BARE_DELTA_POOL_QUEUE_LIMIT_DEFAULT 4096
+
+// Operations a request can carry out on a worker
+enum {
+  BARE_DELTA_OP_CREATE = 0,
+  BARE_DELTA_OP_APPLY = 1,
+  BARE_DELTA_OP_APPLY_BATCH = 2,
+  BARE_DELTA_OP_CREATE_MANY = 3,
+  BARE_DELTA_OP_APPLY_MANY = 4,
+  BARE_DELTA_OP_ENCODE = 5,
+  BARE_DELTA_OP_DECODE = 6,
+  BARE_DELTA_OP_COUNT = 7,
+};
+
+// Independent (source, target|delta) pairs handled by a single request. The
+// pointer and length arrays share one allocation; offsets[i]..offsets[i + 1]
+// locates the i-th result in the packed output.
+typedef struct {
+  size_t count;
+  void **sources;
+  size_t *source_lens;
+  void **inputs;
+  size_t *input_lens;
+  size_t *offsets;
+  size_t failed; // Index of the pair that failed, if any
+} bare_delta_pairs_t;
+
+typedef struct bare_delta_request_s bare_delta_request_t;
+typedef struct bare_delta_pool_s bare_delta_pool_t;
+
+// State an Encoder or Decoder keeps between calls. Scratch buffers only ever
+// grow, so steady-state calls reuse them without allocating.
 typedef struct {
-  uv_work_t request;
+  // Encoder options, parsed once
+  int nhash;
+  int search_limit;
+  int compressed;
+  
+  // Hash table sized to the largest source seen so far
+  int *index;
+  size_t index_len;
+  
+  // Raw delta for an encoder, decompressed delta for a decoder
+  char *scratch;
+  size_t scratch_len;
+  
+  // Compressed delta for an encoder, spare output for a decoder
+  char *packed;
+  size_t packed_len;
+  
+  // Compression contexts, created on first use
+  ZSTD_CCtx *zstd_cctx;
+  ZSTD_DCtx *zstd_dctx;
+  LZ4F_cctx *lz4_cctx;
+  LZ4F_dctx *lz4_dctx;
+  
+  // Async calls run one at a time; the rest wait here in order
+  bool busy;
+  bare_delta_request_t *head;
+  bare_delta_request_t *tail;
+} bare_delta_codec_t;
+
+static void
+bare_delta_codec_next(bare_delta_pool_t *pool, bare_delta_codec_t *codec);
+
+// Request structure for async operations - following bare-xdiff pattern
+struct bare_delta_request_s {
+  bare_delta_pool_t *pool;
+  bare_delta_request_t *next; // Next request in a pool queue
+  int lane;
+  uint64_t submitted_at;
+  uint64_t queued_at;
+  
+  // Set from the JS thread to abandon the request, polled by the engine
+  volatile int cancelled;
+  
   js_env_t *env;
   js_ref_t *ctx;
   js_ref_t *callback;
@@ -129,13 +374,17 @@ typedef struct {
   int search_limit;
   int compressed;
   
+  // Engine counters, gathered for requests made with the `stats` option
+  bool want_stats;
+  bare_delta_stats_t stats;
+  
   // Output
   char *result;
   size_t result_len;
   int32_t error_code;
   
-  // Operation type
-  int is_apply; // 0 for create, 1 for apply, 2 for apply_batch
+  // Operation type, one of BARE_DELTA_OP_*
+  int op;
   
   // For batch operations
   void **batch_deltas;  // Array of delta pointers
@@ -143,42 +392,411 @@ typedef struct {
   size_t batch_count; // Number of deltas
   js_ref_t **batch_refs; // References to delta TypedArrays
   
+  // For createMany/applyMany, with a single reference pinning every buffer
+  bare_delta_pairs_t *pairs;
+  js_ref_t *pairs_ref;
+  
+  // For Encoder/Decoder calls, with a reference keeping the object alive
+  bare_delta_codec_t *codec;
+  js_ref_t *codec_ref;
+  bool holds_codec; // Set once the call owns the object, rather than waiting for it
+  
+  // Bytes the request holds while in flight, counted against the pool limit
+  uint64_t bytes;
+  bool admitted;
+  
   js_deferred_teardown_t *teardown;
-} bare_delta_request_t;
+};
 
-// Core delta creation logic - shared by sync and async
+// Per-lane request queue and scheduling statistics
+typedef struct {
+  bare_delta_request_t *head;
+  bare_delta_request_t *tail;
+  
+  uint32_t queued;
+  uint32_t active;
+  uint64_t submitted;
+  uint64_t completed;
+  uint64_t rejected;
+  uint64_t cancelled;
+  uint64_t wait_total; // Nanoseconds spent queued, summed over started requests
+  uint64_t wait_max;
+} bare_delta_lane_t;
+
+typedef struct {
+  bare_delta_pool_t *pool;
+  uv_thread_t thread;
+  uint32_t index;
+} bare_delta_worker_t;
+
+// Worker pool owned by bare-delta so long diffs never compete with fs and dns
+// work on the shared libuv threadpool. Threads are started lazily and requests
+// are handed back to the JS thread through an async handle.
+struct bare_delta_pool_s {
+  js_env_t *env;
+  uv_async_t async;
+  js_deferred_teardown_t *teardown;
+  
+  uv_mutex_t lock;
+  uv_cond_t available;
+  
+  bare_delta_worker_t workers[BARE_DELTA_POOL_THREADS_MAX];
+  uint32_t thread_count; // Threads started so far
+  uint32_t thread_limit; // Threads allowed to pick up work
+  uint32_t queue_limit;
+  
+  bare_delta_lane_t lanes[BARE_DELTA_LANE_COUNT];
+  
+  // Completed requests waiting to be delivered on the JS thread
+  bare_delta_request_t *done_head;
+  bare_delta_request_t *done_tail;
+  
+  uint32_t pending; // Submitted but not yet delivered, keeps the loop alive
+  bool closing;
+  
+  // Admission control, only touched on the JS thread. Requests beyond the
+  // in-flight limits wait here in submission order or are turned away.
+  uint32_t in_flight;
+  uint64_t in_flight_bytes;
+  uint32_t in_flight_limit; // 0 for no limit
+  uint64_t in_flight_bytes_limit; // 0 for no limit
+  bool reject_overload;
+  bare_delta_request_t *waiting_head;
+  bare_delta_request_t *waiting_tail;
+  uint32_t waiting;
+  uint64_t waiting_bytes;
+  uint64_t overloaded;
+  
+  // Encoder and Decoder calls waiting for their object, counted against the
+  // queue limit
+  uint32_t codec_queued;
+};
+
+// Failure classes reported as the `code` of errors and counted by metrics()
+enum {
+  BARE_DELTA_ERROR_NOMEM = 0,
+  BARE_DELTA_ERROR_INVALID_DELTA = 1,
+  BARE_DELTA_ERROR_CREATE_FAILED = 2,
+  BARE_DELTA_ERROR_COMPRESSION_FAILED = 3,
+  BARE_DELTA_ERROR_OUT_OF_RANGE = 4,
+  BARE_DELTA_ERROR_ABORTED = 5,
+  BARE_DELTA_ERROR_OVERLOADED = 6,
+  BARE_DELTA_ERROR_QUEUE_FULL = 7,
+  BARE_DELTA_ERROR_FAILED = 8,
+  BARE_DELTA_ERROR_COUNT = 9,
+};
+
+static const char *bare_delta_error_names[BARE_DELTA_ERROR_COUNT] = {
+  "ENOMEM", "INVALID_DELTA", "CREATE_FAILED", "COMPRESSION_FAILED", "OUT_OF_RANGE",
+  "ABORT_ERR", "OVERLOADED", "QUEUE_FULL", "FAILED"
+};
+
+// Classify the status returned by the core of an operation. Creates and
+// applies number their failures independently, so the operation decides.
 static int
-delta_create_core(const void *source, size_t source_len, const void *target, size_t target_len,
-                  int nhash, int search_limit, int compressed, char **result, size_t *result_len) {
-  // Allocate buffer for delta - worst case is target_len + small overhead
-  size_t delta_max = target_len + 1024;
-  char *delta_buffer = (char *)malloc(delta_max);
+bare_delta_error_class(int op, int32_t status) {
+  switch (status) {
+  case -7:
+    return BARE_DELTA_ERROR_ABORTED;
+  case BARE_DELTA_OUT_OF_RANGE:
+    return BARE_DELTA_ERROR_OUT_OF_RANGE;
+  case BARE_DELTA_OVERLOADED:
+    return BARE_DELTA_ERROR_OVERLOADED;
+  }
   
-  if (delta_buffer == NULL) {
-    return -1; // Memory allocation failed
+  if (op == BARE_DELTA_OP_CREATE || op == BARE_DELTA_OP_CREATE_MANY || op == BARE_DELTA_OP_ENCODE) {
+    switch (status) {
+    case -1:
+    case -4:
+      return BARE_DELTA_ERROR_NOMEM;
+    case -2:
+    case -3:
+      return BARE_DELTA_ERROR_CREATE_FAILED;
+    case -5:
+      return BARE_DELTA_ERROR_COMPRESSION_FAILED;
+    }
+  } else {
+    switch (status) {
+    case -2:
+    case -5:
+      return BARE_DELTA_ERROR_NOMEM;
+    case -1:
+    case -3:
+    case -4:
+    case -6:
+      return BARE_DELTA_ERROR_INVALID_DELTA;
+    }
   }
   
-  // Create the delta
-  int delta_len = delta_create_with_options(
-    (const char *)source, source_len,
-    (const char *)target, target_len,
-    delta_buffer, nhash, search_limit
-  );
+  return BARE_DELTA_ERROR_FAILED;
+}
+
+// Latency histograms are log-linear in nanoseconds: values below
+// 2^BARE_DELTA_HISTOGRAM_SUB_BITS have a bucket each, and every power of two
+// above is split into 2^BARE_DELTA_HISTOGRAM_SUB_BITS buckets, so a recorded
+// value is known to within 1/8 of itself across the whole uint64_t range
+#define BARE_DELTA_HISTOGRAM_SUB_BITS 3
+#define BARE_DELTA_HISTOGRAM_BUCKETS ((64 - BARE_DELTA_HISTOGRAM_SUB_BITS + 1) << BARE_DELTA_HISTOGRAM_SUB_BITS)
+
+typedef struct {
+  uint64_t count;
+  uint64_t sum;
+  uint64_t max;
+  uint64_t buckets[BARE_DELTA_HISTOGRAM_BUCKETS];
+} bare_delta_histogram_t;
+
+// Histograms kept by metrics()
+enum {
+  BARE_DELTA_HISTOGRAM_WAIT = 0, // Queued on the worker pool
+  BARE_DELTA_HISTOGRAM_EXECUTION = 1, // Running on a worker or inline
+  BARE_DELTA_HISTOGRAM_TOTAL = 2, // From the call until the result is delivered
+  BARE_DELTA_HISTOGRAM_COUNT = 3,
+};
+
+// Process-wide counters, sharded per thread so recording never takes a lock
+// or contends on a cache line. Each shard has one writer, the thread owning
+// it; metrics() sums every shard. Shards outlive their threads, and one given
+// up by an exiting worker is adopted by the next thread that records.
+typedef struct bare_delta_metrics_s bare_delta_metrics_t;
+
+struct bare_delta_metrics_s {
+  bare_delta_metrics_t *next;
+  bool owned;
   
-  if (delta_len < 0) {
-    free(delta_buffer);
-    return -2; // Delta creation failed
+  uint64_t operations[BARE_DELTA_OP_COUNT];
+  uint64_t failures[BARE_DELTA_ERROR_COUNT];
+  uint64_t bytes_in;
+  uint64_t bytes_out;
+  
+  bare_delta_histogram_t histograms[BARE_DELTA_HISTOGRAM_COUNT];
+};
+
+static uv_once_t bare_delta_metrics_guard = UV_ONCE_INIT;
+static uv_mutex_t bare_delta_metrics_lock; // Guards shard ownership only
+static bare_delta_metrics_t *bare_delta_metrics_head;
+static __thread bare_delta_metrics_t *bare_delta_metrics_shard;
+
+static void
+bare_delta_metrics_init(void) {
+  int err = uv_mutex_init(&bare_delta_metrics_lock);
+  assert(err == 0);
+}
+
+// Get the calling thread's shard, or NULL if none could be allocated
+static bare_delta_metrics_t *
+bare_delta_metrics_local(void) {
+  bare_delta_metrics_t *shard = bare_delta_metrics_shard;
+  if (shard) return shard;
+  
+  uv_once(&bare_delta_metrics_guard, bare_delta_metrics_init);
+  uv_mutex_lock(&bare_delta_metrics_lock);
+  
+  for (shard = bare_delta_metrics_head; shard; shard = shard->next) {
+    if (!shard->owned) break;
   }
   
-  // CRITICAL: Check for buffer overflow
-  if ((size_t)delta_len >= delta_max) {
-    free(delta_buffer);
-    return -3; // Buffer overflow error
+  if (shard == NULL) {
+    shard = (bare_delta_metrics_t *)calloc(1, sizeof(bare_delta_metrics_t));
+    
+    if (shard) {
+      // Readers walk the list without the lock, so publish the shard whole
+      shard->next = bare_delta_metrics_head;
+      __atomic_store_n(&bare_delta_metrics_head, shard, __ATOMIC_RELEASE);
+    }
+  }
+  
+  if (shard) shard->owned = true;
+  
+  uv_mutex_unlock(&bare_delta_metrics_lock);
+  
+  bare_delta_metrics_shard = shard;
+  return shard;
+}
+
+// Give up the calling thread's shard before the thread exits
+static void
+bare_delta_metrics_release(void) {
+  bare_delta_metrics_t *shard = bare_delta_metrics_shard;
+  if (shard == NULL) return;
+  
+  uv_mutex_lock(&bare_delta_metrics_lock);
+  shard->owned = false;
+  uv_mutex_unlock(&bare_delta_metrics_lock);
+  
+  bare_delta_metrics_shard = NULL;
+}
+
+// Add to a counter of the calling thread's shard. There is a single writer,
+// so a relaxed load and store suffice for readers to see whole values.
+static inline void
+bare_delta_metrics_add(uint64_t *counter, uint64_t value) {
+  __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + value, __ATOMIC_RELAXED);
+}
+
+static inline uint64_t
+bare_delta_metrics_read(const uint64_t *counter) {
+  return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+static inline uint32_t
+bare_delta_histogram_bucket(uint64_t value) {
+  if (value < (1 << BARE_DELTA_HISTOGRAM_SUB_BITS)) return (uint32_t)value;
+  
+  uint32_t shift = 63 - __builtin_clzll(value) - BARE_DELTA_HISTOGRAM_SUB_BITS;
+  return ((shift + 1) << BARE_DELTA_HISTOGRAM_SUB_BITS) +
+         (uint32_t)((value >> shift) & ((1 << BARE_DELTA_HISTOGRAM_SUB_BITS) - 1));
+}
+
+// Highest value that falls in a bucket
+static inline uint64_t
+bare_delta_histogram_bucket_max(uint32_t bucket) {
+  if (bucket < (1 << BARE_DELTA_HISTOGRAM_SUB_BITS)) return bucket;
+  
+  uint32_t shift = (bucket >> BARE_DELTA_HISTOGRAM_SUB_BITS) - 1;
+  uint64_t base = (1 << BARE_DELTA_HISTOGRAM_SUB_BITS) + (bucket & ((1 << BARE_DELTA_HISTOGRAM_SUB_BITS) - 1));
+  return ((base + 1) << shift) - 1;
+}
+
+static void
+bare_delta_metrics_time(bare_delta_metrics_t *shard, int histogram, uint64_t ns) {
+  bare_delta_histogram_t *h = &shard->histograms[histogram];
+  bare_delta_metrics_add(&h->count, 1);
+  bare_delta_metrics_add(&h->sum, ns);
+  bare_delta_metrics_add(&h->buckets[bare_delta_histogram_bucket(ns)], 1);
+  if (ns > h->max) __atomic_store_n(&h->max, ns, __ATOMIC_RELAXED);
+}
+
+// Record a finished operation in the calling thread's shard, with status the
+// value returned by its core. Sync calls also count their time as execution,
+// which the worker pool records separately for async ones.
+static void
+bare_delta_metrics_record(int op, uint64_t bytes_in, uint64_t bytes_out, int32_t status, uint64_t total_ns, bool sync) {
+  bare_delta_metrics_t *shard = bare_delta_metrics_local();
+  if (shard == NULL) return;
+  
+  bare_delta_metrics_add(&shard->operations[op], 1);
+  bare_delta_metrics_add(&shard->bytes_in, bytes_in);
+  
+  if (status < 0) {
+    bare_delta_metrics_add(&shard->failures[bare_delta_error_class(op, status)], 1);
+  } else {
+    bare_delta_metrics_add(&shard->bytes_out, bytes_out);
+  }
+  
+  bare_delta_metrics_time(shard, BARE_DELTA_HISTOGRAM_TOTAL, total_ns);
+  if (sync) bare_delta_metrics_time(shard, BARE_DELTA_HISTOGRAM_EXECUTION, total_ns);
+}
+
+// Count a failure that happened before an operation could start
+static void
+bare_delta_metrics_fail(int error) {
+  bare_delta_metrics_t *shard = bare_delta_metrics_local();
+  if (shard) bare_delta_metrics_add(&shard->failures[error], 1);
+}
+
+// Approximate log2 for positive integers, accurate to ~0.09 bits which is
+// plenty for a compression heuristic and avoids pulling in libm
+static double
+bare_delta_log2(uint32_t v) {
+  int msb = 0;
+  while ((v >> msb) > 1) msb++;
+  return msb + ((double)v / (double)((uint32_t)1 << msb) - 1.0);
+}
+
+// Estimate the order-0 entropy of a delta in bits per byte by sampling up to
+// BARE_DELTA_AUTO_SAMPLE_SIZE evenly spaced bytes. Deltas are dominated by
+// literal text, so this tracks how well the literals will compress.
+static double
+bare_delta_sample_entropy(const char *data, size_t len) {
+  uint32_t counts[256] = {0};
+  size_t stride = len > BARE_DELTA_AUTO_SAMPLE_SIZE ? len / BARE_DELTA_AUTO_SAMPLE_SIZE : 1;
+  uint32_t samples = 0;
+  
+  for (size_t i = 0; i < len && samples < BARE_DELTA_AUTO_SAMPLE_SIZE; i += stride) {
+    counts[(uint8_t)data[i]]++;
+    samples++;
+  }
+  
+  // H = log2(n) - (1/n) * sum(c * log2(c))
+  double sum = 0;
+  for (int i = 0; i < 256; i++) {
+    if (counts[i] > 1) sum += counts[i] * bare_delta_log2(counts[i]);
+  }
+  
+  return bare_delta_log2(samples) - sum / samples;
+}
+
+// Decide whether a delta is worth compressing in auto mode
+static int
+bare_delta_should_compress(const char *delta, size_t delta_len) {
+  if (delta_len < BARE_DELTA_AUTO_MIN_SIZE) {
+    return 0; // Frame overhead outweighs any savings
+  }
+  
+  return bare_delta_sample_entropy(delta, delta_len) <= BARE_DELTA_AUTO_MAX_ENTROPY;
+}
+
+// Bound on the size of a compressed delta of delta_len bytes
+static size_t
+bare_delta_compress_bound(int compressed, size_t delta_len) {
+  if (compressed == BARE_DELTA_COMPRESSION_LZ4) {
+    LZ4F_preferences_t prefs = LZ4F_INIT_PREFERENCES;
+    prefs.frameInfo.contentSize = delta_len;
+    return LZ4F_compressFrameBound(delta_len, &prefs);
+  }
+  
+  if (compressed != BARE_DELTA_COMPRESSION_NONE) {
+    return ZSTD_compressBound(delta_len);
+  }
+  
+  return 0;
+}
+
+// Compress a finished delta with zstd (also used in auto mode) or LZ4 into
+// out, which must hold bare_delta_compress_bound() bytes
+static int
+bare_delta_compress_into(const char *delta, size_t delta_len, int compressed, char *out, size_t out_cap, size_t *out_len) {
+  size_t compressed_size;
+  
+  if (compressed == BARE_DELTA_COMPRESSION_LZ4) {
+    // LZ4 frame with the content size recorded so apply can size its buffer up front
+    LZ4F_preferences_t prefs = LZ4F_INIT_PREFERENCES;
+    prefs.frameInfo.contentSize = delta_len;
+    
+    DELTA_PROBE1(lz4__compress__start, delta_len);
+    compressed_size = LZ4F_compressFrame(out, out_cap, delta, delta_len, &prefs);
+    DELTA_PROBE2(lz4__compress__done, delta_len, compressed_size);
+    
+    if (LZ4F_isError(compressed_size)) return -5; // Compression failed
+  } else {
+    DELTA_PROBE1(zstd__compress__start, delta_len);
+    compressed_size = ZSTD_compress(out, out_cap, delta, delta_len, 1);
+    DELTA_PROBE2(zstd__compress__done, delta_len, compressed_size);
+    
+    if (ZSTD_isError(compressed_size)) return -5; // Compression failed
   }
   
+  *out_len = compressed_size;
+  return 0;
+}
+
+// Whether an auto mode compression saved enough to keep
+static bool
+bare_delta_compression_paid_off(size_t compressed_len, size_t delta_len) {
+  return compressed_len + delta_len / BARE_DELTA_AUTO_MIN_SAVINGS < delta_len;
+}
+
+// Compress a finished delta as requested, taking ownership of delta_buffer.
+// On success *result holds the delta to hand out, trimmed to its size.
+static int
+bare_delta_compress_delta(char *delta_buffer, size_t delta_len, int compressed, char **result, size_t *result_len) {
   // Apply compression if requested
-  if (compressed) {
-    size_t compressed_bound = ZSTD_compressBound(delta_len);
+  if (compressed == BARE_DELTA_COMPRESSION_AUTO && !bare_delta_should_compress(delta_buffer, delta_len)) {
+    compressed = BARE_DELTA_COMPRESSION_NONE;
+  }
+  
+  if (compressed != BARE_DELTA_COMPRESSION_NONE) {
+    size_t compressed_bound = bare_delta_compress_bound(compressed, delta_len);
     char *compressed_result = (char *)malloc(compressed_bound);
     
     if (compressed_result == NULL) {
@@ -186,15 +804,20 @@ delta_create_core(const void *source, size_t source_len, const void *target, siz
       return -4; // Compression buffer allocation failed
     }
     
-    size_t compressed_size = ZSTD_compress(
-      compressed_result, compressed_bound,
-      delta_buffer, delta_len, 1
-    );
-    
-    if (ZSTD_isError(compressed_size)) {
+    size_t compressed_size;
+    int err = bare_delta_compress_into(delta_buffer, delta_len, compressed, compressed_result, compressed_bound, &compressed_size);
+    if (err != 0) {
       free(delta_buffer);
       free(compressed_result);
-      return -5; // Compression failed
+      return err;
+    }
+    
+    // In auto mode keep the raw delta unless compression paid off
+    if (compressed == BARE_DELTA_COMPRESSION_AUTO && !bare_delta_compression_paid_off(compressed_size, delta_len)) {
+      free(compressed_result);
+      *result = delta_buffer;
+      *result_len = delta_len;
+      return 0;
     }
     
     free(delta_buffer);
@@ -205,36 +828,184 @@ delta_create_core(const void *source, size_t source_len, const void *target, siz
     *result_len = delta_len;
   }
   
+  // Trim the worst-case allocation down to the actual size before it is
+  // handed to JavaScript, shrinking in place where the allocator allows
+  char *trimmed = (char *)realloc(*result, *result_len);
+  if (trimmed != NULL) {
+    *result = trimmed;
+  }
+  
   return 0; // Success
 }
 
-// Core batch delta application logic - applies multiple deltas sequentially
-static int
-delta_apply_batch_core(const void *source, size_t source_len, 
-                      void **deltas, size_t *delta_lens, size_t delta_count,
-                      int compressed, char **result, size_t *result_len);
-
-// Core delta application logic - shared by sync and async
+// Core delta creation logic - shared by sync and async
 static int
-delta_apply_core(const void *source, size_t source_len, const void *delta, size_t delta_len,
-                 int unused_compressed, char **result, size_t *result_len) {
-  const char *delta_data = (const char *)delta;
-  size_t final_delta_len = delta_len;
-  char *decompressed_delta = NULL;
+delta_create_core(const void *source, size_t source_len, const void *target, size_t target_len,
+                  int nhash, int search_limit, int compressed, const volatile int *cancel,
+                  bare_delta_stats_t *stats, char **result, size_t *result_len) {
+  // Allocate buffer for delta - worst case is target_len + small overhead
+  size_t delta_max = target_len + BARE_DELTA_CREATE_OVERHEAD;
+  char *delta_buffer = (char *)malloc(delta_max);
   
-  // Auto-detect zstd compression by checking for magic number
-  int is_compressed = 0;
-  if (delta_len >= 4) {
-    // Zstandard magic number: 0xFD2FB528 (little-endian)
-    const unsigned char *bytes = (const unsigned char *)delta;
-    if (bytes[0] == 0x28 && bytes[1] == 0xB5 && 
-        bytes[2] == 0x2F && bytes[3] == 0xFD) {
-      is_compressed = 1;
-    }
+  if (delta_buffer == NULL) {
+    return -1; // Memory allocation failed
+  }
+  
+  if (stats) stats->engine.xClock = uv_hrtime;
+  
+  // Create the delta
+  int delta_len = delta_create_with_stats(
+    (const char *)source, source_len,
+    (const char *)target, target_len,
+    delta_buffer, nhash, search_limit, cancel,
+    NULL, 0, stats ? &stats->engine : NULL
+  );
+  
+  if (delta_len == DELTA_CANCELLED) {
+    free(delta_buffer);
+    return -7; // Cancelled
+  }
+  
+  if (delta_len < 0) {
+    free(delta_buffer);
+    return -2; // Delta creation failed
+  }
+  
+  // CRITICAL: Check for buffer overflow
+  if ((size_t)delta_len >= delta_max) {
+    free(delta_buffer);
+    return -3; // Buffer overflow error
+  }
+  
+  uint64_t start = stats ? uv_hrtime() : 0;
+  int err = bare_delta_compress_delta(delta_buffer, delta_len, compressed, result, result_len);
+  if (stats) stats->compress_ns += uv_hrtime() - start;
+  
+  return err;
+}
+
+// Core batch delta application logic - applies multiple deltas sequentially
+static int
+delta_apply_batch_core(const void *source, size_t source_len, 
+                      void **deltas, size_t *delta_lens, size_t delta_count,
+                      int compressed, const volatile int *cancel, char **result, size_t *result_len);
+
+// Read the content size recorded in an LZ4 frame header, leaving *header_len
+// at the first byte past the header
+static int
+bare_delta_lz4_content_size(LZ4F_dctx *dctx, const char *src, size_t src_len, size_t *size, size_t *header_len) {
+  LZ4F_frameInfo_t info;
+  size_t src_pos = src_len;
+  size_t ret = LZ4F_getFrameInfo(dctx, &info, src, &src_pos);
+  
+  // A zero content size means the frame did not record it
+  if (LZ4F_isError(ret) || info.contentSize == 0 || info.contentSize > SIZE_MAX) {
+    return -1; // Invalid compressed format - magic number present but corrupt data
+  }
+  
+  *size = (size_t)info.contentSize;
+  *header_len = src_pos;
+  return 0;
+}
+
+// Decompress the blocks of an LZ4 frame following its header into dst, which
+// must hold exactly the recorded content size
+static int
+bare_delta_lz4_decompress_body(LZ4F_dctx *dctx, const char *src, size_t src_len, size_t src_pos, char *dst, size_t dst_len) {
+  size_t ret = 1;
+  size_t dst_pos = 0;
+  DELTA_PROBE1(lz4__decompress__start, src_len);
+  while (ret != 0 && src_pos < src_len) {
+    size_t dst_size = dst_len - dst_pos;
+    size_t src_size = src_len - src_pos;
+    
+    ret = LZ4F_decompress(dctx, dst + dst_pos, &dst_size, src + src_pos, &src_size, NULL);
+    if (LZ4F_isError(ret) || (dst_size == 0 && src_size == 0)) break;
+    
+    dst_pos += dst_size;
+    src_pos += src_size;
+  }
+  
+  DELTA_PROBE2(lz4__decompress__done, src_len, dst_pos);
+  
+  if (ret != 0 || dst_pos != dst_len) {
+    return -3; // Decompression failed - magic number present but corrupt data
+  }
+  
+  return 0;
+}
+
+// Decompress an LZ4 frame whose header records the content size
+static int
+bare_delta_decompress_lz4(const char *src, size_t src_len, char **result, size_t *result_len) {
+  LZ4F_dctx *dctx;
+  if (LZ4F_isError(LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION))) {
+    return -2; // Decompression context allocation failed
+  }
+  
+  size_t decompressed_size, src_pos;
+  int err = bare_delta_lz4_content_size(dctx, src, src_len, &decompressed_size, &src_pos);
+  if (err != 0) {
+    LZ4F_freeDecompressionContext(dctx);
+    return err;
+  }
+  
+  char *decompressed = (char *)malloc(decompressed_size);
+  if (decompressed == NULL) {
+    LZ4F_freeDecompressionContext(dctx);
+    return -2; // Decompression buffer allocation failed
+  }
+  
+  err = bare_delta_lz4_decompress_body(dctx, src, src_len, src_pos, decompressed, decompressed_size);
+  
+  LZ4F_freeDecompressionContext(dctx);
+  
+  if (err != 0) {
+    free(decompressed);
+    return err;
+  }
+  
+  *result = decompressed;
+  *result_len = decompressed_size;
+  return 0;
+}
+
+// Detect a zstd or LZ4 compressed delta by its magic number
+static int
+bare_delta_detect_compression(const void *delta, size_t delta_len) {
+  if (delta_len >= 4) {
+    const unsigned char *bytes = (const unsigned char *)delta;
+    if (bytes[0] == 0x28 && bytes[1] == 0xB5 && 
+        bytes[2] == 0x2F && bytes[3] == 0xFD) {
+      // Zstandard magic number: 0xFD2FB528 (little-endian)
+      return BARE_DELTA_COMPRESSION_ZSTD;
+    } else if (bytes[0] == 0x04 && bytes[1] == 0x22 &&
+               bytes[2] == 0x4D && bytes[3] == 0x18) {
+      // LZ4 frame magic number: 0x184D2204 (little-endian)
+      return BARE_DELTA_COMPRESSION_LZ4;
+    }
+  }
+  
+  return BARE_DELTA_COMPRESSION_NONE;
+}
+
+// Decompress a zstd or LZ4 compressed delta, detected by its magic number.
+// *decompressed is left NULL for an uncompressed delta.
+static int
+bare_delta_decompress_delta(const void *delta, size_t delta_len, char **decompressed, size_t *decompressed_len) {
+  const char *delta_data = (const char *)delta;
+  char *decompressed_delta = NULL;
+  
+  // Auto-detect zstd or LZ4 compression by checking for magic number
+  int is_compressed = bare_delta_detect_compression(delta, delta_len);
+  
+  // Handle decompression if LZ4 magic number detected
+  if (is_compressed == BARE_DELTA_COMPRESSION_LZ4) {
+    return bare_delta_decompress_lz4(delta_data, delta_len, decompressed, decompressed_len);
   }
   
   // Handle decompression if zstd magic number detected
-  if (is_compressed) {
+  if (is_compressed == BARE_DELTA_COMPRESSION_ZSTD) {
     unsigned long long decompressed_size = ZSTD_getFrameContentSize(delta_data, delta_len);
     
     if (decompressed_size == ZSTD_CONTENTSIZE_ERROR || 
@@ -247,20 +1018,112 @@ delta_apply_core(const void *source, size_t source_len, const void *delta, size_
       return -2; // Decompression buffer allocation failed
     }
     
+    DELTA_PROBE1(zstd__decompress__start, delta_len);
     size_t actual_size = ZSTD_decompress(
       decompressed_delta, decompressed_size,
       delta_data, delta_len
     );
+    DELTA_PROBE2(zstd__decompress__done, delta_len, actual_size);
     
     if (ZSTD_isError(actual_size)) {
       free(decompressed_delta);
       return -3; // Decompression failed - magic number present but corrupt data
     }
     
-    delta_data = decompressed_delta;
-    final_delta_len = actual_size;
+    *decompressed = decompressed_delta;
+    *decompressed_len = actual_size;
+  }
+  
+  return 0;
+}
+
+// Decompress just enough of a compressed delta to read the target size from
+// its header
+static int
+bare_delta_peek_output_size(int compression, const char *delta, size_t delta_len) {
+  char head[16];
+  size_t head_len = 0;
+  
+  if (compression == BARE_DELTA_COMPRESSION_LZ4) {
+    LZ4F_dctx *dctx;
+    if (LZ4F_isError(LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION))) return -2;
+    
+    size_t dst_size = sizeof(head);
+    size_t src_size = delta_len;
+    size_t ret = LZ4F_decompress(dctx, head, &dst_size, delta, &src_size, NULL);
+    LZ4F_freeDecompressionContext(dctx);
+    
+    if (LZ4F_isError(ret)) return -3;
+    head_len = dst_size;
+  } else {
+    ZSTD_DCtx *dctx = ZSTD_createDCtx();
+    if (dctx == NULL) return -2;
+    
+    ZSTD_outBuffer out = {head, sizeof(head), 0};
+    ZSTD_inBuffer in = {delta, delta_len, 0};
+    size_t ret = ZSTD_decompressStream(dctx, &out, &in);
+    ZSTD_freeDCtx(dctx);
+    
+    if (ZSTD_isError(ret)) return -3;
+    head_len = out.pos;
+  }
+  
+  int output_size = delta_output_size(head, head_len);
+  return output_size < 0 ? -4 : output_size;
+}
+
+// Estimate the memory applying a delta holds beyond the delta itself without
+// decoding anything. For a raw delta that is the target, read from the delta
+// header. For a compressed delta it is the decompressed delta, read from the
+// frame header, counted twice: once for itself and once in place of the
+// target, which is only known once the frame is decoded. Returns -1 when the
+// sizes cannot be read.
+static int64_t
+bare_delta_apply_bytes(const void *delta, size_t delta_len) {
+  int compression = bare_delta_detect_compression(delta, delta_len);
+  
+  if (compression == BARE_DELTA_COMPRESSION_NONE) {
+    int output_size = delta_output_size(delta, delta_len);
+    return output_size < 0 ? -1 : output_size;
+  }
+  
+  uint64_t decompressed_size;
+  
+  if (compression == BARE_DELTA_COMPRESSION_LZ4) {
+    const uint8_t *z = (const uint8_t *)delta;
+    
+    // The content size follows the FLG and BD bytes when FLG records it
+    if (delta_len < 14 || (z[4] & 0x08) == 0) return -1;
+    
+    decompressed_size = 0;
+    for (int i = 7; i >= 0; i--) decompressed_size = (decompressed_size << 8) | z[6 + i];
+  } else {
+    unsigned long long size = ZSTD_getFrameContentSize(delta, delta_len);
+    if (size == ZSTD_CONTENTSIZE_ERROR || size == ZSTD_CONTENTSIZE_UNKNOWN) return -1;
+    decompressed_size = size;
   }
   
+  if (decompressed_size > INT64_MAX / 2) return -1;
+  
+  return (int64_t)(decompressed_size * 2);
+}
+
+// Core delta application logic - shared by sync and async
+static int
+delta_apply_core(const void *source, size_t source_len, const void *delta, size_t delta_len,
+                 int unused_compressed, const volatile int *cancel, bare_delta_stats_t *stats,
+                 char **result, size_t *result_len) {
+  const char *delta_data = (const char *)delta;
+  size_t final_delta_len = delta_len;
+  char *decompressed_delta = NULL;
+  
+  uint64_t start = stats ? uv_hrtime() : 0;
+  int err = bare_delta_decompress_delta(delta, delta_len, &decompressed_delta, &final_delta_len);
+  if (stats) stats->decompress_ns += uv_hrtime() - start;
+  if (err != 0) return err;
+  
+  if (decompressed_delta) delta_data = decompressed_delta;
+  
   // Get output size from delta
   int output_size = delta_output_size(delta_data, final_delta_len);
   if (output_size < 0) {
@@ -275,13 +1138,21 @@ delta_apply_core(const void *source, size_t source_len, const void *delta, size_
     return -5; // Output buffer allocation failed
   }
   
+  if (stats) stats->engine.xClock = uv_hrtime;
+  
   // Apply the delta
-  int applied_len = delta_apply(
+  int applied_len = delta_apply_with_stats(
     (const char *)source, source_len,
     delta_data, final_delta_len,
-    output_buffer
+    output_buffer, cancel, stats ? &stats->engine : NULL
   );
   
+  if (applied_len == DELTA_CANCELLED) {
+    free(output_buffer);
+    if (decompressed_delta) free(decompressed_delta);
+    return -7; // Cancelled
+  }
+  
   if (applied_len < 0) {
     free(output_buffer);
     if (decompressed_delta) free(decompressed_delta);
@@ -298,12 +1169,12 @@ delta_apply_core(const void *source, size_t source_len, const void *delta, size_
 static int
 delta_apply_batch_core(const void *source, size_t source_len, 
                       void **deltas, size_t *delta_lens, size_t delta_count,
-                      int unused_compressed, char **result, size_t *result_len) {
+                      int unused_compressed, const volatile int *cancel, char **result, size_t *result_len) {
   if (delta_count == 0) {
     // No deltas to apply, return copy of source
     char *output = (char *)malloc(source_len);
     if (output == NULL) {
-      return -1;
+      return -5; // Output buffer allocation failed
     }
     memcpy(output, source, source_len);
     *result = output;
@@ -315,7 +1186,7 @@ delta_apply_batch_core(const void *source, size_t source_len,
   char *current_result;
   size_t current_len;
   int err = delta_apply_core(source, source_len, deltas[0], delta_lens[0], 
-                             0, &current_result, &current_len);
+                             0, cancel, NULL, &current_result, &current_len);
   if (err != 0) {
     return err;
   }
@@ -326,7 +1197,7 @@ delta_apply_batch_core(const void *source, size_t source_len,
     size_t next_len;
     
     err = delta_apply_core(current_result, current_len, deltas[i], delta_lens[i],
-                          0, &next_result, &next_len);
+                          0, cancel, NULL, &next_result, &next_len);
     
     free(current_result); // Free intermediate result
     
@@ -343,597 +1214,3663 @@ delta_apply_batch_core(const void *source, size_t source_len,
   return 0;
 }
 
-// Worker function - delegates to core logic
-static void
-bare_delta_work(uv_work_t *handle) {
-  bare_delta_request_t *request = (bare_delta_request_t *)handle->data;
+// Allocate a pair list for `count` jobs in a single block
+static bare_delta_pairs_t *
+bare_delta_pairs_alloc(size_t count) {
+  size_t size = sizeof(bare_delta_pairs_t) +
+                count * (2 * sizeof(void *) + 2 * sizeof(size_t)) +
+                (count + 1) * sizeof(size_t);
   
-  if (!request) {
-    return;
-  }
+  bare_delta_pairs_t *pairs = (bare_delta_pairs_t *)malloc(size);
+  if (pairs == NULL) return NULL;
   
-  if (request->is_apply == 2) {
-    // Batch apply
-    request->error_code = delta_apply_batch_core(
-      request->buf1, request->len1,
-      request->batch_deltas, request->batch_delta_lens, request->batch_count,
-      request->compressed,
-      &request->result, &request->result_len
-    );
-  } else if (request->is_apply == 1) {
-    // Single apply
-    request->error_code = delta_apply_core(
-      request->buf1, request->len1,
-      request->buf2, request->len2,
-      request->compressed,
-      &request->result, &request->result_len
-    );
-  } else {
-    // Create
-    request->error_code = delta_create_core(
-      request->buf1, request->len1,
-      request->buf2, request->len2,
-      request->nhash, request->search_limit, request->compressed,
-      &request->result, &request->result_len
-    );
-  }
+  pairs->count = count;
+  pairs->failed = 0;
+  pairs->sources = (void **)(pairs + 1);
+  pairs->inputs = pairs->sources + count;
+  pairs->source_lens = (size_t *)(pairs->inputs + count);
+  pairs->input_lens = pairs->source_lens + count;
+  pairs->offsets = pairs->input_lens + count;
+  pairs->offsets[0] = 0;
+  return pairs;
 }
 
-// Callback after worker completes
-static void
-bare_delta_after_work(uv_work_t *handle, int status) {
-  int err;
-  bare_delta_request_t *request = (bare_delta_request_t *)handle->data;
+// Grow a scratch buffer to hold at least len bytes
+static int
+bare_delta_reserve(char **buffer, size_t *capacity, size_t len) {
+  if (len <= *capacity && *buffer) return 0;
   
-  js_env_t *env = request->env;
-  js_handle_scope_t *scope;
-  err = js_open_handle_scope(env, &scope);
-  assert(err == 0);
+  char *grown = (char *)realloc(*buffer, len ? len : 1);
+  if (grown == NULL) return -1;
   
-  js_value_t *ctx;
-  err = js_get_reference_value(env, request->ctx, &ctx);
-  assert(err == 0);
+  *buffer = grown;
+  *capacity = len;
+  return 0;
+}
+
+// Results of createMany/applyMany written back to back into one buffer that
+// grows as needed, with scratch for raw and decompressed deltas
+typedef struct {
+  char *data;
+  size_t len;
+  size_t cap;
+  char *scratch;
+  size_t scratch_cap;
+} bare_delta_packed_t;
+
+// Make room for len more bytes past the end of the packed results
+static int
+bare_delta_packed_reserve(bare_delta_packed_t *packed, size_t len) {
+  if (packed->len + len <= packed->cap) return 0;
   
-  js_value_t *callback;
-  err = js_get_reference_value(env, request->callback, &callback);
-  assert(err == 0);
+  size_t cap = packed->cap ? packed->cap * 2 : 4096;
+  while (cap < packed->len + len) cap *= 2;
   
-  js_value_t *argv[2];
+  char *grown = (char *)realloc(packed->data, cap);
+  if (grown == NULL) return -1;
   
-  if (status != 0 || request->error_code < 0) {
-    // Call callback(error, null)
-    js_value_t *message;
-    err = js_create_string_utf8(env, (const utf8_t *)"Operation failed", -1, &message);
-    assert(err == 0);
-    err = js_create_error(env, NULL, message, &argv[0]);
-    assert(err == 0);
-    
-    err = js_get_null(env, &argv[1]);
-    assert(err == 0);
+  packed->data = grown;
+  packed->cap = cap;
+  return 0;
+}
+
+// Create one delta of createMany at the end of the packed results. Raw
+// deltas are written there directly and compressed ones are compressed
+// there from scratch; in auto mode the raw delta is replaced by its
+// compressed form when that pays off.
+static int
+bare_delta_packed_create(bare_delta_packed_t *packed, const void *source, size_t source_len,
+                         const void *target, size_t target_len, int nhash, int search_limit,
+                         int compressed, const volatile int *cancel) {
+  if (target_len > INT32_MAX - BARE_DELTA_CREATE_OVERHEAD) return -3;
+  
+  size_t delta_max = target_len + BARE_DELTA_CREATE_OVERHEAD;
+  bool in_place = compressed == BARE_DELTA_COMPRESSION_NONE || compressed == BARE_DELTA_COMPRESSION_AUTO;
+  char *raw;
+  
+  if (in_place) {
+    if (bare_delta_packed_reserve(packed, delta_max) != 0) return -1;
+    raw = packed->data + packed->len;
   } else {
-    // Call callback(null, result)
-    err = js_get_null(env, &argv[0]);
-    assert(err == 0);
-    
-    // Create arraybuffer and typedarray for binary data
-    if (request->result && request->result_len > 0) {
-      js_value_t *arraybuffer;
-      void *data;
-      err = js_create_arraybuffer(env, request->result_len, &data, &arraybuffer);
-      assert(err == 0);
-      memcpy(data, request->result, request->result_len);
-      
-      err = js_create_typedarray(env, js_uint8array, request->result_len, arraybuffer, 0, &argv[1]);
-      assert(err == 0);
-    } else {
-      // Handle edge case where result is empty but not an error
-      js_value_t *arraybuffer;
-      void *data;
-      err = js_create_arraybuffer(env, 0, &data, &arraybuffer);
-      assert(err == 0);
-      
-      err = js_create_typedarray(env, js_uint8array, 0, arraybuffer, 0, &argv[1]);
-      assert(err == 0);
-    }
+    if (bare_delta_reserve(&packed->scratch, &packed->scratch_cap, delta_max) != 0) return -1;
+    raw = packed->scratch;
   }
   
-  // Call the callback
-  err = js_call_function(env, ctx, callback, 2, argv, NULL);
-  if (err != 0) {
-    // Callback failed - this would cause hanging Promises
-    // Continue with cleanup to prevent resource leaks
-  }
+  int delta_len = delta_create_with_stats(
+    (const char *)source, source_len,
+    (const char *)target, target_len,
+    raw, nhash, search_limit, cancel,
+    NULL, 0, NULL
+  );
   
-  err = js_close_handle_scope(env, scope);
-  assert(err == 0);
+  if (delta_len == DELTA_CANCELLED) return -7; // Cancelled
+  if (delta_len < 0) return -2; // Delta creation failed
+  if ((size_t)delta_len >= delta_max) return -3; // Buffer overflow error
   
-  // Clean up
-  if (request->source_ref) {
-    err = js_delete_reference(env, request->source_ref);
-    assert(err == 0);
-  }
-  if (request->target_ref) {
-    err = js_delete_reference(env, request->target_ref);
-    assert(err == 0);
+  if (compressed == BARE_DELTA_COMPRESSION_AUTO && !bare_delta_should_compress(raw, delta_len)) {
+    compressed = BARE_DELTA_COMPRESSION_NONE;
   }
   
-  // Clean up batch references if present
-  if (request->batch_refs) {
-    for (size_t i = 0; i < request->batch_count; i++) {
-      if (request->batch_refs[i]) {
-        err = js_delete_reference(env, request->batch_refs[i]);
-        assert(err == 0);
-      }
-    }
-    free(request->batch_refs);
+  if (compressed == BARE_DELTA_COMPRESSION_NONE) {
+    packed->len += delta_len;
+    return 0;
   }
-  if (request->batch_deltas) free(request->batch_deltas);
-  if (request->batch_delta_lens) free(request->batch_delta_lens);
   
-  if (request->result) free(request->result);
+  size_t bound = bare_delta_compress_bound(compressed, delta_len);
+  size_t compressed_len;
+  int err;
   
-  err = js_delete_reference(env, request->ctx);
-  if (err != 0) {
-    // Critical: Reference deletion failed - this causes resource leaks
-    // Continue with cleanup to prevent worse issues
+  if (in_place) {
+    if (bare_delta_reserve(&packed->scratch, &packed->scratch_cap, bound) != 0) return -4;
+    
+    err = bare_delta_compress_into(raw, delta_len, compressed, packed->scratch, bound, &compressed_len);
+    if (err != 0) return err;
+    
+    if (bare_delta_compression_paid_off(compressed_len, delta_len)) {
+      memcpy(raw, packed->scratch, compressed_len);
+      packed->len += compressed_len;
+    } else {
+      packed->len += delta_len;
+    }
+    
+    return 0;
   }
   
-  err = js_delete_reference(env, request->callback);  
-  if (err != 0) {
-    // Critical: Callback reference deletion failed - this causes hanging Promises
-    // Continue with cleanup
-  }
+  if (bare_delta_packed_reserve(packed, bound) != 0) return -4;
   
-  err = js_finish_deferred_teardown_callback(request->teardown);
-  if (err != 0) {
-    // Critical: Teardown callback failed - this could cause hangs
-    // Still free the request to prevent memory leaks
-  }
+  err = bare_delta_compress_into(packed->scratch, delta_len, compressed, packed->data + packed->len, bound, &compressed_len);
+  if (err != 0) return err;
   
-  free(request);
+  packed->len += compressed_len;
+  return 0;
 }
 
-// Synchronous delta_create binding
-static js_value_t *
-bare_delta_create_sync(js_env_t *env, js_callback_info_t *info) {
-  int err;
-  size_t argc = 3;
-  js_value_t *argv[3];
-  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
-  assert(err == 0);
+// Apply one delta of applyMany, writing its target at the end of the packed
+// results
+static int
+bare_delta_packed_apply(bare_delta_packed_t *packed, const void *source, size_t source_len,
+                        const void *delta, size_t delta_len, const volatile int *cancel) {
+  const char *delta_data = (const char *)delta;
+  char *decompressed_delta = NULL;
   
+  int err = bare_delta_decompress_delta(delta, delta_len, &decompressed_delta, &delta_len);
+  if (err != 0) return err;
   
-  if (argc < 2) {
-    js_throw_error(env, NULL, "delta.createSync requires at least 2 arguments (source, target[, options])");
-    return NULL;
-  }
+  if (decompressed_delta) delta_data = decompressed_delta;
+  
+  int output_size = delta_output_size(delta_data, delta_len);
+  if (output_size < 0) {
+    free(decompressed_delta);
+    return -4; // Invalid delta format
+  }
+  
+  // The engine writes a terminator past the end of the output
+  if (bare_delta_packed_reserve(packed, (size_t)output_size + 1) != 0) {
+    free(decompressed_delta);
+    return -5; // Output buffer allocation failed
+  }
+  
+  int applied_len = delta_apply_with_cancel(
+    (const char *)source, source_len,
+    delta_data, delta_len,
+    packed->data + packed->len, cancel
+  );
+  
+  free(decompressed_delta);
+  
+  if (applied_len == DELTA_CANCELLED) return -7; // Cancelled
+  if (applied_len < 0) return -6; // Delta application failed
+  
+  packed->len += applied_len;
+  return 0;
+}
+
+// Core logic for createMany/applyMany - runs every pair in turn, writing the
+// results back to back into one buffer and recording where each one starts.
+// On failure pairs->failed names the failed pair and *result still holds the
+// results of the pairs before it.
+static int
+delta_many_core(int op, bare_delta_pairs_t *pairs, int nhash, int search_limit, int compressed,
+                const volatile int *cancel, char **result, size_t *result_len) {
+  bare_delta_packed_t packed = {0};
+  int err = 0;
+  
+  for (size_t i = 0; i < pairs->count; i++) {
+    if (op == BARE_DELTA_OP_CREATE_MANY) {
+      err = bare_delta_packed_create(&packed, pairs->sources[i], pairs->source_lens[i],
+                                     pairs->inputs[i], pairs->input_lens[i],
+                                     nhash, search_limit, compressed, cancel);
+    } else {
+      err = bare_delta_packed_apply(&packed, pairs->sources[i], pairs->source_lens[i],
+                                    pairs->inputs[i], pairs->input_lens[i], cancel);
+    }
+    
+    if (err != 0) {
+      pairs->failed = i;
+      break;
+    }
+    
+    pairs->offsets[i + 1] = packed.len;
+  }
+  
+  free(packed.scratch);
+  
+  *result = packed.data;
+  *result_len = err != 0 ? pairs->offsets[pairs->failed] : packed.len;
+  return err;
+}
+
+// Create a delta with an Encoder's options, index and contexts. On success
+// *delta points into the encoder's scratch and stays valid until its next call.
+static int
+bare_delta_encoder_encode(bare_delta_codec_t *codec, const void *source, size_t source_len,
+                          const void *target, size_t target_len, const volatile int *cancel,
+                          const char **delta, size_t *delta_len) {
+  size_t index_len = delta_index_size(source_len, codec->nhash);
+  if (index_len > codec->index_len) {
+    int *index = (int *)realloc(codec->index, index_len * sizeof(int));
+    if (index == NULL) return -1;
+    
+    codec->index = index;
+    codec->index_len = index_len;
+  }
+  
+  if (bare_delta_reserve(&codec->scratch, &codec->scratch_len, target_len + BARE_DELTA_CREATE_OVERHEAD) != 0) {
+    return -1; // Memory allocation failed
+  }
+  
+  int len = delta_create_with_index(
+    (const char *)source, source_len,
+    (const char *)target, target_len,
+    codec->scratch, codec->nhash, codec->search_limit, cancel,
+    codec->index, codec->index_len
+  );
+  
+  if (len == DELTA_CANCELLED) return -7; // Cancelled
+  if (len < 0) return -2; // Delta creation failed
+  
+  int compressed = codec->compressed;
+  
+  if (compressed == BARE_DELTA_COMPRESSION_AUTO && !bare_delta_should_compress(codec->scratch, len)) {
+    compressed = BARE_DELTA_COMPRESSION_NONE;
+  }
+  
+  if (compressed == BARE_DELTA_COMPRESSION_NONE) {
+    *delta = codec->scratch;
+    *delta_len = len;
+    return 0;
+  }
+  
+  if (compressed == BARE_DELTA_COMPRESSION_LZ4) {
+    LZ4F_preferences_t prefs = LZ4F_INIT_PREFERENCES;
+    prefs.frameInfo.contentSize = len;
+    
+    if (codec->lz4_cctx == NULL &&
+        LZ4F_isError(LZ4F_createCompressionContext(&codec->lz4_cctx, LZ4F_VERSION))) {
+      codec->lz4_cctx = NULL;
+      return -4; // Compression context allocation failed
+    }
+    
+    size_t bound = LZ4F_compressFrameBound(len, &prefs);
+    if (bare_delta_reserve(&codec->packed, &codec->packed_len, bound) != 0) {
+      return -4; // Compression buffer allocation failed
+    }
+    
+    size_t header = LZ4F_compressBegin(codec->lz4_cctx, codec->packed, bound, &prefs);
+    if (LZ4F_isError(header)) return -5;
+    
+    size_t body = LZ4F_compressUpdate(codec->lz4_cctx, codec->packed + header, bound - header, codec->scratch, len, NULL);
+    if (LZ4F_isError(body)) return -5;
+    
+    size_t end = LZ4F_compressEnd(codec->lz4_cctx, codec->packed + header + body, bound - header - body, NULL);
+    if (LZ4F_isError(end)) return -5;
+    
+    *delta = codec->packed;
+    *delta_len = header + body + end;
+    return 0;
+  }
+  
+  if (codec->zstd_cctx == NULL) {
+    codec->zstd_cctx = ZSTD_createCCtx();
+    if (codec->zstd_cctx == NULL) return -4; // Compression context allocation failed
+  }
+  
+  size_t bound = ZSTD_compressBound(len);
+  if (bare_delta_reserve(&codec->packed, &codec->packed_len, bound) != 0) {
+    return -4; // Compression buffer allocation failed
+  }
+  
+  DELTA_PROBE1(zstd__compress__start, len);
+  size_t compressed_size = ZSTD_compressCCtx(codec->zstd_cctx, codec->packed, bound, codec->scratch, len, 1);
+  DELTA_PROBE2(zstd__compress__done, len, compressed_size);
+  if (ZSTD_isError(compressed_size)) return -5; // Compression failed
+  
+  // In auto mode keep the raw delta unless compression paid off
+  if (compressed == BARE_DELTA_COMPRESSION_AUTO &&
+      compressed_size + len / BARE_DELTA_AUTO_MIN_SAVINGS >= (size_t)len) {
+    *delta = codec->scratch;
+    *delta_len = len;
+    return 0;
+  }
+  
+  *delta = codec->packed;
+  *delta_len = compressed_size;
+  return 0;
+}
+
+// Apply a delta with a Decoder's contexts and scratch. The target is written
+// to out when it fits, otherwise into a fresh allocation returned in *result.
+static int
+bare_delta_decoder_decode(bare_delta_codec_t *codec, const void *source, size_t source_len,
+                          const void *delta, size_t delta_len, const volatile int *cancel,
+                          char *out, size_t out_len, char **result, size_t *result_len) {
+  const char *delta_data = (const char *)delta;
+  int compression = bare_delta_detect_compression(delta, delta_len);
+  
+  if (compression == BARE_DELTA_COMPRESSION_LZ4) {
+    if (codec->lz4_dctx == NULL) {
+      if (LZ4F_isError(LZ4F_createDecompressionContext(&codec->lz4_dctx, LZ4F_VERSION))) {
+        codec->lz4_dctx = NULL;
+        return -2; // Decompression context allocation failed
+      }
+    } else {
+      LZ4F_resetDecompressionContext(codec->lz4_dctx);
+    }
+    
+    size_t size, src_pos;
+    int err = bare_delta_lz4_content_size(codec->lz4_dctx, delta_data, delta_len, &size, &src_pos);
+    if (err != 0) return err;
+    
+    if (bare_delta_reserve(&codec->scratch, &codec->scratch_len, size) != 0) {
+      return -2; // Decompression buffer allocation failed
+    }
+    
+    err = bare_delta_lz4_decompress_body(codec->lz4_dctx, delta_data, delta_len, src_pos, codec->scratch, size);
+    if (err != 0) return err;
+    
+    delta_data = codec->scratch;
+    delta_len = size;
+  } else if (compression == BARE_DELTA_COMPRESSION_ZSTD) {
+    unsigned long long size = ZSTD_getFrameContentSize(delta_data, delta_len);
+    
+    if (size == ZSTD_CONTENTSIZE_ERROR || size == ZSTD_CONTENTSIZE_UNKNOWN) {
+      return -1; // Invalid compressed format - magic number present but corrupt data
+    }
+    
+    if (codec->zstd_dctx == NULL) {
+      codec->zstd_dctx = ZSTD_createDCtx();
+      if (codec->zstd_dctx == NULL) return -2; // Decompression context allocation failed
+    }
+    
+    if (bare_delta_reserve(&codec->scratch, &codec->scratch_len, size) != 0) {
+      return -2; // Decompression buffer allocation failed
+    }
+    
+    DELTA_PROBE1(zstd__decompress__start, delta_len);
+    size_t actual_size = ZSTD_decompressDCtx(codec->zstd_dctx, codec->scratch, size, delta_data, delta_len);
+    DELTA_PROBE2(zstd__decompress__done, delta_len, actual_size);
+    if (ZSTD_isError(actual_size)) return -3; // Decompression failed
+    
+    delta_data = codec->scratch;
+    delta_len = actual_size;
+  }
+  
+  int output_size = delta_output_size(delta_data, delta_len);
+  if (output_size < 0) return -4; // Invalid delta format
+  
+  // The engine writes a terminator past the output, so only apply in place
+  // when out has a spare byte and stage through scratch when it fits exactly
+  char *output;
+  if (out && (size_t)output_size < out_len) {
+    output = out;
+  } else if (out && (size_t)output_size == out_len) {
+    if (bare_delta_reserve(&codec->packed, &codec->packed_len, output_size + 1) != 0) return -5;
+    output = codec->packed;
+  } else if (out) {
+    return BARE_DELTA_OUT_OF_RANGE;
+  } else {
+    output = (char *)malloc(output_size + 1);
+    if (output == NULL) return -5; // Output buffer allocation failed
+  }
+  
+  int applied_len = delta_apply_with_cancel((const char *)source, source_len, delta_data, delta_len, output, cancel);
+  
+  if (applied_len < 0) {
+    if (out == NULL) free(output);
+    return applied_len == DELTA_CANCELLED ? -7 : -6;
+  }
+  
+  if (output == codec->packed) memcpy(out, output, applied_len);
+  
+  if (out == NULL) *result = output;
+  *result_len = applied_len;
+  return 0;
+}
+
+// Worker function - delegates to core logic
+static void
+bare_delta_work(bare_delta_request_t *request) {
+  // Requests cancelled while waiting behind an Encoder or Decoder never start
+  if (request->cancelled) {
+    request->error_code = -7;
+    return;
+  }
+  
+  switch (request->op) {
+  case BARE_DELTA_OP_APPLY_BATCH:
+    request->error_code = delta_apply_batch_core(
+      request->buf1, request->len1,
+      request->batch_deltas, request->batch_delta_lens, request->batch_count,
+      request->compressed, &request->cancelled,
+      &request->result, &request->result_len
+    );
+    break;
+    
+  case BARE_DELTA_OP_APPLY:
+    request->error_code = delta_apply_core(
+      request->buf1, request->len1,
+      request->buf2, request->len2,
+      request->compressed, &request->cancelled,
+      request->want_stats ? &request->stats : NULL,
+      &request->result, &request->result_len
+    );
+    break;
+    
+  case BARE_DELTA_OP_CREATE_MANY:
+  case BARE_DELTA_OP_APPLY_MANY:
+    request->error_code = delta_many_core(
+      request->op, request->pairs,
+      request->nhash, request->search_limit, request->compressed, &request->cancelled,
+      &request->result, &request->result_len
+    );
+    break;
+    
+  case BARE_DELTA_OP_ENCODE: {
+    const char *delta;
+    size_t delta_len;
+    request->error_code = bare_delta_encoder_encode(
+      request->codec, request->buf1, request->len1, request->buf2, request->len2,
+      &request->cancelled, &delta, &delta_len
+    );
+    if (request->error_code != 0) break;
+    
+    // Copy out of the encoder's scratch into memory JavaScript can own
+    request->result = (char *)malloc(delta_len ? delta_len : 1);
+    if (request->result == NULL) {
+      request->error_code = -1;
+      break;
+    }
+    memcpy(request->result, delta, delta_len);
+    request->result_len = delta_len;
+    break;
+  }
+    
+  case BARE_DELTA_OP_DECODE:
+    request->error_code = bare_delta_decoder_decode(
+      request->codec, request->buf1, request->len1, request->buf2, request->len2,
+      &request->cancelled, NULL, 0, &request->result, &request->result_len
+    );
+    break;
+    
+  default:
+    request->error_code = delta_create_core(
+      request->buf1, request->len1,
+      request->buf2, request->len2,
+      request->nhash, request->search_limit, request->compressed, &request->cancelled,
+      request->want_stats ? &request->stats : NULL,
+      &request->result, &request->result_len
+    );
+  }
+}
+
+// Count the bytes a request reads: its source and every target or delta
+static uint64_t
+bare_delta_request_input_bytes(bare_delta_request_t *request) {
+  uint64_t bytes = request->len1 + request->len2;
+  
+  if (request->op == BARE_DELTA_OP_APPLY_BATCH) {
+    for (size_t i = 0; i < request->batch_count; i++) {
+      bytes += request->batch_delta_lens[i];
+    }
+  } else if (request->pairs) {
+    for (size_t i = 0; i < request->pairs->count; i++) {
+      bytes += request->pairs->source_lens[i] + request->pairs->input_lens[i];
+    }
+  }
+  
+  return bytes;
+}
+
+// Run a request on the calling thread, recording its queue wait and
+// execution time in the thread's metrics shard
+static void
+bare_delta_run(bare_delta_request_t *request) {
+  uint64_t start = uv_hrtime();
+  
+  DELTA_PROBE3(op__start, request->op, request->len1, request->len2);
+  bare_delta_work(request);
+  DELTA_PROBE3(op__done, request->op, request->error_code, request->result_len);
+  
+  bare_delta_metrics_t *shard = bare_delta_metrics_local();
+  if (shard) {
+    bare_delta_metrics_time(shard, BARE_DELTA_HISTOGRAM_WAIT, start - request->queued_at);
+    bare_delta_metrics_time(shard, BARE_DELTA_HISTOGRAM_EXECUTION, uv_hrtime() - start);
+  }
+}
+
+// Callback after worker completes
+static void
+bare_delta_after_work(bare_delta_request_t *request, int status) {
+  int err;
+  
+  js_env_t *env = request->env;
+  js_handle_scope_t *scope;
+  err = js_open_handle_scope(env, &scope);
+  assert(err == 0);
+  
+  js_value_t *ctx;
+  err = js_get_reference_value(env, request->ctx, &ctx);
+  assert(err == 0);
+  
+  js_value_t *callback;
+  err = js_get_reference_value(env, request->callback, &callback);
+  assert(err == 0);
+  
+  js_value_t *argv[2];
+  
+  int32_t outcome = request->error_code;
+  if (outcome != BARE_DELTA_OVERLOADED && request->cancelled) outcome = -7;
+  
+  bare_delta_metrics_record(request->op, bare_delta_request_input_bytes(request), request->result_len,
+                            outcome, uv_hrtime() - request->submitted_at, false);
+  
+  if (request->error_code == BARE_DELTA_OVERLOADED) {
+    // Call callback(error, null) for a request turned away by admission control
+    js_value_t *code, *message;
+    err = js_create_string_utf8(env, (const utf8_t *)"OVERLOADED", -1, &code);
+    assert(err == 0);
+    err = js_create_string_utf8(env, (const utf8_t *)"Too many operations in flight", -1, &message);
+    assert(err == 0);
+    err = js_create_error(env, code, message, &argv[0]);
+    assert(err == 0);
+    
+    err = js_get_null(env, &argv[1]);
+    assert(err == 0);
+  } else if (request->cancelled) {
+    // Call callback(error, null) for a request abandoned through cancel()
+    js_value_t *code, *message;
+    err = js_create_string_utf8(env, (const utf8_t *)"ABORT_ERR", -1, &code);
+    assert(err == 0);
+    err = js_create_string_utf8(env, (const utf8_t *)"Operation was aborted", -1, &message);
+    assert(err == 0);
+    err = js_create_error(env, code, message, &argv[0]);
+    assert(err == 0);
+    
+    err = js_get_null(env, &argv[1]);
+    assert(err == 0);
+  } else if (status != 0 || request->error_code < 0) {
+    // Call callback(error, null), naming the failed pair for createMany/applyMany
+    char text[64] = "Operation failed";
+    if (request->pairs && status == 0) {
+      snprintf(text, sizeof(text), "Operation failed at pair %zu", request->pairs->failed);
+    }
+    
+    const char *name = bare_delta_error_names[bare_delta_error_class(request->op, outcome)];
+    
+    js_value_t *code, *message;
+    err = js_create_string_utf8(env, (const utf8_t *)name, -1, &code);
+    assert(err == 0);
+    err = js_create_string_utf8(env, (const utf8_t *)text, -1, &message);
+    assert(err == 0);
+    err = js_create_error(env, code, message, &argv[0]);
+    assert(err == 0);
+    
+    // Also attach the index of the failed pair and the results of the pairs
+    // before it, so they need not be run again
+    if (request->pairs && status == 0) {
+      bare_delta_set_uint32(env, argv[0], "index", (uint32_t)request->pairs->failed);
+      
+      js_value_t *results;
+      err = bare_delta_create_results(env, request->result, request->result_len,
+                                      request->pairs->offsets, request->pairs->failed, &results);
+      request->result = NULL;
+      assert(err == 0);
+      
+      err = js_set_named_property(env, argv[0], "results", results);
+      assert(err == 0);
+    }
+    
+    err = js_get_null(env, &argv[1]);
+    assert(err == 0);
+  } else {
+    // Call callback(null, result)
+    err = js_get_null(env, &argv[0]);
+    assert(err == 0);
+    
+    // Hand the result buffer over to JavaScript without copying
+    if (request->pairs) {
+      err = bare_delta_create_results(env, request->result, request->result_len,
+                                      request->pairs->offsets, request->pairs->count, &argv[1]);
+    } else if (request->want_stats) {
+      err = bare_delta_create_stats_result(env, request->result, request->result_len, &request->stats,
+                                           request->op == BARE_DELTA_OP_APPLY, &argv[1]);
+    } else {
+      err = bare_delta_create_result(env, request->result, request->result_len, &argv[1]);
+    }
+    
+    // The result belongs to JavaScript or has been freed either way
+    request->result = NULL;
+    
+    if (err != 0) {
+      // Call callback(error, null) with the exception the failed call left,
+      // or a generic one if it left none
+      bool pending;
+      err = js_is_exception_pending(env, &pending);
+      assert(err == 0);
+      
+      if (pending) {
+        err = js_get_and_clear_last_exception(env, &argv[0]);
+        assert(err == 0);
+      } else {
+        js_value_t *message;
+        err = js_create_string_utf8(env, (const utf8_t *)"Failed to hand the result to JavaScript", -1, &message);
+        assert(err == 0);
+        err = js_create_error(env, NULL, message, &argv[0]);
+        assert(err == 0);
+      }
+      
+      err = js_get_null(env, &argv[1]);
+      assert(err == 0);
+    }
+  }
+  
+  // Call the callback
+  err = js_call_function(env, ctx, callback, 2, argv, NULL);
+  if (err != 0) {
+    // Callback failed - this would cause hanging Promises
+    // Continue with cleanup to prevent resource leaks
+  }
+  
+  err = js_close_handle_scope(env, scope);
+  assert(err == 0);
+  
+  // Clean up
+  if (request->source_ref) {
+    err = js_delete_reference(env, request->source_ref);
+    assert(err == 0);
+  }
+  if (request->target_ref) {
+    err = js_delete_reference(env, request->target_ref);
+    assert(err == 0);
+  }
+  
+  // Clean up batch references if present
+  if (request->batch_refs) {
+    for (size_t i = 0; i < request->batch_count; i++) {
+      if (request->batch_refs[i]) {
+        err = js_delete_reference(env, request->batch_refs[i]);
+        assert(err == 0);
+      }
+    }
+    free(request->batch_refs);
+  }
+  if (request->batch_deltas) free(request->batch_deltas);
+  if (request->batch_delta_lens) free(request->batch_delta_lens);
+  
+  // Clean up createMany/applyMany state
+  if (request->pairs_ref) {
+    err = js_delete_reference(env, request->pairs_ref);
+    assert(err == 0);
+  }
+  if (request->pairs) free(request->pairs);
+  
+  // Start the next call waiting on the same Encoder or Decoder
+  if (request->codec) {
+    if (request->holds_codec) bare_delta_codec_next(request->pool, request->codec);
+    
+    err = js_delete_reference(env, request->codec_ref);
+    assert(err == 0);
+  }
+  
+  if (request->result) free(request->result);
+  
+  err = js_delete_reference(env, request->ctx);
+  if (err != 0) {
+    // Critical: Reference deletion failed - this causes resource leaks
+    // Continue with cleanup to prevent worse issues
+  }
+  
+  err = js_delete_reference(env, request->callback);  
+  if (err != 0) {
+    // Critical: Callback reference deletion failed - this causes hanging Promises
+    // Continue with cleanup
+  }
+  
+  err = js_finish_deferred_teardown_callback(request->teardown);
+  if (err != 0) {
+    // Critical: Teardown callback failed - this could cause hangs
+    // Still free the request to prevent memory leaks
+  }
+  
+  free(request);
+}
+
+// Pick the next request a worker may run, interactive lane first. Background
+// work never occupies every thread, so one is always left for interactive work.
+static bare_delta_request_t *
+bare_delta_pool_next(bare_delta_pool_t *pool, uint32_t index) {
+  bool js_thread = index == BARE_DELTA_POOL_JS_THREAD;
+  
+  if (!js_thread && index >= pool->thread_limit) {
+    return NULL; // Parked after the pool was shrunk
+  }
+  
+  for (int i = 0; i < BARE_DELTA_LANE_COUNT; i++) {
+    bare_delta_lane_t *lane = &pool->lanes[i];
+    
+    if (lane->head == NULL) continue;
+    
+    if (i == BARE_DELTA_LANE_BACKGROUND && !js_thread && pool->thread_limit > 1 &&
+        lane->active >= pool->thread_limit - 1) {
+      continue;
+    }
+    
+    bare_delta_request_t *request = lane->head;
+    lane->head = request->next;
+    if (lane->head == NULL) lane->tail = NULL;
+    request->next = NULL;
+    
+    lane->queued--;
+    lane->active++;
+    
+    uint64_t wait = uv_hrtime() - request->queued_at;
+    lane->wait_total += wait;
+    if (wait > lane->wait_max) lane->wait_max = wait;
+    
+    DELTA_PROBE3(queue__exit, request->op, i, wait);
+    
+    return request;
+  }
+  
+  return NULL;
+}
+
+static void
+bare_delta_pool_worker(void *data) {
+  bare_delta_worker_t *worker = (bare_delta_worker_t *)data;
+  bare_delta_pool_t *pool = worker->pool;
+  
+  uv_mutex_lock(&pool->lock);
+  
+  for (;;) {
+    bare_delta_request_t *request = bare_delta_pool_next(pool, worker->index);
+    
+    if (request == NULL) {
+      if (pool->closing) break;
+      
+      uv_cond_wait(&pool->available, &pool->lock);
+      continue;
+    }
+    
+    uv_mutex_unlock(&pool->lock);
+    
+    bare_delta_run(request);
+    
+    uv_mutex_lock(&pool->lock);
+    
+    bare_delta_lane_t *lane = &pool->lanes[request->lane];
+    lane->active--;
+    if (request->cancelled) lane->cancelled++;
+    else lane->completed++;
+    
+    if (pool->done_tail) pool->done_tail->next = request;
+    else pool->done_head = request;
+    pool->done_tail = request;
+    
+    // A background slot may have opened up for a parked worker
+    if (pool->lanes[BARE_DELTA_LANE_BACKGROUND].head) {
+      uv_cond_signal(&pool->available);
+    }
+    
+    uv_async_send(&pool->async);
+  }
+  
+  uv_mutex_unlock(&pool->lock);
+  
+  delta_release_thread_cache();
+  bare_delta_metrics_release();
+}
+
+// Check whether the pool can take another request, counting a rejection if not
+static bool
+bare_delta_pool_accepting(bare_delta_pool_t *pool, int lane) {
+  uv_mutex_lock(&pool->lock);
+  
+  bool accepting = pool->lanes[BARE_DELTA_LANE_INTERACTIVE].queued +
+                   pool->lanes[BARE_DELTA_LANE_BACKGROUND].queued +
+                   pool->codec_queued < pool->queue_limit;
+  
+  if (!accepting) pool->lanes[lane].rejected++;
+  
+  uv_mutex_unlock(&pool->lock);
+  
+  if (!accepting) bare_delta_metrics_fail(BARE_DELTA_ERROR_QUEUE_FULL);
+  
+  return accepting;
+}
+
+// Queue an admitted request on its lane, starting worker threads as needed
+static void
+bare_delta_pool_enqueue(bare_delta_pool_t *pool, bare_delta_request_t *request) {
+  int err;
+  
+  request->next = NULL;
+  request->queued_at = uv_hrtime();
+  request->admitted = true;
+  
+  pool->in_flight++;
+  pool->in_flight_bytes += request->bytes;
+  
+  uv_mutex_lock(&pool->lock);
+  
+  while (pool->thread_count < pool->thread_limit) {
+    bare_delta_worker_t *worker = &pool->workers[pool->thread_count];
+    worker->pool = pool;
+    worker->index = pool->thread_count;
+    
+    err = uv_thread_create(&worker->thread, bare_delta_pool_worker, worker);
+    if (err != 0) break; // Run with the threads we have
+    
+    pool->thread_count++;
+  }
+  
+  bare_delta_lane_t *lane = &pool->lanes[request->lane];
+  
+  if (lane->tail) lane->tail->next = request;
+  else lane->head = request;
+  lane->tail = request;
+  
+  lane->queued++;
+  lane->submitted++;
+  
+  DELTA_PROBE3(queue__enter, request->op, request->lane, request->bytes);
+  
+  uv_cond_signal(&pool->available);
+  
+  uv_mutex_unlock(&pool->lock);
+  
+  // The pool was configured without threads, or they could not be started at
+  // all, so run the queued requests on the JS thread rather than leaving them
+  // queued forever
+  if (pool->thread_limit == 0 || pool->thread_count == 0) {
+    for (;;) {
+      uv_mutex_lock(&pool->lock);
+      request = bare_delta_pool_next(pool, BARE_DELTA_POOL_JS_THREAD);
+      uv_mutex_unlock(&pool->lock);
+      
+      if (request == NULL) break;
+      
+      bare_delta_run(request);
+      
+      uv_mutex_lock(&pool->lock);
+      pool->lanes[request->lane].active--;
+      pool->lanes[request->lane].completed++;
+      if (pool->done_tail) pool->done_tail->next = request;
+      else pool->done_head = request;
+      pool->done_tail = request;
+      uv_mutex_unlock(&pool->lock);
+    }
+    
+    uv_async_send(&pool->async);
+  }
+}
+
+// Bytes an apply holds beyond its inputs. A delta whose sizes cannot be read
+// fails before it allocates anything.
+static uint64_t
+bare_delta_request_apply_bytes(const void *delta, size_t delta_len) {
+  int64_t bytes = bare_delta_apply_bytes(delta, delta_len);
+  return bytes < 0 ? 0 : (uint64_t)bytes;
+}
+
+// Estimate the memory a request holds while in flight: its inputs, and its
+// outputs and decompressed deltas as recorded in the delta and frame headers.
+// Reads headers only, as it runs on the JS thread for every submission.
+static uint64_t
+bare_delta_request_bytes(bare_delta_request_t *request) {
+  uint64_t bytes = bare_delta_request_input_bytes(request);
+  
+  switch (request->op) {
+  case BARE_DELTA_OP_CREATE:
+  case BARE_DELTA_OP_ENCODE:
+    bytes += request->len2 + BARE_DELTA_CREATE_OVERHEAD;
+    break;
+    
+  case BARE_DELTA_OP_APPLY:
+  case BARE_DELTA_OP_DECODE:
+    bytes += bare_delta_request_apply_bytes(request->buf2, request->len2);
+    break;
+    
+  case BARE_DELTA_OP_APPLY_BATCH:
+    for (size_t i = 0; i < request->batch_count; i++) {
+      bytes += bare_delta_request_apply_bytes(request->batch_deltas[i], request->batch_delta_lens[i]);
+    }
+    break;
+    
+  case BARE_DELTA_OP_CREATE_MANY:
+    for (size_t i = 0; i < request->pairs->count; i++) {
+      bytes += request->pairs->input_lens[i] + BARE_DELTA_CREATE_OVERHEAD;
+    }
+    break;
+    
+  case BARE_DELTA_OP_APPLY_MANY:
+    for (size_t i = 0; i < request->pairs->count; i++) {
+      bytes += bare_delta_request_apply_bytes(request->pairs->inputs[i], request->pairs->input_lens[i]);
+    }
+    break;
+  }
+  
+  return bytes;
+}
+
+// Whether a request fits within the in-flight limits. A lone request is
+// always admitted so one larger than the byte limit cannot stall forever.
+static bool
+bare_delta_pool_fits(bare_delta_pool_t *pool, uint64_t bytes) {
+  if (pool->in_flight == 0) return true;
+  if (pool->in_flight_limit && pool->in_flight >= pool->in_flight_limit) return false;
+  if (pool->in_flight_bytes_limit && pool->in_flight_bytes + bytes > pool->in_flight_bytes_limit) return false;
+  return true;
+}
+
+// Hand requests waiting for admission to the lanes, in order, while they fit
+static void
+bare_delta_pool_admit(bare_delta_pool_t *pool) {
+  while (pool->waiting_head && bare_delta_pool_fits(pool, pool->waiting_head->bytes)) {
+    bare_delta_request_t *request = pool->waiting_head;
+    
+    pool->waiting_head = request->next;
+    if (pool->waiting_head == NULL) pool->waiting_tail = NULL;
+    
+    pool->waiting--;
+    pool->waiting_bytes -= request->bytes;
+    
+    bare_delta_pool_enqueue(pool, request);
+  }
+}
+
+// Deliver a request that never reached a lane through the completion path
+static void
+bare_delta_pool_finish_unqueued(bare_delta_pool_t *pool, bare_delta_request_t *request) {
+  request->next = NULL;
+  
+  uv_mutex_lock(&pool->lock);
+  if (pool->done_tail) pool->done_tail->next = request;
+  else pool->done_head = request;
+  pool->done_tail = request;
+  uv_mutex_unlock(&pool->lock);
+  
+  uv_async_send(&pool->async);
+}
+
+// The bytes a request is admitted with. Outputs are only estimated when a
+// byte limit needs them; otherwise only the inputs are counted.
+static uint64_t
+bare_delta_pool_request_bytes(bare_delta_pool_t *pool, bare_delta_request_t *request) {
+  if (pool->in_flight_bytes_limit == 0) return bare_delta_request_input_bytes(request);
+  
+  return bare_delta_request_bytes(request);
+}
+
+// Start tracking a request submitted from the JS thread until it is delivered
+static void
+bare_delta_pool_track(bare_delta_pool_t *pool, bare_delta_request_t *request) {
+  request->pool = pool;
+  request->submitted_at = uv_hrtime();
+  request->next = NULL;
+  request->admitted = false;
+  request->bytes = bare_delta_pool_request_bytes(pool, request);
+  
+  if (pool->pending++ == 0) {
+    uv_ref((uv_handle_t *)&pool->async);
+  }
+}
+
+// Whether a request submitted now would have to wait for admission
+static bool
+bare_delta_pool_must_wait(bare_delta_pool_t *pool, uint64_t bytes) {
+  return pool->waiting_head != NULL || !bare_delta_pool_fits(pool, bytes);
+}
+
+// Turn a tracked request away with an OVERLOADED error
+static void
+bare_delta_pool_reject(bare_delta_pool_t *pool, bare_delta_request_t *request) {
+  pool->overloaded++;
+  request->error_code = BARE_DELTA_OVERLOADED;
+  bare_delta_pool_finish_unqueued(pool, request);
+}
+
+// Submit a request from the JS thread. It starts right away when within the
+// in-flight limits; otherwise it waits its turn, or is turned away with an
+// OVERLOADED error when the pool is configured to reject.
+static void
+bare_delta_pool_submit(bare_delta_pool_t *pool, bare_delta_request_t *request) {
+  bare_delta_pool_track(pool, request);
+  
+  if (!bare_delta_pool_must_wait(pool, request->bytes)) {
+    bare_delta_pool_enqueue(pool, request);
+    return;
+  }
+  
+  if (pool->reject_overload) {
+    bare_delta_pool_reject(pool, request);
+    return;
+  }
+  
+  if (pool->waiting_tail) pool->waiting_tail->next = request;
+  else pool->waiting_head = request;
+  pool->waiting_tail = request;
+  
+  pool->waiting++;
+  pool->waiting_bytes += request->bytes;
+}
+
+// Abandon a request. Queued requests are removed before they start and
+// running ones observe the flag at the next engine checkpoint. Either way
+// the request is delivered as usual with an abort error.
+static void
+bare_delta_pool_cancel(bare_delta_pool_t *pool, bare_delta_request_t *request) {
+  // Requests still waiting for admission never reach a lane
+  bare_delta_request_t *prev = NULL;
+  bare_delta_request_t *next = pool->waiting_head;
+  
+  while (next && next != request) {
+    prev = next;
+    next = next->next;
+  }
+  
+  if (next == request) {
+    if (prev) prev->next = request->next;
+    else pool->waiting_head = request->next;
+    if (pool->waiting_tail == request) pool->waiting_tail = prev;
+    
+    pool->waiting--;
+    pool->waiting_bytes -= request->bytes;
+    
+    request->cancelled = 1;
+    pool->lanes[request->lane].cancelled++;
+    bare_delta_pool_finish_unqueued(pool, request);
+    
+    // Requests behind it may fit now
+    bare_delta_pool_admit(pool);
+    return;
+  }
+  
+  uv_mutex_lock(&pool->lock);
+  
+  request->cancelled = 1;
+  
+  bare_delta_lane_t *lane = &pool->lanes[request->lane];
+  prev = NULL;
+  next = lane->head;
+  
+  while (next && next != request) {
+    prev = next;
+    next = next->next;
+  }
+  
+  if (next == request) {
+    if (prev) prev->next = request->next;
+    else lane->head = request->next;
+    if (lane->tail == request) lane->tail = prev;
+    request->next = NULL;
+    
+    lane->queued--;
+    lane->cancelled++;
+    
+    if (pool->done_tail) pool->done_tail->next = request;
+    else pool->done_head = request;
+    pool->done_tail = request;
+    
+    uv_async_send(&pool->async);
+  }
+  
+  uv_mutex_unlock(&pool->lock);
+}
+
+static void
+bare_delta_pool_on_close(uv_handle_t *handle) {
+  bare_delta_pool_t *pool = (bare_delta_pool_t *)handle->data;
+  
+  uv_cond_destroy(&pool->available);
+  uv_mutex_destroy(&pool->lock);
+  
+  js_deferred_teardown_t *teardown = pool->teardown;
+  
+  free(pool);
+  
+  js_finish_deferred_teardown_callback(teardown);
+}
+
+// Stop and join the worker threads once nothing is pending
+static void
+bare_delta_pool_close(bare_delta_pool_t *pool) {
+  uv_mutex_lock(&pool->lock);
+  pool->closing = true;
+  uv_cond_broadcast(&pool->available);
+  uv_mutex_unlock(&pool->lock);
+  
+  for (uint32_t i = 0; i < pool->thread_count; i++) {
+    uv_thread_join(&pool->workers[i].thread);
+  }
+  
+  uv_close((uv_handle_t *)&pool->async, bare_delta_pool_on_close);
+}
+
+// Deliver completed requests on the JS thread
+static void
+bare_delta_pool_on_complete(uv_async_t *handle) {
+  bare_delta_pool_t *pool = (bare_delta_pool_t *)handle->data;
+  
+  uv_mutex_lock(&pool->lock);
+  bare_delta_request_t *request = pool->done_head;
+  pool->done_head = pool->done_tail = NULL;
+  uv_mutex_unlock(&pool->lock);
+  
+  while (request) {
+    bare_delta_request_t *next = request->next;
+    
+    if (request->admitted) {
+      pool->in_flight--;
+      pool->in_flight_bytes -= request->bytes;
+    }
+    
+    pool->pending--;
+    bare_delta_after_work(request, 0);
+    
+    request = next;
+  }
+  
+  bare_delta_pool_admit(pool);
+  
+  if (pool->pending == 0) {
+    if (pool->closing) bare_delta_pool_close(pool);
+    else uv_unref((uv_handle_t *)&pool->async);
+  }
+}
+
+static void
+bare_delta_pool_teardown(js_deferred_teardown_t *handle, void *data) {
+  bare_delta_pool_t *pool = (bare_delta_pool_t *)data;
+  
+  // Workers read the flag under the lock
+  uv_mutex_lock(&pool->lock);
+  pool->closing = true;
+  uv_mutex_unlock(&pool->lock);
+  
+  // Sync calls index on the JS thread, which keeps its table cached
+  delta_release_thread_cache();
+  
+  // Otherwise the pool closes once the last pending request is delivered
+  if (pool->pending == 0) bare_delta_pool_close(pool);
+}
+
+// Run an Encoder or Decoder call now if the object is idle, otherwise queue
+// it behind the calls already issued on that object. Queued calls count
+// against the queue limit, and are turned away right away when the pool
+// rejects overload and would not admit them now.
+static void
+bare_delta_codec_submit(bare_delta_pool_t *pool, bare_delta_codec_t *codec, bare_delta_request_t *request) {
+  if (!codec->busy) {
+    codec->busy = true;
+    request->holds_codec = true;
+    bare_delta_pool_submit(pool, request);
+    return;
+  }
+  
+  if (pool->reject_overload && bare_delta_pool_must_wait(pool, bare_delta_pool_request_bytes(pool, request))) {
+    bare_delta_pool_track(pool, request);
+    bare_delta_pool_reject(pool, request);
+    return;
+  }
+  
+  pool->codec_queued++;
+  
+  request->next = NULL;
+  
+  if (codec->tail) codec->tail->next = request;
+  else codec->head = request;
+  codec->tail = request;
+}
+
+// Hand the object to the next waiting call once the current one is delivered
+static void
+bare_delta_codec_next(bare_delta_pool_t *pool, bare_delta_codec_t *codec) {
+  bare_delta_request_t *request = codec->head;
+  
+  if (request == NULL) {
+    codec->busy = false;
+    return;
+  }
+  
+  codec->head = request->next;
+  if (codec->head == NULL) codec->tail = NULL;
+  
+  pool->codec_queued--;
+  
+  request->holds_codec = true;
+  bare_delta_pool_submit(pool, request);
+}
+
+static bare_delta_pool_t *
+bare_delta_pool_init(js_env_t *env) {
+  int err;
+  
+  bare_delta_pool_t *pool = (bare_delta_pool_t *)malloc(sizeof(bare_delta_pool_t));
+  memset(pool, 0, sizeof(bare_delta_pool_t));
+  
+  pool->env = env;
+  pool->thread_limit = BARE_DELTA_POOL_THREADS_DEFAULT;
+  pool->queue_limit = BARE_DELTA_POOL_QUEUE_LIMIT_DEFAULT;
+  
+  err = uv_mutex_init(&pool->lock);
+  assert(err == 0);
+  
+  err = uv_cond_init(&pool->available);
+  assert(err == 0);
+  
+  uv_loop_t *loop;
+  err = js_get_env_loop(env, &loop);
+  assert(err == 0);
+  
+  err = uv_async_init(loop, &pool->async, bare_delta_pool_on_complete);
+  assert(err == 0);
+  
+  pool->async.data = pool;
+  
+  // Only keep the loop alive while requests are pending
+  uv_unref((uv_handle_t *)&pool->async);
+  
+  err = js_add_deferred_teardown_callback(env, bare_delta_pool_teardown, pool, &pool->teardown);
+  assert(err == 0);
+  
+  return pool;
+}
+
+// Read the lane for an async request from the `priority` option
+static int
+parse_priority_option(js_env_t *env, js_value_t *options, int fallback) {
+  js_value_t *prop;
+  js_value_type_t type;
+  
+  if (options == NULL || js_typeof(env, options, &type) != 0 || type != js_object) {
+    return fallback;
+  }
+  
+  if (js_get_named_property(env, options, "priority", &prop) != 0 ||
+      js_typeof(env, prop, &type) != 0 || type != js_string) {
+    return fallback;
+  }
+  
+  utf8_t value[16] = {0};
+  size_t len;
+  if (js_get_value_string_utf8(env, prop, value, sizeof(value) - 1, &len) != 0) {
+    return fallback;
+  }
+  
+  if (strcmp((const char *)value, "interactive") == 0) return BARE_DELTA_LANE_INTERACTIVE;
+  if (strcmp((const char *)value, "background") == 0) return BARE_DELTA_LANE_BACKGROUND;
+  
+  return fallback;
+}
+
+// Read the `stats` option, which asks for engine counters with the result
+static bool
+parse_stats_option(js_env_t *env, js_value_t *options) {
+  js_value_t *prop;
+  js_value_type_t type;
+  
+  if (options == NULL || js_typeof(env, options, &type) != 0 || type != js_object) {
+    return false;
+  }
+  
+  bool value;
+  if (js_get_named_property(env, options, "stats", &prop) != 0 ||
+      js_typeof(env, prop, &type) != 0 || type != js_boolean ||
+      js_get_value_bool(env, prop, &value) != 0) {
+    return false;
+  }
+  
+  return value;
+}
+
+// Reconfigure the worker pool: configure(threads, queueLimit), where 0 keeps
+// the current value
+static js_value_t *
+bare_delta_configure(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  size_t argc = 2;
+  js_value_t *argv[2];
+  bare_delta_pool_t *pool;
+  err = js_get_callback_info(env, info, &argc, argv, NULL, (void **)&pool);
+  assert(err == 0);
+  
+  if (argc < 2) {
+    js_throw_error(env, NULL, "delta.configure requires 2 arguments (threads, queueLimit)");
+    return NULL;
+  }
+  
+  // A negative value leaves the setting unchanged
+  int64_t threads, queue_limit;
+  err = js_get_value_int64(env, argv[0], &threads);
+  assert(err == 0);
+  err = js_get_value_int64(env, argv[1], &queue_limit);
+  assert(err == 0);
+  
+  if (threads > BARE_DELTA_POOL_THREADS_MAX) threads = BARE_DELTA_POOL_THREADS_MAX;
+  if (queue_limit > UINT32_MAX) queue_limit = UINT32_MAX;
+  
+  uv_mutex_lock(&pool->lock);
+  if (threads >= 0) pool->thread_limit = (uint32_t)threads;
+  if (queue_limit > 0) pool->queue_limit = (uint32_t)queue_limit;
+  uv_cond_broadcast(&pool->available);
+  uv_mutex_unlock(&pool->lock);
+  
+  return NULL;
+}
+
+// Set admission limits: configureAdmission(maxInFlight, maxInFlightBytes, reject)
+// A limit of 0 means unlimited. Raising a limit admits waiting requests.
+static js_value_t *
+bare_delta_configure_admission(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  size_t argc = 3;
+  js_value_t *argv[3];
+  bare_delta_pool_t *pool;
+  err = js_get_callback_info(env, info, &argc, argv, NULL, (void **)&pool);
+  assert(err == 0);
+  
+  if (argc < 3) {
+    js_throw_error(env, NULL, "delta.configureAdmission requires 3 arguments (maxInFlight, maxInFlightBytes, reject)");
+    return NULL;
+  }
+  
+  uint32_t max_in_flight;
+  double max_in_flight_bytes;
+  bool reject;
+  err = js_get_value_uint32(env, argv[0], &max_in_flight);
+  assert(err == 0);
+  err = js_get_value_double(env, argv[1], &max_in_flight_bytes);
+  assert(err == 0);
+  err = js_get_value_bool(env, argv[2], &reject);
+  assert(err == 0);
+  
+  pool->in_flight_limit = max_in_flight;
+  pool->in_flight_bytes_limit = max_in_flight_bytes > 0 ? (uint64_t)max_in_flight_bytes : 0;
+  pool->reject_overload = reject;
+  
+  bare_delta_pool_admit(pool);
+  
+  return NULL;
+}
+
+// Snapshot of worker pool state and per-lane queue wait times in milliseconds
+static js_value_t *
+bare_delta_stats(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  bare_delta_pool_t *pool;
+  err = js_get_callback_info(env, info, NULL, NULL, NULL, (void **)&pool);
+  assert(err == 0);
+  
+  static const char *lane_names[BARE_DELTA_LANE_COUNT] = {"interactive", "background"};
+  
+  uv_mutex_lock(&pool->lock);
+  uint32_t threads = pool->thread_limit;
+  uint32_t started = pool->thread_count;
+  uint32_t queue_limit = pool->queue_limit;
+  bare_delta_lane_t lanes[BARE_DELTA_LANE_COUNT];
+  memcpy(lanes, pool->lanes, sizeof(lanes));
+  uv_mutex_unlock(&pool->lock);
+  
+  js_value_t *result;
+  err = js_create_object(env, &result);
+  assert(err == 0);
+  
+  bare_delta_set_uint32(env, result, "threads", threads);
+  bare_delta_set_uint32(env, result, "started", started);
+  bare_delta_set_uint32(env, result, "queueLimit", queue_limit);
+  bare_delta_set_uint32(env, result, "pending", pool->pending);
+  bare_delta_set_uint32(env, result, "inFlight", pool->in_flight);
+  bare_delta_set_double(env, result, "inFlightBytes", (double)pool->in_flight_bytes);
+  bare_delta_set_uint32(env, result, "waiting", pool->waiting);
+  bare_delta_set_uint32(env, result, "codecQueued", pool->codec_queued);
+  bare_delta_set_double(env, result, "waitingBytes", (double)pool->waiting_bytes);
+  bare_delta_set_double(env, result, "overloaded", (double)pool->overloaded);
+  
+  for (int i = 0; i < BARE_DELTA_LANE_COUNT; i++) {
+    bare_delta_lane_t *lane = &lanes[i];
+    uint64_t started_requests = lane->submitted - lane->queued;
+    
+    js_value_t *stats;
+    err = js_create_object(env, &stats);
+    assert(err == 0);
+    
+    bare_delta_set_uint32(env, stats, "queued", lane->queued);
+    bare_delta_set_uint32(env, stats, "active", lane->active);
+    bare_delta_set_double(env, stats, "submitted", (double)lane->submitted);
+    bare_delta_set_double(env, stats, "completed", (double)lane->completed);
+    bare_delta_set_double(env, stats, "rejected", (double)lane->rejected);
+    bare_delta_set_double(env, stats, "cancelled", (double)lane->cancelled);
+    bare_delta_set_double(env, stats, "waitTotal", lane->wait_total / 1e6);
+    bare_delta_set_double(env, stats, "waitMax", lane->wait_max / 1e6);
+    bare_delta_set_double(env, stats, "waitMean", started_requests ? lane->wait_total / 1e6 / started_requests : 0);
+    
+    err = js_set_named_property(env, result, lane_names[i], stats);
+    assert(err == 0);
+  }
+  
+  return result;
+}
+
+// Value below which a fraction q of the recorded values fall, reported as the
+// highest value of its bucket but never above the recorded maximum
+static uint64_t
+bare_delta_histogram_percentile(const bare_delta_histogram_t *h, double q) {
+  uint64_t rank = (uint64_t)(q * h->count + 0.5);
+  if (rank == 0) rank = 1;
+  
+  uint64_t seen = 0;
+  for (uint32_t i = 0; i < BARE_DELTA_HISTOGRAM_BUCKETS; i++) {
+    seen += h->buckets[i];
+    if (seen >= rank) {
+      uint64_t value = bare_delta_histogram_bucket_max(i);
+      return value < h->max ? value : h->max;
+    }
+  }
+  
+  return h->max;
+}
+
+// Summarise a histogram in milliseconds
+static js_value_t *
+bare_delta_create_histogram(js_env_t *env, const bare_delta_histogram_t *h) {
+  js_value_t *result;
+  int err = js_create_object(env, &result);
+  assert(err == 0);
+  
+  bare_delta_set_double(env, result, "count", (double)h->count);
+  bare_delta_set_double(env, result, "mean", h->count ? h->sum / 1e6 / h->count : 0);
+  bare_delta_set_double(env, result, "max", h->max / 1e6);
+  bare_delta_set_double(env, result, "p50", h->count ? bare_delta_histogram_percentile(h, 0.5) / 1e6 : 0);
+  bare_delta_set_double(env, result, "p90", h->count ? bare_delta_histogram_percentile(h, 0.9) / 1e6 : 0);
+  bare_delta_set_double(env, result, "p99", h->count ? bare_delta_histogram_percentile(h, 0.99) / 1e6 : 0);
+  bare_delta_set_double(env, result, "p999", h->count ? bare_delta_histogram_percentile(h, 0.999) / 1e6 : 0);
+  
+  return result;
+}
+
+// Cumulative process-wide counters and latency histograms, summed over the
+// shards of every thread that has recorded an operation
+static js_value_t *
+bare_delta_metrics(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  
+  static const char *op_names[BARE_DELTA_OP_COUNT] = {
+    "create", "apply", "applyBatch", "createMany", "applyMany", "encode", "decode"
+  };
+  
+  static const char *histogram_names[BARE_DELTA_HISTOGRAM_COUNT] = {"queueWait", "execution", "total"};
+  
+  uint64_t operations[BARE_DELTA_OP_COUNT] = {0};
+  uint64_t failures[BARE_DELTA_ERROR_COUNT] = {0};
+  uint64_t bytes_in = 0, bytes_out = 0;
+  
+  bare_delta_histogram_t *histograms = (bare_delta_histogram_t *)calloc(BARE_DELTA_HISTOGRAM_COUNT, sizeof(bare_delta_histogram_t));
+  if (histograms == NULL) {
+    js_throw_error(env, "ENOMEM", "Failed to allocate metrics");
+    return NULL;
+  }
+  
+  bare_delta_metrics_t *shard = __atomic_load_n(&bare_delta_metrics_head, __ATOMIC_ACQUIRE);
+  
+  for (; shard; shard = shard->next) {
+    for (int i = 0; i < BARE_DELTA_OP_COUNT; i++) {
+      operations[i] += bare_delta_metrics_read(&shard->operations[i]);
+    }
+    for (int i = 0; i < BARE_DELTA_ERROR_COUNT; i++) {
+      failures[i] += bare_delta_metrics_read(&shard->failures[i]);
+    }
+    bytes_in += bare_delta_metrics_read(&shard->bytes_in);
+    bytes_out += bare_delta_metrics_read(&shard->bytes_out);
+    
+    for (int i = 0; i < BARE_DELTA_HISTOGRAM_COUNT; i++) {
+      const bare_delta_histogram_t *from = &shard->histograms[i];
+      bare_delta_histogram_t *to = &histograms[i];
+      
+      to->count += bare_delta_metrics_read(&from->count);
+      to->sum += bare_delta_metrics_read(&from->sum);
+      
+      uint64_t max = bare_delta_metrics_read(&from->max);
+      if (max > to->max) to->max = max;
+      
+      for (uint32_t j = 0; j < BARE_DELTA_HISTOGRAM_BUCKETS; j++) {
+        to->buckets[j] += bare_delta_metrics_read(&from->buckets[j]);
+      }
+    }
+  }
+  
+  js_value_t *result;
+  err = js_create_object(env, &result);
+  assert(err == 0);
+  
+  js_value_t *object;
+  err = js_create_object(env, &object);
+  assert(err == 0);
+  for (int i = 0; i < BARE_DELTA_OP_COUNT; i++) {
+    bare_delta_set_double(env, object, op_names[i], (double)operations[i]);
+  }
+  err = js_set_named_property(env, result, "operations", object);
+  assert(err == 0);
+  
+  bare_delta_set_double(env, result, "bytesIn", (double)bytes_in);
+  bare_delta_set_double(env, result, "bytesOut", (double)bytes_out);
+  
+  err = js_create_object(env, &object);
+  assert(err == 0);
+  for (int i = 0; i < BARE_DELTA_ERROR_COUNT; i++) {
+    bare_delta_set_double(env, object, bare_delta_error_names[i], (double)failures[i]);
+  }
+  err = js_set_named_property(env, result, "failures", object);
+  assert(err == 0);
+  
+  for (int i = 0; i < BARE_DELTA_HISTOGRAM_COUNT; i++) {
+    err = js_set_named_property(env, result, histogram_names[i], bare_delta_create_histogram(env, &histograms[i]));
+    assert(err == 0);
+  }
+  
+  free(histograms);
+  
+  return result;
+}
+
+// Cancel an in-flight async request: cancel(handle)
+static js_value_t *
+bare_delta_cancel(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  size_t argc = 1;
+  js_value_t *argv[1];
+  bare_delta_pool_t *pool;
+  err = js_get_callback_info(env, info, &argc, argv, NULL, (void **)&pool);
+  assert(err == 0);
+  
+  if (argc < 1) {
+    js_throw_error(env, NULL, "delta.cancel requires 1 argument (request)");
+    return NULL;
+  }
+  
+  bare_delta_request_t *request;
+  err = js_get_value_external(env, argv[0], (void **)&request);
+  if (err != 0) return NULL;
+  
+  bare_delta_pool_cancel(pool, request);
+  
+  return NULL;
+}
+
+// Synchronous delta_create binding
+static js_value_t *
+bare_delta_create_sync(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  size_t argc = 3;
+  js_value_t *argv[3];
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+  
+  
+  if (argc < 2) {
+    js_throw_error(env, NULL, "delta.createSync requires at least 2 arguments (source, target[, options])");
+    return NULL;
+  }
+  
+  // Extract buffers
+  size_t source_len, target_len;
+  void *source_data, *target_data;
+  
+  if (extract_buffer(env, argv[0], &source_data, &source_len, "source") != 0 ||
+      extract_buffer(env, argv[1], &target_data, &target_len, "target") != 0) {
+    return NULL;
+  }
+  
+  // Parse options
+  int nhash, search_limit, compressed;
+  parse_create_options(env, argc > 2 ? argv[2] : NULL, &nhash, &search_limit, &compressed);
+  bool want_stats = parse_stats_option(env, argc > 2 ? argv[2] : NULL);
+  
+  // Use core logic
+  bare_delta_stats_t stats = {0};
+  char *result_data;
+  size_t result_len = 0;
+  uint64_t start = uv_hrtime();
+  DELTA_PROBE3(op__start, BARE_DELTA_OP_CREATE, source_len, target_len);
+  int result_code = delta_create_core(source_data, source_len, target_data, target_len,
+                                      nhash, search_limit, compressed, NULL,
+                                      want_stats ? &stats : NULL, &result_data, &result_len);
+  
+  DELTA_PROBE3(op__done, BARE_DELTA_OP_CREATE, result_code, result_len);
+  bare_delta_metrics_record(BARE_DELTA_OP_CREATE, source_len + target_len, result_len, result_code, uv_hrtime() - start, true);
+  
+  if (result_code != 0) {
+    js_throw_error(env, bare_delta_error_names[bare_delta_error_class(BARE_DELTA_OP_CREATE, result_code)], "Failed to create delta");
+    return NULL;
+  }
+  
+  // Hand the result buffer over to JavaScript without copying
+  js_value_t *result;
+  if (want_stats) {
+    err = bare_delta_create_stats_result(env, result_data, result_len, &stats, false, &result);
+  } else {
+    err = bare_delta_create_result(env, result_data, result_len, &result);
+  }
+  if (err != 0) return NULL;
+  
+  return result;
+}
+
+// Synchronous delta_apply binding
+static js_value_t *
+bare_delta_apply_sync(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  size_t argc = 3;
+  js_value_t *argv[3];
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+  
+  if (argc < 2) {
+    js_throw_error(env, NULL, "delta.applySync requires at least 2 arguments (source, delta[, options])");
+    return NULL;
+  }
   
   // Extract buffers
+  size_t source_len, delta_len;
+  void *source_data, *delta_data;
+  
+  if (extract_buffer(env, argv[0], &source_data, &source_len, "source") != 0 ||
+      extract_buffer(env, argv[1], &delta_data, &delta_len, "delta") != 0) {
+    return NULL;
+  }
+  
+  bool want_stats = parse_stats_option(env, argc > 2 ? argv[2] : NULL);
+  
+  // Use core logic (auto-detection handled internally)
+  bare_delta_stats_t stats = {0};
+  char *result_data;
+  size_t result_len = 0;
+  uint64_t start = uv_hrtime();
+  DELTA_PROBE3(op__start, BARE_DELTA_OP_APPLY, source_len, delta_len);
+  int result_code = delta_apply_core(source_data, source_len, delta_data, delta_len,
+                                     0, NULL, want_stats ? &stats : NULL, &result_data, &result_len);
+  
+  DELTA_PROBE3(op__done, BARE_DELTA_OP_APPLY, result_code, result_len);
+  bare_delta_metrics_record(BARE_DELTA_OP_APPLY, source_len + delta_len, result_len, result_code, uv_hrtime() - start, true);
+  
+  if (result_code != 0) {
+    js_throw_error(env, bare_delta_error_names[bare_delta_error_class(BARE_DELTA_OP_APPLY, result_code)], "Failed to apply delta");
+    return NULL;
+  }
+  
+  // Hand the result buffer over to JavaScript without copying
+  js_value_t *result;
+  if (want_stats) {
+    err = bare_delta_create_stats_result(env, result_data, result_len, &stats, true, &result);
+  } else {
+    err = bare_delta_create_result(env, result_data, result_len, &result);
+  }
+  if (err != 0) return NULL;
+  
+  return result;
+}
+
+// Extract buffer and create reference (helper function)
+static int
+extract_buffer_with_ref(js_env_t *env, js_value_t *value, const char *name,
+                        void **data, size_t *len, js_ref_t **ref) {
+  if (extract_buffer(env, value, data, len, name) != 0) {
+    return -1;
+  }
+  
+  // Create a reference to keep the TypedArray alive
+  int err = js_create_reference(env, value, 1, ref);
+  if (err != 0) {
+    js_throw_error(env, NULL, "Failed to create buffer reference");
+    return -1;
+  }
+  
+  return 0;
+}
+
+// Asynchronous delta_create binding
+static js_value_t *
+bare_delta_create_async(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  size_t argc = 4;
+  js_value_t *argv[4];
+  js_value_t *ctx;
+  bare_delta_pool_t *pool;
+  err = js_get_callback_info(env, info, &argc, argv, &ctx, (void **)&pool);
+  assert(err == 0);
+  
+  if (argc < 3) {
+    js_throw_error(env, NULL, "delta.create requires at least 3 arguments (source, target, [options,] callback)");
+    return NULL;
+  }
+  
+  int lane = parse_priority_option(env, argc == 4 ? argv[2] : NULL, BARE_DELTA_LANE_BACKGROUND);
+  
+  if (!bare_delta_pool_accepting(pool, lane)) {
+    js_throw_error(env, "QUEUE_FULL", "Worker queue is full");
+    return NULL;
+  }
+  
+  // Allocate request
+  bare_delta_request_t *request = (bare_delta_request_t *)malloc(sizeof(bare_delta_request_t));
+  memset(request, 0, sizeof(bare_delta_request_t));
+  
+  request->env = env;
+  request->lane = lane;
+  request->op = BARE_DELTA_OP_CREATE;
+  
+  // Extract buffers and create references (no copying)
+  if (extract_buffer_with_ref(env, argv[0], "source", &request->buf1, &request->len1, &request->source_ref) != 0 ||
+      extract_buffer_with_ref(env, argv[1], "target", &request->buf2, &request->len2, &request->target_ref) != 0) {
+    if (request->source_ref) js_delete_reference(env, request->source_ref);
+    free(request);
+    return NULL;
+  }
+  
+  // Parse options and store callback
+  js_value_t *callback;
+  if (argc == 4) {
+    parse_create_options(env, argv[2], &request->nhash, &request->search_limit, &request->compressed);
+    request->want_stats = parse_stats_option(env, argv[2]);
+    callback = argv[3];
+  } else {
+    parse_create_options(env, NULL, &request->nhash, &request->search_limit, &request->compressed);
+    callback = argv[2];
+  }
+  
+  // Store callback reference
+  err = js_create_reference(env, callback, 1, &request->callback);
+  assert(err == 0);
+  
+  err = js_create_reference(env, ctx, 1, &request->ctx);
+  assert(err == 0);
+  
+  // Start teardown tracking
+  err = js_add_deferred_teardown_callback(env, NULL, NULL, &request->teardown);
+  assert(err == 0);
+  
+  // Queue work on the worker pool
+  bare_delta_pool_submit(pool, request);
+  
+  // Return a handle that can be passed to cancel() until the callback runs
+  js_value_t *handle;
+  err = js_create_external(env, request, NULL, NULL, &handle);
+  assert(err == 0);
+  
+  return handle;
+}
+
+// Asynchronous delta_apply binding
+static js_value_t *
+bare_delta_apply_async(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  size_t argc = 4;
+  js_value_t *argv[4];
+  js_value_t *ctx;
+  bare_delta_pool_t *pool;
+  err = js_get_callback_info(env, info, &argc, argv, &ctx, (void **)&pool);
+  assert(err == 0);
+  
+  if (argc < 3) {
+    js_throw_error(env, NULL, "delta.apply requires at least 3 arguments (source, delta, [options,] callback)");
+    return NULL;
+  }
+  
+  int lane = parse_priority_option(env, argc == 4 ? argv[2] : NULL, BARE_DELTA_LANE_INTERACTIVE);
+  
+  if (!bare_delta_pool_accepting(pool, lane)) {
+    js_throw_error(env, "QUEUE_FULL", "Worker queue is full");
+    return NULL;
+  }
+  
+  // Allocate request
+  bare_delta_request_t *request = (bare_delta_request_t *)malloc(sizeof(bare_delta_request_t));
+  memset(request, 0, sizeof(bare_delta_request_t));
+  
+  request->env = env;
+  request->lane = lane;
+  request->op = BARE_DELTA_OP_APPLY;
+  request->compressed = 0; // Auto-detection in core
+  request->want_stats = parse_stats_option(env, argc == 4 ? argv[2] : NULL);
+  
+  // Extract buffers and create references (no copying)
+  if (extract_buffer_with_ref(env, argv[0], "source", &request->buf1, &request->len1, &request->source_ref) != 0 ||
+      extract_buffer_with_ref(env, argv[1], "delta", &request->buf2, &request->len2, &request->target_ref) != 0) {
+    if (request->source_ref) js_delete_reference(env, request->source_ref);
+    free(request);
+    return NULL;
+  }
+  
+  // Store callback
+  js_value_t *callback = argv[argc - 1];
+  
+  // Store callback reference
+  err = js_create_reference(env, callback, 1, &request->callback);
+  assert(err == 0);
+  
+  err = js_create_reference(env, ctx, 1, &request->ctx);
+  assert(err == 0);
+  
+  // Start teardown tracking
+  err = js_add_deferred_teardown_callback(env, NULL, NULL, &request->teardown);
+  assert(err == 0);
+  
+  // Queue work on the worker pool
+  bare_delta_pool_submit(pool, request);
+  
+  // Return a handle that can be passed to cancel() until the callback runs
+  js_value_t *handle;
+  err = js_create_external(env, request, NULL, NULL, &handle);
+  assert(err == 0);
+  
+  return handle;
+}
+
+// Synchronous batch delta_apply binding
+static js_value_t *
+bare_delta_apply_batch_sync(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  size_t argc = 2;
+  js_value_t *argv[2];
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+  
+  if (argc < 2) {
+    js_throw_error(env, NULL, "delta.applyBatchSync requires 2 arguments (source, deltas)");
+    return NULL;
+  }
+  
+  // Extract source buffer
+  size_t source_len;
+  void *source_data;
+  if (extract_buffer(env, argv[0], &source_data, &source_len, "source") != 0) {
+    return NULL;
+  }
+  
+  // Get delta array
+  bool is_array;
+  err = js_is_array(env, argv[1], &is_array);
+  assert(err == 0);
+  
+  if (!is_array) {
+    js_throw_type_error(env, NULL, "deltas must be an array");
+    return NULL;
+  }
+  
+  uint32_t delta_count;
+  err = js_get_array_length(env, argv[1], &delta_count);
+  assert(err == 0);
+  
+  // Extract all deltas
+  void **deltas = malloc(sizeof(void *) * delta_count);
+  size_t *delta_lens = malloc(sizeof(size_t) * delta_count);
+  
+  if (!deltas || !delta_lens) {
+    if (deltas) free(deltas);
+    if (delta_lens) free(delta_lens);
+    js_throw_error(env, NULL, "Failed to allocate memory for delta arrays");
+    return NULL;
+  }
+  
+  for (uint32_t i = 0; i < delta_count; i++) {
+    js_value_t *delta_val;
+    err = js_get_element(env, argv[1], i, &delta_val);
+    assert(err == 0);
+    
+    if (extract_buffer(env, delta_val, &deltas[i], &delta_lens[i], "delta") != 0) {
+      free(deltas);
+      free(delta_lens);
+      return NULL;
+    }
+  }
+  
+  uint64_t bytes_in = source_len;
+  for (uint32_t i = 0; i < delta_count; i++) {
+    bytes_in += delta_lens[i];
+  }
+  
+  // Use core batch logic (auto-detection handled internally)
+  char *result_data;
+  size_t result_len = 0;
+  uint64_t start = uv_hrtime();
+  int result_code = delta_apply_batch_core(source_data, source_len, deltas, delta_lens, delta_count,
+                                           0, NULL, &result_data, &result_len);
+  
+  bare_delta_metrics_record(BARE_DELTA_OP_APPLY_BATCH, bytes_in, result_len, result_code, uv_hrtime() - start, true);
+  
+  free(deltas);
+  free(delta_lens);
+  
+  if (result_code != 0) {
+    js_throw_error(env, bare_delta_error_names[bare_delta_error_class(BARE_DELTA_OP_APPLY_BATCH, result_code)], "Failed to apply batch deltas");
+    return NULL;
+  }
+  
+  // Hand the result buffer over to JavaScript without copying
+  js_value_t *result;
+  err = bare_delta_create_result(env, result_data, result_len, &result);
+  if (err != 0) return NULL;
+  
+  return result;
+}
+
+// Asynchronous batch delta_apply binding
+static js_value_t *
+bare_delta_apply_batch_async(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  size_t argc = 4;
+  js_value_t *argv[4];
+  js_value_t *ctx;
+  bare_delta_pool_t *pool;
+  err = js_get_callback_info(env, info, &argc, argv, &ctx, (void **)&pool);
+  assert(err == 0);
+  
+  if (argc < 3) {
+    js_throw_error(env, NULL, "delta.applyBatch requires at least 3 arguments (source, deltas, [options,] callback)");
+    return NULL;
+  }
+  
+  int lane = parse_priority_option(env, argc == 4 ? argv[2] : NULL, BARE_DELTA_LANE_INTERACTIVE);
+  
+  if (!bare_delta_pool_accepting(pool, lane)) {
+    js_throw_error(env, "QUEUE_FULL", "Worker queue is full");
+    return NULL;
+  }
+  
+  // Get delta array
+  bool is_array;
+  err = js_is_array(env, argv[1], &is_array);
+  assert(err == 0);
+  
+  if (!is_array) {
+    js_throw_type_error(env, NULL, "deltas must be an array");
+    return NULL;
+  }
+  
+  uint32_t delta_count;
+  err = js_get_array_length(env, argv[1], &delta_count);
+  assert(err == 0);
+  
+  // Allocate request
+  bare_delta_request_t *request = (bare_delta_request_t *)malloc(sizeof(bare_delta_request_t));
+  memset(request, 0, sizeof(bare_delta_request_t));
+  
+  request->env = env;
+  request->lane = lane;
+  request->op = BARE_DELTA_OP_APPLY_BATCH;
+  request->batch_count = delta_count;
+  
+  // Extract source buffer and create reference
+  if (extract_buffer_with_ref(env, argv[0], "source", &request->buf1, &request->len1, &request->source_ref) != 0) {
+    free(request);
+    return NULL;
+  }
+  
+  // Allocate arrays for batch operation
+  request->batch_deltas = malloc(sizeof(void *) * delta_count);
+  request->batch_delta_lens = malloc(sizeof(size_t) * delta_count);
+  request->batch_refs = malloc(sizeof(js_ref_t *) * delta_count);
+  
+  if (!request->batch_deltas || !request->batch_delta_lens || !request->batch_refs) {
+    if (request->source_ref) js_delete_reference(env, request->source_ref);
+    if (request->batch_deltas) free(request->batch_deltas);
+    if (request->batch_delta_lens) free(request->batch_delta_lens);
+    if (request->batch_refs) free(request->batch_refs);
+    free(request);
+    js_throw_error(env, NULL, "Failed to allocate memory for batch arrays");
+    return NULL;
+  }
+  
+  memset(request->batch_refs, 0, sizeof(js_ref_t *) * delta_count);
+  
+  // Extract all deltas and create references
+  for (uint32_t i = 0; i < delta_count; i++) {
+    js_value_t *delta_val;
+    err = js_get_element(env, argv[1], i, &delta_val);
+    assert(err == 0);
+    
+    if (extract_buffer_with_ref(env, delta_val, "delta", 
+                                &request->batch_deltas[i], &request->batch_delta_lens[i], 
+                                &request->batch_refs[i]) != 0) {
+      // Clean up on error
+      if (request->source_ref) js_delete_reference(env, request->source_ref);
+      for (uint32_t j = 0; j <= i; j++) {
+        if (request->batch_refs[j]) js_delete_reference(env, request->batch_refs[j]);
+      }
+      free(request->batch_deltas);
+      free(request->batch_delta_lens);
+      free(request->batch_refs);
+      free(request);
+      return NULL;
+    }
+  }
+  
+  // Store callback
+  js_value_t *callback = argv[argc - 1];
+  request->compressed = 0; // Auto-detection in core
+  
+  // Store callback reference
+  err = js_create_reference(env, callback, 1, &request->callback);
+  assert(err == 0);
+  
+  err = js_create_reference(env, ctx, 1, &request->ctx);
+  assert(err == 0);
+  
+  // Start teardown tracking
+  err = js_add_deferred_teardown_callback(env, NULL, NULL, &request->teardown);
+  assert(err == 0);
+  
+  // Queue work on the worker pool
+  bare_delta_pool_submit(pool, request);
+  
+  // Return a handle that can be passed to cancel() until the callback runs
+  js_value_t *handle;
+  err = js_create_external(env, request, NULL, NULL, &handle);
+  assert(err == 0);
+  
+  return handle;
+}
+
+
+// Extract an array of [source, target|delta] pairs. When `holder` is given, a
+// fresh array holding every buffer is returned through it so the caller can
+// pin them all with a single reference for the duration of async work.
+static bare_delta_pairs_t *
+extract_pairs(js_env_t *env, js_value_t *value, const char *input_name, js_value_t **holder) {
+  int err;
+  
+  bool is_array;
+  err = js_is_array(env, value, &is_array);
+  assert(err == 0);
+  
+  if (!is_array) {
+    js_throw_type_error(env, NULL, "pairs must be an array");
+    return NULL;
+  }
+  
+  uint32_t count;
+  err = js_get_array_length(env, value, &count);
+  assert(err == 0);
+  
+  bare_delta_pairs_t *pairs = bare_delta_pairs_alloc(count);
+  if (pairs == NULL) {
+    js_throw_error(env, NULL, "Failed to allocate memory for pairs");
+    return NULL;
+  }
+  
+  if (holder) {
+    err = js_create_array_with_length(env, count * 2, holder);
+    assert(err == 0);
+  }
+  
+  for (uint32_t i = 0; i < count; i++) {
+    js_value_t *pair;
+    err = js_get_element(env, value, i, &pair);
+    assert(err == 0);
+    
+    err = js_is_array(env, pair, &is_array);
+    assert(err == 0);
+    
+    if (!is_array) {
+      js_throw_type_error(env, NULL, "each pair must be an array of two buffers");
+      free(pairs);
+      return NULL;
+    }
+    
+    js_value_t *source, *input;
+    err = js_get_element(env, pair, 0, &source);
+    assert(err == 0);
+    err = js_get_element(env, pair, 1, &input);
+    assert(err == 0);
+    
+    if (extract_buffer(env, source, &pairs->sources[i], &pairs->source_lens[i], "source") != 0 ||
+        extract_buffer(env, input, &pairs->inputs[i], &pairs->input_lens[i], input_name) != 0) {
+      free(pairs);
+      return NULL;
+    }
+    
+    if (holder) {
+      err = js_set_element(env, *holder, i * 2, source);
+      assert(err == 0);
+      err = js_set_element(env, *holder, i * 2 + 1, input);
+      assert(err == 0);
+    }
+  }
+  
+  return pairs;
+}
+
+// Run createMany/applyMany on the JS thread
+static js_value_t *
+bare_delta_many_sync(js_env_t *env, js_callback_info_t *info, int op) {
+  int err;
+  size_t argc = 2;
+  js_value_t *argv[2];
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+  
+  if (argc < 1) {
+    js_throw_error(env, NULL, op == BARE_DELTA_OP_CREATE_MANY
+      ? "delta.createManySync requires at least 1 argument (pairs, [options])"
+      : "delta.applyManySync requires 1 argument (pairs)");
+    return NULL;
+  }
+  
+  bare_delta_pairs_t *pairs = extract_pairs(env, argv[0], op == BARE_DELTA_OP_CREATE_MANY ? "target" : "delta", NULL);
+  if (pairs == NULL) return NULL;
+  
+  int nhash, search_limit, compressed;
+  parse_create_options(env, argc == 2 ? argv[1] : NULL, &nhash, &search_limit, &compressed);
+  
+  uint64_t bytes_in = 0;
+  for (size_t i = 0; i < pairs->count; i++) {
+    bytes_in += pairs->source_lens[i] + pairs->input_lens[i];
+  }
+  
+  char *result_data;
+  size_t result_len = 0;
+  uint64_t start = uv_hrtime();
+  int result_code = delta_many_core(op, pairs, nhash, search_limit, compressed, NULL, &result_data, &result_len);
+  
+  bare_delta_metrics_record(op, bytes_in, result_len, result_code, uv_hrtime() - start, true);
+  
+  if (result_code != 0) {
+    // Throw with the same code, index and partial results as the async path
+    char text[64];
+    snprintf(text, sizeof(text), "Operation failed at pair %zu", pairs->failed);
+    
+    js_value_t *code, *message, *error, *results;
+    err = js_create_string_utf8(env, (const utf8_t *)bare_delta_error_names[bare_delta_error_class(op, result_code)], -1, &code);
+    assert(err == 0);
+    err = js_create_string_utf8(env, (const utf8_t *)text, -1, &message);
+    assert(err == 0);
+    err = js_create_error(env, code, message, &error);
+    assert(err == 0);
+    
+    bare_delta_set_uint32(env, error, "index", (uint32_t)pairs->failed);
+    
+    err = bare_delta_create_results(env, result_data, result_len, pairs->offsets, pairs->failed, &results);
+    assert(err == 0);
+    err = js_set_named_property(env, error, "results", results);
+    assert(err == 0);
+    
+    free(pairs);
+    
+    err = js_throw(env, error);
+    assert(err == 0);
+    return NULL;
+  }
+  
+  // Hand the packed results over to JavaScript without copying
+  js_value_t *result;
+  err = bare_delta_create_results(env, result_data, result_len, pairs->offsets, pairs->count, &result);
+  
+  free(pairs);
+  
+  if (err != 0) return NULL;
+  
+  return result;
+}
+
+// Synchronous createMany binding
+static js_value_t *
+bare_delta_create_many_sync(js_env_t *env, js_callback_info_t *info) {
+  return bare_delta_many_sync(env, info, BARE_DELTA_OP_CREATE_MANY);
+}
+
+// Synchronous applyMany binding
+static js_value_t *
+bare_delta_apply_many_sync(js_env_t *env, js_callback_info_t *info) {
+  return bare_delta_many_sync(env, info, BARE_DELTA_OP_APPLY_MANY);
+}
+
+// Queue createMany/applyMany as a single work item on the worker pool
+static js_value_t *
+bare_delta_many_async(js_env_t *env, js_callback_info_t *info, int op) {
+  int err;
+  size_t argc = 3;
+  js_value_t *argv[3];
+  js_value_t *ctx;
+  bare_delta_pool_t *pool;
+  err = js_get_callback_info(env, info, &argc, argv, &ctx, (void **)&pool);
+  assert(err == 0);
+  
+  if (argc < 2) {
+    js_throw_error(env, NULL, op == BARE_DELTA_OP_CREATE_MANY
+      ? "delta.createMany requires at least 2 arguments (pairs, [options,] callback)"
+      : "delta.applyMany requires at least 2 arguments (pairs, [options,] callback)");
+    return NULL;
+  }
+  
+  js_value_t *options = argc == 3 ? argv[1] : NULL;
+  
+  int lane = parse_priority_option(env, options, op == BARE_DELTA_OP_CREATE_MANY
+    ? BARE_DELTA_LANE_BACKGROUND
+    : BARE_DELTA_LANE_INTERACTIVE);
+  
+  if (!bare_delta_pool_accepting(pool, lane)) {
+    js_throw_error(env, "QUEUE_FULL", "Worker queue is full");
+    return NULL;
+  }
+  
+  js_value_t *holder;
+  bare_delta_pairs_t *pairs = extract_pairs(env, argv[0], op == BARE_DELTA_OP_CREATE_MANY ? "target" : "delta", &holder);
+  if (pairs == NULL) return NULL;
+  
+  // Allocate request
+  bare_delta_request_t *request = (bare_delta_request_t *)malloc(sizeof(bare_delta_request_t));
+  memset(request, 0, sizeof(bare_delta_request_t));
+  
+  request->env = env;
+  request->lane = lane;
+  request->op = op;
+  request->pairs = pairs;
+  
+  if (op == BARE_DELTA_OP_CREATE_MANY) {
+    parse_create_options(env, options, &request->nhash, &request->search_limit, &request->compressed);
+  }
+  
+  // One reference keeps every source and input buffer alive
+  err = js_create_reference(env, holder, 1, &request->pairs_ref);
+  assert(err == 0);
+  
+  err = js_create_reference(env, argv[argc - 1], 1, &request->callback);
+  assert(err == 0);
+  
+  err = js_create_reference(env, ctx, 1, &request->ctx);
+  assert(err == 0);
+  
+  // Start teardown tracking
+  err = js_add_deferred_teardown_callback(env, NULL, NULL, &request->teardown);
+  assert(err == 0);
+  
+  // Queue work on the worker pool
+  bare_delta_pool_submit(pool, request);
+  
+  // Return a handle that can be passed to cancel() until the callback runs
+  js_value_t *handle;
+  err = js_create_external(env, request, NULL, NULL, &handle);
+  assert(err == 0);
+  
+  return handle;
+}
+
+// Asynchronous createMany binding
+static js_value_t *
+bare_delta_create_many_async(js_env_t *env, js_callback_info_t *info) {
+  return bare_delta_many_async(env, info, BARE_DELTA_OP_CREATE_MANY);
+}
+
+// Asynchronous applyMany binding
+static js_value_t *
+bare_delta_apply_many_async(js_env_t *env, js_callback_info_t *info) {
+  return bare_delta_many_async(env, info, BARE_DELTA_OP_APPLY_MANY);
+}
+
+// Options packed by compileOptions() into a single integer so the fast paths
+// never look up properties: the compression mode in bits 0-1, log2 of the
+// hash window size in bits 2-6 and the search depth in bits 7-31
+#define BARE_DELTA_COMPILED_SEARCH_LIMIT_MAX 0x1ffffff
+
+static uint32_t
+bare_delta_pack_options(int nhash, int search_limit, int compressed) {
+  uint32_t log2_nhash = 0;
+  while ((1 << log2_nhash) < nhash && log2_nhash < 31) log2_nhash++;
+  
+  if (search_limit > BARE_DELTA_COMPILED_SEARCH_LIMIT_MAX) {
+    search_limit = BARE_DELTA_COMPILED_SEARCH_LIMIT_MAX;
+  }
+  
+  return (uint32_t)compressed | (log2_nhash << 2) | ((uint32_t)search_limit << 7);
+}
+
+static void
+bare_delta_unpack_options(uint32_t compiled, int *nhash, int *search_limit, int *compressed) {
+  *compressed = compiled & 0x3;
+  *nhash = 1 << ((compiled >> 2) & 0x1f);
+  *search_limit = compiled >> 7;
+}
+
+// Create a delta straight into a caller-provided buffer. Uncompressed deltas
+// are written in place when the buffer has room for the worst case, anything
+// else goes through the core logic and is copied over.
+static int32_t
+bare_delta_create_into(const void *source, size_t source_len, const void *target, size_t target_len,
+                       char *out, size_t out_len, uint32_t compiled) {
+  int nhash, search_limit, compressed;
+  bare_delta_unpack_options(compiled, &nhash, &search_limit, &compressed);
+  
+  if (target_len > INT32_MAX - BARE_DELTA_CREATE_OVERHEAD) return -3;
+  
+  if (compressed == BARE_DELTA_COMPRESSION_NONE && out_len >= target_len + BARE_DELTA_CREATE_OVERHEAD) {
+    int len = delta_create_with_options(
+      (const char *)source, source_len,
+      (const char *)target, target_len,
+      out, nhash, search_limit, NULL
+    );
+    
+    return len < 0 ? -2 : len;
+  }
+  
+  char *result;
+  size_t result_len;
+  int err = delta_create_core(source, source_len, target, target_len,
+                              nhash, search_limit, compressed, NULL, NULL, &result, &result_len);
+  if (err != 0) return err;
+  
+  if (result_len > out_len) {
+    free(result);
+    return BARE_DELTA_OUT_OF_RANGE;
+  }
+  
+  memcpy(out, result, result_len);
+  free(result);
+  
+  return (int32_t)result_len;
+}
+
+// Apply a delta straight into a caller-provided buffer. The engine writes a
+// terminator past the end of the output, so uncompressed deltas are applied in
+// place only when the buffer has a spare byte.
+static int32_t
+bare_delta_apply_into(const void *source, size_t source_len, const void *delta, size_t delta_len,
+                      char *out, size_t out_len) {
+  if (bare_delta_detect_compression(delta, delta_len) == BARE_DELTA_COMPRESSION_NONE) {
+    int output_size = delta_output_size(delta, delta_len);
+    if (output_size < 0) return -4;
+    
+    if ((size_t)output_size > out_len) return BARE_DELTA_OUT_OF_RANGE;
+    
+    if ((size_t)output_size < out_len) {
+      int len = delta_apply(source, source_len, delta, delta_len, out);
+      return len < 0 ? -6 : len;
+    }
+  }
+  
+  char *result;
+  size_t result_len;
+  int err = delta_apply_core(source, source_len, delta, delta_len, 0, NULL, NULL, &result, &result_len);
+  if (err != 0) return err;
+  
+  if (result_len > out_len || result_len > INT32_MAX) {
+    free(result);
+    return BARE_DELTA_OUT_OF_RANGE;
+  }
+  
+  memcpy(out, result, result_len);
+  free(result);
+  
+  return (int32_t)result_len;
+}
+
+
+// estimate binding: estimate(sourceLength, targetLength[, options]) returns
+// the peak memory create allocates and the largest delta it can return,
+// following the allocations of delta_create_core()
+static js_value_t *
+bare_delta_estimate(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  size_t argc = 3;
+  js_value_t *argv[3];
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+  
+  double source_length, target_length;
+  if (argc < 2 ||
+      js_get_value_double(env, argv[0], &source_length) != 0 ||
+      js_get_value_double(env, argv[1], &target_length) != 0) {
+    js_throw_type_error(env, NULL, "estimate requires a source and target length");
+    return NULL;
+  }
+  
+  int nhash, search_limit, compressed;
+  parse_create_options(env, argc > 2 ? argv[2] : NULL, &nhash, &search_limit, &compressed);
+  
+  // The hash table is returned before compression starts, so the delta
+  // buffer overlaps with one or the other
+  uint64_t index_bytes = delta_index_size((size_t)source_length, nhash) * sizeof(int);
+  uint64_t delta_max = (uint64_t)target_length + BARE_DELTA_CREATE_OVERHEAD;
+  uint64_t compress_bound = bare_delta_compress_bound(compressed, delta_max);
+  uint64_t peak = delta_max + (index_bytes > compress_bound ? index_bytes : compress_bound);
+  
+  js_value_t *result;
+  err = js_create_object(env, &result);
+  assert(err == 0);
+  
+  bare_delta_set_double(env, result, "peakMemory", (double)peak);
+  bare_delta_set_double(env, result, "maxDeltaLength", (double)(compress_bound > delta_max ? compress_bound : delta_max));
+  
+  return result;
+}
+
+// estimateApply binding: estimateApply(delta) returns the peak memory apply
+// allocates for the delta and the sizes decoded from its header
+static js_value_t *
+bare_delta_estimate_apply(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  size_t argc = 1;
+  js_value_t *argv[1];
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+  
+  if (argc < 1) {
+    js_throw_error(env, NULL, "estimateApply requires a delta");
+    return NULL;
+  }
+  
+  void *delta;
+  size_t delta_len;
+  if (extract_buffer(env, argv[0], &delta, &delta_len, "delta") != 0) {
+    return NULL;
+  }
+  
+  int compression = bare_delta_detect_compression(delta, delta_len);
+  size_t decompressed_len = 0;
+  int output_size = 0;
+  
+  // Compressed deltas record their decompressed size in the frame header
+  if (compression == BARE_DELTA_COMPRESSION_LZ4) {
+    LZ4F_dctx *dctx;
+    if (LZ4F_isError(LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION))) {
+      output_size = -2;
+    } else {
+      size_t header_len;
+      output_size = bare_delta_lz4_content_size(dctx, delta, delta_len, &decompressed_len, &header_len);
+      LZ4F_freeDecompressionContext(dctx);
+    }
+  } else if (compression == BARE_DELTA_COMPRESSION_ZSTD) {
+    unsigned long long size = ZSTD_getFrameContentSize(delta, delta_len);
+    if (size == ZSTD_CONTENTSIZE_ERROR || size == ZSTD_CONTENTSIZE_UNKNOWN) output_size = -1;
+    else decompressed_len = (size_t)size;
+  }
+  
+  if (output_size == 0) {
+    if (compression == BARE_DELTA_COMPRESSION_NONE) {
+      output_size = delta_output_size(delta, delta_len);
+      if (output_size < 0) output_size = -4; // Invalid delta format
+    } else {
+      output_size = bare_delta_peek_output_size(compression, delta, delta_len);
+    }
+  }
+  
+  if (output_size < 0) {
+    js_throw_error(env, bare_delta_error_names[bare_delta_error_class(BARE_DELTA_OP_APPLY, output_size)], "Failed to read delta header");
+    return NULL;
+  }
+  
+  // The decompressed delta stays alive while the target is written
+  js_value_t *result;
+  err = js_create_object(env, &result);
+  assert(err == 0);
+  
+  bare_delta_set_double(env, result, "peakMemory", (double)decompressed_len + output_size + 1);
+  bare_delta_set_double(env, result, "targetLength", output_size);
+  bare_delta_set_double(env, result, "deltaLength", (double)(compression == BARE_DELTA_COMPRESSION_NONE ? delta_len : decompressed_len));
+  js_value_t *compressed;
+  err = js_get_boolean(env, compression != BARE_DELTA_COMPRESSION_NONE, &compressed);
+  assert(err == 0);
+  err = js_set_named_property(env, result, "compressed", compressed);
+  assert(err == 0);
+  
+  return result;
+}
+
+// compileOptions binding - packs creation options for createInto()
+static js_value_t *
+bare_delta_compile_options(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  size_t argc = 1;
+  js_value_t *argv[1];
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+  
+  int nhash, search_limit, compressed;
+  parse_create_options(env, argc > 0 ? argv[0] : NULL, &nhash, &search_limit, &compressed);
+  
+  js_value_t *result;
+  err = js_create_uint32(env, bare_delta_pack_options(nhash, search_limit, compressed), &result);
+  assert(err == 0);
+  
+  return result;
+}
+
+// Untyped createInto binding, used when the engine cannot take the fast path.
+// Arguments are validated in JavaScript; failures are returned as negative
+// lengths because typed calls cannot throw.
+static js_value_t *
+bare_delta_create_into_untyped(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  size_t argc = 4;
+  js_value_t *argv[4];
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+  
+  void *source, *target, *out;
+  size_t source_len, target_len, out_len;
+  
+  if (extract_buffer(env, argv[0], &source, &source_len, "source") != 0 ||
+      extract_buffer(env, argv[1], &target, &target_len, "target") != 0 ||
+      extract_buffer(env, argv[2], &out, &out_len, "out") != 0) {
+    return NULL;
+  }
+  
+  uint32_t compiled;
+  err = js_get_value_uint32(env, argv[3], &compiled);
+  assert(err == 0);
+  
+  js_value_t *result;
+  err = js_create_int32(env, bare_delta_create_into(source, source_len, target, target_len, out, out_len, compiled), &result);
+  assert(err == 0);
+  
+  return result;
+}
+
+// Typed createInto binding
+static int32_t
+bare_delta_create_into_typed(js_value_t *receiver, js_value_t *source, js_value_t *target, js_value_t *out, uint32_t compiled, js_typed_callback_info_t *info) {
+  int err;
+  js_env_t *env;
+  err = js_get_typed_callback_info(info, &env, NULL);
+  assert(err == 0);
+  
+  void *source_data, *target_data, *out_data;
+  size_t source_len, target_len, out_len;
+  js_typedarray_view_t *source_view, *target_view, *out_view;
+  
+  err = js_get_typedarray_view(env, source, NULL, &source_data, &source_len, &source_view);
+  assert(err == 0);
+  err = js_get_typedarray_view(env, target, NULL, &target_data, &target_len, &target_view);
+  assert(err == 0);
+  err = js_get_typedarray_view(env, out, NULL, &out_data, &out_len, &out_view);
+  assert(err == 0);
+  
+  int32_t result = bare_delta_create_into(source_data, source_len, target_data, target_len, out_data, out_len, compiled);
+  
+  err = js_release_typedarray_view(env, out_view);
+  assert(err == 0);
+  err = js_release_typedarray_view(env, target_view);
+  assert(err == 0);
+  err = js_release_typedarray_view(env, source_view);
+  assert(err == 0);
+  
+  return result;
+}
+
+// Untyped applyInto binding
+static js_value_t *
+bare_delta_apply_into_untyped(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  size_t argc = 3;
+  js_value_t *argv[3];
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+  
+  void *source, *delta, *out;
+  size_t source_len, delta_len, out_len;
+  
+  if (extract_buffer(env, argv[0], &source, &source_len, "source") != 0 ||
+      extract_buffer(env, argv[1], &delta, &delta_len, "delta") != 0 ||
+      extract_buffer(env, argv[2], &out, &out_len, "out") != 0) {
+    return NULL;
+  }
+  
+  js_value_t *result;
+  err = js_create_int32(env, bare_delta_apply_into(source, source_len, delta, delta_len, out, out_len), &result);
+  assert(err == 0);
+  
+  return result;
+}
+
+// Typed applyInto binding
+static int32_t
+bare_delta_apply_into_typed(js_value_t *receiver, js_value_t *source, js_value_t *delta, js_value_t *out, js_typed_callback_info_t *info) {
+  int err;
+  js_env_t *env;
+  err = js_get_typed_callback_info(info, &env, NULL);
+  assert(err == 0);
+  
+  void *source_data, *delta_data, *out_data;
+  size_t source_len, delta_len, out_len;
+  js_typedarray_view_t *source_view, *delta_view, *out_view;
+  
+  err = js_get_typedarray_view(env, source, NULL, &source_data, &source_len, &source_view);
+  assert(err == 0);
+  err = js_get_typedarray_view(env, delta, NULL, &delta_data, &delta_len, &delta_view);
+  assert(err == 0);
+  err = js_get_typedarray_view(env, out, NULL, &out_data, &out_len, &out_view);
+  assert(err == 0);
+  
+  int32_t result = bare_delta_apply_into(source_data, source_len, delta_data, delta_len, out_data, out_len);
+  
+  err = js_release_typedarray_view(env, out_view);
+  assert(err == 0);
+  err = js_release_typedarray_view(env, delta_view);
+  assert(err == 0);
+  err = js_release_typedarray_view(env, source_view);
+  assert(err == 0);
+  
+  return result;
+}
+
+// Release an Encoder or Decoder once its JavaScript handle is collected
+static void
+bare_delta_codec_finalize(js_env_t *env, void *data, void *finalize_hint) {
+  bare_delta_codec_t *codec = (bare_delta_codec_t *)data;
+  
+  free(codec->index);
+  free(codec->scratch);
+  free(codec->packed);
+  
+  if (codec->zstd_cctx) ZSTD_freeCCtx(codec->zstd_cctx);
+  if (codec->zstd_dctx) ZSTD_freeDCtx(codec->zstd_dctx);
+  if (codec->lz4_cctx) LZ4F_freeCompressionContext(codec->lz4_cctx);
+  if (codec->lz4_dctx) LZ4F_freeDecompressionContext(codec->lz4_dctx);
+  
+  free(codec);
+}
+
+// Create the native state behind an Encoder or Decoder. Encoders parse their
+// creation options once here.
+static js_value_t *
+bare_delta_codec_init(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  size_t argc = 1;
+  js_value_t *argv[1];
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+  
+  bare_delta_codec_t *codec = (bare_delta_codec_t *)malloc(sizeof(bare_delta_codec_t));
+  if (codec == NULL) {
+    js_throw_error(env, NULL, "Failed to allocate codec");
+    return NULL;
+  }
+  
+  memset(codec, 0, sizeof(bare_delta_codec_t));
+  
+  parse_create_options(env, argc > 0 ? argv[0] : NULL, &codec->nhash, &codec->search_limit, &codec->compressed);
+  
+  js_value_t *handle;
+  err = js_create_external(env, codec, bare_delta_codec_finalize, NULL, &handle);
+  assert(err == 0);
+  
+  return handle;
+}
+
+// Fetch the native state behind an Encoder or Decoder handle for a sync call,
+// which must not overlap async calls still using its scratch memory
+static bare_delta_codec_t *
+bare_delta_codec_get_idle(js_env_t *env, js_value_t *handle) {
+  bare_delta_codec_t *codec;
+  if (js_get_value_external(env, handle, (void **)&codec) != 0) return NULL;
+  
+  if (codec->busy) {
+    js_throw_error(env, "BUSY", "Cannot run a sync call while async calls are in flight");
+    return NULL;
+  }
+  
+  return codec;
+}
+
+// Encoder#createSync binding
+static js_value_t *
+bare_delta_encoder_create_sync(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  size_t argc = 3;
+  js_value_t *argv[3];
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+  
+  if (argc < 3) {
+    js_throw_error(env, NULL, "encoder.createSync requires 2 arguments (source, target)");
+    return NULL;
+  }
+  
+  bare_delta_codec_t *codec = bare_delta_codec_get_idle(env, argv[0]);
+  if (codec == NULL) return NULL;
+  
+  void *source, *target;
   size_t source_len, target_len;
-  void *source_data, *target_data;
   
-  if (extract_buffer(env, argv[0], &source_data, &source_len, "source") != 0 ||
-      extract_buffer(env, argv[1], &target_data, &target_len, "target") != 0) {
+  if (extract_buffer(env, argv[1], &source, &source_len, "source") != 0 ||
+      extract_buffer(env, argv[2], &target, &target_len, "target") != 0) {
+    return NULL;
+  }
+  
+  const char *delta;
+  size_t delta_len;
+  if (bare_delta_encoder_encode(codec, source, source_len, target, target_len, NULL, &delta, &delta_len) != 0) {
+    js_throw_error(env, NULL, "Failed to create delta");
+    return NULL;
+  }
+  
+  // Copy out of the encoder's scratch into an ArrayBuffer JavaScript owns
+  void *data;
+  js_value_t *arraybuffer;
+  err = js_create_arraybuffer(env, delta_len, &data, &arraybuffer);
+  assert(err == 0);
+  
+  memcpy(data, delta, delta_len);
+  
+  js_value_t *result;
+  err = js_create_typedarray(env, js_uint8array, delta_len, arraybuffer, 0, &result);
+  assert(err == 0);
+  
+  return result;
+}
+
+// Encoder#createInto binding, returning the written length or a negative error
+static js_value_t *
+bare_delta_encoder_create_into(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  size_t argc = 4;
+  js_value_t *argv[4];
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+  
+  if (argc < 4) {
+    js_throw_error(env, NULL, "encoder.createInto requires 3 arguments (source, target, out)");
+    return NULL;
+  }
+  
+  bare_delta_codec_t *codec = bare_delta_codec_get_idle(env, argv[0]);
+  if (codec == NULL) return NULL;
+  
+  void *source, *target, *out;
+  size_t source_len, target_len, out_len;
+  
+  if (extract_buffer(env, argv[1], &source, &source_len, "source") != 0 ||
+      extract_buffer(env, argv[2], &target, &target_len, "target") != 0 ||
+      extract_buffer(env, argv[3], &out, &out_len, "out") != 0) {
+    return NULL;
+  }
+  
+  const char *delta;
+  size_t delta_len;
+  int32_t len = bare_delta_encoder_encode(codec, source, source_len, target, target_len, NULL, &delta, &delta_len);
+  
+  if (len == 0) {
+    if (delta_len > out_len || delta_len > INT32_MAX) {
+      len = BARE_DELTA_OUT_OF_RANGE;
+    } else {
+      memcpy(out, delta, delta_len);
+      len = (int32_t)delta_len;
+    }
+  }
+  
+  js_value_t *result;
+  err = js_create_int32(env, len, &result);
+  assert(err == 0);
+  
+  return result;
+}
+
+// Decoder#applySync binding
+static js_value_t *
+bare_delta_decoder_apply_sync(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  size_t argc = 3;
+  js_value_t *argv[3];
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+  
+  if (argc < 3) {
+    js_throw_error(env, NULL, "decoder.applySync requires 2 arguments (source, delta)");
+    return NULL;
+  }
+  
+  bare_delta_codec_t *codec = bare_delta_codec_get_idle(env, argv[0]);
+  if (codec == NULL) return NULL;
+  
+  void *source, *delta;
+  size_t source_len, delta_len;
+  
+  if (extract_buffer(env, argv[1], &source, &source_len, "source") != 0 ||
+      extract_buffer(env, argv[2], &delta, &delta_len, "delta") != 0) {
+    return NULL;
+  }
+  
+  char *result_data;
+  size_t result_len;
+  if (bare_delta_decoder_decode(codec, source, source_len, delta, delta_len, NULL, NULL, 0, &result_data, &result_len) != 0) {
+    js_throw_error(env, NULL, "Failed to apply delta");
+    return NULL;
+  }
+  
+  // Hand the result buffer over to JavaScript without copying
+  js_value_t *result;
+  err = bare_delta_create_result(env, result_data, result_len, &result);
+  if (err != 0) return NULL;
+  
+  return result;
+}
+
+// Decoder#applyInto binding, returning the written length or a negative error
+static js_value_t *
+bare_delta_decoder_apply_into(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  size_t argc = 4;
+  js_value_t *argv[4];
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+  
+  if (argc < 4) {
+    js_throw_error(env, NULL, "decoder.applyInto requires 3 arguments (source, delta, out)");
     return NULL;
   }
   
-  // Parse options
-  int nhash, search_limit, compressed;
-  parse_create_options(env, argc > 2 ? argv[2] : NULL, &nhash, &search_limit, &compressed);
+  bare_delta_codec_t *codec = bare_delta_codec_get_idle(env, argv[0]);
+  if (codec == NULL) return NULL;
   
-  // Use core logic
-  char *result_data;
-  size_t result_len;
-  int result_code = delta_create_core(source_data, source_len, target_data, target_len,
-                                      nhash, search_limit, compressed, &result_data, &result_len);
+  void *source, *delta, *out;
+  size_t source_len, delta_len, out_len;
   
-  if (result_code != 0) {
-    js_throw_error(env, NULL, "Failed to create delta");
+  if (extract_buffer(env, argv[1], &source, &source_len, "source") != 0 ||
+      extract_buffer(env, argv[2], &delta, &delta_len, "delta") != 0 ||
+      extract_buffer(env, argv[3], &out, &out_len, "out") != 0) {
     return NULL;
   }
   
-  // Create JS result
-  js_value_t *arraybuffer;
-  void *js_data;
-  err = js_create_arraybuffer(env, result_len, &js_data, &arraybuffer);
-  assert(err == 0);
-  memcpy(js_data, result_data, result_len);
-  free(result_data);
+  size_t result_len;
+  int32_t len = bare_delta_decoder_decode(codec, source, source_len, delta, delta_len, NULL, out, out_len, NULL, &result_len);
+  if (len == 0) len = (int32_t)result_len;
   
   js_value_t *result;
-  err = js_create_typedarray(env, js_uint8array, result_len, arraybuffer, 0, &result);
+  err = js_create_int32(env, len, &result);
   assert(err == 0);
   
   return result;
 }
 
-// Synchronous delta_apply binding
+// Queue an Encoder#create or Decoder#apply call. Calls on the same object run
+// one after another, in the order they were issued.
 static js_value_t *
-bare_delta_apply_sync(js_env_t *env, js_callback_info_t *info) {
+bare_delta_codec_async(js_env_t *env, js_callback_info_t *info, int op) {
   int err;
-  size_t argc = 2;
-  js_value_t *argv[2];
+  size_t argc = 5;
+  js_value_t *argv[5];
+  js_value_t *ctx;
+  bare_delta_pool_t *pool;
+  err = js_get_callback_info(env, info, &argc, argv, &ctx, (void **)&pool);
+  assert(err == 0);
+  
+  if (argc < 5) {
+    js_throw_error(env, NULL, op == BARE_DELTA_OP_ENCODE
+      ? "encoder.create requires 5 arguments (handle, source, target, options, callback)"
+      : "decoder.apply requires 5 arguments (handle, source, delta, options, callback)");
+    return NULL;
+  }
+  
+  bare_delta_codec_t *codec;
+  err = js_get_value_external(env, argv[0], (void **)&codec);
+  if (err != 0) return NULL;
+  
+  int lane = parse_priority_option(env, argv[3], op == BARE_DELTA_OP_ENCODE
+    ? BARE_DELTA_LANE_BACKGROUND
+    : BARE_DELTA_LANE_INTERACTIVE);
+  
+  if (!bare_delta_pool_accepting(pool, lane)) {
+    js_throw_error(env, "QUEUE_FULL", "Worker queue is full");
+    return NULL;
+  }
+  
+  // Allocate request
+  bare_delta_request_t *request = (bare_delta_request_t *)malloc(sizeof(bare_delta_request_t));
+  memset(request, 0, sizeof(bare_delta_request_t));
+  
+  request->env = env;
+  request->lane = lane;
+  request->op = op;
+  request->codec = codec;
+  
+  // Extract buffers and create references (no copying)
+  if (extract_buffer_with_ref(env, argv[1], "source", &request->buf1, &request->len1, &request->source_ref) != 0 ||
+      extract_buffer_with_ref(env, argv[2], op == BARE_DELTA_OP_ENCODE ? "target" : "delta", &request->buf2, &request->len2, &request->target_ref) != 0) {
+    if (request->source_ref) js_delete_reference(env, request->source_ref);
+    free(request);
+    return NULL;
+  }
+  
+  err = js_create_reference(env, argv[0], 1, &request->codec_ref);
+  assert(err == 0);
+  
+  err = js_create_reference(env, argv[4], 1, &request->callback);
+  assert(err == 0);
+  
+  err = js_create_reference(env, ctx, 1, &request->ctx);
+  assert(err == 0);
+  
+  // Start teardown tracking
+  err = js_add_deferred_teardown_callback(env, NULL, NULL, &request->teardown);
+  assert(err == 0);
+  
+  bare_delta_codec_submit(pool, codec, request);
+  
+  // Return a handle that can be passed to cancel() until the callback runs
+  js_value_t *handle;
+  err = js_create_external(env, request, NULL, NULL, &handle);
+  assert(err == 0);
+  
+  return handle;
+}
+
+// Asynchronous Encoder#create binding
+static js_value_t *
+bare_delta_encoder_create_async(js_env_t *env, js_callback_info_t *info) {
+  return bare_delta_codec_async(env, info, BARE_DELTA_OP_ENCODE);
+}
+
+// Asynchronous Decoder#apply binding
+static js_value_t *
+bare_delta_decoder_apply_async(js_env_t *env, js_callback_info_t *info) {
+  return bare_delta_codec_async(env, info, BARE_DELTA_OP_DECODE);
+}
+
+static void
+bare_delta_create_stream_finalize(js_env_t *env, void *data, void *finalize_hint) {
+  delta_create_stream_free((delta_create_stream *)data);
+}
+
+// Open the native state behind createStream():
+// createStreamInit(source, length, options). The source is indexed once here
+// and must be passed unchanged to every write.
+static js_value_t *
+bare_delta_create_stream_init(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  size_t argc = 3;
+  js_value_t *argv[3];
   err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
   assert(err == 0);
   
   if (argc < 2) {
-    js_throw_error(env, NULL, "delta.applySync requires 2 arguments (source, delta)");
+    js_throw_error(env, NULL, "delta.createStreamInit requires at least 2 arguments (source, length[, options])");
     return NULL;
   }
   
-  // Extract buffers
-  size_t source_len, delta_len;
-  void *source_data, *delta_data;
+  size_t source_len;
+  void *source_data;
+  if (extract_buffer(env, argv[0], &source_data, &source_len, "source") != 0) return NULL;
   
-  if (extract_buffer(env, argv[0], &source_data, &source_len, "source") != 0 ||
-      extract_buffer(env, argv[1], &delta_data, &delta_len, "delta") != 0) {
+  uint32_t length;
+  err = js_get_value_uint32(env, argv[1], &length);
+  assert(err == 0);
+  
+  int nhash, search_limit, compressed;
+  parse_create_options(env, argc > 2 ? argv[2] : NULL, &nhash, &search_limit, &compressed);
+  
+  delta_create_stream *stream = delta_create_stream_new(source_data, source_len, length, nhash, search_limit);
+  if (stream == NULL) {
+    js_throw_error(env, NULL, "Failed to allocate stream");
     return NULL;
   }
   
-  // Use core logic (auto-detection handled internally)
-  char *result_data;
-  size_t result_len;
-  int result_code = delta_apply_core(source_data, source_len, delta_data, delta_len,
-                                     0, &result_data, &result_len);
+  js_value_t *handle;
+  err = js_create_external(env, stream, bare_delta_create_stream_finalize, NULL, &handle);
+  assert(err == 0);
   
-  if (result_code != 0) {
-    js_throw_error(env, NULL, "Failed to apply delta");
+  return handle;
+}
+
+// Encode the next piece of the target: createStreamWrite(handle, source,
+// chunk, final). Returns the delta bytes ready so far.
+static js_value_t *
+bare_delta_create_stream_write(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  size_t argc = 4;
+  js_value_t *argv[4];
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+  
+  if (argc < 4) {
+    js_throw_error(env, NULL, "delta.createStreamWrite requires 4 arguments (handle, source, chunk, final)");
     return NULL;
   }
   
-  // Create JS result
-  js_value_t *arraybuffer;
-  void *js_data;
-  err = js_create_arraybuffer(env, result_len, &js_data, &arraybuffer);
+  delta_create_stream *stream;
+  err = js_get_value_external(env, argv[0], (void **)&stream);
+  if (err != 0) return NULL;
+  
+  size_t source_len, chunk_len;
+  void *source_data, *chunk_data;
+  if (extract_buffer(env, argv[1], &source_data, &source_len, "source") != 0 ||
+      extract_buffer(env, argv[2], &chunk_data, &chunk_len, "chunk") != 0) {
+    return NULL;
+  }
+  
+  bool final;
+  err = js_get_value_bool(env, argv[3], &final);
   assert(err == 0);
-  memcpy(js_data, result_data, result_len);
-  free(result_data);
+  
+  char *data = malloc(delta_create_stream_bound(stream, chunk_len));
+  if (data == NULL) {
+    js_throw_error(env, NULL, "Failed to allocate memory for delta");
+    return NULL;
+  }
+  
+  int len = delta_create_stream_write(stream, source_data, chunk_data, chunk_len, final, data);
+  if (len < 0) {
+    free(data);
+    js_throw_error(env, NULL, "Failed to create delta");
+    return NULL;
+  }
   
   js_value_t *result;
-  err = js_create_typedarray(env, js_uint8array, result_len, arraybuffer, 0, &result);
-  assert(err == 0);
+  err = bare_delta_create_result(env, data, len, &result);
+  if (err != 0) return NULL;
   
   return result;
 }
 
-// Extract buffer and create reference (helper function)
-static int
-extract_buffer_with_ref(js_env_t *env, js_value_t *value, const char *name,
-                        void **data, size_t *len, js_ref_t **ref) {
-  if (extract_buffer(env, value, data, len, name) != 0) {
-    return -1;
-  }
+static void
+bare_delta_apply_stream_finalize(js_env_t *env, void *data, void *finalize_hint) {
+  delta_apply_stream_free((delta_apply_stream *)data);
+}
+
+// Open the native state behind applyStream()
+static js_value_t *
+bare_delta_apply_stream_init(js_env_t *env, js_callback_info_t *info) {
+  int err;
   
-  // Create a reference to keep the TypedArray alive
-  int err = js_create_reference(env, value, 1, ref);
-  if (err != 0) {
-    js_throw_error(env, NULL, "Failed to create buffer reference");
-    return -1;
+  delta_apply_stream *stream = delta_apply_stream_new();
+  if (stream == NULL) {
+    js_throw_error(env, NULL, "Failed to allocate stream");
+    return NULL;
   }
   
-  return 0;
+  js_value_t *handle;
+  err = js_create_external(env, stream, bare_delta_apply_stream_finalize, NULL, &handle);
+  assert(err == 0);
+  
+  return handle;
 }
 
-// Asynchronous delta_create binding
+// Decode delta bytes into out: applyStreamWrite(handle, source, chunk, out).
+// Returns [consumed, written]; the caller writes the rest of chunk once it has
+// drained out.
 static js_value_t *
-bare_delta_create_async(js_env_t *env, js_callback_info_t *info) {
+bare_delta_apply_stream_write(js_env_t *env, js_callback_info_t *info) {
   int err;
   size_t argc = 4;
   js_value_t *argv[4];
-  js_value_t *ctx;
-  err = js_get_callback_info(env, info, &argc, argv, &ctx, NULL);
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
   assert(err == 0);
   
-  if (argc < 3) {
-    js_throw_error(env, NULL, "delta.create requires at least 3 arguments (source, target, [options,] callback)");
+  if (argc < 4) {
+    js_throw_error(env, NULL, "delta.applyStreamWrite requires 4 arguments (handle, source, chunk, out)");
     return NULL;
   }
   
-  // Allocate request
-  bare_delta_request_t *request = (bare_delta_request_t *)malloc(sizeof(bare_delta_request_t));
-  memset(request, 0, sizeof(bare_delta_request_t));
-  
-  request->env = env;
-  request->is_apply = 0;
+  delta_apply_stream *stream;
+  err = js_get_value_external(env, argv[0], (void **)&stream);
+  if (err != 0) return NULL;
   
-  // Extract buffers and create references (no copying)
-  if (extract_buffer_with_ref(env, argv[0], "source", &request->buf1, &request->len1, &request->source_ref) != 0 ||
-      extract_buffer_with_ref(env, argv[1], "target", &request->buf2, &request->len2, &request->target_ref) != 0) {
-    if (request->source_ref) js_delete_reference(env, request->source_ref);
-    free(request);
+  size_t source_len, chunk_len, out_len;
+  void *source_data, *chunk_data, *out_data;
+  if (extract_buffer(env, argv[1], &source_data, &source_len, "source") != 0 ||
+      extract_buffer(env, argv[2], &chunk_data, &chunk_len, "chunk") != 0 ||
+      extract_buffer(env, argv[3], &out_data, &out_len, "out") != 0) {
     return NULL;
   }
   
-  // Parse options and store callback
-  js_value_t *callback;
-  if (argc == 4) {
-    parse_create_options(env, argv[2], &request->nhash, &request->search_limit, &request->compressed);
-    callback = argv[3];
-  } else {
-    parse_create_options(env, NULL, &request->nhash, &request->search_limit, &request->compressed);
-    callback = argv[2];
+  const char *next = chunk_data;
+  size_t remaining = chunk_len;
+  
+  int written = delta_apply_stream_write(stream, source_data, source_len, &next, &remaining, out_data, out_len);
+  if (written < 0) {
+    js_throw_error(env, NULL, "Failed to apply delta");
+    return NULL;
   }
   
-  // Store callback reference
-  err = js_create_reference(env, callback, 1, &request->callback);
+  js_value_t *result, *value;
+  err = js_create_array_with_length(env, 2, &result);
   assert(err == 0);
   
-  err = js_create_reference(env, ctx, 1, &request->ctx);
+  err = js_create_uint32(env, (uint32_t)(chunk_len - remaining), &value);
+  assert(err == 0);
+  err = js_set_element(env, result, 0, value);
   assert(err == 0);
   
-  // Start teardown tracking
-  err = js_add_deferred_teardown_callback(env, NULL, NULL, &request->teardown);
+  err = js_create_uint32(env, (uint32_t)written, &value);
+  assert(err == 0);
+  err = js_set_element(env, result, 1, value);
   assert(err == 0);
   
-  // Queue work
-  request->request.data = request;
-  uv_loop_t *loop;
-  err = js_get_env_loop(env, &loop);
+  return result;
+}
+
+// Whether the whole delta has been read: applyStreamDone(handle)
+static js_value_t *
+bare_delta_apply_stream_done(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  size_t argc = 1;
+  js_value_t *argv[1];
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
   assert(err == 0);
-  uv_queue_work(loop, &request->request, bare_delta_work, bare_delta_after_work);
   
-  return NULL;
+  delta_apply_stream *stream;
+  err = js_get_value_external(env, argv[0], (void **)&stream);
+  if (err != 0) return NULL;
+  
+  js_value_t *result;
+  err = js_get_boolean(env, delta_apply_stream_done(stream), &result);
+  assert(err == 0);
+  
+  return result;
+}
+
+// Phases of an incremental create or apply, in order. Each step advances the
+// current phase by up to its budget, so no phase runs in a single call.
+enum {
+  BARE_DELTA_JOB_INDEX,      // Indexing the source, budget in source bytes
+  BARE_DELTA_JOB_DECOMPRESS, // Decompressing the delta, budget in delta bytes produced
+  BARE_DELTA_JOB_RUN,        // Encoding the target or writing the output
+  BARE_DELTA_JOB_COMPRESS,   // Compressing the finished delta, budget in delta bytes read
+  BARE_DELTA_JOB_DONE,
+};
+
+// Native state of an incremental create or apply that runs on the JS thread
+// in slices. The caller's buffers are passed to every step, never kept.
+typedef struct {
+  int op;
+  int phase;
+  int compressed;
+  delta_create_stream *create;
+  delta_apply_stream *apply;
+  
+  // Lengths of the caller's source and of its target or delta, checked on
+  // every step
+  size_t source_len;
+  size_t input_len;
+  
+  // Decompressed copy of a compressed delta being applied, filled up to
+  // decompressed_pos of decompressed_len bytes
+  char *decompressed;
+  size_t decompressed_len;
+  size_t decompressed_pos;
+  
+  // Compressed delta being written by a create, and the bytes of the raw
+  // delta it holds so far
+  char *frame;
+  size_t frame_len;
+  size_t frame_cap;
+  size_t frame_pos;
+  
+  // Streaming contexts of the (de)compression phase
+  ZSTD_CCtx *zstd_cctx;
+  ZSTD_DCtx *zstd_dctx;
+  LZ4F_cctx *lz4_cctx;
+  LZ4F_dctx *lz4_dctx;
+  
+  // Bytes of target or delta consumed so far
+  size_t position;
+  
+  char *output;
+  size_t output_len;
+  size_t output_cap;
+} bare_delta_job_t;
+
+static void
+bare_delta_job_finalize(js_env_t *env, void *data, void *finalize_hint) {
+  bare_delta_job_t *job = (bare_delta_job_t *)data;
+  
+  if (job->create) delta_create_stream_free(job->create);
+  if (job->apply) delta_apply_stream_free(job->apply);
+  if (job->zstd_cctx) ZSTD_freeCCtx(job->zstd_cctx);
+  if (job->zstd_dctx) ZSTD_freeDCtx(job->zstd_dctx);
+  if (job->lz4_cctx) LZ4F_freeCompressionContext(job->lz4_cctx);
+  if (job->lz4_dctx) LZ4F_freeDecompressionContext(job->lz4_dctx);
+  free(job->decompressed);
+  free(job->frame);
+  free(job->output);
+  free(job);
 }
 
-// Asynchronous delta_apply binding
 static js_value_t *
-bare_delta_apply_async(js_env_t *env, js_callback_info_t *info) {
+bare_delta_job_create_handle(js_env_t *env, bare_delta_job_t *job) {
+  js_value_t *handle;
+  int err = js_create_external(env, job, bare_delta_job_finalize, NULL, &handle);
+  assert(err == 0);
+  
+  return handle;
+}
+
+// Start an incremental create: createIncrementalInit(source, target, options).
+// The source is indexed by the first steps, not here.
+static js_value_t *
+bare_delta_create_incremental_init(js_env_t *env, js_callback_info_t *info) {
   int err;
   size_t argc = 3;
   js_value_t *argv[3];
-  js_value_t *ctx;
-  err = js_get_callback_info(env, info, &argc, argv, &ctx, NULL);
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
   assert(err == 0);
   
-  if (argc < 3) {
-    js_throw_error(env, NULL, "delta.apply requires 3 arguments (source, delta, callback)");
+  if (argc < 2) {
+    js_throw_error(env, NULL, "delta.createIncrementalInit requires at least 2 arguments (source, target[, options])");
+    return NULL;
+  }
+  
+  size_t source_len, target_len;
+  void *source_data, *target_data;
+  if (extract_buffer(env, argv[0], &source_data, &source_len, "source") != 0 ||
+      extract_buffer(env, argv[1], &target_data, &target_len, "target") != 0) {
+    return NULL;
+  }
+  
+  int nhash, search_limit, compressed;
+  parse_create_options(env, argc > 2 ? argv[2] : NULL, &nhash, &search_limit, &compressed);
+  
+  bare_delta_job_t *job = (bare_delta_job_t *)calloc(1, sizeof(bare_delta_job_t));
+  if (job == NULL) goto err;
+  
+  job->op = BARE_DELTA_OP_CREATE;
+  job->phase = BARE_DELTA_JOB_INDEX;
+  job->compressed = compressed;
+  job->source_len = source_len;
+  job->input_len = target_len;
+  job->create = delta_create_stream_open(source_len, target_len, nhash, search_limit);
+  if (job->create == NULL) goto err;
+  
+  if (bare_delta_reserve(&job->output, &job->output_cap, target_len + BARE_DELTA_CREATE_OVERHEAD) != 0) goto err;
+  
+  return bare_delta_job_create_handle(env, job);
+  
+err:
+  if (job) bare_delta_job_finalize(env, job, NULL);
+  js_throw_error(env, NULL, "Failed to allocate memory for delta");
+  return NULL;
+}
+
+// Start an incremental apply: applyIncrementalInit(delta). A compressed delta
+// is decompressed by the first steps; only its frame header is read here.
+static js_value_t *
+bare_delta_apply_incremental_init(js_env_t *env, js_callback_info_t *info) {
+  int err;
+  size_t argc = 1;
+  js_value_t *argv[1];
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+  
+  if (argc < 1) {
+    js_throw_error(env, NULL, "delta.applyIncrementalInit requires 1 argument (delta)");
+    return NULL;
+  }
+  
+  size_t delta_len;
+  void *delta_data;
+  if (extract_buffer(env, argv[0], &delta_data, &delta_len, "delta") != 0) return NULL;
+  
+  bare_delta_job_t *job = (bare_delta_job_t *)calloc(1, sizeof(bare_delta_job_t));
+  if (job == NULL) {
+    js_throw_error(env, NULL, "Failed to allocate memory for delta");
     return NULL;
   }
   
-  // Allocate request
-  bare_delta_request_t *request = (bare_delta_request_t *)malloc(sizeof(bare_delta_request_t));
-  memset(request, 0, sizeof(bare_delta_request_t));
+  job->op = BARE_DELTA_OP_APPLY;
+  job->compressed = bare_delta_detect_compression(delta_data, delta_len);
+  job->input_len = delta_len;
+  
+  job->apply = delta_apply_stream_new();
+  if (job->apply == NULL) goto err;
+  
+  if (job->compressed == BARE_DELTA_COMPRESSION_NONE) {
+    int output_size = delta_output_size(delta_data, delta_len);
+    if (output_size < 0) goto err;
+    
+    if (bare_delta_reserve(&job->output, &job->output_cap, output_size) != 0) goto err;
+    
+    job->phase = BARE_DELTA_JOB_RUN;
+    return bare_delta_job_create_handle(env, job);
+  }
+  
+  size_t content_size;
+  
+  if (job->compressed == BARE_DELTA_COMPRESSION_LZ4) {
+    if (LZ4F_isError(LZ4F_createDecompressionContext(&job->lz4_dctx, LZ4F_VERSION))) {
+      job->lz4_dctx = NULL;
+      goto err;
+    }
+    
+    if (bare_delta_lz4_content_size(job->lz4_dctx, delta_data, delta_len, &content_size, &job->position) != 0) goto err;
+  } else {
+    unsigned long long size = ZSTD_getFrameContentSize(delta_data, delta_len);
+    if (size == ZSTD_CONTENTSIZE_ERROR || size == ZSTD_CONTENTSIZE_UNKNOWN || size > SIZE_MAX) goto err;
+    content_size = (size_t)size;
+    
+    job->zstd_dctx = ZSTD_createDCtx();
+    if (job->zstd_dctx == NULL) goto err;
+  }
+  
+  job->decompressed = (char *)malloc(content_size ? content_size : 1);
+  if (job->decompressed == NULL) goto err;
+  
+  job->decompressed_len = content_size;
+  job->phase = BARE_DELTA_JOB_DECOMPRESS;
+  
+  return bare_delta_job_create_handle(env, job);
+  
+err:
+  bare_delta_job_finalize(env, job, NULL);
+  js_throw_error(env, NULL, "Failed to apply delta");
+  return NULL;
+}
+
+// Index up to budget more bytes of the source of a create
+static void
+bare_delta_job_index_step(bare_delta_job_t *job, const char *source, size_t budget) {
+  if (delta_create_stream_index(job->create, source, budget)) {
+    job->phase = BARE_DELTA_JOB_RUN;
+  }
+}
+
+// Set up the compression of a finished raw delta, or skip it when none is
+// wanted. The frame header is written here; its body by the steps.
+static int
+bare_delta_job_compress_begin(bare_delta_job_t *job) {
+  if (job->compressed == BARE_DELTA_COMPRESSION_AUTO && !bare_delta_should_compress(job->output, job->output_len)) {
+    job->compressed = BARE_DELTA_COMPRESSION_NONE;
+  }
+  
+  if (job->compressed == BARE_DELTA_COMPRESSION_NONE) {
+    job->phase = BARE_DELTA_JOB_DONE;
+    return 0;
+  }
   
-  request->env = env;
-  request->is_apply = 1;
-  request->compressed = 0; // Auto-detection in core
+  size_t bound = bare_delta_compress_bound(job->compressed, job->output_len);
+  if (bare_delta_reserve(&job->frame, &job->frame_cap, bound) != 0) return -4;
   
-  // Extract buffers and create references (no copying)
-  if (extract_buffer_with_ref(env, argv[0], "source", &request->buf1, &request->len1, &request->source_ref) != 0 ||
-      extract_buffer_with_ref(env, argv[1], "delta", &request->buf2, &request->len2, &request->target_ref) != 0) {
-    if (request->source_ref) js_delete_reference(env, request->source_ref);
-    free(request);
-    return NULL;
+  if (job->compressed == BARE_DELTA_COMPRESSION_LZ4) {
+    LZ4F_preferences_t prefs = LZ4F_INIT_PREFERENCES;
+    prefs.frameInfo.contentSize = job->output_len;
+    
+    if (LZ4F_isError(LZ4F_createCompressionContext(&job->lz4_cctx, LZ4F_VERSION))) {
+      job->lz4_cctx = NULL;
+      return -4; // Compression context allocation failed
+    }
+    
+    DELTA_PROBE1(lz4__compress__start, job->output_len);
+    size_t header = LZ4F_compressBegin(job->lz4_cctx, job->frame, job->frame_cap, &prefs);
+    if (LZ4F_isError(header)) return -5;
+    
+    job->frame_len = header;
+  } else {
+    job->zstd_cctx = ZSTD_createCCtx();
+    if (job->zstd_cctx == NULL) return -4; // Compression context allocation failed
+    
+    // The content size goes in the frame header so apply can size its buffer
+    if (ZSTD_isError(ZSTD_CCtx_setParameter(job->zstd_cctx, ZSTD_c_compressionLevel, 1)) ||
+        ZSTD_isError(ZSTD_CCtx_setPledgedSrcSize(job->zstd_cctx, job->output_len))) {
+      return -5;
+    }
+    
+    DELTA_PROBE1(zstd__compress__start, job->output_len);
   }
   
-  // Store callback
-  js_value_t *callback = argv[2];
+  job->phase = BARE_DELTA_JOB_COMPRESS;
+  return 0;
+}
+
+// Run one create slice over up to budget more bytes of target
+static int
+bare_delta_job_create_step(bare_delta_job_t *job, const char *source, const char *target, size_t budget) {
+  size_t len = job->input_len - job->position;
+  if (len > budget) len = budget;
   
-  // Store callback reference
-  err = js_create_reference(env, callback, 1, &request->callback);
-  assert(err == 0);
+  bool final = job->position + len == job->input_len;
   
-  err = js_create_reference(env, ctx, 1, &request->ctx);
-  assert(err == 0);
+  size_t needed = job->output_len + delta_create_stream_bound(job->create, len);
+  if (needed > job->output_cap && bare_delta_reserve(&job->output, &job->output_cap, needed + needed / 2) != 0) {
+    return -1;
+  }
   
-  // Start teardown tracking
-  err = js_add_deferred_teardown_callback(env, NULL, NULL, &request->teardown);
-  assert(err == 0);
+  int written = delta_create_stream_write(job->create, source, target + job->position, len, final, job->output + job->output_len);
+  if (written < 0) return -1;
   
-  // Queue work
-  request->request.data = request;
-  uv_loop_t *loop;
-  err = js_get_env_loop(env, &loop);
-  assert(err == 0);
-  uv_queue_work(loop, &request->request, bare_delta_work, bare_delta_after_work);
+  job->position += len;
+  job->output_len += written;
   
-  return NULL;
+  return final ? bare_delta_job_compress_begin(job) : 0;
 }
 
-// Synchronous batch delta_apply binding
-static js_value_t *
-bare_delta_apply_batch_sync(js_env_t *env, js_callback_info_t *info) {
-  int err;
-  size_t argc = 2;
-  js_value_t *argv[2];
-  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
-  assert(err == 0);
+// Compress up to budget more bytes of the finished raw delta
+static int
+bare_delta_job_compress_step(bare_delta_job_t *job, size_t budget) {
+  size_t len = job->output_len - job->frame_pos;
+  if (len > budget) len = budget;
   
-  if (argc < 2) {
-    js_throw_error(env, NULL, "delta.applyBatchSync requires 2 arguments (source, deltas)");
-    return NULL;
-  }
+  bool final = job->frame_pos + len == job->output_len;
   
-  // Extract source buffer
-  size_t source_len;
-  void *source_data;
-  if (extract_buffer(env, argv[0], &source_data, &source_len, "source") != 0) {
-    return NULL;
+  if (job->compressed == BARE_DELTA_COMPRESSION_LZ4) {
+    // Without autoFlush a slice may be held back, so room for the worst case
+    size_t needed = job->frame_len + LZ4F_compressBound(len, NULL) + (final ? LZ4F_compressBound(0, NULL) : 0);
+    if (bare_delta_reserve(&job->frame, &job->frame_cap, needed) != 0) return -4;
+    
+    size_t body = LZ4F_compressUpdate(job->lz4_cctx, job->frame + job->frame_len, job->frame_cap - job->frame_len,
+                                      job->output + job->frame_pos, len, NULL);
+    if (LZ4F_isError(body)) return -5;
+    job->frame_len += body;
+    
+    if (final) {
+      size_t end = LZ4F_compressEnd(job->lz4_cctx, job->frame + job->frame_len, job->frame_cap - job->frame_len, NULL);
+      if (LZ4F_isError(end)) return -5;
+      job->frame_len += end;
+      
+      DELTA_PROBE2(lz4__compress__done, job->output_len, job->frame_len);
+    }
+  } else {
+    ZSTD_inBuffer in = {job->output + job->frame_pos, len, 0};
+    ZSTD_EndDirective mode = final ? ZSTD_e_end : ZSTD_e_continue;
+    size_t remaining;
+    
+    do {
+      // Sized to the compress bound, the frame should never fill up
+      if (job->frame_len == job->frame_cap &&
+          bare_delta_reserve(&job->frame, &job->frame_cap, job->frame_cap * 2) != 0) {
+        return -4;
+      }
+      
+      ZSTD_outBuffer out = {job->frame, job->frame_cap, job->frame_len};
+      remaining = ZSTD_compressStream2(job->zstd_cctx, &out, &in, mode);
+      if (ZSTD_isError(remaining)) return -5;
+      
+      job->frame_len = out.pos;
+    } while (final ? remaining != 0 : in.pos < in.size);
+    
+    if (final) DELTA_PROBE2(zstd__compress__done, job->output_len, job->frame_len);
   }
   
-  // Get delta array
-  bool is_array;
-  err = js_is_array(env, argv[1], &is_array);
-  assert(err == 0);
+  job->frame_pos += len;
   
-  if (!is_array) {
-    js_throw_type_error(env, NULL, "deltas must be an array");
-    return NULL;
+  if (final) {
+    // In auto mode keep the raw delta unless compression paid off
+    if (job->compressed != BARE_DELTA_COMPRESSION_AUTO || bare_delta_compression_paid_off(job->frame_len, job->output_len)) {
+      free(job->output);
+      job->output = job->frame;
+      job->output_len = job->frame_len;
+      job->output_cap = job->frame_cap;
+      job->frame = NULL;
+    }
+    
+    job->phase = BARE_DELTA_JOB_DONE;
   }
   
-  uint32_t delta_count;
-  err = js_get_array_length(env, argv[1], &delta_count);
-  assert(err == 0);
-  
-  // Extract all deltas
-  void **deltas = malloc(sizeof(void *) * delta_count);
-  size_t *delta_lens = malloc(sizeof(size_t) * delta_count);
+  return 0;
+}
+
+// Decompress up to budget more bytes of a compressed delta being applied
+static int
+bare_delta_job_decompress_step(bare_delta_job_t *job, const char *delta, size_t budget) {
+  size_t room = job->decompressed_len - job->decompressed_pos;
+  if (room > budget) room = budget;
   
-  if (!deltas || !delta_lens) {
-    if (deltas) free(deltas);
-    if (delta_lens) free(delta_lens);
-    js_throw_error(env, NULL, "Failed to allocate memory for delta arrays");
-    return NULL;
-  }
+  char *dst = job->decompressed + job->decompressed_pos;
+  size_t filled = 0;
+  bool ended = false;
   
-  for (uint32_t i = 0; i < delta_count; i++) {
-    js_value_t *delta_val;
-    err = js_get_element(env, argv[1], i, &delta_val);
-    assert(err == 0);
+  // Once the content is complete, keep reading until the frame ends
+  for (;;) {
+    size_t dst_size = room - filled;
+    size_t src_size = job->input_len - job->position;
+    size_t ret;
     
-    if (extract_buffer(env, delta_val, &deltas[i], &delta_lens[i], "delta") != 0) {
-      free(deltas);
-      free(delta_lens);
-      return NULL;
+    if (job->compressed == BARE_DELTA_COMPRESSION_LZ4) {
+      ret = LZ4F_decompress(job->lz4_dctx, dst + filled, &dst_size, delta + job->position, &src_size, NULL);
+      if (LZ4F_isError(ret)) return -3;
+    } else {
+      ZSTD_outBuffer out = {dst + filled, dst_size, 0};
+      ZSTD_inBuffer in = {delta + job->position, src_size, 0};
+      ret = ZSTD_decompressStream(job->zstd_dctx, &out, &in);
+      if (ZSTD_isError(ret)) return -3;
+      dst_size = out.pos;
+      src_size = in.pos;
+    }
+    
+    filled += dst_size;
+    job->position += src_size;
+    
+    if (ret == 0) {
+      ended = true;
+      break;
     }
+    
+    if (dst_size == 0 && src_size == 0) return -3; // Truncated or corrupt
+    if (filled == room && job->decompressed_pos + filled < job->decompressed_len) break;
   }
   
-  // Use core batch logic (auto-detection handled internally)
-  char *result_data;
-  size_t result_len;
-  int result_code = delta_apply_batch_core(source_data, source_len, deltas, delta_lens, delta_count,
-                                           0, &result_data, &result_len);
+  job->decompressed_pos += filled;
   
-  free(deltas);
-  free(delta_lens);
+  if (!ended) return 0;
+  if (job->decompressed_pos != job->decompressed_len) return -3;
   
-  if (result_code != 0) {
-    js_throw_error(env, NULL, "Failed to apply batch deltas");
-    return NULL;
-  }
+  int output_size = delta_output_size(job->decompressed, job->decompressed_len);
+  if (output_size < 0) return -4; // Invalid delta format
   
-  // Create JS result
-  js_value_t *arraybuffer;
-  void *js_data;
-  err = js_create_arraybuffer(env, result_len, &js_data, &arraybuffer);
-  assert(err == 0);
-  memcpy(js_data, result_data, result_len);
-  free(result_data);
+  if (bare_delta_reserve(&job->output, &job->output_cap, output_size) != 0) return -5;
   
-  js_value_t *result;
-  err = js_create_typedarray(env, js_uint8array, result_len, arraybuffer, 0, &result);
-  assert(err == 0);
+  // The apply phase reads the decompressed delta from its start
+  job->position = 0;
+  job->phase = BARE_DELTA_JOB_RUN;
+  return 0;
+}
+
+// Run one apply slice writing up to budget more bytes of output
+static int
+bare_delta_job_apply_step(bare_delta_job_t *job, const char *source, size_t source_len, const char *delta, size_t budget) {
+  if (job->decompressed) delta = job->decompressed;
+  size_t delta_len = job->decompressed ? job->decompressed_len : job->input_len;
   
-  return result;
+  const char *next = delta + job->position;
+  size_t remaining = delta_len - job->position;
+  
+  size_t room = job->output_cap - job->output_len;
+  if (room > budget) room = budget;
+  
+  int written = delta_apply_stream_write(job->apply, source, source_len, &next, &remaining, job->output + job->output_len, room);
+  if (written < 0) return -1;
+  
+  size_t consumed = delta_len - remaining - job->position;
+  
+  job->position += consumed;
+  job->output_len += written;
+  
+  if (delta_apply_stream_done(job->apply)) {
+    job->phase = BARE_DELTA_JOB_DONE;
+    return 0;
+  }
+  
+  // A delta that ends early, or stops making progress, is malformed
+  if (remaining == 0 || (consumed == 0 && written == 0)) return -1;
+  
+  return 0;
 }
 
-// Asynchronous batch delta_apply binding
+// Advance an incremental create or apply by up to budget bytes of its current
+// phase: incrementalStep(handle, source, input, budget). Returns null until
+// the operation completes, then its result.
 static js_value_t *
-bare_delta_apply_batch_async(js_env_t *env, js_callback_info_t *info) {
+bare_delta_incremental_step(js_env_t *env, js_callback_info_t *info) {
   int err;
-  size_t argc = 3;
-  js_value_t *argv[3];
-  js_value_t *ctx;
-  err = js_get_callback_info(env, info, &argc, argv, &ctx, NULL);
+  size_t argc = 4;
+  js_value_t *argv[4];
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
   assert(err == 0);
   
-  if (argc < 3) {
-    js_throw_error(env, NULL, "delta.applyBatch requires 3 arguments (source, deltas, callback)");
+  if (argc < 4) {
+    js_throw_error(env, NULL, "delta.incrementalStep requires 4 arguments (handle, source, input, budget)");
     return NULL;
   }
   
-  // Get delta array
-  bool is_array;
-  err = js_is_array(env, argv[1], &is_array);
-  assert(err == 0);
+  bare_delta_job_t *job;
+  err = js_get_value_external(env, argv[0], (void **)&job);
+  if (err != 0) return NULL;
   
-  if (!is_array) {
-    js_throw_type_error(env, NULL, "deltas must be an array");
+  size_t source_len, input_len;
+  void *source_data, *input_data;
+  if (extract_buffer(env, argv[1], &source_data, &source_len, "source") != 0 ||
+      extract_buffer(env, argv[2], &input_data, &input_len, "input") != 0) {
     return NULL;
   }
   
-  uint32_t delta_count;
-  err = js_get_array_length(env, argv[1], &delta_count);
+  uint32_t budget;
+  err = js_get_value_uint32(env, argv[3], &budget);
   assert(err == 0);
   
-  // Allocate request
-  bare_delta_request_t *request = (bare_delta_request_t *)malloc(sizeof(bare_delta_request_t));
-  memset(request, 0, sizeof(bare_delta_request_t));
-  
-  request->env = env;
-  request->is_apply = 2; // Batch apply mode
-  request->batch_count = delta_count;
+  bool is_create = job->op == BARE_DELTA_OP_CREATE;
   
-  // Extract source buffer and create reference
-  if (extract_buffer_with_ref(env, argv[0], "source", &request->buf1, &request->len1, &request->source_ref) != 0) {
-    free(request);
+  if (job->phase == BARE_DELTA_JOB_DONE) {
+    js_throw_error(env, NULL, "Operation already completed");
     return NULL;
   }
   
-  // Allocate arrays for batch operation
-  request->batch_deltas = malloc(sizeof(void *) * delta_count);
-  request->batch_delta_lens = malloc(sizeof(size_t) * delta_count);
-  request->batch_refs = malloc(sizeof(js_ref_t *) * delta_count);
-  
-  if (!request->batch_deltas || !request->batch_delta_lens || !request->batch_refs) {
-    if (request->source_ref) js_delete_reference(env, request->source_ref);
-    if (request->batch_deltas) free(request->batch_deltas);
-    if (request->batch_delta_lens) free(request->batch_delta_lens);
-    if (request->batch_refs) free(request->batch_refs);
-    free(request);
-    js_throw_error(env, NULL, "Failed to allocate memory for batch arrays");
+  if (input_len != job->input_len) {
+    js_throw_type_error(env, NULL, is_create ? "target changed length" : "delta changed length");
     return NULL;
   }
   
-  memset(request->batch_refs, 0, sizeof(js_ref_t *) * delta_count);
+  if (is_create && source_len != job->source_len) {
+    js_throw_type_error(env, NULL, "source changed length");
+    return NULL;
+  }
   
-  // Extract all deltas and create references
-  for (uint32_t i = 0; i < delta_count; i++) {
-    js_value_t *delta_val;
-    err = js_get_element(env, argv[1], i, &delta_val);
-    assert(err == 0);
+  switch (job->phase) {
+  case BARE_DELTA_JOB_INDEX:
+    bare_delta_job_index_step(job, source_data, budget);
+    break;
     
-    if (extract_buffer_with_ref(env, delta_val, "delta", 
-                                &request->batch_deltas[i], &request->batch_delta_lens[i], 
-                                &request->batch_refs[i]) != 0) {
-      // Clean up on error
-      if (request->source_ref) js_delete_reference(env, request->source_ref);
-      for (uint32_t j = 0; j <= i; j++) {
-        if (request->batch_refs[j]) js_delete_reference(env, request->batch_refs[j]);
-      }
-      free(request->batch_deltas);
-      free(request->batch_delta_lens);
-      free(request->batch_refs);
-      free(request);
-      return NULL;
+  case BARE_DELTA_JOB_DECOMPRESS:
+    err = bare_delta_job_decompress_step(job, input_data, budget);
+    break;
+    
+  case BARE_DELTA_JOB_COMPRESS:
+    err = bare_delta_job_compress_step(job, budget);
+    break;
+    
+  default:
+    if (is_create) {
+      err = bare_delta_job_create_step(job, source_data, input_data, budget);
+    } else {
+      err = bare_delta_job_apply_step(job, source_data, source_len, input_data, budget);
     }
+    break;
   }
   
-  // Store callback (no options needed for apply operations)
-  js_value_t *callback = argv[2];
-  request->compressed = 0; // Auto-detection in core
+  if (err != 0) {
+    js_throw_error(env, NULL, is_create ? "Failed to create delta" : "Failed to apply delta");
+    return NULL;
+  }
   
-  // Store callback reference
-  err = js_create_reference(env, callback, 1, &request->callback);
-  assert(err == 0);
+  js_value_t *result;
   
-  err = js_create_reference(env, ctx, 1, &request->ctx);
-  assert(err == 0);
+  if (job->phase != BARE_DELTA_JOB_DONE) {
+    err = js_get_null(env, &result);
+    assert(err == 0);
+    
+    return result;
+  }
   
-  // Start teardown tracking
-  err = js_add_deferred_teardown_callback(env, NULL, NULL, &request->teardown);
-  assert(err == 0);
+  // Trim the worst-case allocation before it is handed to JavaScript
+  char *data = job->output;
+  size_t len = job->output_len;
+  job->output = NULL;
   
-  // Queue work
-  request->request.data = request;
-  uv_loop_t *loop;
-  err = js_get_env_loop(env, &loop);
-  assert(err == 0);
-  uv_queue_work(loop, &request->request, bare_delta_work, bare_delta_after_work);
+  char *trimmed = (char *)realloc(data, len ? len : 1);
+  if (trimmed != NULL) data = trimmed;
   
-  return NULL;
+  err = bare_delta_create_result(env, data, len, &result);
+  if (err != 0) return NULL;
+  
+  return result;
 }
 
-
 // Module initialization
 static js_value_t *
 init(js_env_t *env, js_value_t *exports) {
+  bare_delta_pool_t *pool = bare_delta_pool_init(env);
+  
   js_value_t *create_fn;
-  js_create_function(env, "create", -1, bare_delta_create_async, NULL, &create_fn);
+  js_create_function(env, "create", -1, bare_delta_create_async, pool, &create_fn);
   js_set_named_property(env, exports, "create", create_fn);
   
   js_value_t *apply_fn;
-  js_create_function(env, "apply", -1, bare_delta_apply_async, NULL, &apply_fn);
+  js_create_function(env, "apply", -1, bare_delta_apply_async, pool, &apply_fn);
   js_set_named_property(env, exports, "apply", apply_fn);
   
   js_value_t *create_sync_fn;
@@ -945,13 +4882,158 @@ init(js_env_t *env, js_value_t *exports) {
   js_set_named_property(env, exports, "applySync", apply_sync_fn);
   
   js_value_t *apply_batch_fn;
-  js_create_function(env, "applyBatch", -1, bare_delta_apply_batch_async, NULL, &apply_batch_fn);
+  js_create_function(env, "applyBatch", -1, bare_delta_apply_batch_async, pool, &apply_batch_fn);
   js_set_named_property(env, exports, "applyBatch", apply_batch_fn);
   
   js_value_t *apply_batch_sync_fn;
   js_create_function(env, "applyBatchSync", -1, bare_delta_apply_batch_sync, NULL, &apply_batch_sync_fn);
   js_set_named_property(env, exports, "applyBatchSync", apply_batch_sync_fn);
   
+  js_value_t *create_many_fn;
+  js_create_function(env, "createMany", -1, bare_delta_create_many_async, pool, &create_many_fn);
+  js_set_named_property(env, exports, "createMany", create_many_fn);
+  
+  js_value_t *apply_many_fn;
+  js_create_function(env, "applyMany", -1, bare_delta_apply_many_async, pool, &apply_many_fn);
+  js_set_named_property(env, exports, "applyMany", apply_many_fn);
+  
+  js_value_t *create_many_sync_fn;
+  js_create_function(env, "createManySync", -1, bare_delta_create_many_sync, NULL, &create_many_sync_fn);
+  js_set_named_property(env, exports, "createManySync", create_many_sync_fn);
+  
+  js_value_t *apply_many_sync_fn;
+  js_create_function(env, "applyManySync", -1, bare_delta_apply_many_sync, NULL, &apply_many_sync_fn);
+  js_set_named_property(env, exports, "applyManySync", apply_many_sync_fn);
+  
+  js_value_t *compile_options_fn;
+  js_create_function(env, "compileOptions", -1, bare_delta_compile_options, NULL, &compile_options_fn);
+  js_set_named_property(env, exports, "compileOptions", compile_options_fn);
+  
+  js_value_t *estimate_fn;
+  js_create_function(env, "estimate", -1, bare_delta_estimate, NULL, &estimate_fn);
+  js_set_named_property(env, exports, "estimate", estimate_fn);
+  
+  js_value_t *estimate_apply_fn;
+  js_create_function(env, "estimateApply", -1, bare_delta_estimate_apply, NULL, &estimate_apply_fn);
+  js_set_named_property(env, exports, "estimateApply", estimate_apply_fn);
+  
+  js_value_t *create_into_fn;
+  js_create_typed_function(
+    env, "createInto", -1, bare_delta_create_into_untyped,
+    &((js_callback_signature_t){
+      .version = 0,
+      .result = js_int32,
+      .args_len = 5,
+      .args = (int[]){
+        js_object,
+        js_object,
+        js_object,
+        js_object,
+        js_uint32,
+      },
+    }),
+    bare_delta_create_into_typed, NULL, &create_into_fn
+  );
+  js_set_named_property(env, exports, "createInto", create_into_fn);
+  
+  js_value_t *apply_into_fn;
+  js_create_typed_function(
+    env, "applyInto", -1, bare_delta_apply_into_untyped,
+    &((js_callback_signature_t){
+      .version = 0,
+      .result = js_int32,
+      .args_len = 4,
+      .args = (int[]){
+        js_object,
+        js_object,
+        js_object,
+        js_object,
+      },
+    }),
+    bare_delta_apply_into_typed, NULL, &apply_into_fn
+  );
+  js_set_named_property(env, exports, "applyInto", apply_into_fn);
+  
+  js_value_t *codec_init_fn;
+  js_create_function(env, "codecInit", -1, bare_delta_codec_init, NULL, &codec_init_fn);
+  js_set_named_property(env, exports, "codecInit", codec_init_fn);
+  
+  js_value_t *encoder_create_fn;
+  js_create_function(env, "encoderCreate", -1, bare_delta_encoder_create_async, pool, &encoder_create_fn);
+  js_set_named_property(env, exports, "encoderCreate", encoder_create_fn);
+  
+  js_value_t *encoder_create_sync_fn;
+  js_create_function(env, "encoderCreateSync", -1, bare_delta_encoder_create_sync, NULL, &encoder_create_sync_fn);
+  js_set_named_property(env, exports, "encoderCreateSync", encoder_create_sync_fn);
+  
+  js_value_t *encoder_create_into_fn;
+  js_create_function(env, "encoderCreateInto", -1, bare_delta_encoder_create_into, NULL, &encoder_create_into_fn);
+  js_set_named_property(env, exports, "encoderCreateInto", encoder_create_into_fn);
+  
+  js_value_t *decoder_apply_fn;
+  js_create_function(env, "decoderApply", -1, bare_delta_decoder_apply_async, pool, &decoder_apply_fn);
+  js_set_named_property(env, exports, "decoderApply", decoder_apply_fn);
+  
+  js_value_t *decoder_apply_sync_fn;
+  js_create_function(env, "decoderApplySync", -1, bare_delta_decoder_apply_sync, NULL, &decoder_apply_sync_fn);
+  js_set_named_property(env, exports, "decoderApplySync", decoder_apply_sync_fn);
+  
+  js_value_t *decoder_apply_into_fn;
+  js_create_function(env, "decoderApplyInto", -1, bare_delta_decoder_apply_into, NULL, &decoder_apply_into_fn);
+  js_set_named_property(env, exports, "decoderApplyInto", decoder_apply_into_fn);
+  
+  js_value_t *create_stream_init_fn;
+  js_create_function(env, "createStreamInit", -1, bare_delta_create_stream_init, NULL, &create_stream_init_fn);
+  js_set_named_property(env, exports, "createStreamInit", create_stream_init_fn);
+  
+  js_value_t *create_stream_write_fn;
+  js_create_function(env, "createStreamWrite", -1, bare_delta_create_stream_write, NULL, &create_stream_write_fn);
+  js_set_named_property(env, exports, "createStreamWrite", create_stream_write_fn);
+  
+  js_value_t *apply_stream_init_fn;
+  js_create_function(env, "applyStreamInit", -1, bare_delta_apply_stream_init, NULL, &apply_stream_init_fn);
+  js_set_named_property(env, exports, "applyStreamInit", apply_stream_init_fn);
+  
+  js_value_t *apply_stream_write_fn;
+  js_create_function(env, "applyStreamWrite", -1, bare_delta_apply_stream_write, NULL, &apply_stream_write_fn);
+  js_set_named_property(env, exports, "applyStreamWrite", apply_stream_write_fn);
+  
+  js_value_t *apply_stream_done_fn;
+  js_create_function(env, "applyStreamDone", -1, bare_delta_apply_stream_done, NULL, &apply_stream_done_fn);
+  js_set_named_property(env, exports, "applyStreamDone", apply_stream_done_fn);
+  
+  js_value_t *create_incremental_init_fn;
+  js_create_function(env, "createIncrementalInit", -1, bare_delta_create_incremental_init, NULL, &create_incremental_init_fn);
+  js_set_named_property(env, exports, "createIncrementalInit", create_incremental_init_fn);
+  
+  js_value_t *apply_incremental_init_fn;
+  js_create_function(env, "applyIncrementalInit", -1, bare_delta_apply_incremental_init, NULL, &apply_incremental_init_fn);
+  js_set_named_property(env, exports, "applyIncrementalInit", apply_incremental_init_fn);
+  
+  js_value_t *incremental_step_fn;
+  js_create_function(env, "incrementalStep", -1, bare_delta_incremental_step, NULL, &incremental_step_fn);
+  js_set_named_property(env, exports, "incrementalStep", incremental_step_fn);
+  
+  js_value_t *configure_fn;
+  js_create_function(env, "configure", -1, bare_delta_configure, pool, &configure_fn);
+  js_set_named_property(env, exports, "configure", configure_fn);
+  
+  js_value_t *configure_admission_fn;
+  js_create_function(env, "configureAdmission", -1, bare_delta_configure_admission, pool, &configure_admission_fn);
+  js_set_named_property(env, exports, "configureAdmission", configure_admission_fn);
+  
+  js_value_t *stats_fn;
+  js_create_function(env, "stats", -1, bare_delta_stats, pool, &stats_fn);
+  js_set_named_property(env, exports, "stats", stats_fn);
+  
+  js_value_t *metrics_fn;
+  js_create_function(env, "metrics", -1, bare_delta_metrics, NULL, &metrics_fn);
+  js_set_named_property(env, exports, "metrics", metrics_fn);
+  
+  js_value_t *cancel_fn;
+  js_create_function(env, "cancel", -1, bare_delta_cancel, pool, &cancel_fn);
+  js_set_named_property(env, exports, "cancel", cancel_fn);
+  
   return exports;
 }
 
@@ -35,34 +35,99 @@
 
 #include <simdle.h>
 
+#include <delta.h>
+
+#include "probes.h"
+
 /* Remove the INTERFACE macro - Fossil uses this for its build system */
 #define INTERFACE
 
+/*
+** Memory allocation hooks.  Embedders can route the engine's allocations
+** through their own allocator (mimalloc, jemalloc, ...) with
+** delta_set_allocator().  Install the hooks before the first delta is
+** created; they must not change while any operation is running.
+*/
+static delta_allocator deltaAllocator = { malloc, free };
+
+/*
+** Install pAllocator as the engine's allocator, or restore the C library
+** allocator when pAllocator is NULL.
+*/
+void delta_set_allocator(const delta_allocator *pAllocator){
+  if( pAllocator ){
+    deltaAllocator = *pAllocator;
+  }else{
+    deltaAllocator.xMalloc = malloc;
+    deltaAllocator.xFree = free;
+  }
+}
+
 /* Forward declare the memory functions */
 void* fossil_malloc(size_t size);
 void fossil_free(void* ptr);
 
 /* Implementation of fossil memory functions */
 void* fossil_malloc(size_t size) {
-  return malloc(size);
+  return deltaAllocator.xMalloc(size);
 }
 
 void fossil_free(void* ptr) {
   if (ptr) {
-    free(ptr);
+    deltaAllocator.xFree(ptr);
   }
 }
 
-/* Forward declaration for the configurable delta_create */
-int delta_create_with_options(
-  const char *zSrc,
-  size_t lenSrc,
-  const char *zOut,
-  size_t lenOut,
-  char *zDelta,
-  int nhash,
-  int searchLimit
-);
+/*
+** Hash tables of up to this many bytes are kept per thread and reused by
+** the next delta created on that thread, so a worker pool diffing many
+** small and medium files never returns to the allocator for them.  Larger
+** tables are allocated and released per delta.
+*/
+#define INDEX_CACHE_MAX (4*1024*1024)
+
+static __thread int *indexCache = 0;       /* Recycled hash table */
+static __thread size_t indexCacheLen = 0;  /* Integers in indexCache */
+
+/*
+** Borrow a hash table of at least n integers, from the thread's cache when
+** it fits.  Returns 0 on allocation failure.
+*/
+static int *index_borrow(size_t n){
+  if( n*sizeof(int)>INDEX_CACHE_MAX ){
+    return (int *)fossil_malloc(n*sizeof(int));
+  }
+  if( indexCache==0 || indexCacheLen<n ){
+    fossil_free(indexCache);
+    indexCacheLen = 0;
+    indexCache = (int *)fossil_malloc(n*sizeof(int));
+    if( indexCache==0 ) return 0;
+    indexCacheLen = n;
+  }
+  return indexCache;
+}
+
+/*
+** Return a hash table obtained from index_borrow().
+*/
+static void index_return(int *aIndex){
+  if( aIndex!=indexCache ) fossil_free(aIndex);
+}
+
+/*
+** Release the hash table cached by the calling thread.  Threads that
+** create deltas should call this before they exit.
+*/
+void delta_release_thread_cache(void){
+  fossil_free(indexCache);
+  indexCache = 0;
+  indexCacheLen = 0;
+}
+
+/*
+** Number of target positions scanned between checks of the cancel flag
+*/
+#define CANCEL_CHECK_INTERVAL 4096
 
 /*
 ** Macros for turning debugging printfs on and off
@@ -104,12 +169,12 @@ typedef unsigned short int u16;
 ** The default width of a hash window in bytes.  The algorithm only works if this
 ** is a power of 2.
 */
-#define NHASH_DEFAULT 16
+#define NHASH_DEFAULT DELTA_NHASH_DEFAULT
 
 /*
 ** Default search depth limit for hash collisions
 */
-#define SEARCH_LIMIT_DEFAULT 64
+#define SEARCH_LIMIT_DEFAULT DELTA_SEARCH_LIMIT_DEFAULT
 
 /*
 ** The current state of the rolling hash.
@@ -128,25 +193,32 @@ struct hash {
   u16 a, b;         /* Hash values */
   u16 i;            /* Start of the hash window */
   u16 nhash;        /* Hash window size */
-  char *z;          /* The values that have been hashed (allocated) */
+  char *z;          /* The values that have been hashed */
+  char zInline[64]; /* Storage for z[] when the window is small */
 };
 
+/*
+** Allocate the window of a rolling hash.  This happens once per delta;
+** hash_init() then reuses the window for every block.  Small windows live
+** inside the hash itself.  Returns 0 on allocation failure.
+*/
+static int hash_alloc(hash *pHash, int nhash){
+  pHash->nhash = nhash;
+  if( nhash<=(int)sizeof(pHash->zInline) ){
+    pHash->z = pHash->zInline;
+  }else{
+    pHash->z = (char *)fossil_malloc(nhash);
+  }
+  return pHash->z!=0;
+}
+
 /*
 ** Initialize the rolling hash using the first nhash characters of z[]
-** For small hash windows, use stack allocation to avoid malloc overhead
 */
 static void hash_init(hash *pHash, const char *z, int nhash){
   u16 a, b, i;
   pHash->nhash = nhash;
   
-  // Use stack buffer for small hash windows to avoid malloc overhead
-  if (nhash <= 32) {
-    static __thread char stack_buffer[64];  // Thread-local stack buffer
-    pHash->z = stack_buffer;
-  } else {
-    pHash->z = (char *)fossil_malloc(nhash);
-  }
-  
   a = b = z[0];
   for(i=1; i<nhash; i++){
     a += z[i];
@@ -159,14 +231,13 @@ static void hash_init(hash *pHash, const char *z, int nhash){
 }
 
 /*
-** Free the rolling hash - only free heap-allocated buffers
+** Free the window of a rolling hash allocated by hash_alloc()
 */
 static void hash_free(hash *pHash){
-  if(pHash->z && pHash->nhash > 32){
-    // Only free if we used heap allocation (nhash > 32)
+  if( pHash->z && pHash->z!=pHash->zInline ){
     fossil_free(pHash->z);
-    pHash->z = 0;
   }
+  pHash->z = 0;
 }
 
 /*
@@ -441,140 +512,110 @@ static unsigned int checksum(const char *zIn, size_t N){
 }
 
 /*
-** Create a new delta.
-**
-** The delta is written into a preallocated buffer, zDelta, which
-** should be at least 60 bytes longer than the target file, zOut.
-** The delta string will be NUL-terminated, but it might also contain
-** embedded NUL characters if either the zSrc or zOut files are
-** binary.  This function returns the length of the delta string
-** in bytes, excluding the final NUL terminator character.
-**
-** Output Format:
-**
-** The delta begins with a compact-encoded integer.  This
-** number is the number of bytes in the TARGET file.  Thus, given a
-** delta file z, a program can compute the size of the output file
-** simply by decoding the compact integer
-** found there.  The delta_output_size() routine does exactly this.
-**
-** After the initial size number, the delta consists of a series of
-** literal text segments and commands to copy from the SOURCE file.
-** A copy command looks like this:
-**
-**     NNN@MMM,
-**
-** where NNN is the number of bytes to be copied and MMM is the offset
-** into the source file of the first byte (both compact-encoded integers).   If NNN is 0
-** it means copy the rest of the input file.  Literal text is like this:
-**
-**     NNN:TTTTT
-**
-** where NNN is the number of bytes of text (compact-encoded) and TTTTT is the text.
-**
-** The last term is of the form
-**
-**     NNN;
-**
-** In this case, NNN is a 32-bit bigendian checksum of the output file
-** that can be used to verify that the delta applied correctly.  All
-** numbers are compact-encoded.
-**
-** Pure text files generate a pure text delta.  Binary files generate a
-** delta that may contain some binary data.
-**
-** Algorithm:
-**
-** The encoder first builds a hash table to help it find matching
-** patterns in the source file.  16-byte chunks of the source file
-** sampled at evenly spaced intervals are used to populate the hash
-** table.
-**
-** Next we begin scanning the target file using a sliding 16-byte
-** window.  The hash of the 16-byte window in the target is used to
-** search for a matching section in the source file.  When a match
-** is found, a copy command is added to the delta.  An effort is
-** made to extend the matching section to regions that come before
-** and after the 16-byte hash window.  A copy command is only issued
-** if the result would use less space that just quoting the text
-** literally. Literal text is added to the delta for sections that
-** do not match or which can not be encoded efficiently using copy
-** commands.
+** Continue a checksum() over N more bytes that begin at offset iPos of
+** the buffer being summed.  The input need not be aligned, so a buffer
+** can be summed piecewise as it arrives.
 */
-int delta_create(
-  const char *zSrc,      /* The source or pattern file */
-  size_t lenSrc,         /* Length of the source file */
-  const char *zOut,      /* The target file */
-  size_t lenOut,         /* Length of the target file */
-  char *zDelta           /* Write the delta into this buffer */
+static unsigned int checksum_update(
+  unsigned int sum,      /* Checksum of the first iPos bytes */
+  size_t iPos,           /* Offset of zIn[0] within the whole buffer */
+  const char *zIn,       /* Next bytes of the buffer */
+  size_t N               /* Number of bytes in zIn */
 ){
-  return delta_create_with_options(zSrc, lenSrc, zOut, lenOut, zDelta, 
-                                   NHASH_DEFAULT, SEARCH_LIMIT_DEFAULT);
+  const unsigned char *z = (const unsigned char *)zIn;
+  while( N>0 && (iPos&3)!=0 ){
+    sum += (unsigned)*(z++) << (24 - 8*(iPos&3));
+    iPos++;
+    N--;
+  }
+  while( N>=4 ){
+    sum += ((unsigned)z[0]<<24) | ((unsigned)z[1]<<16) | ((unsigned)z[2]<<8) | z[3];
+    z += 4;
+    N -= 4;
+  }
+  while( N>0 ){
+    sum += (unsigned)*(z++) << (24 - 8*(iPos&3));
+    iPos++;
+    N--;
+  }
+  return sum;
 }
 
-int delta_create_with_options(
+/*
+** Add the counters of q to p
+*/
+static void stats_add(delta_stats *p, const delta_stats *q){
+  p->nProbe += q->nProbe;
+  p->nChain += q->nChain;
+  p->nReject += q->nReject;
+  p->nForward += q->nForward;
+  p->nBackward += q->nBackward;
+  p->nCopy += q->nCopy;
+  p->nCopyBytes += q->nCopyBytes;
+  p->nInsert += q->nInsert;
+  p->nInsertBytes += q->nInsertBytes;
+}
+
+/*
+** Read the caller's clock for timing counters, or 0 without one
+*/
+static uint64_t stats_clock(const delta_stats *pStats){
+  return pStats && pStats->xClock ? pStats->xClock() : 0;
+}
+
+/*
+** Encode zOut[*pBase..lenOut) as copy and insert commands against the
+** source indexed by collide[] and landmark[], writing them to zDelta.
+** *pBase is advanced past the target bytes encoded.  When bFinal is zero
+** more target follows, so the scan stops short of the last hash window
+** and leaves those bytes for the next call.  Returns the end of the
+** commands written, or 0 if the scan was abandoned through *pCancel.
+*/
+static char *delta_scan(
   const char *zSrc,      /* The source or pattern file */
   size_t lenSrc,         /* Length of the source file */
   const char *zOut,      /* The target file */
-  size_t lenOut,         /* Length of the target file */
-  char *zDelta,          /* Write the delta into this buffer */
+  size_t lenOut,         /* Length of the target available */
+  char *zDelta,          /* Write commands into this buffer */
+  hash *pH,              /* Rolling hash with an allocated window */
   int nhash,             /* Hash window size (must be power of 2) */
-  int searchLimit        /* Search depth limit */
+  int searchLimit,       /* Search depth limit */
+  int *collide,          /* Collision chain */
+  int nHash,             /* Number of hash table entries */
+  int bFinal,            /* True if zOut ends the target */
+  const volatile int *pCancel, /* Abandon the scan when *pCancel is set */
+  delta_stats *pStats,   /* Add counters here if not NULL */
+  int *pBase             /* IN/OUT: First target byte not yet encoded */
 ){
-  int i, base;
-  char *zOrigDelta = zDelta;
-  hash h;
-  int nHash;                 /* Number of hash table entries */
-  int *landmark;             /* Primary hash table */
-  int *collide;              /* Collision chain */
+  int i;
+  int base = *pBase;
+  int *landmark = &collide[nHash];
   int lastRead = -1;         /* Last byte of zSrc read by a COPY command */
+  delta_stats st;            /* Counters for this call */
 
-  /* Add the target file size to the beginning of the delta
-  */
-  putInt(lenOut, &zDelta);
-
-  /* If the source file is very small, it means that we have no
-  ** chance of ever doing a copy command.  Just output a single
-  ** literal segment for the entire target and exit.
-  */
-  if( lenSrc<=nhash ){
-    putInt(lenOut, &zDelta);
-    *(zDelta++) = ':';
-    memcpy(zDelta, zOut, lenOut);
-    zDelta += lenOut;
-    putInt(checksum(zOut, lenOut), &zDelta);
-    *(zDelta++) = ';';
-    return zDelta - zOrigDelta;
-  }
-
-  /* Compute the hash table used to locate matching sections in the
-  ** source file.
-  */
-  nHash = lenSrc/nhash;
-  collide = fossil_malloc( nHash*2*sizeof(int) );
-  memset(collide, -1, nHash*2*sizeof(int));
-  landmark = &collide[nHash];
-  for(i=0; i<(int)lenSrc-nhash; i+=nhash){
-    int hv = hash_once(&zSrc[i], nhash) % nHash;
-    collide[i/nhash] = landmark[hv];
-    landmark[hv] = i/nhash;
-  }
+  memset(&st, 0, sizeof(st));
 
-  /* Begin scanning the target file and generating copy commands and
-  ** literal sections of the delta.
-  */
-  base = 0;    /* We have already generated everything before zOut[base] */
   while( base+nhash<(int)lenOut ){
     int iSrc, iBlock;
     unsigned int bestCnt, bestOfst=0, bestLitsz=0;
-    hash_init(&h, &zOut[base], nhash);
+    if( pCancel && *pCancel ){
+      zDelta = 0;
+      goto scan_done;
+    }
+    hash_init(pH, &zOut[base], nhash);
     i = 0;     /* Trying to match a landmark against zOut[base+i] */
     bestCnt = 0;
     while( 1 ){
       int hv;
       int limit = searchLimit;
 
-      hv = hash_32bit(&h) % nHash;
+      if( pCancel && (i % CANCEL_CHECK_INTERVAL)==CANCEL_CHECK_INTERVAL-1 && *pCancel ){
+        zDelta = 0;
+        goto scan_done;
+      }
+
+      hv = hash_32bit(pH) % nHash;
+      st.nProbe++;
       DEBUG2( printf("LOOKING: %4d [%s]\n", base+i, print16(&zOut[base+i])); )
       iBlock = landmark[hv];
       while( iBlock>=0 && (limit--)>0 ){
@@ -601,10 +642,12 @@ int delta_create_with_options(
         /* Get candidate source position from hash table */
         iSrc = iBlock*nhash;
         y = base+i;
+        st.nChain++;
         
         /* FIRST: Verify the hash window actually matches (eliminate hash collisions) */
         if (memcmp(&zSrc[iSrc], &zOut[y], nhash) != 0) {
           /* Hash collision - skip this block */
+          st.nReject++;
           iBlock = collide[iBlock];
           continue;
         }
@@ -620,6 +663,8 @@ int delta_create_with_options(
         /* THIRD: Extend backward from START of verified hash window */
         int max_backward = (iSrc < i) ? iSrc : i;
         k = (max_backward > 0) ? match_backward(&zSrc[iSrc], &zOut[y], max_backward) : 0;
+        st.nForward += j;
+        st.nBackward += k;
         
         /* FOURTH: Compute final match region (now guaranteed correct) */
         ofst = iSrc - k;
@@ -649,14 +694,20 @@ int delta_create_with_options(
       if( bestCnt>0 ){
         if( bestLitsz>0 ){
           /* Add an insert command before the copy */
+          DELTA_PROBE2(literal, base, bestLitsz);
           putInt(bestLitsz,&zDelta);
           *(zDelta++) = ':';
           memcpy(zDelta, &zOut[base], bestLitsz);
           zDelta += bestLitsz;
           base += bestLitsz;
+          st.nInsert++;
+          st.nInsertBytes += bestLitsz;
           DEBUG2( printf("insert %d\n", bestLitsz); )
         }
+        DELTA_PROBE3(copy, base, bestOfst, bestCnt);
         base += bestCnt;
+        st.nCopy++;
+        st.nCopyBytes += bestCnt;
         putInt(bestCnt, &zDelta);
         *(zDelta++) = '@';
         putInt(bestOfst, &zDelta);
@@ -673,23 +724,258 @@ int delta_create_with_options(
       /* If we reach this point, it means no match is found so far */
       if( base+i+nhash>=(int)lenOut ){
         /* We have reached the end of the file and have not found any
-        ** matches.  Do an "insert" for everything that does not match */
-        putInt(lenOut-base, &zDelta);
-        *(zDelta++) = ':';
-        memcpy(zDelta, &zOut[base], lenOut-base);
-        zDelta += lenOut-base;
-        base = lenOut;
+        ** matches.  Do an "insert" for everything that does not match.
+        ** Unless this is the end of the target, keep the bytes under
+        ** the hash window back: more target may turn them into a match. */
+        int n = bFinal ? (int)lenOut-base : i;
+        if( n>0 ){
+          DELTA_PROBE2(literal, base, n);
+          putInt(n, &zDelta);
+          *(zDelta++) = ':';
+          memcpy(zDelta, &zOut[base], n);
+          zDelta += n;
+          base += n;
+          st.nInsert++;
+          st.nInsertBytes += n;
+        }
         break;
       }
 
       /* Advance the hash by one character.  Keep looking for a match */
-      hash_next(&h, zOut[base+i+nhash]);
+      hash_next(pH, zOut[base+i+nhash]);
       i++;
     }
   }
-  
-  /* Clean up hash */
+
+scan_done:
+  if( pStats ) stats_add(pStats, &st);
+  *pBase = base;
+  return zDelta;
+}
+
+/*
+** Create a new delta.
+**
+** The delta is written into a preallocated buffer, zDelta, which
+** should be at least 60 bytes longer than the target file, zOut.
+** The delta string will be NUL-terminated, but it might also contain
+** embedded NUL characters if either the zSrc or zOut files are
+** binary.  This function returns the length of the delta string
+** in bytes, excluding the final NUL terminator character.
+**
+** Output Format:
+**
+** The delta begins with a compact-encoded integer.  This
+** number is the number of bytes in the TARGET file.  Thus, given a
+** delta file z, a program can compute the size of the output file
+** simply by decoding the compact integer
+** found there.  The delta_output_size() routine does exactly this.
+**
+** After the initial size number, the delta consists of a series of
+** literal text segments and commands to copy from the SOURCE file.
+** A copy command looks like this:
+**
+**     NNN@MMM,
+**
+** where NNN is the number of bytes to be copied and MMM is the offset
+** into the source file of the first byte (both compact-encoded integers).   If NNN is 0
+** it means copy the rest of the input file.  Literal text is like this:
+**
+**     NNN:TTTTT
+**
+** where NNN is the number of bytes of text (compact-encoded) and TTTTT is the text.
+**
+** The last term is of the form
+**
+**     NNN;
+**
+** In this case, NNN is a 32-bit bigendian checksum of the output file
+** that can be used to verify that the delta applied correctly.  All
+** numbers are compact-encoded.
+**
+** Pure text files generate a pure text delta.  Binary files generate a
+** delta that may contain some binary data.
+**
+** Algorithm:
+**
+** The encoder first builds a hash table to help it find matching
+** patterns in the source file.  16-byte chunks of the source file
+** sampled at evenly spaced intervals are used to populate the hash
+** table.
+**
+** Next we begin scanning the target file using a sliding 16-byte
+** window.  The hash of the 16-byte window in the target is used to
+** search for a matching section in the source file.  When a match
+** is found, a copy command is added to the delta.  An effort is
+** made to extend the matching section to regions that come before
+** and after the 16-byte hash window.  A copy command is only issued
+** if the result would use less space that just quoting the text
+** literally. Literal text is added to the delta for sections that
+** do not match or which can not be encoded efficiently using copy
+** commands.
+*/
+int delta_create(
+  const char *zSrc,      /* The source or pattern file */
+  size_t lenSrc,         /* Length of the source file */
+  const char *zOut,      /* The target file */
+  size_t lenOut,         /* Length of the target file */
+  char *zDelta           /* Write the delta into this buffer */
+){
+  return delta_create_with_options(zSrc, lenSrc, zOut, lenOut, zDelta, 
+                                   NHASH_DEFAULT, SEARCH_LIMIT_DEFAULT, 0);
+}
+
+/*
+** Like delta_create() but with a configurable hash window and search depth.
+**
+** If pCancel is not NULL it is polled once per emitted command and every
+** CANCEL_CHECK_INTERVAL scanned bytes.  As soon as it reads non-zero the
+** partial delta is abandoned and DELTA_CANCELLED is returned.
+*/
+
+int delta_create_with_options(
+  const char *zSrc,      /* The source or pattern file */
+  size_t lenSrc,         /* Length of the source file */
+  const char *zOut,      /* The target file */
+  size_t lenOut,         /* Length of the target file */
+  char *zDelta,          /* Write the delta into this buffer */
+  int nhash,             /* Hash window size (must be power of 2) */
+  int searchLimit,       /* Search depth limit */
+  const volatile int *pCancel /* Abandon the delta when *pCancel is set */
+){
+  return delta_create_with_index(zSrc, lenSrc, zOut, lenOut, zDelta,
+                                 nhash, searchLimit, pCancel, 0, 0);
+}
+
+/*
+** Return the number of integers in the hash table delta_create_with_index()
+** builds over a source of lenSrc bytes with the given hash window.
+*/
+size_t delta_index_size(size_t lenSrc, int nhash){
+  if( lenSrc<=(size_t)nhash ) return 0;
+  return (lenSrc/nhash)*2;
+}
+
+/*
+** Like delta_create_with_options() but builds the hash table in aIndex
+** when it holds at least delta_index_size() integers, so callers issuing
+** many deltas can keep one table around instead of allocating it every
+** time.  A smaller or NULL aIndex falls back to a temporary allocation.
+*/
+int delta_create_with_index(
+  const char *zSrc,      /* The source or pattern file */
+  size_t lenSrc,         /* Length of the source file */
+  const char *zOut,      /* The target file */
+  size_t lenOut,         /* Length of the target file */
+  char *zDelta,          /* Write the delta into this buffer */
+  int nhash,             /* Hash window size (must be power of 2) */
+  int searchLimit,       /* Search depth limit */
+  const volatile int *pCancel, /* Abandon the delta when *pCancel is set */
+  int *aIndex,           /* Scratch space for the hash table, or NULL */
+  size_t nIndex          /* Number of integers in aIndex */
+){
+  return delta_create_with_stats(zSrc, lenSrc, zOut, lenOut, zDelta, nhash,
+                                 searchLimit, pCancel, aIndex, nIndex, 0);
+}
+
+/*
+** Like delta_create_with_index() but adds what the call did to *pStats,
+** when not NULL, so callers can see where the time of a slow delta went.
+** The timings are only taken when pStats->xClock is set.
+*/
+int delta_create_with_stats(
+  const char *zSrc,      /* The source or pattern file */
+  size_t lenSrc,         /* Length of the source file */
+  const char *zOut,      /* The target file */
+  size_t lenOut,         /* Length of the target file */
+  char *zDelta,          /* Write the delta into this buffer */
+  int nhash,             /* Hash window size (must be power of 2) */
+  int searchLimit,       /* Search depth limit */
+  const volatile int *pCancel, /* Abandon the delta when *pCancel is set */
+  int *aIndex,           /* Scratch space for the hash table, or NULL */
+  size_t nIndex,         /* Number of integers in aIndex */
+  delta_stats *pStats    /* Add counters here if not NULL */
+){
+  int i, base;
+  uint64_t tStart, tIndexed;
+  int *aOwned = 0;           /* Hash table borrowed by this call */
+  char *zOrigDelta = zDelta;
+  hash h;
+  int nHash;                 /* Number of hash table entries */
+  int *landmark;             /* Primary hash table */
+  int *collide;              /* Collision chain */
+
+  DELTA_PROBE2(create__start, lenSrc, lenOut);
+
+  /* Add the target file size to the beginning of the delta
+  */
+  putInt(lenOut, &zDelta);
+
+  /* If the source file is very small, it means that we have no
+  ** chance of ever doing a copy command.  Just output a single
+  ** literal segment for the entire target and exit.
+  */
+  if( lenSrc<=nhash ){
+    putInt(lenOut, &zDelta);
+    *(zDelta++) = ':';
+    memcpy(zDelta, zOut, lenOut);
+    zDelta += lenOut;
+    putInt(checksum(zOut, lenOut), &zDelta);
+    *(zDelta++) = ';';
+    if( pStats ){
+      pStats->nInsert++;
+      pStats->nInsertBytes += lenOut;
+    }
+    DELTA_PROBE2(literal, 0, lenOut);
+    DELTA_PROBE2(create__done, lenOut, zDelta - zOrigDelta);
+    return zDelta - zOrigDelta;
+  }
+
+  /* Compute the hash table used to locate matching sections in the
+  ** source file.
+  */
+  tStart = stats_clock(pStats);
+  nHash = lenSrc/nhash;
+  if( aIndex && nIndex>=(size_t)nHash*2 ){
+    collide = aIndex;
+  }else{
+    collide = aOwned = index_borrow( (size_t)nHash*2 );
+    if( collide==0 ){
+      DELTA_PROBE2(create__done, lenOut, -1);
+      return -1;
+    }
+  }
+  memset(collide, -1, nHash*2*sizeof(int));
+  landmark = &collide[nHash];
+  for(i=0; i<(int)lenSrc-nhash; i+=nhash){
+    int hv = hash_once(&zSrc[i], nhash) % nHash;
+    collide[i/nhash] = landmark[hv];
+    landmark[hv] = i/nhash;
+  }
+  tIndexed = stats_clock(pStats);
+  DELTA_PROBE2(index__built, lenSrc, nHash);
+
+  /* Begin scanning the target file and generating copy commands and
+  ** literal sections of the delta.
+  */
+  base = 0;    /* We have already generated everything before zOut[base] */
+  if( !hash_alloc(&h, nhash) ){
+    index_return(aOwned);
+    DELTA_PROBE2(create__done, lenOut, -1);
+    return -1;
+  }
+  zDelta = delta_scan(zSrc, lenSrc, zOut, lenOut, zDelta, &h, nhash,
+                      searchLimit, collide, nHash, 1, pCancel, pStats, &base);
   hash_free(&h);
+  if( pStats && pStats->xClock ){
+    pStats->nsIndex += tIndexed - tStart;
+    pStats->nsScan += pStats->xClock() - tIndexed;
+  }
+  if( zDelta==0 ){
+    index_return(aOwned);
+    DELTA_PROBE2(create__done, lenOut, DELTA_CANCELLED);
+    return DELTA_CANCELLED;
+  }
   /* Output a final "insert" record to get all the text at the end of
   ** the file that does not match anything in the source file.
   */
@@ -698,11 +984,17 @@ int delta_create_with_options(
     *(zDelta++) = ':';
     memcpy(zDelta, &zOut[base], lenOut-base);
     zDelta += lenOut-base;
+    if( pStats ){
+      pStats->nInsert++;
+      pStats->nInsertBytes += lenOut-base;
+    }
+    DELTA_PROBE2(literal, base, lenOut-base);
   }
   /* Output the final checksum record. */
   putInt(checksum(zOut, lenOut), &zDelta);
   *(zDelta++) = ';';
-  fossil_free(collide);
+  index_return(aOwned);
+  DELTA_PROBE2(create__done, lenOut, zDelta - zOrigDelta);
   return zDelta - zOrigDelta;
 }
 
@@ -752,6 +1044,38 @@ int delta_apply(
   const char *zDelta,    /* Delta to apply to the pattern */
   size_t lenDelta,       /* Length of the delta */
   char *zOut             /* Write the output into this preallocated buffer */
+){
+  return delta_apply_with_cancel(zSrc, lenSrc, zDelta, lenDelta, zOut, 0);
+}
+
+/*
+** Like delta_apply() but polls *pCancel, if not NULL, before every
+** command and returns DELTA_CANCELLED as soon as it reads non-zero.
+*/
+int delta_apply_with_cancel(
+  const char *zSrc,      /* The source or pattern file */
+  size_t lenSrc,         /* Length of the source file */
+  const char *zDelta,    /* Delta to apply to the pattern */
+  size_t lenDelta,       /* Length of the delta */
+  char *zOut,            /* Write the output into this preallocated buffer */
+  const volatile int *pCancel /* Abandon the output when *pCancel is set */
+){
+  return delta_apply_with_stats(zSrc, lenSrc, zDelta, lenDelta, zOut,
+                                pCancel, 0);
+}
+
+/*
+** The body of delta_apply_with_stats().  Copy and insert commands are
+** added to *pStats as they are applied, when pStats is not NULL.
+*/
+static int delta_apply_int(
+  const char *zSrc,      /* The source or pattern file */
+  size_t lenSrc,         /* Length of the source file */
+  const char *zDelta,    /* Delta to apply to the pattern */
+  size_t lenDelta,       /* Length of the delta */
+  char *zOut,            /* Write the output into this preallocated buffer */
+  const volatile int *pCancel, /* Abandon the output when *pCancel is set */
+  delta_stats *pStats    /* Add counters here if not NULL */
 ){
   uint32_t limit;
   uint32_t total = 0;
@@ -769,6 +1093,10 @@ int delta_apply(
   while( lenDelta>0 ){
     uint32_t cnt, ofst;
     
+    if( pCancel && *pCancel ){
+      return DELTA_CANCELLED;
+    }
+    
     DEBUG1( printf("delta_apply: loop iteration, %zu bytes remaining, first byte = 0x%02x\n", lenDelta, (uint8_t)*zDelta); )
     
     cnt = getInt(&zDelta, &lenDelta);
@@ -802,6 +1130,10 @@ int delta_apply(
         }
         memcpy(zOut, &zSrc[ofst], cnt);
         zOut += cnt;
+        if( pStats ){
+          pStats->nCopy++;
+          pStats->nCopyBytes += cnt;
+        }
         break;
       }
       case ':': {
@@ -824,6 +1156,10 @@ int delta_apply(
         }
         zDelta += cnt;
         lenDelta -= cnt;
+        if( pStats ){
+          pStats->nInsert++;
+          pStats->nInsertBytes += cnt;
+        }
         DEBUG1( printf("delta_apply: INSERT completed, %zu bytes remaining in delta\n", lenDelta); )
         break;
       }
@@ -854,6 +1190,30 @@ int delta_apply(
   return -1;
 }
 
+/*
+** Like delta_apply_with_cancel() but adds what the call did to *pStats,
+** when not NULL.  The time is only taken when pStats->xClock is set.
+*/
+int delta_apply_with_stats(
+  const char *zSrc,      /* The source or pattern file */
+  size_t lenSrc,         /* Length of the source file */
+  const char *zDelta,    /* Delta to apply to the pattern */
+  size_t lenDelta,       /* Length of the delta */
+  char *zOut,            /* Write the output into this preallocated buffer */
+  const volatile int *pCancel, /* Abandon the output when *pCancel is set */
+  delta_stats *pStats    /* Add counters here if not NULL */
+){
+  uint64_t tStart = stats_clock(pStats);
+  int rc;
+  DELTA_PROBE2(apply__start, lenSrc, lenDelta);
+  rc = delta_apply_int(zSrc, lenSrc, zDelta, lenDelta, zOut, pCancel, pStats);
+  DELTA_PROBE2(apply__done, lenDelta, rc);
+  if( pStats && pStats->xClock ){
+    pStats->nsApply += pStats->xClock() - tStart;
+  }
+  return rc;
+}
+
 /*
 ** Analyze a delta.  Figure out the total number of bytes copied from
 ** source to target, and the total number of bytes inserted by the delta,
@@ -913,3 +1273,453 @@ int delta_analyze(
   /* ERROR: unterminated delta */
   return -1;
 }
+
+/*
+** Streaming delta creation.
+**
+** A delta_create_stream produces the same format as delta_create() while
+** the target is written to it piecewise, so a large target never has to
+** be held in memory.  The size of the target goes first in the delta and
+** must therefore be declared up front.  The source is indexed once, when
+** the stream is opened or piecewise by delta_create_stream_index(), and
+** must stay unchanged until the stream is freed.
+**
+** Matches never extend across the end of the target received so far, so
+** a streamed delta may be slightly larger than one created in a single
+** call.  Only the last hash window of each write is held back.
+*/
+struct delta_create_stream {
+  size_t lenSrc;         /* Length of the source */
+  size_t lenOut;         /* Declared length of the target */
+  size_t nIn;            /* Target bytes written so far */
+  int nhash;             /* Hash window size */
+  int searchLimit;       /* Search depth limit */
+  int nHash;             /* Number of hash table entries, 0 for no index */
+  int *collide;          /* Collision chain followed by the landmarks */
+  size_t nIndexed;       /* Source offset the index has reached */
+  hash h;                /* Rolling hash */
+  char *zPend;           /* Target bytes written but not yet encoded */
+  size_t nPend;          /* Number of bytes in zPend */
+  size_t nPendAlloc;     /* Space allocated for zPend */
+  unsigned int cksum;    /* Checksum of the target written so far */
+  int bHeader;           /* True once the target size has been emitted */
+};
+
+/*
+** Open a stream creating a delta from a source of lenSrc bytes to a
+** target of lenOut bytes, without indexing the source yet.  Returns 0 on
+** allocation failure.
+*/
+delta_create_stream *delta_create_stream_open(
+  size_t lenSrc,         /* Length of the source file */
+  size_t lenOut,         /* Length of the target file */
+  int nhash,             /* Hash window size (must be power of 2) */
+  int searchLimit        /* Search depth limit */
+){
+  delta_create_stream *p;
+
+  p = (delta_create_stream *)fossil_malloc(sizeof(*p));
+  if( p==0 ) return 0;
+  memset(p, 0, sizeof(*p));
+  p->lenSrc = lenSrc;
+  p->lenOut = lenOut;
+  p->nhash = nhash;
+  p->searchLimit = searchLimit;
+
+  /* As in delta_create_with_index(), a source no longer than the hash
+  ** window cannot yield a copy and the target is sent literally.
+  */
+  if( lenSrc<=(size_t)nhash ) return p;
+
+  p->nHash = lenSrc/nhash;
+  p->collide = (int *)fossil_malloc((size_t)p->nHash*2*sizeof(int));
+  if( p->collide==0 || !hash_alloc(&p->h, nhash) ){
+    delta_create_stream_free(p);
+    return 0;
+  }
+  memset(p->collide, -1, (size_t)p->nHash*2*sizeof(int));
+  return p;
+}
+
+/*
+** Index up to nBudget more bytes of the source of a stream opened by
+** delta_create_stream_open().  Blocks are indexed in the same order as
+** in a single pass, so the index does not depend on how it is sliced.
+** Returns 1 once the whole source is indexed and 0 before that.
+*/
+int delta_create_stream_index(
+  delta_create_stream *p, /* The stream */
+  const char *zSrc,      /* The source the stream was opened with */
+  size_t nBudget         /* Most source bytes to index in this call */
+){
+  size_t i, iEnd;
+  int *landmark;
+
+  if( p->nHash==0 ) return 1;
+  landmark = &p->collide[p->nHash];
+  iEnd = p->lenSrc - p->nhash;
+  if( p->nIndexed<iEnd && nBudget<iEnd-p->nIndexed ) iEnd = p->nIndexed + nBudget;
+  for(i=p->nIndexed; i<iEnd; i+=p->nhash){
+    int hv = hash_once(&zSrc[i], p->nhash) % p->nHash;
+    p->collide[i/p->nhash] = landmark[hv];
+    landmark[hv] = i/p->nhash;
+  }
+  if( i>p->nIndexed ) p->nIndexed = i;
+  return p->nIndexed>=p->lenSrc-p->nhash;
+}
+
+/*
+** Open a stream creating a delta from zSrc to a target of lenOut bytes,
+** indexing the whole source.  Returns 0 on allocation failure.
+*/
+delta_create_stream *delta_create_stream_new(
+  const char *zSrc,      /* The source or pattern file */
+  size_t lenSrc,         /* Length of the source file */
+  size_t lenOut,         /* Length of the target file */
+  int nhash,             /* Hash window size (must be power of 2) */
+  int searchLimit        /* Search depth limit */
+){
+  delta_create_stream *p = delta_create_stream_open(lenSrc, lenOut, nhash, searchLimit);
+  if( p ) delta_create_stream_index(p, zSrc, (size_t)-1);
+  return p;
+}
+
+/*
+** Return the most bytes delta_create_stream_write() can emit for nIn more
+** target bytes, including the final checksum.
+*/
+size_t delta_create_stream_bound(const delta_create_stream *p, size_t nIn){
+  return p->nPend + nIn + 32;
+}
+
+/*
+** Write the next nIn bytes of the target.  bFinal is true for the last
+** write, which must complete the declared target length.  The commands
+** ready so far are written into zDelta, which must hold at least
+** delta_create_stream_bound() bytes, and their length is returned.
+** Returns -1 if the target outgrows its declared length, falls short of
+** it at the end, or memory runs out.
+*/
+int delta_create_stream_write(
+  delta_create_stream *p, /* The stream */
+  const char *zSrc,      /* The source the stream was opened with */
+  const char *zIn,       /* Next bytes of the target */
+  size_t nIn,            /* Number of bytes in zIn */
+  int bFinal,            /* True if zIn ends the target */
+  char *zDelta           /* Write the delta into this buffer */
+){
+  char *zOrigDelta = zDelta;
+  int base = 0;
+
+  if( nIn>p->lenOut-p->nIn ) return -1;
+  if( bFinal && p->nIn+nIn!=p->lenOut ) return -1;
+
+  /* Finish an index left incomplete by delta_create_stream_index() */
+  delta_create_stream_index(p, zSrc, (size_t)-1);
+
+  if( p->nPend+nIn>p->nPendAlloc ){
+    size_t nAlloc = (p->nPend+nIn)*2;
+    char *zNew = (char *)fossil_malloc(nAlloc);
+    if( zNew==0 ) return -1;
+    if( p->nPend>0 ) memcpy(zNew, p->zPend, p->nPend);
+    fossil_free(p->zPend);
+    p->zPend = zNew;
+    p->nPendAlloc = nAlloc;
+  }
+  if( nIn>0 ) memcpy(&p->zPend[p->nPend], zIn, nIn);
+  p->nPend += nIn;
+  p->cksum = checksum_update(p->cksum, p->nIn, zIn, nIn);
+  p->nIn += nIn;
+
+  if( !p->bHeader ){
+    putInt(p->lenOut, &zDelta);
+    p->bHeader = 1;
+  }
+
+  if( p->nHash>0 ){
+    zDelta = delta_scan(zSrc, p->lenSrc, p->zPend, p->nPend, zDelta, &p->h,
+                        p->nhash, p->searchLimit, p->collide, p->nHash,
+                        bFinal, 0, 0, &base);
+  }
+
+  /* Without an index nothing can match, so there is no reason to hold
+  ** bytes back.
+  */
+  if( (bFinal || p->nHash==0) && base<(int)p->nPend ){
+    putInt(p->nPend-base, &zDelta);
+    *(zDelta++) = ':';
+    memcpy(zDelta, &p->zPend[base], p->nPend-base);
+    zDelta += p->nPend-base;
+    base = p->nPend;
+  }
+  if( base>0 ){
+    memmove(p->zPend, &p->zPend[base], p->nPend-base);
+    p->nPend -= base;
+  }
+
+  if( bFinal ){
+    putInt(p->cksum, &zDelta);
+    *(zDelta++) = ';';
+  }
+  return zDelta - zOrigDelta;
+}
+
+/*
+** Free a stream opened by delta_create_stream_new()
+*/
+void delta_create_stream_free(delta_create_stream *p){
+  if( p==0 ) return;
+  hash_free(&p->h);
+  fossil_free(p->collide);
+  fossil_free(p->zPend);
+  fossil_free(p);
+}
+
+/*
+** Streaming delta application.
+**
+** A delta_apply_stream decodes a delta as it arrives and writes the target
+** into output buffers of any size, so neither the delta nor the target
+** has to be held in memory whole.  Every integer and command may be split
+** across writes.  The source must be available in full.
+*/
+#define APPLY_STREAM_SIZE    0   /* Reading the target size */
+#define APPLY_STREAM_COUNT   1   /* Reading the count of the next command */
+#define APPLY_STREAM_OP      2   /* Reading the command character */
+#define APPLY_STREAM_OFFSET  3   /* Reading the source offset of a copy */
+#define APPLY_STREAM_COMMA   4   /* Reading the ',' that ends a copy */
+#define APPLY_STREAM_COPY    5   /* Writing bytes copied from the source */
+#define APPLY_STREAM_INSERT  6   /* Writing literal bytes from the delta */
+#define APPLY_STREAM_DONE    7   /* The checksum has been read */
+#define APPLY_STREAM_ERROR   8   /* The delta is malformed */
+
+struct delta_apply_stream {
+  int eState;            /* One of the APPLY_STREAM_ values */
+  uint32_t limit;        /* Size of the target */
+  uint32_t total;        /* Target bytes produced by commands read so far */
+  uint32_t cnt;          /* Count of the current command */
+  uint32_t ofst;         /* Next source byte of the current copy */
+  uint32_t nLeft;        /* Bytes of the current command not yet written */
+  char aInt[9];          /* Bytes of an integer split across writes */
+  size_t nInt;           /* Number of bytes in aInt */
+};
+
+/*
+** Open a stream applying a delta.  Returns 0 on allocation failure.
+*/
+delta_apply_stream *delta_apply_stream_new(void){
+  delta_apply_stream *p = (delta_apply_stream *)fossil_malloc(sizeof(*p));
+  if( p==0 ) return 0;
+  memset(p, 0, sizeof(*p));
+  p->eState = APPLY_STREAM_SIZE;
+  return p;
+}
+
+/*
+** Read a compact-encoded integer that may be split across writes.
+** Returns 1 with the value in *pV once it is complete, 0 if more input is
+** needed and -1 if it is malformed.
+*/
+static int apply_stream_int(
+  delta_apply_stream *p,
+  const char **pz,
+  size_t *pn,
+  uint32_t *pV
+){
+  size_t need, n;
+  const char *z;
+  uint32_t v;
+
+  if( p->nInt==0 ){
+    if( *pn==0 ) return 0;
+    z = *pz;
+  }else{
+    z = p->aInt;
+  }
+  switch( (unsigned char)z[0] ){
+    case 0xfd: need = 3; break;
+    case 0xfe: need = 5; break;
+    case 0xff: need = 9; break;
+    default:   need = 1; break;
+  }
+
+  if( p->nInt==0 && *pn>=need ){
+    /* The whole integer is in the input; decode it in place */
+    v = getInt(pz, pn);
+  }else{
+    n = need-p->nInt;
+    if( n>*pn ) n = *pn;
+    memcpy(&p->aInt[p->nInt], *pz, n);
+    p->nInt += n;
+    *pz += n;
+    *pn -= n;
+    if( p->nInt<need ) return 0;
+    z = p->aInt;
+    n = need;
+    v = getInt(&z, &n);
+    p->nInt = 0;
+  }
+  if( v==UINT32_MAX ) return -1;
+  *pV = v;
+  return 1;
+}
+
+/*
+** Decode as much of the delta in *pzDelta as fits, writing up to nOut
+** target bytes into zOut.  *pzDelta and *pnDelta are advanced past the
+** bytes consumed.  Returns the number of bytes written, which is less
+** than nOut only once all input is consumed or the delta is complete, or
+** -1 if the delta is malformed or does not fit the source.
+*/
+int delta_apply_stream_write(
+  delta_apply_stream *p, /* The stream */
+  const char *zSrc,      /* The source or pattern file */
+  size_t lenSrc,         /* Length of the source file */
+  const char **pzDelta,  /* IN/OUT: Next bytes of the delta */
+  size_t *pnDelta,       /* IN/OUT: Number of bytes at *pzDelta */
+  char *zOut,            /* Write the output into this buffer */
+  size_t nOut            /* Space available in zOut */
+){
+  char *zOrigOut = zOut;
+  char *zEnd = zOut+nOut;
+  int rc;
+  size_t n;
+
+  while( 1 ){
+    switch( p->eState ){
+      case APPLY_STREAM_SIZE: {
+        rc = apply_stream_int(p, pzDelta, pnDelta, &p->limit);
+        if( rc<=0 ) goto stop;
+        p->eState = APPLY_STREAM_COUNT;
+        break;
+      }
+      case APPLY_STREAM_COUNT: {
+        rc = apply_stream_int(p, pzDelta, pnDelta, &p->cnt);
+        if( rc<=0 ) goto stop;
+        p->eState = APPLY_STREAM_OP;
+        break;
+      }
+      case APPLY_STREAM_OP: {
+        if( *pnDelta==0 ) return zOut - zOrigOut;
+        switch( **pzDelta ){
+          case '@': {
+            p->eState = APPLY_STREAM_OFFSET;
+            break;
+          }
+          case ':': {
+            if( p->cnt>p->limit-p->total ){
+              /* ERROR:  insert command gives an output larger than predicted */
+              p->eState = APPLY_STREAM_ERROR;
+              return -1;
+            }
+            p->total += p->cnt;
+            p->nLeft = p->cnt;
+            p->eState = APPLY_STREAM_INSERT;
+            break;
+          }
+          case ';': {
+            if( p->total!=p->limit ){
+              /* ERROR: generated size does not match predicted size */
+              p->eState = APPLY_STREAM_ERROR;
+              return -1;
+            }
+            p->eState = APPLY_STREAM_DONE;
+            break;
+          }
+          default: {
+            /* ERROR: unknown delta operator */
+            p->eState = APPLY_STREAM_ERROR;
+            return -1;
+          }
+        }
+        (*pzDelta)++;
+        (*pnDelta)--;
+        break;
+      }
+      case APPLY_STREAM_OFFSET: {
+        rc = apply_stream_int(p, pzDelta, pnDelta, &p->ofst);
+        if( rc<=0 ) goto stop;
+        p->eState = APPLY_STREAM_COMMA;
+        break;
+      }
+      case APPLY_STREAM_COMMA: {
+        if( *pnDelta==0 ) return zOut - zOrigOut;
+        if( **pzDelta!=',' ){
+          /* ERROR: copy command not terminated by ',' */
+          p->eState = APPLY_STREAM_ERROR;
+          return -1;
+        }
+        (*pzDelta)++;
+        (*pnDelta)--;
+        if( p->cnt>p->limit-p->total ){
+          /* ERROR: copy exceeds output file size */
+          p->eState = APPLY_STREAM_ERROR;
+          return -1;
+        }
+        if( (uint64_t)p->ofst+p->cnt>lenSrc ){
+          /* ERROR: copy extends past end of input */
+          p->eState = APPLY_STREAM_ERROR;
+          return -1;
+        }
+        p->total += p->cnt;
+        p->nLeft = p->cnt;
+        p->eState = APPLY_STREAM_COPY;
+        break;
+      }
+      case APPLY_STREAM_COPY: {
+        n = zEnd-zOut;
+        if( n>p->nLeft ) n = p->nLeft;
+        memcpy(zOut, &zSrc[p->ofst], n);
+        zOut += n;
+        p->ofst += n;
+        p->nLeft -= n;
+        if( p->nLeft>0 ) return zOut - zOrigOut;
+        p->eState = APPLY_STREAM_COUNT;
+        break;
+      }
+      case APPLY_STREAM_INSERT: {
+        n = zEnd-zOut;
+        if( n>p->nLeft ) n = p->nLeft;
+        if( n>*pnDelta ) n = *pnDelta;
+        if( n>0 ){
+          memcpy(zOut, *pzDelta, n);
+          zOut += n;
+          *pzDelta += n;
+          *pnDelta -= n;
+          p->nLeft -= n;
+        }
+        if( p->nLeft>0 ) return zOut - zOrigOut;
+        p->eState = APPLY_STREAM_COUNT;
+        break;
+      }
+      case APPLY_STREAM_DONE: {
+        return zOut - zOrigOut;
+      }
+      default: {
+        return -1;
+      }
+    }
+  }
+
+stop:
+  if( rc<0 ){
+    /* ERROR: failed to decode an integer */
+    p->eState = APPLY_STREAM_ERROR;
+    return -1;
+  }
+  return zOut - zOrigOut;
+}
+
+/*
+** Return true once the stream has read the whole delta
+*/
+int delta_apply_stream_done(const delta_apply_stream *p){
+  return p->eState==APPLY_STREAM_DONE;
+}
+
+/*
+** Free a stream opened by delta_apply_stream_new()
+*/
+void delta_apply_stream_free(delta_apply_stream *p){
+  fossil_free(p);
+}
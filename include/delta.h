@@ -0,0 +1,303 @@
+#ifndef DELTA_H
+#define DELTA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+** C API of the bare-delta engine.
+**
+** Deltas are created against a source buffer and reproduce a target
+** buffer when applied to the same source.  Every function is safe to call
+** from any thread; state is only shared through the allocator hooks and
+** the per-thread index cache.  Buffers belong to the caller throughout.
+*/
+
+/*
+** Default width of the hash window in bytes, and default number of
+** candidate matches examined per position.
+*/
+#define DELTA_NHASH_DEFAULT 16
+#define DELTA_SEARCH_LIMIT_DEFAULT 250
+
+/*
+** Returned by the cancellable calls when *pCancel became non-zero
+*/
+#define DELTA_CANCELLED (-2)
+
+/*
+** Counters filled in by delta_create_with_stats() and
+** delta_apply_with_stats().  The calls add to the fields rather than
+** overwrite them, so zero the structure first.  The ns* timings are only
+** taken when xClock is set to a monotonic clock in nanoseconds.
+*/
+typedef struct delta_stats delta_stats;
+struct delta_stats {
+  uint64_t (*xClock)(void);        /* Monotonic clock in ns, or NULL */
+  uint64_t nsIndex;                /* Time spent indexing the source */
+  uint64_t nsScan;                 /* Time spent matching the target */
+  uint64_t nsApply;                /* Time spent applying a delta */
+  uint64_t nProbe;                 /* Hash table lookups */
+  uint64_t nChain;                 /* Candidates visited on hash chains */
+  uint64_t nReject;                /* Candidates whose bytes did not match */
+  uint64_t nForward;               /* Bytes matched extending forwards */
+  uint64_t nBackward;              /* Bytes matched extending backwards */
+  uint64_t nCopy;                  /* Copy commands */
+  uint64_t nCopyBytes;             /* Bytes covered by copy commands */
+  uint64_t nInsert;                /* Insert commands */
+  uint64_t nInsertBytes;           /* Literal bytes inserted */
+};
+
+/*
+** Memory allocation hooks, see delta_set_allocator()
+*/
+typedef struct delta_allocator delta_allocator;
+struct delta_allocator {
+  void *(*xMalloc)(size_t);        /* Allocate memory */
+  void (*xFree)(void*);            /* Release memory from xMalloc */
+};
+
+/*
+** Route the engine's allocations through pAllocator, or back to the C
+** library allocator when it is NULL.  Install the hooks before the first
+** delta is created; they must not change while any operation is running.
+*/
+void delta_set_allocator(const delta_allocator *pAllocator);
+
+/*
+** Release the hash table cached by the calling thread.  Threads that
+** create deltas should call this before they exit.
+*/
+void delta_release_thread_cache(void);
+
+/*
+** Create a delta from zSrc to zOut with the default options.  zDelta must
+** hold at least lenOut+60 bytes.  Returns the length of the delta.
+*/
+int delta_create(
+  const char *zSrc,      /* The source or pattern file */
+  size_t lenSrc,         /* Length of the source file */
+  const char *zOut,      /* The target file */
+  size_t lenOut,         /* Length of the target file */
+  char *zDelta           /* Write the delta into this buffer */
+);
+
+/*
+** Like delta_create() with a configurable hash window, a power of two,
+** and search depth.  If pCancel is not NULL, the call returns
+** DELTA_CANCELLED soon after *pCancel becomes non-zero.  Returns -1 if
+** memory runs out.
+*/
+int delta_create_with_options(
+  const char *zSrc,      /* The source or pattern file */
+  size_t lenSrc,         /* Length of the source file */
+  const char *zOut,      /* The target file */
+  size_t lenOut,         /* Length of the target file */
+  char *zDelta,          /* Write the delta into this buffer */
+  int nhash,             /* Hash window size (must be power of 2) */
+  int searchLimit,       /* Search depth limit */
+  const volatile int *pCancel /* Abandon the delta when *pCancel is set */
+);
+
+/*
+** Like delta_create_with_options() but builds the hash table in aIndex
+** when it holds at least delta_index_size() integers.
+*/
+int delta_create_with_index(
+  const char *zSrc,      /* The source or pattern file */
+  size_t lenSrc,         /* Length of the source file */
+  const char *zOut,      /* The target file */
+  size_t lenOut,         /* Length of the target file */
+  char *zDelta,          /* Write the delta into this buffer */
+  int nhash,             /* Hash window size (must be power of 2) */
+  int searchLimit,       /* Search depth limit */
+  const volatile int *pCancel, /* Abandon the delta when *pCancel is set */
+  int *aIndex,           /* Scratch space for the hash table, or NULL */
+  size_t nIndex          /* Number of integers in aIndex */
+);
+
+/*
+** Like delta_create_with_index() but adds what the call did to *pStats
+** when it is not NULL
+*/
+int delta_create_with_stats(
+  const char *zSrc,      /* The source or pattern file */
+  size_t lenSrc,         /* Length of the source file */
+  const char *zOut,      /* The target file */
+  size_t lenOut,         /* Length of the target file */
+  char *zDelta,          /* Write the delta into this buffer */
+  int nhash,             /* Hash window size (must be power of 2) */
+  int searchLimit,       /* Search depth limit */
+  const volatile int *pCancel, /* Abandon the delta when *pCancel is set */
+  int *aIndex,           /* Scratch space for the hash table, or NULL */
+  size_t nIndex,         /* Number of integers in aIndex */
+  delta_stats *pStats    /* Add counters here if not NULL */
+);
+
+/*
+** Number of integers in the hash table built over a source of lenSrc
+** bytes with the given hash window
+*/
+size_t delta_index_size(size_t lenSrc, int nhash);
+
+/*
+** Return the size of the target a delta produces, or -1 if the delta is
+** malformed
+*/
+int delta_output_size(const char *zDelta, size_t lenDelta);
+
+/*
+** Apply a delta to zSrc.  zOut must hold delta_output_size() bytes plus
+** one.  Returns the length of the target, or -1 if the delta is malformed
+** or does not fit the source.
+*/
+int delta_apply(
+  const char *zSrc,      /* The source or pattern file */
+  size_t lenSrc,         /* Length of the source file */
+  const char *zDelta,    /* Delta to apply to the pattern */
+  size_t lenDelta,       /* Length of the delta */
+  char *zOut             /* Write the output into this preallocated buffer */
+);
+
+/*
+** Like delta_apply() but returns DELTA_CANCELLED soon after *pCancel, if
+** not NULL, becomes non-zero
+*/
+int delta_apply_with_cancel(
+  const char *zSrc,      /* The source or pattern file */
+  size_t lenSrc,         /* Length of the source file */
+  const char *zDelta,    /* Delta to apply to the pattern */
+  size_t lenDelta,       /* Length of the delta */
+  char *zOut,            /* Write the output into this preallocated buffer */
+  const volatile int *pCancel /* Abandon the output when *pCancel is set */
+);
+
+/*
+** Like delta_apply_with_cancel() but adds the copy and insert commands
+** applied, and the time taken, to *pStats when it is not NULL
+*/
+int delta_apply_with_stats(
+  const char *zSrc,      /* The source or pattern file */
+  size_t lenSrc,         /* Length of the source file */
+  const char *zDelta,    /* Delta to apply to the pattern */
+  size_t lenDelta,       /* Length of the delta */
+  char *zOut,            /* Write the output into this preallocated buffer */
+  const volatile int *pCancel, /* Abandon the output when *pCancel is set */
+  delta_stats *pStats    /* Add counters here if not NULL */
+);
+
+/*
+** Count the bytes a delta copies from the source and inserts literally.
+** Returns 0, or -1 if the delta is malformed.
+*/
+int delta_analyze(
+  const char *zDelta,    /* Delta to analyze */
+  size_t lenDelta,       /* Length of the delta */
+  int *pnCopy,           /* OUT: Number of bytes copied */
+  int *pnInsert          /* OUT: Number of bytes inserted */
+);
+
+/*
+** Streaming creation.  The target is written piecewise and the delta is
+** emitted as it is produced.  The source must stay unchanged and be passed
+** to every write until the stream is freed.
+*/
+typedef struct delta_create_stream delta_create_stream;
+
+/*
+** Open a stream creating a delta from zSrc to a target of lenOut bytes.
+** Returns NULL if memory runs out.
+*/
+delta_create_stream *delta_create_stream_new(
+  const char *zSrc,      /* The source or pattern file */
+  size_t lenSrc,         /* Length of the source file */
+  size_t lenOut,         /* Length of the target file */
+  int nhash,             /* Hash window size (must be power of 2) */
+  int searchLimit        /* Search depth limit */
+);
+
+/*
+** Open a stream without indexing the source, for callers that index it in
+** slices with delta_create_stream_index().  Returns NULL if memory runs out.
+*/
+delta_create_stream *delta_create_stream_open(
+  size_t lenSrc,         /* Length of the source file */
+  size_t lenOut,         /* Length of the target file */
+  int nhash,             /* Hash window size (must be power of 2) */
+  int searchLimit        /* Search depth limit */
+);
+
+/*
+** Index up to nBudget more source bytes.  Returns 1 once the whole source
+** is indexed.  A write finishes whatever indexing is left.
+*/
+int delta_create_stream_index(
+  delta_create_stream *p, /* The stream */
+  const char *zSrc,      /* The source the stream was opened with */
+  size_t nBudget         /* Most source bytes to index in this call */
+);
+
+/*
+** Most bytes the next write of nIn target bytes can emit
+*/
+size_t delta_create_stream_bound(const delta_create_stream *p, size_t nIn);
+
+/*
+** Write the next nIn target bytes, with bFinal set on the last write.
+** Returns the number of delta bytes written to zDelta, or -1 if the
+** target does not match its declared length or memory runs out.
+*/
+int delta_create_stream_write(
+  delta_create_stream *p, /* The stream */
+  const char *zSrc,      /* The source the stream was opened with */
+  const char *zIn,       /* Next bytes of the target */
+  size_t nIn,            /* Number of bytes in zIn */
+  int bFinal,            /* True if zIn ends the target */
+  char *zDelta           /* Write the delta into this buffer */
+);
+
+void delta_create_stream_free(delta_create_stream *p);
+
+/*
+** Streaming application.  The delta is written piecewise, split at any
+** byte, and the target is produced into output buffers of any size.
+*/
+typedef struct delta_apply_stream delta_apply_stream;
+
+/*
+** Open a stream applying a delta.  Returns NULL if memory runs out.
+*/
+delta_apply_stream *delta_apply_stream_new(void);
+
+/*
+** Decode the delta bytes at *pzDelta, advancing it past those consumed,
+** and write up to nOut target bytes into zOut.  Returns the number of
+** bytes written, or -1 if the delta is malformed.  Call again with more
+** room while input remains.
+*/
+int delta_apply_stream_write(
+  delta_apply_stream *p, /* The stream */
+  const char *zSrc,      /* The source or pattern file */
+  size_t lenSrc,         /* Length of the source file */
+  const char **pzDelta,  /* IN/OUT: Next bytes of the delta */
+  size_t *pnDelta,       /* IN/OUT: Number of bytes at *pzDelta */
+  char *zOut,            /* Write the output into this buffer */
+  size_t nOut            /* Space available in zOut */
+);
+
+/*
+** Return true once the whole delta has been read
+*/
+int delta_apply_stream_done(const delta_apply_stream *p);
+
+void delta_apply_stream_free(delta_apply_stream *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DELTA_H
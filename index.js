@@ -1,5 +1,224 @@
 const binding = require('./binding')
 const b4a = require('b4a')
+const { Duplex } = require('streamx')
+
+// Default number of input bytes up to which async requests always run
+// inline on the JS thread
+const INLINE_THRESHOLD_DEFAULT = 1024
+
+// Default cost of a worker pool round trip in nanoseconds: queueing, waking
+// a thread and scheduling the callback. Requests estimated to cost less run
+// inline.
+const INLINE_OVERHEAD_DEFAULT = 20000
+
+// Estimated engine cost in nanoseconds per input byte
+const CREATE_COST_PER_BYTE = 4
+const APPLY_COST_PER_BYTE = 0.5
+
+// Estimated zstd or LZ4 cost in nanoseconds per uncompressed byte
+const COMPRESS_COST_PER_BYTE = 2
+const DECOMPRESS_COST_PER_BYTE = 0.5
+
+let inlineThreshold = INLINE_THRESHOLD_DEFAULT
+let inlineOverhead = INLINE_OVERHEAD_DEFAULT
+
+// Number of async requests run inline so far
+let inlined = 0
+
+// Admission limits on async requests running at once, and what to do with
+// requests beyond them
+let maxInFlight = Infinity
+let maxInFlightBytes = Infinity
+let overload = 'wait'
+
+// Async requests with at most this many input bytes that are issued in the
+// same tick are coalesced into a single createMany/applyMany request
+const COALESCE_MAX_BYTES = 16 * 1024
+
+// Upper bound on the number of requests coalesced into one batch
+const COALESCE_MAX_COUNT = 1024
+
+// Pending batches of small requests, keyed by operation and options
+const batches = new Map()
+
+// Worst-case number of bytes an uncompressed delta adds on top of the target
+const CREATE_OVERHEAD = 1024
+
+// Compiled form of the default creation options
+const DEFAULT_COMPILED_OPTIONS = binding.compileOptions({})
+
+// Returned by the native createInto()/applyInto() when out is too small
+const OUT_OF_RANGE = -8
+
+// Largest chunk of target an apply stream pushes at a time
+const STREAM_CHUNK_SIZE = 64 * 1024
+
+const EMPTY = b4a.alloc(0)
+
+// Default number of bytes an incremental create or apply handles per step
+const STEP_BUDGET_DEFAULT = 64 * 1024
+
+// Run an async binding call, cancelling the native request if the signal
+// aborts before it completes
+function schedule(signal, call, convert = b4a.toBuffer) {
+  return new Promise((resolve, reject) => {
+    if (signal && signal.aborted) {
+      reject(abortReason(signal))
+      return
+    }
+
+    const request = call((err, result) => {
+      if (signal) signal.removeEventListener('abort', onabort)
+
+      if (err) reject(err)
+      else resolve(convert(result))
+    })
+
+    if (signal) signal.addEventListener('abort', onabort)
+
+    function onabort() {
+      binding.cancel(request)
+      reject(abortReason(signal))
+    }
+  })
+}
+
+// Queue a small request to be run with others issued in the same tick. Each
+// caller gets its own promise. When a pair fails, the callers before it get
+// their results, its caller gets the error and the pairs after it, which
+// never ran, are run again as a batch of their own.
+function coalesce(key, op, source, input, options) {
+  return new Promise((resolve, reject) => {
+    let batch = batches.get(key)
+
+    if (batch === undefined) {
+      batch = { op, options, pairs: [], waiters: [] }
+      batches.set(key, batch)
+      if (batches.size === 1) queueMicrotask(flush)
+    }
+
+    batch.pairs.push([source, input])
+    batch.waiters.push({ resolve, reject })
+
+    if (batch.pairs.length === COALESCE_MAX_COUNT) {
+      batches.delete(key)
+      run(batch)
+    }
+  })
+}
+
+function flush() {
+  for (const batch of batches.values()) run(batch)
+  batches.clear()
+}
+
+function run(batch) {
+  const { op, options, pairs, waiters } = batch
+
+  if (pairs.length === 1) {
+    single(op, pairs[0], options).then(waiters[0].resolve, waiters[0].reject)
+    return
+  }
+
+  const many = op === 'create' ? binding.createMany : binding.applyMany
+
+  schedule(null, (callback) => many(pairs, options, callback), toBuffers).then(
+    (results) => {
+      for (let i = 0; i < waiters.length; i++) waiters[i].resolve(results[i])
+    },
+    (err) => {
+      const { index, results } = err
+
+      // The batch failed as a whole, so it fails every caller
+      if (index === undefined) {
+        for (const waiter of waiters) waiter.reject(err)
+        return
+      }
+
+      delete err.index
+      delete err.results
+
+      for (let i = 0; i < index; i++) waiters[i].resolve(b4a.toBuffer(results[i]))
+      waiters[index].reject(err)
+
+      if (index + 1 < pairs.length) {
+        run({ op, options, pairs: pairs.slice(index + 1), waiters: waiters.slice(index + 1) })
+      }
+    }
+  )
+}
+
+function single(op, [source, input], options) {
+  const call = op === 'create' ? binding.create : binding.apply
+  const convert = options.stats ? toStatsResult : b4a.toBuffer
+  return schedule(options.signal, (callback) => call(source, input, options, callback), convert)
+}
+
+// Whether an async request is cheaper to run on the JS thread than to hand
+// to the worker pool
+function shouldInline(size, costPerByte) {
+  return size <= inlineThreshold || size * costPerByte < inlineOverhead
+}
+
+// Length of the target recorded in the compact-encoding uint that starts an
+// uncompressed delta, or -1 when the delta is compressed or the header cannot
+// be read
+function outputLength(delta) {
+  if (!isTypedArray(delta) || delta.byteLength === 0) return -1
+
+  const bytes = new Uint8Array(delta.buffer, delta.byteOffset, delta.byteLength)
+
+  if (bytes.length >= 4 && isCompressed(bytes)) return -1
+
+  const first = bytes[0]
+
+  if (first <= 0xfc) return first
+  if (first === 0xfd && bytes.length >= 3) return bytes[1] | (bytes[2] << 8)
+  if (first === 0xfe && bytes.length >= 5) return (bytes[1] | (bytes[2] << 8) | (bytes[3] << 16)) + bytes[4] * 0x1000000
+
+  return -1
+}
+
+// Whether a delta starts with the zstd or LZ4 frame magic number
+function isCompressed(bytes) {
+  return (bytes[0] === 0x28 && bytes[1] === 0xb5 && bytes[2] === 0x2f && bytes[3] === 0xfd) ||
+    (bytes[0] === 0x04 && bytes[1] === 0x22 && bytes[2] === 0x4d && bytes[3] === 0x18)
+}
+
+function isTypedArray(value) {
+  return ArrayBuffer.isView(value) && !(value instanceof DataView)
+}
+
+function byteLength(buffer) {
+  return buffer && typeof buffer.byteLength === 'number' ? buffer.byteLength : Infinity
+}
+
+function toBuffers(results) {
+  return results.map((result) => b4a.toBuffer(result))
+}
+
+// Rethrow the error of a failed createMany/applyMany call with the results of
+// the pairs before the failed one as buffers
+function toPairError(err) {
+  if (err.results) err.results = toBuffers(err.results)
+  throw err
+}
+
+// Convert the { delta, stats } or { target, stats } result of a call made
+// with the stats option
+function toStatsResult(result) {
+  const key = result.delta ? 'delta' : 'target'
+  result[key] = b4a.toBuffer(result[key])
+  return result
+}
+
+function abortReason(signal) {
+  if (signal.reason !== undefined) return signal.reason
+
+  const err = new Error('Operation was aborted')
+  err.code = 'ABORT_ERR'
+  return err
+}
 
 /**
  * Creates a binary delta between source and target buffers.
@@ -9,33 +228,62 @@ const b4a = require('b4a')
  * @param {Object} [options] - Optional delta creation options
  * @param {number} [options.hashWindowSize=16] - Hash window size (must be power of 2)
  * @param {number} [options.searchDepth=250] - Maximum search depth for matches
- * @param {boolean} [options.compressed=false] - Whether to compress the delta
- * @returns {Promise<Uint8Array>} A Promise that resolves with the delta buffer
+ * @param {boolean|string} [options.compressed=false] - Whether to compress the delta, 'zstd', 'lz4' for faster applies, or 'auto' to compress only when it pays off
+ * @param {string} [options.priority='background'] - Worker pool lane, 'interactive' or 'background'
+ * @param {AbortSignal} [options.signal] - Signal that cancels the operation when aborted
+ * @param {boolean} [options.stats=false] - Resolve with { delta, stats } carrying engine counters
+ * @returns {Promise<Uint8Array|Object>} A Promise that resolves with the delta buffer
  */
 async function create(source, target, options = {}) {
-  return new Promise((resolve, reject) => {
-    binding.create(source, target, options, (err, result) => {
-      if (err) reject(err)
-      else resolve(b4a.toBuffer(result))
-    })
-  })
+  const size = byteLength(source) + byteLength(target)
+
+  if (options.signal && options.signal.aborted) throw abortReason(options.signal)
+
+  if (shouldInline(size, CREATE_COST_PER_BYTE)) {
+    inlined++
+    return createSync(source, target, options)
+  }
+
+  if (size <= COALESCE_MAX_BYTES && !options.signal && !options.stats) {
+    const { hashWindowSize, searchDepth, compressed, priority } = options
+    return coalesce(`create:${hashWindowSize}:${searchDepth}:${compressed}:${priority}`, 'create', source, target, options)
+  }
+
+  return single('create', [source, target], options)
 }
 
 /**
  * Applies a binary delta to a source buffer to recreate the target.
- * Automatically detects if the delta is zstd compressed.
+ * Automatically detects if the delta is zstd or LZ4 compressed.
  * 
  * @param {Uint8Array} source - The source/original buffer
  * @param {Uint8Array} delta - The delta buffer created by create()
- * @returns {Promise<Uint8Array>} A Promise that resolves with the target buffer
+ * @param {Object} [options] - Optional scheduling options
+ * @param {string} [options.priority='interactive'] - Worker pool lane, 'interactive' or 'background'
+ * @param {AbortSignal} [options.signal] - Signal that cancels the operation when aborted
+ * @param {boolean} [options.stats=false] - Resolve with { target, stats } carrying engine counters
+ * @returns {Promise<Uint8Array|Object>} A Promise that resolves with the target buffer
  */
-async function apply(source, delta) {
-  return new Promise((resolve, reject) => {
-    binding.apply(source, delta, (err, result) => {
-      if (err) reject(err)
-      else resolve(b4a.toBuffer(result))
-    })
-  })
+async function apply(source, delta, options = {}) {
+  const size = byteLength(source) + byteLength(delta)
+
+  if (options.signal && options.signal.aborted) throw abortReason(options.signal)
+
+  // A small delta can expand into a large target, so the cost counts the
+  // target too. Compressed deltas, whose target length is not known without
+  // decompressing, always leave the JS thread.
+  const output = outputLength(delta)
+
+  if (output !== -1 && shouldInline(size + output, APPLY_COST_PER_BYTE)) {
+    inlined++
+    return applySync(source, delta, options)
+  }
+
+  if (size <= COALESCE_MAX_BYTES && !options.signal && !options.stats) {
+    return coalesce(`apply:${options.priority}`, 'apply', source, delta, options)
+  }
+
+  return single('apply', [source, delta], options)
 }
 
 /**
@@ -46,46 +294,48 @@ async function apply(source, delta) {
  * @param {Object} [options] - Optional delta creation options
  * @param {number} [options.hashWindowSize=16] - Hash window size (must be power of 2)
  * @param {number} [options.searchDepth=250] - Maximum search depth for matches
- * @param {boolean} [options.compressed=false] - Whether to compress the delta
- * @returns {Uint8Array} The delta buffer
+ * @param {boolean|string} [options.compressed=false] - Whether to compress the delta, 'zstd', 'lz4' for faster applies, or 'auto' to compress only when it pays off
+ * @param {boolean} [options.stats=false] - Return { delta, stats } carrying engine counters
+ * @returns {Uint8Array|Object} The delta buffer
  */
 function createSync(source, target, options = {}) {
   const result = binding.createSync(source, target, options);
-  return b4a.toBuffer(result);
+  return options.stats ? toStatsResult(result) : b4a.toBuffer(result);
 }
 
 /**
  * Applies a binary delta to a source buffer to recreate the target (synchronous).
- * Automatically detects if the delta is zstd compressed.
+ * Automatically detects if the delta is zstd or LZ4 compressed.
  * 
  * @param {Uint8Array} source - The source/original buffer
  * @param {Uint8Array} delta - The delta buffer created by create()
- * @returns {Uint8Array} The target buffer
+ * @param {Object} [options] - Optional options
+ * @param {boolean} [options.stats=false] - Return { target, stats } carrying engine counters
+ * @returns {Uint8Array|Object} The target buffer
  */
-function applySync(source, delta) {
-  return b4a.toBuffer(binding.applySync(source, delta))
+function applySync(source, delta, options = {}) {
+  const result = binding.applySync(source, delta, options)
+  return options.stats ? toStatsResult(result) : b4a.toBuffer(result)
 }
 
 /**
  * Applies multiple binary deltas sequentially to a source buffer.
- * Automatically detects if each delta is zstd compressed.
+ * Automatically detects if each delta is zstd or LZ4 compressed.
  * 
  * @param {Uint8Array} source - The source/original buffer
  * @param {Uint8Array[]} deltas - Array of delta buffers to apply in sequence
+ * @param {Object} [options] - Optional scheduling options
+ * @param {string} [options.priority='interactive'] - Worker pool lane, 'interactive' or 'background'
+ * @param {AbortSignal} [options.signal] - Signal that cancels the operation when aborted
  * @returns {Promise<Uint8Array>} A Promise that resolves with the final target buffer
  */
-async function applyBatch(source, deltas) {
-  return new Promise((resolve, reject) => {
-    binding.applyBatch(source, deltas, (err, result) => {
-      if (err) reject(err)
-      else resolve(b4a.toBuffer(result))
-    })
-  })
+async function applyBatch(source, deltas, options = {}) {
+  return schedule(options.signal, (callback) => binding.applyBatch(source, deltas, options, callback))
 }
 
 /**
  * Applies multiple binary deltas sequentially to a source buffer (synchronous).
- * Automatically detects if each delta is zstd compressed.
+ * Automatically detects if each delta is zstd or LZ4 compressed.
  * 
  * @param {Uint8Array} source - The source/original buffer
  * @param {Uint8Array[]} deltas - Array of delta buffers to apply in sequence
@@ -95,11 +345,599 @@ function applyBatchSync(source, deltas) {
   return b4a.toBuffer(binding.applyBatchSync(source, deltas))
 }
 
+/**
+ * Creates deltas for many independent (source, target) pairs in a single
+ * worker pool request. Much cheaper than calling create() per pair when the
+ * buffers are small.
+ *
+ * @param {Array<[Uint8Array, Uint8Array]>} pairs - Array of [source, target] pairs
+ * @param {Object} [options] - Optional delta creation options, shared by every pair
+ * @param {number} [options.hashWindowSize=16] - Hash window size (must be power of 2)
+ * @param {number} [options.searchDepth=250] - Maximum search depth for matches
+ * @param {boolean|string} [options.compressed=false] - Whether to compress the deltas, 'zstd', 'lz4' for faster applies, or 'auto' to compress only when it pays off
+ * @param {string} [options.priority='background'] - Worker pool lane, 'interactive' or 'background'
+ * @param {AbortSignal} [options.signal] - Signal that cancels the operation when aborted
+ * @returns {Promise<Uint8Array[]>} A Promise that resolves with one delta per pair
+ */
+async function createMany(pairs, options = {}) {
+  return schedule(options.signal, (callback) => binding.createMany(pairs, options, callback), toBuffers).catch(toPairError)
+}
+
+/**
+ * Applies many independent (source, delta) pairs in a single worker pool
+ * request. Automatically detects if each delta is zstd or LZ4 compressed.
+ *
+ * @param {Array<[Uint8Array, Uint8Array]>} pairs - Array of [source, delta] pairs
+ * @param {Object} [options] - Optional scheduling options
+ * @param {string} [options.priority='interactive'] - Worker pool lane, 'interactive' or 'background'
+ * @param {AbortSignal} [options.signal] - Signal that cancels the operation when aborted
+ * @returns {Promise<Uint8Array[]>} A Promise that resolves with one target per pair
+ */
+async function applyMany(pairs, options = {}) {
+  return schedule(options.signal, (callback) => binding.applyMany(pairs, options, callback), toBuffers).catch(toPairError)
+}
+
+/**
+ * Creates deltas for many independent (source, target) pairs (synchronous).
+ *
+ * @param {Array<[Uint8Array, Uint8Array]>} pairs - Array of [source, target] pairs
+ * @param {Object} [options] - Optional delta creation options, shared by every pair
+ * @returns {Uint8Array[]} One delta per pair
+ */
+function createManySync(pairs, options = {}) {
+  try {
+    return toBuffers(binding.createManySync(pairs, options))
+  } catch (err) {
+    toPairError(err)
+  }
+}
+
+/**
+ * Applies many independent (source, delta) pairs (synchronous).
+ *
+ * @param {Array<[Uint8Array, Uint8Array]>} pairs - Array of [source, delta] pairs
+ * @returns {Uint8Array[]} One target per pair
+ */
+function applyManySync(pairs) {
+  try {
+    return toBuffers(binding.applyManySync(pairs))
+  } catch (err) {
+    toPairError(err)
+  }
+}
+
+/**
+ * Compiles delta creation options into a number that createInto() accepts,
+ * so hot loops skip option parsing on every call.
+ *
+ * @param {Object} [options] - Delta creation options, as for createSync()
+ * @returns {number} The compiled options
+ */
+function compileOptions(options = {}) {
+  return binding.compileOptions(options)
+}
+
+/**
+ * Returns the output size that lets createInto() write an uncompressed delta
+ * for a target of the given length in place.
+ *
+ * @param {number} targetLength - Length of the target buffer
+ * @returns {number} The output buffer size
+ */
+function createBound(targetLength) {
+  return targetLength + CREATE_OVERHEAD
+}
+
+/**
+ * Creates a binary delta directly into a caller-provided buffer (synchronous).
+ * Uses a typed fast call where the engine supports it.
+ *
+ * @param {Uint8Array} source - The source/original buffer
+ * @param {Uint8Array} target - The target/modified buffer
+ * @param {Uint8Array} out - The buffer to write the delta into
+ * @param {number} [compiled] - Options compiled by compileOptions()
+ * @returns {number} The number of bytes written to out
+ */
+function createInto(source, target, out, compiled = DEFAULT_COMPILED_OPTIONS) {
+  if (!isTypedArray(source) || !isTypedArray(target) || !isTypedArray(out)) {
+    throw new TypeError('source, target and out must be Buffers or TypedArrays')
+  }
+
+  const len = binding.createInto(source, target, out, compiled >>> 0)
+  if (len < 0) throw intoError(len, 'Failed to create delta')
+  return len
+}
+
+/**
+ * Applies a binary delta directly into a caller-provided buffer (synchronous).
+ * Uses a typed fast call where the engine supports it. Automatically detects
+ * if the delta is zstd or LZ4 compressed.
+ *
+ * @param {Uint8Array} source - The source/original buffer
+ * @param {Uint8Array} delta - The delta buffer created by create()
+ * @param {Uint8Array} out - The buffer to write the target into
+ * @returns {number} The number of bytes written to out
+ */
+function applyInto(source, delta, out) {
+  if (!isTypedArray(source) || !isTypedArray(delta) || !isTypedArray(out)) {
+    throw new TypeError('source, delta and out must be Buffers or TypedArrays')
+  }
+
+  const len = binding.applyInto(source, delta, out)
+  if (len < 0) throw intoError(len, 'Failed to apply delta')
+  return len
+}
+
+function intoError(code, message) {
+  if (code === OUT_OF_RANGE) return new RangeError('out is too small')
+  return new Error(message)
+}
+
+/**
+ * Creates deltas with options, a hash table, compression contexts and scratch
+ * memory kept between calls, so steady-state workloads stop allocating on
+ * every call. Async calls on one encoder run one at a time, in order.
+ */
+class Encoder {
+  /**
+   * @param {Object} [options] - Delta creation options, as for createSync()
+   */
+  constructor(options = {}) {
+    this._handle = binding.codecInit(options)
+  }
+
+  /**
+   * @param {Uint8Array} source - The source/original buffer
+   * @param {Uint8Array} target - The target/modified buffer
+   * @param {Object} [options] - Optional scheduling options
+   * @param {string} [options.priority='background'] - Worker pool lane, 'interactive' or 'background'
+   * @param {AbortSignal} [options.signal] - Signal that cancels the operation when aborted
+   * @returns {Promise<Uint8Array>} A Promise that resolves with the delta buffer
+   */
+  async create(source, target, options = {}) {
+    return schedule(options.signal, (callback) => binding.encoderCreate(this._handle, source, target, options, callback))
+  }
+
+  /**
+   * @param {Uint8Array} source - The source/original buffer
+   * @param {Uint8Array} target - The target/modified buffer
+   * @returns {Uint8Array} The delta buffer
+   */
+  createSync(source, target) {
+    return b4a.toBuffer(binding.encoderCreateSync(this._handle, source, target))
+  }
+
+  /**
+   * @param {Uint8Array} source - The source/original buffer
+   * @param {Uint8Array} target - The target/modified buffer
+   * @param {Uint8Array} out - The buffer to write the delta into
+   * @returns {number} The number of bytes written to out
+   */
+  createInto(source, target, out) {
+    const len = binding.encoderCreateInto(this._handle, source, target, out)
+    if (len < 0) throw intoError(len, 'Failed to create delta')
+    return len
+  }
+}
+
+/**
+ * Applies deltas with decompression contexts and scratch memory kept between
+ * calls. Async calls on one decoder run one at a time, in order.
+ */
+class Decoder {
+  constructor() {
+    this._handle = binding.codecInit()
+  }
+
+  /**
+   * @param {Uint8Array} source - The source/original buffer
+   * @param {Uint8Array} delta - The delta buffer
+   * @param {Object} [options] - Optional scheduling options
+   * @param {string} [options.priority='interactive'] - Worker pool lane, 'interactive' or 'background'
+   * @param {AbortSignal} [options.signal] - Signal that cancels the operation when aborted
+   * @returns {Promise<Uint8Array>} A Promise that resolves with the target buffer
+   */
+  async apply(source, delta, options = {}) {
+    return schedule(options.signal, (callback) => binding.decoderApply(this._handle, source, delta, options, callback))
+  }
+
+  /**
+   * @param {Uint8Array} source - The source/original buffer
+   * @param {Uint8Array} delta - The delta buffer
+   * @returns {Uint8Array} The target buffer
+   */
+  applySync(source, delta) {
+    return b4a.toBuffer(binding.decoderApplySync(this._handle, source, delta))
+  }
+
+  /**
+   * @param {Uint8Array} source - The source/original buffer
+   * @param {Uint8Array} delta - The delta buffer
+   * @param {Uint8Array} out - The buffer to write the target into
+   * @returns {number} The number of bytes written to out
+   */
+  applyInto(source, delta, out) {
+    const len = binding.decoderApplyInto(this._handle, source, delta, out)
+    if (len < 0) throw intoError(len, 'Failed to apply delta')
+    return len
+  }
+}
+
+/**
+ * Duplex stream that reads target bytes and writes delta bytes, created by
+ * createStream().
+ */
+class CreateStream extends Duplex {
+  constructor(source, length, options) {
+    super()
+
+    this._source = source
+    this._handle = binding.createStreamInit(source, length, options)
+    this._callback = null
+  }
+
+  _write(data, cb) {
+    this._emit(data, false, cb)
+  }
+
+  _final(cb) {
+    this._emit(EMPTY, true, cb)
+  }
+
+  _read(cb) {
+    // The reader caught up, so take the next piece of target
+    const callback = this._callback
+    this._callback = null
+    if (callback !== null) callback(null)
+    cb(null)
+  }
+
+  _emit(data, final, cb) {
+    let delta
+    try {
+      delta = binding.createStreamWrite(this._handle, this._source, data, final)
+    } catch (err) {
+      cb(err)
+      return
+    }
+
+    const drained = delta.byteLength === 0 || this.push(b4a.toBuffer(delta))
+
+    if (final) this.push(null)
+
+    if (drained || final) cb(null)
+    else this._callback = cb
+  }
+}
+
+/**
+ * Duplex stream that reads delta bytes and writes target bytes, created by
+ * applyStream().
+ */
+class ApplyStream extends Duplex {
+  constructor(source) {
+    super()
+
+    this._source = source
+    this._handle = binding.applyStreamInit()
+    this._out = b4a.allocUnsafe(STREAM_CHUNK_SIZE)
+    this._pending = null
+    this._callback = null
+  }
+
+  _write(data, cb) {
+    this._pending = data
+    this._callback = cb
+    this._continue()
+  }
+
+  _final(cb) {
+    if (!binding.applyStreamDone(this._handle)) {
+      cb(new Error('Delta ended before the target was complete'))
+      return
+    }
+
+    this.push(null)
+    cb(null)
+  }
+
+  _read(cb) {
+    if (this._callback !== null) this._continue()
+    cb(null)
+  }
+
+  // Decode the pending chunk one output slice at a time, pausing whenever the
+  // readable side is full
+  _continue() {
+    let drained = true
+
+    while (drained && this._pending !== null) {
+      let consumed, written
+      try {
+        [consumed, written] = binding.applyStreamWrite(this._handle, this._source, this._pending, this._out)
+      } catch (err) {
+        this._pending = null
+        this._finish(err)
+        return
+      }
+
+      // Bytes after the end of the delta are ignored, as by apply()
+      if (consumed === this._pending.byteLength || (consumed === 0 && written === 0)) {
+        this._pending = null
+      } else {
+        this._pending = this._pending.subarray(consumed)
+      }
+
+      if (written > 0) drained = this.push(b4a.from(this._out.subarray(0, written)))
+    }
+
+    if (drained) this._finish(null)
+  }
+
+  _finish(err) {
+    const callback = this._callback
+    this._callback = null
+    callback(err)
+  }
+}
+
+/**
+ * Creates a delta from a target written to the returned stream piecewise.
+ * The delta is read from the stream as it is produced, so the target never
+ * has to be held in memory whole.
+ *
+ * @param {Uint8Array} source - The source/original buffer
+ * @param {Object} options - Stream options
+ * @param {number} options.length - Length of the target in bytes
+ * @param {number} [options.hashWindowSize=16] - Hash window size (must be power of 2)
+ * @param {number} [options.searchDepth=250] - Maximum search depth for matches
+ * @returns {Duplex} A stream taking target bytes and producing delta bytes
+ */
+function createStream(source, options = {}) {
+  const { length, compressed = false } = options
+
+  if (!Number.isInteger(length) || length < 0 || length > 0xffffffff) {
+    throw new TypeError('length must be the target length in bytes')
+  }
+
+  if (compressed) {
+    throw new TypeError('Compressed deltas cannot be streamed')
+  }
+
+  return new CreateStream(source, length, options)
+}
+
+/**
+ * Applies a delta written to the returned stream piecewise. The target is
+ * read from the stream as it is produced, in chunks of at most 64 KiB.
+ *
+ * @param {Uint8Array} source - The source/original buffer
+ * @returns {Duplex} A stream taking delta bytes and producing target bytes
+ */
+function applyStream(source) {
+  return new ApplyStream(source)
+}
+
+/**
+ * A create or apply run on the calling thread in slices, returned by
+ * createIncremental() and applyIncremental().
+ */
+class Incremental {
+  constructor(handle, source, input) {
+    this._handle = handle
+    this._source = source
+    this._input = input
+    this.done = false
+  }
+
+  /**
+   * Advances the operation by up to budget bytes of its current phase. A
+   * create indexes the source, encodes the target and compresses the delta
+   * if asked to; an apply decompresses a compressed delta and writes the
+   * output.
+   *
+   * @param {number} [budget] - Bytes to handle in this step (default 65536)
+   * @returns {Buffer|null} The result once the operation completes, otherwise null
+   */
+  step(budget = STEP_BUDGET_DEFAULT) {
+    if (!Number.isInteger(budget) || budget < 1 || budget > 0xffffffff) {
+      throw new TypeError('budget must be a positive integer')
+    }
+
+    const result = binding.incrementalStep(this._handle, this._source, this._input, budget)
+    if (result === null) return null
+
+    this.done = true
+    return b4a.toBuffer(result)
+  }
+}
+
+/**
+ * Starts creating a delta that advances only when step() is called, for
+ * targets without worker threads that must not block the event loop for a
+ * whole diff. The buffers must stay unchanged until the delta is complete.
+ *
+ * @param {Uint8Array} source - The source/original buffer
+ * @param {Uint8Array} target - The target/modified buffer
+ * @param {Object} [options] - Delta creation options, as for createSync()
+ * @returns {Incremental} The operation
+ */
+function createIncremental(source, target, options = {}) {
+  return new Incremental(binding.createIncrementalInit(source, target, options), source, target)
+}
+
+/**
+ * Starts applying a delta that advances only when step() is called. The
+ * buffers must stay unchanged until the target is complete.
+ *
+ * @param {Uint8Array} source - The source/original buffer
+ * @param {Uint8Array} delta - The delta buffer
+ * @returns {Incremental} The operation
+ */
+function applyIncremental(source, delta) {
+  return new Incremental(binding.applyIncrementalInit(delta), source, delta)
+}
+
+/**
+ * Configures the worker pool used by the async API.
+ *
+ * @param {Object} options - Pool options
+ * @param {number} [options.threads] - Number of worker threads; 0 runs every async request on the JS thread (default 2)
+ * @param {number} [options.queueLimit] - Maximum number of queued requests before new ones are rejected (default 4096)
+ * @param {number} [options.inlineThreshold] - Input size in bytes up to which async requests run inline; 0 disables (default 1024)
+ * @param {number} [options.inlineOverhead] - Estimated worker pool round trip in nanoseconds; requests estimated to cost less run inline; 0 disables (default 20000)
+ * @param {number} [options.maxInFlight] - Maximum number of async requests running at once (default Infinity)
+ * @param {number} [options.maxInFlightBytes] - Maximum estimated memory held by running async requests (default Infinity)
+ * @param {string} [options.overload] - Whether requests beyond the limits 'wait' for admission or are rejected with 'reject' (default 'wait')
+ */
+function configure(options = {}) {
+  const {
+    threads,
+    queueLimit,
+    inlineThreshold: threshold = inlineThreshold,
+    inlineOverhead: overhead = inlineOverhead,
+    maxInFlight: inFlight = maxInFlight,
+    maxInFlightBytes: inFlightBytes = maxInFlightBytes,
+    overload: policy = overload
+  } = options
+
+  if (threads !== undefined && (!Number.isInteger(threads) || threads < 0)) {
+    throw new TypeError('threads must be a non-negative integer')
+  }
+
+  if (queueLimit !== undefined && (!Number.isInteger(queueLimit) || queueLimit < 1)) {
+    throw new TypeError('queueLimit must be a positive integer')
+  }
+
+  if (!Number.isInteger(threshold) || threshold < 0) {
+    throw new TypeError('inlineThreshold must be a non-negative integer')
+  }
+
+  if (typeof overhead !== 'number' || !(overhead >= 0)) {
+    throw new TypeError('inlineOverhead must be a non-negative number')
+  }
+
+  if (inFlight !== Infinity && (!Number.isInteger(inFlight) || inFlight < 1 || inFlight > 0xffffffff)) {
+    throw new TypeError('maxInFlight must be a positive integer or Infinity')
+  }
+
+  if (inFlightBytes !== Infinity && (!Number.isInteger(inFlightBytes) || inFlightBytes < 1)) {
+    throw new TypeError('maxInFlightBytes must be a positive integer or Infinity')
+  }
+
+  if (policy !== 'wait' && policy !== 'reject') {
+    throw new TypeError("overload must be 'wait' or 'reject'")
+  }
+
+  binding.configure(threads === undefined ? -1 : threads, queueLimit === undefined ? -1 : queueLimit)
+  binding.configureAdmission(
+    inFlight === Infinity ? 0 : inFlight,
+    inFlightBytes === Infinity ? 0 : inFlightBytes,
+    policy === 'reject'
+  )
+
+  inlineThreshold = threshold
+  inlineOverhead = overhead
+  maxInFlight = inFlight
+  maxInFlightBytes = inFlightBytes
+  overload = policy
+}
+
+/**
+ * Returns a snapshot of the worker pool, with request counts and queue wait
+ * times in milliseconds for the interactive and background lanes, the
+ * requests running and waiting for admission with their estimated bytes, and
+ * the number of async requests that ran inline instead.
+ *
+ * @returns {Object} Worker pool statistics
+ */
+function stats() {
+  const result = binding.stats()
+  result.inlined = inlined
+  return result
+}
+
+/**
+ * Estimates the cost of creating a delta without running it: the peak
+ * memory create allocates beyond its inputs, the largest delta it can return
+ * and the approximate CPU time in milliseconds.
+ *
+ * @param {number} sourceLength - Length of the source buffer
+ * @param {number} targetLength - Length of the target buffer
+ * @param {Object} [options] - Delta creation options, as for create()
+ * @returns {Object} { peakMemory, maxDeltaLength, cpuTime }
+ */
+function estimate(sourceLength, targetLength, options = {}) {
+  if (!Number.isInteger(sourceLength) || sourceLength < 0) {
+    throw new TypeError('sourceLength must be a non-negative integer')
+  }
+
+  if (!Number.isInteger(targetLength) || targetLength < 0) {
+    throw new TypeError('targetLength must be a non-negative integer')
+  }
+
+  const result = binding.estimate(sourceLength, targetLength, options)
+
+  let cost = (sourceLength + targetLength) * CREATE_COST_PER_BYTE
+  if (options.compressed) cost += targetLength * COMPRESS_COST_PER_BYTE
+
+  result.cpuTime = cost / 1e6
+  return result
+}
+
+/**
+ * Estimates the cost of applying a delta from its header: the peak memory
+ * apply allocates, the length of the target and of the uncompressed delta,
+ * whether it is compressed and the approximate CPU time in milliseconds.
+ *
+ * @param {Uint8Array} delta - The delta buffer created by create()
+ * @returns {Object} { peakMemory, targetLength, deltaLength, compressed, cpuTime }
+ */
+function estimateApply(delta) {
+  const result = binding.estimateApply(delta)
+
+  let cost = (result.targetLength + result.deltaLength) * APPLY_COST_PER_BYTE
+  if (result.compressed) cost += result.deltaLength * DECOMPRESS_COST_PER_BYTE
+
+  result.cpuTime = cost / 1e6
+  return result
+}
+
+/**
+ * Returns cumulative counters for the whole process: operations by type,
+ * bytes in and out, failures by error code, and the queue wait, execution and
+ * total latency of operations in milliseconds.
+ *
+ * @returns {Object} Process-wide metrics
+ */
+function metrics() {
+  return binding.metrics()
+}
+
 module.exports = {
   create,
   apply,
   createSync,
   applySync,
   applyBatch,
-  applyBatchSync
+  applyBatchSync,
+  createMany,
+  applyMany,
+  createManySync,
+  applyManySync,
+  compileOptions,
+  createBound,
+  createInto,
+  applyInto,
+  Encoder,
+  Decoder,
+  createStream,
+  applyStream,
+  createIncremental,
+  applyIncremental,
+  estimate,
+  estimateApply,
+  configure,
+  stats,
+  metrics
 }
\ No newline at end of file
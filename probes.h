@@ -0,0 +1,33 @@
+#ifndef BARE_DELTA_PROBES_H
+#define BARE_DELTA_PROBES_H
+
+/*
+** USDT tracepoints of the engine and binding, under the bare_delta
+** provider.  They are compiled in when the build defines DELTA_USDT, which
+** the BARE_DELTA_USDT CMake option does on systems with <sys/sdt.h>, and
+** expand to nothing otherwise.  An unattached probe costs a single nop, so
+** they can stay enabled in production builds and be listed with
+**
+**   bpftrace -l 'usdt:/path/to/bare-delta.bare:bare_delta:*'
+**
+** The probes are defined with <sys/sdt.h> alone, with no dtrace -G step to
+** turn a double underscore into a dash, so they are attached by the names
+** written here, such as create__start.
+*/
+#ifdef DELTA_USDT
+
+#include <sys/sdt.h>
+
+#define DELTA_PROBE1(name, a) DTRACE_PROBE1(bare_delta, name, a)
+#define DELTA_PROBE2(name, a, b) DTRACE_PROBE2(bare_delta, name, a, b)
+#define DELTA_PROBE3(name, a, b, c) DTRACE_PROBE3(bare_delta, name, a, b, c)
+
+#else
+
+#define DELTA_PROBE1(name, a) do {} while (0)
+#define DELTA_PROBE2(name, a, b) do {} while (0)
+#define DELTA_PROBE3(name, a, b, c) do {} while (0)
+
+#endif
+
+#endif // BARE_DELTA_PROBES_H
@@ -0,0 +1,79 @@
+// The checks are the test, so they stay in release builds too
+#undef NDEBUG
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <delta.h>
+
+// Engine allocations go through the installed hooks, and back to the C
+// library once the hooks are removed
+
+static size_t allocations;
+static size_t releases;
+
+static void *
+counting_malloc(size_t size) {
+  allocations++;
+  return malloc(size);
+}
+
+static void
+counting_free(void *ptr) {
+  releases++;
+  free(ptr);
+}
+
+static void
+roundtrip(size_t len) {
+  char *source = malloc(len);
+  char *target = malloc(len);
+  char *delta = malloc(len + 1024);
+  char *output = malloc(len + 1);
+
+  for (size_t i = 0; i < len; i++) source[i] = (char) (i * 7 + i / 251);
+  memcpy(target, source, len);
+  for (size_t i = 0; i < len; i += 97) target[i] ^= 0x5a;
+
+  int delta_len = delta_create(source, len, target, len, delta);
+  assert(delta_len > 0);
+
+  int output_len = delta_apply(source, len, delta, delta_len, output);
+  assert(output_len == (int) len);
+  assert(memcmp(output, target, len) == 0);
+
+  free(source);
+  free(target);
+  free(delta);
+  free(output);
+}
+
+int
+main() {
+  delta_allocator allocator = {counting_malloc, counting_free};
+  delta_set_allocator(&allocator);
+
+  roundtrip(64 * 1024);
+
+  assert(allocations > 0);
+
+  // Only the hash table kept by the thread cache is still out
+  assert(allocations - releases == 1);
+
+  delta_release_thread_cache();
+
+  assert(allocations == releases);
+
+  delta_set_allocator(NULL);
+
+  size_t before = allocations;
+
+  roundtrip(64 * 1024);
+
+  assert(allocations == before);
+
+  delta_release_thread_cache();
+
+  return 0;
+}
@@ -237,7 +237,196 @@ function mutateData(original, mutationType, mutationSize = 0.1) {
   }
 }
 
+// AbortController, falling back to a minimal stand-in on runtimes without one
+function createAbortController() {
+  if (typeof AbortController === 'function') return new AbortController()
+
+  const listeners = new Set()
+  const signal = {
+    aborted: false,
+    reason: undefined,
+    addEventListener(name, fn) {
+      if (name === 'abort') listeners.add(fn)
+    },
+    removeEventListener(name, fn) {
+      listeners.delete(fn)
+    }
+  }
+
+  return {
+    signal,
+    abort(reason = new Error('This operation was aborted')) {
+      if (signal.aborted) return
+      signal.aborted = true
+      signal.reason = reason
+      for (const fn of listeners) fn()
+    }
+  }
+}
+
+// Build the inputs of a recipe from test/fixtures/worst-case.json exactly as
+// bench/bench_worstcase.c does, with no buffer longer than max bytes.
+// Returns { source, target } for create recipes and { source, delta } for
+// apply recipes.
+function buildRecipe(recipe, max) {
+  const source = buildSegments(recipe.source, max, null)
+
+  if (recipe.target) return { source, target: buildSegments(recipe.target, max, source) }
+
+  return { source, delta: buildDelta(recipe.delta, max, source) }
+}
+
+function buildSegments(segments, max, source) {
+  const out = b4a.alloc(max)
+  let len = 0
+
+  for (const segment of segments) {
+    if (len >= max) break
+
+    let count = Math.min(segment.length, max - len)
+
+    if (segment.fill !== undefined) {
+      out.fill(segment.fill, len, len + count)
+    } else if (segment.pattern !== undefined) {
+      const pattern = b4a.from(segment.pattern, 'hex')
+      for (let i = 0; i < count; i++) out[len + i] = pattern.length ? pattern[i % pattern.length] : 0
+    } else if (segment.random !== undefined) {
+      let x = segment.random || 1
+      for (let i = 0; i < count; i++) {
+        x = (x ^ (x << 13)) >>> 0
+        x = (x ^ (x >>> 17)) >>> 0
+        x = (x ^ (x << 5)) >>> 0
+        out[len + i] = x >>> 24
+      }
+    } else if (source === null || source.length === 0) {
+      count = 0
+    } else {
+      const offset = segment.source % source.length
+      count = Math.min(count, source.length - offset)
+      source.copy(out, len, offset, offset + count)
+    }
+
+    len += count
+  }
+
+  return out.subarray(0, len)
+}
+
+// The compact-encoding uint the delta format uses
+function encodeInt(value, out) {
+  if (value <= 0xfc) return out.push(value)
+  if (value <= 0xffff) return out.push(0xfd, value & 0xff, value >>> 8)
+  out.push(0xfe, value & 0xff, (value >>> 8) & 0xff, (value >>> 16) & 0xff, value >>> 24)
+}
+
+function buildDelta({ rounds, ops }, max, source) {
+  const commands = []
+  const target = b4a.alloc(max)
+  let total = 0
+  let full = false
+
+  for (let r = 0; r < rounds && !full; r++) {
+    for (const op of ops) {
+      if (full) break
+
+      const copy = op.copy !== undefined
+      if (copy && source.length === 0) continue
+
+      for (let k = 0; k < op.repeat; k++) {
+        if (total >= max || commands.length + 16 > max) {
+          full = true
+          break
+        }
+
+        let count = Math.min(copy ? op.copy : op.insert, max - total)
+
+        if (copy) {
+          const offset = op.offset % source.length
+          count = Math.min(count, source.length - offset)
+
+          encodeInt(count, commands)
+          commands.push(0x40) // '@'
+          encodeInt(offset, commands)
+          commands.push(0x2c) // ','
+          source.copy(target, total, offset, offset + count)
+        } else {
+          if (commands.length + count + 16 > max) {
+            full = true
+            break
+          }
+
+          encodeInt(count, commands)
+          commands.push(0x3a) // ':'
+          for (let i = 0; i < count; i++) commands.push(op.byte)
+          target.fill(op.byte, total, total + count)
+        }
+
+        total += count
+      }
+    }
+  }
+
+  // The big-endian word sum of the target
+  let checksum = 0
+  for (let i = 0; i < total; i++) checksum = (checksum + ((target[i] << (24 - 8 * (i & 3))) >>> 0)) >>> 0
+
+  const header = []
+  encodeInt(total, header)
+
+  const trailer = []
+  encodeInt(checksum, trailer)
+  trailer.push(0x3b) // ';'
+
+  return b4a.concat([b4a.from(header), b4a.from(commands), b4a.from(trailer)])
+}
+
+// Time a fixture of test/fixtures/worst-case.json and its baseline, the
+// fastest of runs runs each, with the create and apply of the module under
+// test. Creates are costed per target byte and applies per byte of delta and
+// output, as bench/bench_worstcase.c records them. Returns nanoseconds per
+// byte as { ns, baseNs }.
+function measureRecipe(fixture, size, { createSync, applySync }, options, runs) {
+  const process = require('bare-process')
+
+  function fastest(fn) {
+    let best = Infinity
+    for (let i = 0; i < runs; i++) {
+      const start = process.hrtime.bigint()
+      fn()
+      best = Math.min(best, Number(process.hrtime.bigint() - start))
+    }
+    return best
+  }
+
+  const baseline = buildRecipe(fixture.baseline, size)
+  const baseDiff = createSync(baseline.source, baseline.target, options)
+
+  if (fixture.op === 'create') {
+    const { source, target } = buildRecipe(fixture, size)
+
+    if (!b4a.equals(applySync(source, createSync(source, target, options)), target)) {
+      throw new Error(`${fixture.name} does not round-trip`)
+    }
+
+    return {
+      ns: fastest(() => createSync(source, target, options)) / target.length,
+      baseNs: fastest(() => createSync(baseline.source, baseline.target, options)) / baseline.target.length
+    }
+  }
+
+  const { source, delta } = buildRecipe(fixture, size)
+  const length = applySync(source, delta).length
+
+  return {
+    ns: fastest(() => applySync(source, delta)) / (delta.length + length),
+    baseNs: fastest(() => applySync(baseline.source, baseDiff)) / (baseDiff.length + baseline.target.length)
+  }
+}
+
 module.exports = {
   generateTestData,
-  mutateData
+  mutateData,
+  createAbortController,
+  buildRecipe,
+  measureRecipe
 }
\ No newline at end of file
@@ -0,0 +1,81 @@
+// The checks are the test, so they stay in release builds too
+#undef NDEBUG
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <delta.h>
+
+// The hash table of the last delta is kept per thread and reused by the
+// next one, unless it is larger than the cache cap
+
+static size_t allocations;
+static size_t releases;
+
+static void *
+counting_malloc(size_t size) {
+  allocations++;
+  return malloc(size);
+}
+
+static void
+counting_free(void *ptr) {
+  releases++;
+  free(ptr);
+}
+
+// Create a delta from a source of len bytes
+static void
+create(size_t len) {
+  char *source = malloc(len);
+  char target[4096];
+  char delta[4096 + 1024];
+
+  for (size_t i = 0; i < len; i++) source[i] = (char) (i * 13 + i / 509);
+  memcpy(target, source + len / 2, sizeof(target));
+
+  int delta_len = delta_create(source, len, target, sizeof(target), delta);
+  assert(delta_len > 0);
+
+  free(source);
+}
+
+int
+main() {
+  delta_allocator allocator = {counting_malloc, counting_free};
+  delta_set_allocator(&allocator);
+
+  // The first delta fills the cache
+  create(256 * 1024);
+  assert(allocations == 1);
+  assert(releases == 0);
+
+  // Deltas whose table fits in the cached one do not allocate
+  create(256 * 1024);
+  create(64 * 1024);
+  assert(allocations == 1);
+  assert(releases == 0);
+
+  // A larger table replaces the cached one
+  create(1024 * 1024);
+  assert(allocations == 2);
+  assert(releases == 1);
+
+  // A table over the 4 MiB cap is allocated and released per delta, and
+  // leaves the cached one in place
+  create(16 * 1024 * 1024);
+  assert(allocations == 3);
+  assert(releases == 2);
+
+  create(1024 * 1024);
+  assert(allocations == 3);
+  assert(releases == 2);
+
+  delta_release_thread_cache();
+  assert(allocations == releases);
+
+  delta_set_allocator(NULL);
+
+  return 0;
+}
@@ -1,7 +1,7 @@
 const test = require('brittle')
 const b4a = require('b4a')
 const delta = require('../index')
-const { generateTestData, mutateData } = require('./helpers')
+const { generateTestData, mutateData, createAbortController, measureRecipe } = require('./helpers')
 
 const { create, apply, createSync, applySync, applyBatch, applyBatchSync } = delta
 
@@ -783,3 +783,864 @@ test('batch apply - auto-detection of mixed compressed/uncompressed deltas', asy
   t.alike(syncResult, current, 'sync batch with mixed compression works')
 })
 
+
+test('compression - auto mode compresses when it pays off', async (t) => {
+  const source = b4a.from('This is repeated text data. '.repeat(100))
+  const target = b4a.from('This is modified repeated text data. '.repeat(100))
+
+  const autoDelta = await delta.create(source, target, { compressed: 'auto' })
+  const uncompressedDelta = await delta.create(source, target, { compressed: false })
+
+  t.ok(autoDelta[0] === 0x28 && autoDelta[1] === 0xB5 &&
+       autoDelta[2] === 0x2F && autoDelta[3] === 0xFD,
+       'compressible delta has zstd magic number')
+  t.ok(autoDelta.length < uncompressedDelta.length, 'auto compressed delta is smaller')
+  t.alike(await delta.apply(source, autoDelta), target, 'auto compressed delta applies correctly')
+})
+
+test('compression - auto mode skips incompressible deltas', async (t) => {
+  const source = generateTestData(8192, 'random')
+  const target = generateTestData(8192, 'random')
+
+  const autoDelta = await delta.create(source, target, { compressed: 'auto' })
+  const uncompressedDelta = await delta.create(source, target, { compressed: false })
+
+  t.is(autoDelta.length, uncompressedDelta.length, 'incompressible delta is kept raw')
+  t.alike(await delta.apply(source, autoDelta), target, 'raw delta from auto mode applies correctly')
+
+  const small = delta.createSync(b4a.from('Hello'), b4a.from('Hello!'), { compressed: 'auto' })
+  t.alike(small, delta.createSync(b4a.from('Hello'), b4a.from('Hello!')), 'tiny delta is kept raw')
+  t.alike(delta.applySync(b4a.from('Hello'), small), b4a.from('Hello!'), 'tiny raw delta applies correctly')
+})
+
+test('compression - lz4 create and apply', async (t) => {
+  const source = generateTestData(16384, 'text')
+  const target = mutateData(source, 'replace', 0.05)
+
+  const lz4Delta = await delta.create(source, target, { compressed: 'lz4' })
+  const uncompressedDelta = await delta.create(source, target, { compressed: false })
+
+  t.ok(lz4Delta[0] === 0x04 && lz4Delta[1] === 0x22 &&
+       lz4Delta[2] === 0x4D && lz4Delta[3] === 0x18,
+       'lz4 delta has lz4 frame magic number')
+  t.ok(lz4Delta.length < uncompressedDelta.length, 'lz4 delta is smaller')
+
+  t.alike(await delta.apply(source, lz4Delta), target, 'async apply auto-detects lz4')
+  t.alike(delta.applySync(source, lz4Delta), target, 'sync apply auto-detects lz4')
+
+  const zstdDelta = delta.createSync(source, target, { compressed: 'zstd' })
+  t.alike(applyBatchSync(source, [lz4Delta, createSync(target, source, { compressed: 'lz4' }), zstdDelta]), target,
+    'batch apply handles mixed lz4 and zstd deltas')
+})
+
+test('compression - error handling with lz4 magic but invalid data', (t) => {
+  const source = generateTestData(1024, 'binary')
+  const invalidWithMagic = b4a.from([
+    0x04, 0x22, 0x4D, 0x18, // Correct lz4 frame magic number
+    0xFF, 0xFF, 0xFF, 0xFF,
+    0x00, 0x00, 0x00, 0x00
+  ])
+
+  t.exception(() => delta.applySync(source, invalidWithMagic), 'throws error for corrupt data with lz4 magic number')
+})
+
+test('worker pool - stats track lanes', async (t) => {
+  const source = generateTestData(4096, 'text')
+  const target = mutateData(source, 'point', 0.05)
+
+  delta.configure({ inlineThreshold: 0, inlineOverhead: 0 })
+
+  const before = delta.stats()
+  const diff = await delta.create(source, target)
+  await delta.apply(source, diff)
+  await delta.apply(source, diff, { priority: 'background' })
+  const after = delta.stats()
+
+  delta.configure({ inlineThreshold: 1024, inlineOverhead: 20000 })
+
+  t.ok(after.threads > 0, 'pool has threads')
+  t.is(after.background.completed - before.background.completed, 2, 'create and background apply ran on the background lane')
+  t.is(after.interactive.completed - before.interactive.completed, 1, 'apply ran on the interactive lane')
+  t.ok(after.background.waitMax >= 0 && after.background.waitMean >= 0, 'queue wait times are reported')
+})
+
+test('worker pool - bounded queue rejects excess requests', async (t) => {
+  const source = generateTestData(64 * 1024, 'binary')
+  const target = mutateData(source, 'point', 0.05)
+
+  delta.configure({ threads: 1, queueLimit: 1 })
+
+  // Hold the only worker with a create that takes seconds on shifted
+  // periodic input, and abort it once the queue has been filled
+  const blocker = createAbortController()
+  const periodic = b4a.alloc(4 * 1024 * 1024, 'abcdefghijklmno')
+  const shifted = b4a.alloc(4 * 1024 * 1024, 'bcdefghijklmno')
+  const before = delta.stats().background
+  const busy = delta.create(periodic, shifted, { signal: blocker.signal })
+
+  for (;;) {
+    const lane = delta.stats().background
+    if (lane.active > 0 || lane.completed > before.completed) break
+  }
+
+  const pending = Array.from({ length: 20 }, () => delta.create(source, target))
+  blocker.abort()
+
+  const results = await Promise.allSettled(pending)
+  await t.exception(busy, 'blocking create rejects when aborted')
+
+  delta.configure({ threads: 2, queueLimit: 4096 })
+
+  const rejected = results.filter((r) => r.status === 'rejected')
+  t.is(rejected.length, 19, 'every request beyond the one queued slot is rejected')
+  t.ok(rejected.every((r) => r.reason.code === 'QUEUE_FULL'), 'rejections carry QUEUE_FULL')
+
+  for (const r of results.filter((r) => r.status === 'fulfilled')) {
+    t.alike(await delta.apply(source, r.value), target, 'accepted requests still complete')
+  }
+})
+
+test('worker pool - configure validates options', (t) => {
+  t.exception(() => delta.configure({ threads: -1 }), /threads must be a non-negative integer/, 'negative thread count throws')
+  t.exception(() => delta.configure({ queueLimit: 1.5 }), 'fractional queue limit throws')
+  t.exception(() => delta.configure({ queueLimit: 0 }), /queueLimit must be a positive integer/, 'zero queue limit throws')
+})
+
+test('worker pool - zero threads run requests on the JS thread', async (t) => {
+  const source = generateTestData(256 * 1024, 'text')
+  const target = mutateData(source, 'point', 0.05)
+
+  delta.configure({ threads: 0, inlineThreshold: 0, inlineOverhead: 0 })
+
+  try {
+    t.is(delta.stats().threads, 0, 'pool has no threads')
+
+    const completed = () => delta.stats().interactive.completed + delta.stats().background.completed
+    const before = completed()
+    const diffs = await Promise.all([create(source, target), create(source, target, { compressed: 'zstd' })])
+
+    t.alike(diffs[0], createSync(source, target), 'create completes without threads')
+    t.alike(await apply(source, diffs[1]), target, 'compressed apply completes without threads')
+    t.is(completed() - before, 3, 'requests still go through the queue')
+  } finally {
+    delta.configure({ threads: 2, inlineThreshold: 1024, inlineOverhead: 20000 })
+  }
+})
+
+test('worker pool - admission waits for in-flight bytes', async (t) => {
+  const source = generateTestData(64 * 1024, 'binary')
+  const target = mutateData(source, 'point', 0.05)
+
+  delta.configure({ maxInFlightBytes: 256 * 1024 })
+
+  const pending = Array.from({ length: 10 }, () => delta.create(source, target))
+  const during = delta.stats()
+  const results = await Promise.all(pending)
+
+  delta.configure({ maxInFlightBytes: Infinity })
+
+  t.ok(during.waiting > 0, 'requests beyond the byte limit wait')
+  t.ok(during.inFlightBytes <= 256 * 1024, 'admitted requests stay within the limit')
+
+  for (const diff of results) {
+    t.alike(await delta.apply(source, diff), target, 'waiting requests complete in turn')
+  }
+
+  const after = delta.stats()
+  t.is(after.inFlight, 0, 'nothing is left in flight')
+  t.is(after.waiting, 0, 'nothing is left waiting')
+})
+
+test('worker pool - admission counts apply outputs', async (t) => {
+  const source = generateTestData(64 * 1024, 'text')
+  const target = b4a.concat(Array.from({ length: 16 }, () => source))
+
+  // Outputs are only estimated under a byte limit
+  delta.configure({ maxInFlightBytes: 1024 * 1024 * 1024 })
+
+  const raw = createSync(source, target)
+  let pending = delta.apply(source, raw)
+  let during = delta.stats()
+  t.alike(await pending, target, 'raw apply works')
+  t.ok(during.inFlightBytes >= source.length + raw.length + target.length, 'raw apply counts its target')
+
+  for (const compressed of ['zstd', 'lz4']) {
+    const diff = createSync(source, target, { compressed })
+    const { deltaLength } = delta.estimateApply(diff)
+
+    pending = delta.apply(source, diff)
+    during = delta.stats()
+    t.alike(await pending, target, `${compressed} apply works`)
+    t.is(during.inFlightBytes, source.length + diff.length + 2 * deltaLength, `${compressed} apply counts its frame content size`)
+  }
+
+  const diff = createSync(source, target, { compressed: 'zstd' })
+  const { deltaLength } = delta.estimateApply(diff)
+
+  const many = delta.applyMany([[source, diff], [source, diff]])
+  during = delta.stats()
+  t.is((await many).length, 2, 'applyMany works')
+  t.ok(during.inFlightBytes >= 2 * (source.length + diff.length + 2 * deltaLength), 'applyMany counts every pair')
+
+  const batch = delta.applyBatch(target, [createSync(target, source), createSync(source, target)])
+  during = delta.stats()
+  t.alike(await batch, target, 'applyBatch works')
+  t.ok(during.inFlightBytes >= target.length + source.length + target.length, 'applyBatch counts every output')
+
+  delta.configure({ maxInFlightBytes: Infinity })
+
+  pending = delta.apply(source, raw)
+  during = delta.stats()
+  await pending
+  t.is(during.inFlightBytes, source.length + raw.length, 'without a byte limit only the inputs are counted')
+})
+
+test('worker pool - admission rejects when overloaded', async (t) => {
+  const source = generateTestData(64 * 1024, 'binary')
+  const target = mutateData(source, 'point', 0.05)
+
+  delta.configure({ maxInFlight: 2, overload: 'reject' })
+
+  const results = await Promise.allSettled(
+    Array.from({ length: 10 }, () => delta.create(source, target))
+  )
+
+  delta.configure({ maxInFlight: Infinity, overload: 'wait' })
+
+  const rejected = results.filter((r) => r.status === 'rejected')
+  t.is(rejected.length, 8, 'requests beyond the limit are rejected')
+  t.ok(rejected.every((r) => r.reason.code === 'OVERLOADED'), 'rejections carry OVERLOADED')
+
+  t.exception(() => delta.configure({ maxInFlight: 0 }), 'zero in-flight limit throws')
+  t.exception(() => delta.configure({ overload: 'drop' }), 'unknown overload policy throws')
+})
+
+test('cancellation - already aborted signal rejects without queueing', async (t) => {
+  const source = generateTestData(4096, 'text')
+  const target = mutateData(source, 'point', 0.05)
+  const controller = createAbortController()
+  controller.abort()
+
+  const before = delta.stats()
+  await t.exception(delta.create(source, target, { signal: controller.signal }), 'create rejects')
+  await t.exception(delta.apply(source, createSync(source, target), { signal: controller.signal }), 'apply rejects')
+  await t.exception(delta.applyBatch(source, [], { signal: controller.signal }), 'applyBatch rejects')
+  const after = delta.stats()
+
+  t.is(after.background.submitted, before.background.submitted, 'nothing was queued on the background lane')
+  t.is(after.interactive.submitted, before.interactive.submitted, 'nothing was queued on the interactive lane')
+})
+
+test('cancellation - aborting queued and running work', async (t) => {
+  const source = generateTestData(1024 * 1024, 'random')
+  const target = generateTestData(1024 * 1024, 'random')
+
+  delta.configure({ threads: 1 })
+
+  const before = delta.stats()
+
+  const running = createAbortController()
+  const queued = createAbortController()
+
+  const first = delta.create(source, target, { signal: running.signal })
+  const second = delta.create(source, target, { signal: queued.signal })
+  const third = delta.create(source, target)
+
+  queued.abort()
+  running.abort()
+
+  await t.exception(first, 'running create rejects when aborted')
+  await t.exception(second, 'queued create rejects when aborted')
+
+  const diff = await third
+  t.alike(await delta.apply(source, diff), target, 'unaborted work still completes')
+
+  delta.configure({ threads: 2 })
+
+  const after = delta.stats()
+  t.ok(after.background.cancelled - before.background.cancelled >= 1, 'cancelled work is counted')
+})
+
+test('many - createMany and applyMany roundtrip independent pairs', async (t) => {
+  const pairs = Array.from({ length: 50 }, (_, i) => {
+    const source = generateTestData(100 + i * 7, i % 2 ? 'text' : 'binary')
+    return [source, mutateData(source, 'point', 0.1)]
+  })
+  pairs.push([b4a.alloc(0), b4a.from('from nothing')])
+
+  const deltas = await delta.createMany(pairs)
+  t.is(deltas.length, pairs.length, 'one delta per pair')
+
+  const targets = await delta.applyMany(pairs.map(([source], i) => [source, deltas[i]]))
+  t.is(targets.length, pairs.length, 'one target per pair')
+
+  for (let i = 0; i < pairs.length; i++) {
+    t.alike(deltas[i], createSync(pairs[i][0], pairs[i][1]), `delta ${i} matches createSync`)
+    t.alike(targets[i], pairs[i][1], `target ${i} is reconstructed`)
+  }
+
+  const compressed = delta.createManySync(pairs, { compressed: 'lz4' })
+  t.alike(delta.applyManySync(pairs.map(([source], i) => [source, compressed[i]])), pairs.map(([, target]) => target),
+    'sync variants handle compressed deltas')
+
+  t.alike(await delta.createMany([]), [], 'empty batch resolves to an empty array')
+})
+
+test('many - a failing pair rejects the whole call', async (t) => {
+  const source = generateTestData(256, 'text')
+  const good = createSync(source, mutateData(source, 'point', 0.1))
+  const corrupt = b4a.from([0x28, 0xB5, 0x2F, 0xFD, 0xFF, 0xFF])
+
+  await t.exception(delta.applyMany([[source, good], [source, corrupt]]), /pair 1/, 'async call names the failed pair')
+
+  try {
+    await delta.applyMany([[source, good], [source, good], [source, corrupt], [source, good]])
+    t.fail('corrupt pair should reject')
+  } catch (err) {
+    t.is(err.index, 2, 'error carries the failed index')
+    t.alike(err.results, [applySync(source, good), applySync(source, good)], 'error carries the results before it')
+  }
+
+  t.exception(() => delta.applyManySync([[source, corrupt]]), /pair 0/, 'sync call names the failed pair')
+
+  try {
+    delta.applyManySync([[source, good], [source, corrupt], [source, good]])
+    t.fail('corrupt pair should throw')
+  } catch (err) {
+    t.is(err.code, 'INVALID_DELTA', 'sync error carries a code')
+    t.is(err.index, 1, 'sync error carries the failed index')
+    t.alike(err.results, [applySync(source, good)], 'sync error carries the results before it')
+  }
+  t.exception(() => delta.createManySync([source]), 'pairs must be arrays')
+})
+
+test('coalescing - concurrent small requests share worker pool requests', async (t) => {
+  const sources = Array.from({ length: 100 }, (_, i) => generateTestData(2048 + i, 'text'))
+  const targets = sources.map((source) => mutateData(source, 'point', 0.05))
+
+  delta.configure({ inlineOverhead: 0 })
+
+  const before = delta.stats()
+  const deltas = await Promise.all(sources.map((source, i) => delta.create(source, targets[i])))
+  const results = await Promise.all(sources.map((source, i) => delta.apply(source, deltas[i])))
+  const after = delta.stats()
+
+  delta.configure({ inlineOverhead: 20000 })
+
+  t.alike(results, targets, 'every coalesced request resolves with its own result')
+  t.ok(after.background.submitted - before.background.submitted < 100, 'creates were coalesced')
+  t.ok(after.interactive.submitted - before.interactive.submitted < 100, 'applies were coalesced')
+
+  const corrupt = b4a.alloc(2048, 0xff)
+  const settled = await Promise.allSettled([
+    delta.apply(sources[0], deltas[0]),
+    delta.apply(sources[1], corrupt),
+    delta.apply(sources[2], deltas[2])
+  ])
+
+  t.is(settled[0].status, 'fulfilled', 'requests before a failing one resolve')
+  t.is(settled[1].status, 'rejected', 'the failing request rejects on its own')
+  t.is(settled[2].status, 'fulfilled', 'requests after a failing one resolve')
+})
+
+test('coalescing - a failing request only fails its own caller', async (t) => {
+  const sources = Array.from({ length: 8 }, (_, i) => generateTestData(2048 + i, 'text'))
+  const targets = sources.map((source) => mutateData(source, 'point', 0.05))
+
+  // Compressed deltas never run inline, so these are all coalesced
+  const diffs = sources.map((source, i) => createSync(source, targets[i], { compressed: 'zstd' }))
+  diffs[3] = b4a.from([0x28, 0xB5, 0x2F, 0xFD, 0xFF, 0xFF])
+
+  const before = delta.stats()
+  const results = await Promise.allSettled(sources.map((source, i) => delta.apply(source, diffs[i])))
+  const after = delta.stats()
+
+  t.is(results[3].status, 'rejected', 'the corrupt request is rejected')
+  t.alike(results.filter((r, i) => i !== 3).map((r) => r.value), targets.filter((r, i) => i !== 3), 'every other request resolves')
+
+  const submitted = (after.interactive.submitted + after.background.submitted) - (before.interactive.submitted + before.background.submitted)
+  t.is(submitted, 2, 'only the requests after the failure are run again, once')
+})
+
+test('coalescing - tiny requests run inline', async (t) => {
+  const source = b4a.from('tiny source record')
+  const target = b4a.from('tiny target record')
+
+  const before = delta.stats()
+  const diff = await delta.create(source, target)
+  t.alike(await delta.apply(source, diff), target, 'tiny roundtrip works')
+  const after = delta.stats()
+
+  t.is(after.background.submitted, before.background.submitted, 'tiny create skipped the worker pool')
+  t.is(after.interactive.submitted, before.interactive.submitted, 'tiny apply skipped the worker pool')
+})
+
+test('inline - thresholds are configurable', async (t) => {
+  const source = generateTestData(16 * 1024, 'text')
+  const target = mutateData(source, 'point', 0.01)
+  const diff = createSync(source, target)
+
+  let before = delta.stats()
+  t.alike(await delta.apply(source, diff), target, 'apply of a 16 KiB record works')
+  let after = delta.stats()
+  t.is(after.inlined - before.inlined, 1, 'cheap apply ran inline by cost estimate')
+
+  delta.configure({ inlineThreshold: 0, inlineOverhead: 0 })
+
+  before = delta.stats()
+  t.alike(await delta.apply(b4a.from('a'), createSync(b4a.from('a'), b4a.from('b'))), b4a.from('b'), 'tiny apply works')
+  after = delta.stats()
+  t.is(after.inlined, before.inlined, 'nothing runs inline when disabled')
+  t.is(after.interactive.submitted - before.interactive.submitted, 1, 'tiny apply went to the worker pool')
+
+  delta.configure({ inlineThreshold: 1024, inlineOverhead: 20000 })
+
+  // A 4 KiB delta of copies from a 64 byte source expands into 64 KiB
+  const record = generateTestData(64, 'random')
+  const expanded = b4a.concat(Array.from({ length: 1024 }, () => record))
+  const small = createSync(record, expanded)
+
+  before = delta.stats()
+  t.alike(await delta.apply(record, small), expanded, 'apply of an expanding delta works')
+  after = delta.stats()
+  t.is(after.inlined, before.inlined, 'apply costed by its target went to the worker pool')
+
+  const compressed = createSync(source, target, { compressed: 'zstd' })
+
+  before = delta.stats()
+  t.alike(await delta.apply(source, compressed), target, 'apply of a compressed delta works')
+  after = delta.stats()
+  t.is(after.inlined, before.inlined, 'compressed apply went to the worker pool')
+
+  t.exception(() => delta.configure({ inlineThreshold: -1 }), 'negative threshold throws')
+  t.exception(() => delta.configure({ inlineOverhead: NaN }), 'invalid overhead throws')
+})
+
+test('into - createInto and applyInto write into caller buffers', (t) => {
+  const source = generateTestData(4096, 'structured')
+  const target = mutateData(source, 'replace', 0.05)
+
+  const out = b4a.alloc(delta.createBound(target.length))
+  const len = delta.createInto(source, target, out)
+  t.alike(out.subarray(0, len), createSync(source, target), 'createInto matches createSync')
+
+  const exact = b4a.alloc(target.length)
+  t.is(delta.applyInto(source, out.subarray(0, len), exact), target.length, 'applyInto reports the target length')
+  t.alike(exact, target, 'applyInto fills an exactly sized buffer')
+
+  const roomy = b4a.alloc(target.length + 100)
+  t.is(delta.applyInto(source, out.subarray(0, len), roomy), target.length, 'applyInto writes in place with room to spare')
+  t.alike(roomy.subarray(0, target.length), target, 'in place apply reconstructs the target')
+
+  const compiled = delta.compileOptions({ compressed: 'lz4', searchDepth: 64 })
+  const clen = delta.createInto(source, target, out, compiled)
+  t.alike(out.subarray(0, 4), b4a.from([0x04, 0x22, 0x4D, 0x18]), 'compiled options select lz4')
+  t.alike(delta.applySync(source, out.subarray(0, clen)), target, 'compressed createInto output applies')
+
+  t.exception(() => delta.createInto(source, target, b4a.alloc(4)), RangeError, 'small create output throws RangeError')
+  t.exception(() => delta.applyInto(source, out.subarray(0, clen), b4a.alloc(10)), RangeError, 'small apply output throws RangeError')
+  t.exception(() => delta.applyInto(source, 'nope', exact), TypeError, 'non-buffer arguments throw TypeError')
+})
+
+test('codec - Encoder and Decoder reuse state across calls', async (t) => {
+  const encoder = new delta.Encoder({ compressed: 'zstd' })
+  const decoder = new delta.Decoder()
+
+  for (let i = 0; i < 5; i++) {
+    const source = generateTestData(1024 << i, 'text')
+    const target = mutateData(source, 'insert', 0.05)
+
+    const diff = encoder.createSync(source, target)
+    t.alike(decoder.applySync(source, diff), target, `sync roundtrip ${i} with growing scratch`)
+    t.alike(delta.applySync(source, diff), target, `encoder output ${i} applies with the plain API`)
+  }
+
+  const lz4 = new delta.Encoder({ compressed: 'lz4' })
+  const source = generateTestData(8192, 'binary')
+  const target = mutateData(source, 'replace', 0.05)
+  const out = b4a.alloc(target.length)
+
+  const len = lz4.createInto(source, target, b4a.alloc(delta.createBound(target.length)))
+  t.ok(len > 0, 'createInto writes an lz4 delta')
+  t.is(decoder.applyInto(source, lz4.createSync(source, target), out), target.length, 'applyInto writes the target')
+  t.alike(out, target, 'applyInto reconstructs the target')
+  t.exception(() => decoder.applyInto(source, lz4.createSync(source, target), b4a.alloc(1)), RangeError, 'small output throws')
+})
+
+test('codec - async calls on one object run in order', async (t) => {
+  const encoder = new delta.Encoder()
+  const decoder = new delta.Decoder()
+
+  const sources = Array.from({ length: 10 }, (_, i) => generateTestData(4096 + i * 1024, 'structured'))
+  const targets = sources.map((source) => mutateData(source, 'point', 0.05))
+
+  const order = []
+  const deltas = await Promise.all(sources.map((source, i) =>
+    encoder.create(source, targets[i]).then((diff) => {
+      order.push(i)
+      return diff
+    })
+  ))
+
+  t.alike(order, sources.map((_, i) => i), 'calls complete in issue order')
+
+  const results = await Promise.all(sources.map((source, i) => decoder.apply(source, deltas[i])))
+  t.alike(results, targets, 'every queued apply resolves with its own result')
+
+  const pending = encoder.create(sources[0], targets[0])
+  t.exception(() => encoder.createSync(sources[0], targets[0]), /in flight/, 'sync calls are refused while async ones run')
+  await pending
+})
+
+test('codec - queued calls count against the pool limits', async (t) => {
+  const source = generateTestData(64 * 1024, 'binary')
+  const target = mutateData(source, 'point', 0.05)
+
+  delta.configure({ queueLimit: 2 })
+
+  const encoder = new delta.Encoder()
+  const results = await Promise.allSettled(
+    Array.from({ length: 10 }, () => encoder.create(source, target))
+  )
+
+  delta.configure({ queueLimit: 4096 })
+
+  const rejected = results.filter((r) => r.status === 'rejected')
+  t.ok(rejected.length >= 7, 'calls queued on the encoder beyond the queue limit are rejected')
+  t.ok(rejected.every((r) => r.reason.code === 'QUEUE_FULL'), 'rejections carry QUEUE_FULL')
+
+  delta.configure({ maxInFlight: 1, overload: 'reject' })
+
+  const overloaded = await Promise.allSettled(
+    Array.from({ length: 5 }, () => encoder.create(source, target))
+  )
+
+  delta.configure({ maxInFlight: Infinity, overload: 'wait' })
+
+  t.is(overloaded[0].status, 'fulfilled', 'the call holding the encoder runs')
+  t.ok(overloaded.slice(1).every((r) => r.status === 'rejected' && r.reason.code === 'OVERLOADED'), 'calls queued behind it are rejected as the pool would')
+  t.is(delta.stats().codecQueued, 0, 'nothing is left queued on the encoder')
+})
+
+test('stream - createStream produces a delta from a chunked target', async (t) => {
+  const source = generateTestData(256 * 1024, 'structured')
+  const target = mutateData(source, 'point', 0.02)
+
+  const stream = delta.createStream(source, { length: target.length })
+  const chunks = []
+  stream.on('data', (chunk) => chunks.push(chunk))
+
+  for (let i = 0; i < target.length; i += 10000) stream.write(target.subarray(i, i + 10000))
+  stream.end()
+
+  await new Promise((resolve, reject) => {
+    stream.on('end', resolve)
+    stream.on('error', reject)
+  })
+
+  const diff = b4a.concat(chunks)
+  t.ok(diff.length < target.length / 4, 'streamed delta is compact')
+  t.alike(applySync(source, diff), target, 'streamed delta applies with the plain API')
+
+  // Options reach the engine: a wide hash window misses the short matches
+  // between point edits that the default one finds
+  const wide = delta.createStream(source, { length: target.length, hashWindowSize: 1024 })
+  const wideChunks = []
+  wide.on('data', (chunk) => wideChunks.push(chunk))
+  wide.end(target)
+
+  await new Promise((resolve, reject) => {
+    wide.on('end', resolve)
+    wide.on('error', reject)
+  })
+
+  const wideDiff = b4a.concat(wideChunks)
+  t.ok(wideDiff.length > diff.length, 'hashWindowSize is passed through the stream')
+  t.alike(applySync(source, wideDiff), target, 'delta with a wide hash window applies')
+
+  t.exception(() => delta.createStream(source, {}), 'length is required')
+  t.exception(() => delta.createStream(source, { length: 1, compressed: true }), 'compressed deltas are refused')
+})
+
+test('stream - applyStream reconstructs the target from delta chunks', async (t) => {
+  const source = generateTestData(128 * 1024, 'binary')
+  const target = b4a.concat([mutateData(source, 'replace', 0.05), generateTestData(100 * 1024, 'random')])
+  const diff = createSync(source, target)
+
+  const stream = delta.applyStream(source)
+  const chunks = []
+  stream.on('data', (chunk) => chunks.push(chunk))
+
+  // Split every integer and command across writes
+  for (let i = 0; i < diff.length; i += 3) stream.write(diff.subarray(i, i + 3))
+  stream.end()
+
+  await new Promise((resolve, reject) => {
+    stream.on('end', resolve)
+    stream.on('error', reject)
+  })
+
+  t.ok(chunks.every((chunk) => chunk.length <= 64 * 1024), 'output is pushed in bounded chunks')
+  t.alike(b4a.concat(chunks), target, 'applied stream matches the target')
+})
+
+test('stream - applyStream fails on a truncated or corrupt delta', async (t) => {
+  const source = generateTestData(8192, 'text')
+  const target = mutateData(source, 'point', 0.05)
+  const diff = createSync(source, target)
+
+  const truncated = delta.applyStream(source)
+  truncated.resume()
+  truncated.end(diff.subarray(0, diff.length - 1))
+  await t.exception(new Promise((resolve, reject) => {
+    truncated.on('end', resolve)
+    truncated.on('error', reject)
+  }), 'truncated delta errors')
+
+  const corrupt = delta.applyStream(source)
+  corrupt.resume()
+  corrupt.end(b4a.from([10, 1, 0x21]))
+  await t.exception(new Promise((resolve, reject) => {
+    corrupt.on('end', resolve)
+    corrupt.on('error', reject)
+  }), 'unknown command errors')
+})
+
+test('stream - createStream piped into applyStream', async (t) => {
+  const { pipeline, Readable } = require('streamx')
+
+  const source = generateTestData(512 * 1024, 'structured')
+  const target = mutateData(source, 'insert', 0.01)
+
+  const chunks = []
+  await new Promise((resolve, reject) => {
+    pipeline(
+      Readable.from(Array.from({ length: Math.ceil(target.length / 65536) }, (_, i) => target.subarray(i * 65536, (i + 1) * 65536))),
+      delta.createStream(source, { length: target.length }),
+      delta.applyStream(source),
+      (err) => (err ? reject(err) : resolve())
+    ).on('data', (chunk) => chunks.push(chunk))
+  })
+
+  t.alike(b4a.concat(chunks), target, 'target survives a streamed round trip')
+})
+
+test('incremental - createIncremental and applyIncremental advance in slices', (t) => {
+  const source = generateTestData(200 * 1024, 'structured')
+  const target = mutateData(source, 'point', 0.02)
+
+  const create = delta.createIncremental(source, target)
+  let diff = null
+  let steps = 0
+  while (diff === null) {
+    diff = create.step(16 * 1024)
+    steps++
+  }
+
+  // The index covers every block but the last hash window of the source
+  t.is(steps, Math.ceil((source.length - 16) / (16 * 1024)) + Math.ceil(target.length / (16 * 1024)), 'create took one step per budget of source and target')
+  t.ok(create.done, 'create is done')
+  t.alike(applySync(source, diff), target, 'incremental delta applies with the plain API')
+  t.exception(() => create.step(), 'stepping a finished create throws')
+
+  const apply = delta.applyIncremental(source, createSync(source, target))
+  let result = null
+  steps = 0
+  while (result === null) {
+    result = apply.step(16 * 1024)
+    steps++
+  }
+
+  t.ok(steps >= Math.ceil(target.length / (16 * 1024)), 'apply took one step per budget of output')
+  t.alike(result, target, 'incremental apply reconstructs the target')
+})
+
+test('incremental - compressed deltas and invalid input', (t) => {
+  const source = generateTestData(64 * 1024, 'text')
+  const target = mutateData(source, 'replace', 0.05)
+
+  for (const compressed of ['zstd', 'lz4']) {
+    const create = delta.createIncremental(source, target, { compressed })
+    let diff
+    while ((diff = create.step(4096)) === null);
+    t.alike(applySync(source, diff), target, `${compressed} incremental delta applies`)
+
+    const apply = delta.applyIncremental(source, diff)
+    let result
+    while ((result = apply.step(4096)) === null);
+    t.alike(result, target, `${compressed} delta applies incrementally`)
+  }
+
+  const diff = createSync(source, target)
+  const truncated = delta.applyIncremental(source, diff.subarray(0, diff.length - 2))
+  t.exception(() => {
+    while (truncated.step() === null);
+  }, 'truncated delta throws')
+
+  t.exception(() => delta.createIncremental(source, target).step(0), 'zero budget throws')
+
+  const changed = delta.createIncremental(source, target)
+  changed._source = source.subarray(1)
+  t.exception(() => changed.step(), /source changed length/, 'changed source length throws')
+})
+
+test('incremental - indexing and compression are sliced too', (t) => {
+  const source = generateTestData(512 * 1024, 'structured')
+  const target = mutateData(source, 'point', 0.02)
+  const budget = 16 * 1024
+
+  for (const compressed of [false, 'zstd', 'lz4']) {
+    const create = delta.createIncremental(source, target, { compressed })
+    let diff = null
+    let steps = 0
+    let slowest = 0
+    while (diff === null) {
+      const start = Date.now()
+      diff = create.step(budget)
+      slowest = Math.max(slowest, Date.now() - start)
+      steps++
+    }
+
+    const name = compressed || 'raw'
+    const raw = compressed ? delta.estimateApply(diff).deltaLength : 0
+    const expected = Math.ceil(source.length / budget) + Math.ceil(target.length / budget) + Math.ceil(raw / budget)
+
+    t.ok(steps >= expected - 1, `${name} create took a step per budget of source, target and raw delta (${steps} steps, slowest ${slowest} ms)`)
+    t.alike(applySync(source, diff), target, `${name} sliced create applies`)
+
+    if (!compressed) continue
+
+    const apply = delta.applyIncremental(source, diff)
+    let result = null
+    steps = 0
+    while (result === null) {
+      result = apply.step(budget)
+      steps++
+    }
+
+    t.ok(steps >= Math.ceil(raw / budget) + Math.ceil(target.length / budget), `${name} apply took a step per budget of decompressed delta and output`)
+    t.alike(result, target, `${name} sliced apply reconstructs the target`)
+  }
+})
+
+test('stats - create and apply report engine counters', async (t) => {
+  const source = generateTestData(128 * 1024, 'structured')
+  const target = mutateData(source, 'point', 0.01)
+
+  const created = createSync(source, target, { stats: true })
+  t.alike(created.delta, createSync(source, target), 'delta matches the plain call')
+  t.ok(created.stats.probes > 0, 'probes counted')
+  t.ok(created.stats.chainSteps >= created.stats.rejections, 'rejections are chain steps')
+  t.is(created.stats.copyBytes + created.stats.literalBytes, target.length, 'commands cover the target')
+  t.ok(created.stats.indexTime >= 0 && created.stats.scanTime >= 0, 'times reported')
+
+  const applied = applySync(source, created.delta, { stats: true })
+  t.alike(applied.target, target, 'target matches')
+  t.is(applied.stats.copies, created.stats.copies, 'apply saw the same copies')
+  t.is(applied.stats.literalBytes, created.stats.literalBytes, 'apply saw the same literals')
+
+  const { delta: compressed, stats } = await create(source, target, { compressed: 'zstd', stats: true })
+  t.ok(stats.compressTime >= 0, 'compression time reported')
+
+  const result = await apply(source, compressed, { stats: true })
+  t.alike(result.target, target, 'async apply with stats')
+  t.ok(result.stats.decompressTime >= 0, 'decompression time reported')
+
+  const small = await create(b4a.from('hello world'), b4a.from('hello there world'), { stats: true })
+  t.ok(b4a.isBuffer(small.delta), 'inline create returns stats too')
+})
+
+test('metrics - operations, failures and latency are counted', async (t) => {
+  const source = generateTestData(64 * 1024, 'text')
+  const target = mutateData(source, 'replace', 0.05)
+
+  const before = delta.metrics()
+
+  const diff = createSync(source, target)
+  await apply(source, diff)
+
+  try {
+    applySync(source, b4a.from('not a delta'))
+    t.fail('corrupt delta should throw')
+  } catch (err) {
+    t.is(err.code, 'INVALID_DELTA', 'sync failures carry an error code')
+  }
+
+  const batched = delta.metrics()
+
+  for (const [name, fn] of [
+    ['batch', () => applyBatchSync(source, [diff, b4a.from('not a delta')])],
+    ['many', () => delta.applyManySync([[source, b4a.from('not a delta')]])]
+  ]) {
+    try {
+      fn()
+      t.fail(`corrupt ${name} delta should throw`)
+    } catch (err) {
+      t.is(err.code, 'INVALID_DELTA', `sync ${name} failures carry an error code`)
+    }
+  }
+  delta.createManySync([[source, target]])
+
+  const after = delta.metrics()
+
+  t.is(after.operations.applyBatch - batched.operations.applyBatch, 1, 'sync batch counted')
+  t.is(after.operations.applyMany - batched.operations.applyMany, 1, 'sync applyMany counted')
+  t.is(after.operations.createMany - batched.operations.createMany, 1, 'sync createMany counted')
+  t.is(after.failures.INVALID_DELTA - batched.failures.INVALID_DELTA, 2, 'sync batch and many failures counted by code')
+  t.is(after.total.count - batched.total.count, 3, 'sync batch and many operations timed')
+
+  t.is(batched.operations.create - before.operations.create, 1, 'create counted')
+  t.is(batched.operations.apply - before.operations.apply, 2, 'applies counted')
+  t.is(batched.failures.INVALID_DELTA - before.failures.INVALID_DELTA, 1, 'failure counted by code')
+  t.ok(batched.bytesIn - before.bytesIn >= source.length * 2 + target.length, 'bytes in counted')
+  t.ok(batched.bytesOut - before.bytesOut >= diff.length + target.length, 'bytes out counted')
+  t.is(batched.total.count - before.total.count, 3, 'every operation timed')
+  t.ok(after.total.p50 <= after.total.p99 && after.total.p99 <= after.total.max, 'percentiles are ordered')
+})
+
+test('estimate - create and apply costs follow the allocations', (t) => {
+  const source = generateTestData(64 * 1024, 'text')
+  const target = mutateData(source, 'replace', 0.05)
+
+  const plain = delta.estimate(source.length, target.length)
+  t.is(plain.maxDeltaLength, target.length + 1024, 'delta bound is the output buffer')
+  t.is(plain.peakMemory, target.length + 1024 + (source.length / 16) * 2 * 4, 'peak holds the output and hash table')
+  t.ok(plain.cpuTime > 0, 'cpu time estimated')
+
+  const wide = delta.estimate(source.length, target.length, { hashWindowSize: 64 })
+  t.ok(wide.peakMemory < plain.peakMemory, 'wider hash window needs a smaller table')
+
+  const zstd = delta.estimate(source.length, target.length, { compressed: 'zstd' })
+  t.ok(zstd.maxDeltaLength > plain.maxDeltaLength, 'compression bound exceeds the raw delta')
+  t.ok(zstd.cpuTime > plain.cpuTime, 'compression adds cpu time')
+
+  t.exception(() => delta.estimate(-1, 10), /non-negative integer/, 'negative length throws')
+  t.is(delta.estimate(0, 0).maxDeltaLength, 1024, 'empty inputs are accepted')
+
+  const diff = createSync(source, target, { compressed: 'zstd' })
+  const applied = delta.estimateApply(diff)
+  t.is(applied.targetLength, target.length, 'target length read through zstd')
+  t.ok(applied.compressed, 'compression detected')
+  t.ok(applied.peakMemory >= target.length + applied.deltaLength, 'peak holds target and decompressed delta')
+
+  const lz4 = delta.estimateApply(createSync(source, target, { compressed: 'lz4' }))
+  t.is(lz4.targetLength, target.length, 'target length read through lz4')
+
+  const raw = createSync(source, target)
+  t.alike(delta.estimateApply(raw), { peakMemory: target.length + 1, targetLength: target.length, deltaLength: raw.length, compressed: false, cpuTime: (target.length + raw.length) * 0.5 / 1e6 }, 'uncompressed delta')
+
+  t.exception(() => delta.estimateApply(b4a.alloc(0)), /header/, 'unreadable header throws')
+})
+
+test('performance - worst-case fixtures stay within their time budgets', (t) => {
+  const { size, hashWindowSize, searchLimit, fixtures } = require('./fixtures/worst-case.json')
+  const options = { hashWindowSize, searchDepth: searchLimit }
+
+  // Fewer runs than bench-worstcase.js, which is enough for budgets of
+  // three times the recorded ratio
+  for (const fixture of fixtures) {
+    const { ns, baseNs } = measureRecipe(fixture, size, { createSync, applySync }, options, 2)
+    const ratio = ns / baseNs
+    t.ok(ratio <= fixture.budget, `${fixture.name} costs ${ratio.toFixed(1)}x the baseline per byte, budget ${fixture.budget}x`)
+  }
+})